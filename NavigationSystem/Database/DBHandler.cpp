@@ -1,33 +1,82 @@
 #include "DBHandler.h"
 #include <cstdio>
 #include <cstdlib>
-#include <iomanip>
 #include <string>
-#include <thread>
-#include "../SystemServices/Timer.h"
 #include "../SystemServices/Wrapper.h"
 
+// Pragmas of every connection. In WAL mode synchronous NORMAL only syncs the disk at
+// checkpoints, a power loss can lose the last transactions but not corrupt the database.
+#define DB_CONNECTION_PRAGMAS \
+    "PRAGMA synchronous = NORMAL; PRAGMA cache_size = -2048; PRAGMA mmap_size = 33554432;"
+
+// How long a connection waits for a lock held by another process
+#define DB_BUSY_TIMEOUT_MS 10
+
+// Appends text as a quoted json string
+static void appendJsonString(std::string& json, const char* text) {
+    json += '"';
+    for (const char* c = text; *c != '\0'; c++) {
+        switch (*c) {
+            case '"':
+                json += "\\\"";
+                break;
+            case '\\':
+                json += "\\\\";
+                break;
+            case '\n':
+                json += "\\n";
+                break;
+            case '\r':
+                json += "\\r";
+                break;
+            case '\t':
+                json += "\\t";
+                break;
+            default:
+                if ((unsigned char)*c < 0x20) {
+                    char escaped[8];
+                    snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                    json += escaped;
+                } else {
+                    json += *c;
+                }
+        }
+    }
+    json += '"';
+}
 
-std::mutex DBHandler::m_databaseLock;
-
-DBHandler::DBHandler(std::string filePath) : m_filePath(filePath) {
+DBHandler::DBHandler(std::string filePath, unsigned int readerCount)
+    : m_filePath(filePath),
+      m_writeConnection(NULL),
+      m_currentMissionStatement(NULL),
+      m_openReaders(0),
+      m_maxReaders(readerCount > 0 ? readerCount : 1) {
     m_latestDataLogId = 0;
+    for (int i = 0; i < DataLogTableCount; i++) {
+        m_logStatements[i] = NULL;
+    }
 }
 
 DBHandler::~DBHandler(void) {
-    m_databaseLock.unlock();
+    closeWriteConnection();
+
+    for (auto connection : m_idleReaders) {
+        sqlite3_close(connection);
+    }
 }
 
 bool DBHandler::initialise() {
-    sqlite3* connection = openDatabase();
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
 
-    if (connection != 0) {
-        closeDatabase(connection);
-        return true;
-    } else {
-        closeDatabase(connection);
-        return false;
+        // Opening the writer switches the database to WAL, the mode is stored in the file
+        if (m_writeConnection == NULL && not openWriteConnection()) {
+            return false;
+        }
     }
+
+    reloadConfigs();
+    return true;
 }
 
 void DBHandler::getDataAsJson(std::string select,
@@ -80,37 +129,12 @@ void DBHandler::getDataAsJson(std::string select,
     columnNames.clear();
 }
 
-void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
-    std::stringstream actuatorFeedbackValues;
-    std::stringstream compassModelValues;
-    std::stringstream courseCalculationValues;
-    std::stringstream currentSensorsValues;
-    std::stringstream gpsValues;
-    std::stringstream marineSensorsValues;
-    std::stringstream vesselStateValues;
-    std::stringstream windStateValues;
-    std::stringstream windsensorValues;
-    std::stringstream systemValues;
-    std::stringstream ss;
-    int actuatorFeedbackId = 0;
-    int compassModelId = 0;
-    int courceCalculationId = 0;
-    int currentMissionId = 0;
-    int currentSensorsId = 0;
-    int gpsId = 0;
-    int marineSensorsId = 0;
-    int vesselStateId = 0;
-    int windStateId = 0;
-    int windsensorId = 0;
-    int logNumber = 0;
-    std::string tableId;
-
-    sqlite3* db = openDatabase();
+bool DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
 
-    if (db == NULL) {
+    if (m_writeConnection == NULL && not openWriteConnection()) {
         Logger::error("%s Database is null!", __PRETTY_FUNCTION__);
-        closeDatabase(db);
-        return;
+        return false;
     }
 
     if (logs.size() > 0) {
@@ -118,172 +142,216 @@ void DBHandler::insertDataLogs(std::vector<LogItem>& logs) {
                      logs[0].m_timestamp_str.c_str(), logs.size());
     }
 
-    tableId = getIdFromTable("dataLogs_actuator_feedback", true, db);
-    if (tableId.size() > 0) {
-        actuatorFeedbackId = (int)strtol(tableId.c_str(), NULL, 10);
+    // NOTE : Marc : To update the id of currentMission in the DB
+    int currentMissionId = 0;
+    if (sqlite3_step(m_currentMissionStatement) == SQLITE_ROW) {
+        currentMissionId = sqlite3_column_int(m_currentMissionStatement, 0);
     }
-    tableId = getIdFromTable("dataLogs_compass", true, db);
-    if (tableId.size() > 0) {
-        compassModelId = (int)strtol(tableId.c_str(), NULL, 10);
+    sqlite3_reset(m_currentMissionStatement);
+
+    // The whole buffer goes in one transaction, so one journal write instead of one per row
+    bool success = sqlite3_exec(m_writeConnection, "BEGIN TRANSACTION;", NULL, NULL, NULL) == SQLITE_OK;
+
+    for (auto& log : logs) {
+        if (not success) {
+            break;
+        }
+        success = insertLogItem(log, currentMissionId);
     }
-    tableId = getIdFromTable("dataLogs_course_calculation", true, db);
-    if (tableId.size() > 0) {
-        courceCalculationId = (int)strtol(tableId.c_str(), NULL, 10);
+
+    if (success && sqlite3_exec(m_writeConnection, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK) {
+        m_latestDataLogId = (int)sqlite3_last_insert_rowid(m_writeConnection);
+        return true;
+    } else {
+        Logger::error("%s Error, failed to insert %d logs: %s", __PRETTY_FUNCTION__, (int)logs.size(),
+                      sqlite3_errmsg(m_writeConnection));
+        sqlite3_exec(m_writeConnection, "ROLLBACK;", NULL, NULL, NULL);
+        m_latestDataLogId = 0;
+
+        // Start from a fresh connection next time, in case the database file changed
+        closeWriteConnection();
+        return false;
     }
-    tableId = getIdFromTable("dataLogs_current_sensors", true, db);
-    if (tableId.size() > 0) {
-        currentSensorsId = (int)strtol(tableId.c_str(), NULL, 10);
+}
+
+bool DBHandler::openWriteConnection() {
+    static const char* insertSql[DataLogTableCount] = {
+        "INSERT INTO dataLogs_actuator_feedback VALUES(NULL, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_compass VALUES(NULL, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_course_calculation VALUES(NULL, ?, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_current_sensors VALUES(NULL, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_gps VALUES(NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_marine_sensors VALUES(NULL, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_vessel_state VALUES(NULL, ?, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_wind_state VALUES(NULL, ?, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_windsensor VALUES(NULL, ?, ?, ?, ?);",
+        "INSERT INTO dataLogs_system VALUES(NULL, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);"};
+
+    m_writeConnection = openConnection(false);
+    if (m_writeConnection == NULL) {
+        return false;
     }
-    tableId = getIdFromTable("dataLogs_gps", true, db);
-    if (tableId.size() > 0) {
-        gpsId = (int)strtol(tableId.c_str(), NULL, 10);
+
+    char* error = NULL;
+    sqlite3_exec(m_writeConnection, "PRAGMA journal_mode = WAL;", NULL, NULL, &error);
+    if (error != NULL) {
+        Logger::warning("%s Failed to enable WAL, readers may wait for writes: %s",
+                        __PRETTY_FUNCTION__, error);
+        sqlite3_free(error);
     }
-    tableId = getIdFromTable("dataLogs_marine_sensors", true, db);
-    if (tableId.size() > 0) {
-        marineSensorsId = (int)strtol(tableId.c_str(), NULL, 10);
+
+    for (int i = 0; i < DataLogTableCount; i++) {
+        if (sqlite3_prepare_v2(m_writeConnection, insertSql[i], -1, &m_logStatements[i], NULL) !=
+            SQLITE_OK) {
+            Logger::error("%s Failed to prepare \"%s\" Error: %s", __PRETTY_FUNCTION__, insertSql[i],
+                          sqlite3_errmsg(m_writeConnection));
+            closeWriteConnection();
+            return false;
+        }
     }
-    tableId = getIdFromTable("dataLogs_vessel_state", true, db);
-    if (tableId.size() > 0) {
-        vesselStateId = (int)strtol(tableId.c_str(), NULL, 10);
+
+    if (sqlite3_prepare_v2(m_writeConnection, "SELECT MAX(id) FROM currentMission;", -1,
+                           &m_currentMissionStatement, NULL) != SQLITE_OK) {
+        Logger::error("%s Failed to prepare the current mission query Error: %s",
+                      __PRETTY_FUNCTION__, sqlite3_errmsg(m_writeConnection));
+        closeWriteConnection();
+        return false;
     }
-    tableId = getIdFromTable("dataLogs_wind_state", true, db);
-    if (tableId.size() > 0) {
-        windStateId = (int)strtol(tableId.c_str(), NULL, 10);
+    return true;
+}
+
+void DBHandler::closeWriteConnection() {
+    for (int i = 0; i < DataLogTableCount; i++) {
+        sqlite3_finalize(m_logStatements[i]);
+        m_logStatements[i] = NULL;
     }
-    tableId = getIdFromTable("dataLogs_windsensor", true, db);
-    if (tableId.size() > 0) {
-        windsensorId = (int)strtol(tableId.c_str(), NULL, 10);
+    sqlite3_finalize(m_currentMissionStatement);
+    m_currentMissionStatement = NULL;
+
+    if (m_writeConnection != NULL) {
+        sqlite3_close(m_writeConnection);
+        m_writeConnection = NULL;
     }
-    // NOTE : Marc : To update the id of currentMission in the DB
-    tableId = getIdFromTable("currentMission", true, db);
-    if (tableId.size() > 0) {
-        currentMissionId = (int)strtol(tableId.c_str(), NULL, 10);
-    }
-
-    for (auto log : logs) {
-        logNumber++;
-        actuatorFeedbackValues.str("");
-        compassModelValues.str("");
-        courseCalculationValues.str("");
-        currentSensorsValues.str("");
-        gpsValues.str("");
-        marineSensorsValues.str("");
-        vesselStateValues.str("");
-        windStateValues.str("");
-        windsensorValues.str("");
-        systemValues.str("");
-
-        actuatorFeedbackValues << std::setprecision(10) << log.m_rudderPosition << ", "
-                               << log.m_wingsailPosition << ", " << log.m_radioControllerOn << ", "
-                               << log.m_windVaneAngle << ",'" << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_actuator_feedback"
-           << " VALUES(NULL, " << actuatorFeedbackValues.str() << "'); \n";
-
-        compassModelValues << std::setprecision(10) << log.m_compassHeading << ", "
-                           << log.m_compassPitch << ", " << log.m_compassRoll << ",'"
-                           << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_compass"
-           << " VALUES(NULL, " << compassModelValues.str() << "'); \n";
-
-        courseCalculationValues << std::setprecision(10) << log.m_distanceToWaypoint << ", "
-                                << log.m_bearingToWaypoint << ", " << log.m_courseToSteer << ", "
-                                << log.m_tack << ", " << log.m_goingStarboard << ",'"
-                                << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_course_calculation"
-           << " VALUES(NULL, " << courseCalculationValues.str() << "'); \n";
-
-        
-        
-        marineSensorsValues << std::setprecision(10) << log.m_temperature << ", "
-                            << log.m_conductivity << ", " << log.m_ph << ", " << log.m_salinity
-                            << ",'" << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_marine_sensors"
-           << " VALUES(NULL, " << marineSensorsValues.str() << "'); \n";
-
-        vesselStateValues << std::setprecision(10) << log.m_vesselHeading << ", " << log.m_vesselLat
-                          << ", " << log.m_vesselLon << ", " << log.m_vesselSpeed << ", "
-                          << log.m_vesselCourse << ",'" << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_vessel_state"
-           << " VALUES(NULL, " << vesselStateValues.str() << "'); \n";
-
-        windStateValues << std::setprecision(10) << log.m_trueWindSpeed << ", " << log.m_trueWindDir
-                        << ", " << log.m_apparentWindSpeed << ", " << log.m_apparentWindDir << ",'"
-                        << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_wind_state"
-           << " VALUES(NULL, " << windStateValues.str() << "'); \n";
-
-        windsensorValues << std::setprecision(10) << log.m_windDir << ", " << log.m_windSpeed
-                         << ", " << log.m_windTemp << ",'" << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_windsensor"
-           << " VALUES(NULL, " << windsensorValues.str() << "'); \n";
-
-        systemValues << std::setprecision(10) << actuatorFeedbackId + logNumber << ", "
-                     << compassModelId + logNumber << ", " << courceCalculationId + logNumber
-                     << ", " << currentSensorsId + logNumber << ", " << gpsId + logNumber << ", "
-                     << marineSensorsId + logNumber << ", " << vesselStateId + logNumber << ", "
-                     << windStateId + logNumber << ", " << windsensorId + logNumber << ", "
-                     << currentMissionId;
-
-        ss << "INSERT INTO "
-           << "dataLogs_system"
-           << " VALUES(NULL, " << systemValues.str() << "); \n";
-
-        // NEW FEATURE, CAREFUL WITH THE APOSTROPHE (added in dbloggernode.h for now, maybe add it in getelementstr)
-        currentSensorsValues << std::setprecision(10) << log.m_current << ", "
-                              << log.m_voltage << ", "
-                              << log.m_element << ", '" //HERE (moved to the m_element_str)
-                              << log.m_element_str.c_str() << "', '" //AND HERE (moved to the m_element_str)
-                             << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_current_sensors"
-           << " VALUES(NULL, " << currentSensorsValues.str() << "'); \n";
-
-        
-
-        gpsValues << std::setprecision(10) << log.m_gpsHasFix << ", " << log.m_gpsOnline << ",'"
-                  << log.m_timestamp_str.c_str() << "', " << log.m_gpsLat << ", " << log.m_gpsLon
-                  << ", " << log.m_gpsSpeed << ", " << log.m_gpsCourse << ", " << log.m_gpsSatellite
-                  << ", " << log.m_routeStarted << ",'" << log.m_timestamp_str.c_str();
-
-        ss << "INSERT INTO "
-           << "dataLogs_gps"
-           << " VALUES(NULL, " << gpsValues.str() << "'); \n";
-
-        //Logger::info("Current sensors database insert command: %s \n", ss);
-        //std::cout << "Current sensors database insert command: " << currentSensorsValues.str() << std::endl;
-        //std::cout << "Full insert command line: " << ss.str() << std::endl;
-
-    }
-
-    if (queryTable(ss.str(), db)) {
-        tableId = getIdFromTable("dataLogs_system", true, db);
-        if (tableId.size() > 0) {
-            m_latestDataLogId = (int)strtol(tableId.c_str(), NULL, 10);
-        } else {
-            m_latestDataLogId = 0;
+}
+
+bool DBHandler::insertLogItem(const LogItem& log, int currentMissionId) {
+    const char* timestamp = log.m_timestamp_str.c_str();
+    sqlite3_stmt* statement;
+    int ids[DataLogTableCount];
+
+    statement = m_logStatements[ActuatorFeedbackLog];
+    sqlite3_bind_double(statement, 1, log.m_rudderPosition);
+    sqlite3_bind_double(statement, 2, log.m_wingsailPosition);
+    sqlite3_bind_int(statement, 3, log.m_radioControllerOn);
+    sqlite3_bind_double(statement, 4, log.m_windVaneAngle);
+    sqlite3_bind_text(statement, 5, timestamp, -1, SQLITE_STATIC);
+    ids[ActuatorFeedbackLog] = stepLogStatement(ActuatorFeedbackLog);
+
+    statement = m_logStatements[CompassLog];
+    sqlite3_bind_double(statement, 1, log.m_compassHeading);
+    sqlite3_bind_double(statement, 2, log.m_compassPitch);
+    sqlite3_bind_double(statement, 3, log.m_compassRoll);
+    sqlite3_bind_text(statement, 4, timestamp, -1, SQLITE_STATIC);
+    ids[CompassLog] = stepLogStatement(CompassLog);
+
+    statement = m_logStatements[CourseCalculationLog];
+    sqlite3_bind_double(statement, 1, log.m_distanceToWaypoint);
+    sqlite3_bind_double(statement, 2, log.m_bearingToWaypoint);
+    sqlite3_bind_double(statement, 3, log.m_courseToSteer);
+    sqlite3_bind_int(statement, 4, log.m_tack);
+    sqlite3_bind_int(statement, 5, log.m_goingStarboard);
+    sqlite3_bind_text(statement, 6, timestamp, -1, SQLITE_STATIC);
+    ids[CourseCalculationLog] = stepLogStatement(CourseCalculationLog);
+
+    statement = m_logStatements[CurrentSensorsLog];
+    sqlite3_bind_double(statement, 1, log.m_current);
+    sqlite3_bind_double(statement, 2, log.m_voltage);
+    sqlite3_bind_int(statement, 3, log.m_element);
+    sqlite3_bind_text(statement, 4, log.m_element_str.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(statement, 5, timestamp, -1, SQLITE_STATIC);
+    ids[CurrentSensorsLog] = stepLogStatement(CurrentSensorsLog);
+
+    statement = m_logStatements[GPSLog];
+    sqlite3_bind_int(statement, 1, log.m_gpsHasFix);
+    sqlite3_bind_int(statement, 2, log.m_gpsOnline);
+    sqlite3_bind_text(statement, 3, timestamp, -1, SQLITE_STATIC);
+    sqlite3_bind_double(statement, 4, log.m_gpsLat);
+    sqlite3_bind_double(statement, 5, log.m_gpsLon);
+    sqlite3_bind_double(statement, 6, log.m_gpsSpeed);
+    sqlite3_bind_double(statement, 7, log.m_gpsCourse);
+    sqlite3_bind_int(statement, 8, log.m_gpsSatellite);
+    sqlite3_bind_int(statement, 9, log.m_routeStarted);
+    sqlite3_bind_text(statement, 10, timestamp, -1, SQLITE_STATIC);
+    ids[GPSLog] = stepLogStatement(GPSLog);
+
+    statement = m_logStatements[MarineSensorsLog];
+    sqlite3_bind_double(statement, 1, log.m_temperature);
+    sqlite3_bind_double(statement, 2, log.m_conductivity);
+    sqlite3_bind_double(statement, 3, log.m_ph);
+    sqlite3_bind_double(statement, 4, log.m_salinity);
+    sqlite3_bind_text(statement, 5, timestamp, -1, SQLITE_STATIC);
+    ids[MarineSensorsLog] = stepLogStatement(MarineSensorsLog);
+
+    statement = m_logStatements[VesselStateLog];
+    sqlite3_bind_double(statement, 1, log.m_vesselHeading);
+    sqlite3_bind_double(statement, 2, log.m_vesselLat);
+    sqlite3_bind_double(statement, 3, log.m_vesselLon);
+    sqlite3_bind_double(statement, 4, log.m_vesselSpeed);
+    sqlite3_bind_double(statement, 5, log.m_vesselCourse);
+    sqlite3_bind_text(statement, 6, timestamp, -1, SQLITE_STATIC);
+    ids[VesselStateLog] = stepLogStatement(VesselStateLog);
+
+    statement = m_logStatements[WindStateLog];
+    sqlite3_bind_double(statement, 1, log.m_trueWindSpeed);
+    sqlite3_bind_double(statement, 2, log.m_trueWindDir);
+    sqlite3_bind_double(statement, 3, log.m_apparentWindSpeed);
+    sqlite3_bind_double(statement, 4, log.m_apparentWindDir);
+    sqlite3_bind_text(statement, 5, timestamp, -1, SQLITE_STATIC);
+    ids[WindStateLog] = stepLogStatement(WindStateLog);
+
+    statement = m_logStatements[WindsensorLog];
+    sqlite3_bind_double(statement, 1, log.m_windDir);
+    sqlite3_bind_double(statement, 2, log.m_windSpeed);
+    sqlite3_bind_double(statement, 3, log.m_windTemp);
+    sqlite3_bind_text(statement, 4, timestamp, -1, SQLITE_STATIC);
+    ids[WindsensorLog] = stepLogStatement(WindsensorLog);
+
+    for (int i = 0; i < SystemLog; i++) {
+        if (ids[i] == 0) {
+            return false;
         }
-    } else {
-        m_latestDataLogId = 0;
-        Logger::error("%s Error, failed to insert log Request: %s", __PRETTY_FUNCTION__,
-                      ss.str().c_str());
     }
 
-    closeDatabase(db);
+    // The system row links the rows just inserted, the ids come straight from the inserts
+    // so the tables never need to be queried for them.
+    statement = m_logStatements[SystemLog];
+    sqlite3_bind_int(statement, 1, ids[ActuatorFeedbackLog]);
+    sqlite3_bind_int(statement, 2, ids[CompassLog]);
+    sqlite3_bind_int(statement, 3, ids[CourseCalculationLog]);
+    sqlite3_bind_int(statement, 4, ids[CurrentSensorsLog]);
+    sqlite3_bind_int(statement, 5, ids[GPSLog]);
+    sqlite3_bind_int(statement, 6, ids[MarineSensorsLog]);
+    sqlite3_bind_int(statement, 7, ids[VesselStateLog]);
+    sqlite3_bind_int(statement, 8, ids[WindStateLog]);
+    sqlite3_bind_int(statement, 9, ids[WindsensorLog]);
+    sqlite3_bind_int(statement, 10, currentMissionId);
+    return stepLogStatement(SystemLog) != 0;
+}
+
+int DBHandler::stepLogStatement(DataLogTable table) {
+    sqlite3_stmt* statement = m_logStatements[table];
+    int resultcode;
+
+    do {
+        resultcode = sqlite3_step(statement);
+    } while (resultcode == SQLITE_BUSY);
+    sqlite3_reset(statement);
+
+    if (resultcode != SQLITE_DONE) {
+        Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(m_writeConnection));
+        return 0;
+    }
+    return (int)sqlite3_last_insert_rowid(m_writeConnection);
 }
 
 // TODO -Oliver: make private
@@ -299,6 +367,12 @@ void DBHandler::insertMessageLog(std::string gps_time, std::string type, std::st
 }
 
 bool DBHandler::updateTableJson(std::string table, std::string data) {
+    bool success = writeTableJson(table, data);
+    configTableChanged(table);
+    return success;
+}
+
+bool DBHandler::writeTableJson(std::string table, std::string data) {
     std::vector<std::string> columns = getColumnInfo("name", table);
 
     if (columns.size() <= 0) {
@@ -366,6 +440,7 @@ bool DBHandler::updateTableJsonObject(std::string table, Json data) {
         Logger::error("%s Error: ", __PRETTY_FUNCTION__);
         return false;
     }
+    configTableChanged(table);
     return true;
 }
 
@@ -378,6 +453,7 @@ bool DBHandler::updateTable(std::string table,
         Logger::error("%s Error updating table", __PRETTY_FUNCTION__);
         return false;
     }
+    configTableChanged(table);
     return true;
 }
 
@@ -421,10 +497,13 @@ void DBHandler::updateConfigs(std::string configs) {
 
     for (auto table : tables) {  // for each table in there
         if (js[table] != NULL) {
-            updateTableJson(table, js[table].dump());  // eg updatetablejson("sailing_config",
-                                                       // configs['sailing_config'] as json)
+            writeTableJson(table, js[table].dump());  // eg updatetablejson("sailing_config",
+                                                      // configs['sailing_config'] as json)
         }
     }
+
+    // One reload for all the tables, before the nodes are told about the new configs
+    reloadConfigs();
 }
 
 bool DBHandler::updateWaypoints(std::string waypoints) {
@@ -490,6 +569,11 @@ bool DBHandler::updateWaypoints(std::string waypoints) {
 }
 
 int DBHandler::retrieveCellAsInt(std::string table, std::string id, std::string column) {
+    ConfigValue config;
+    if (findConfig(table, id, column, config)) {
+        return config.asInt;
+    }
+
     std::string data = retrieveCell(table, id, column);
     if (data.size() > 0) {
         return strtol(data.c_str(), NULL, 10);
@@ -500,6 +584,11 @@ int DBHandler::retrieveCellAsInt(std::string table, std::string id, std::string
 }
 
 double DBHandler::retrieveCellAsDouble(std::string table, std::string id, std::string column) {
+    ConfigValue config;
+    if (findConfig(table, id, column, config)) {
+        return config.asDouble;
+    }
+
     std::string data = retrieveCell(table, id, column);
     if (data.size() > 0) {
         return strtod(data.c_str(), NULL);
@@ -556,6 +645,141 @@ void DBHandler::clearLogs() {
     }
 }
 
+bool DBHandler::getLogsSince(LogCursor& cursor, unsigned int maxRows, std::string& json) {
+    std::vector<std::string> datalogTables = getTableNames("dataLogs_%");
+
+    sqlite3* db = acquireReader();
+    if (db == NULL) {
+        Logger::error("%s Error: no db connection", __PRETTY_FUNCTION__);
+        return false;
+    }
+
+    // One read transaction, so the tables are read from the same state of the database and
+    // the system rows never refer to rows left out of the export
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+
+    bool empty = true;
+    json = "{";
+
+    for (auto& table : datalogTables) {
+        std::string query = "SELECT * FROM " + table + " WHERE id > ? ORDER BY id LIMIT ?;";
+        sqlite3_stmt* statement = NULL;
+
+        if (sqlite3_prepare_v2(db, query.c_str(), -1, &statement, NULL) != SQLITE_OK) {
+            Logger::error("%s SQL statement: %s Error: %s", __PRETTY_FUNCTION__, query.c_str(),
+                          sqlite3_errmsg(db));
+            sqlite3_finalize(statement);
+            continue;
+        }
+        sqlite3_bind_int(statement, 1, cursor[table]);
+        sqlite3_bind_int(statement, 2, maxRows);
+
+        int columns = sqlite3_column_count(statement);
+        int rows = 0;
+
+        while (sqlite3_step(statement) == SQLITE_ROW) {
+            if (rows == 0) {
+                if (not empty) {
+                    json += ',';
+                }
+                appendJsonString(json, table.c_str());
+                json += ":[";
+            } else {
+                json += ',';
+            }
+
+            // Every value is sent as a string, like getLogs does
+            json += '{';
+            for (int i = 0; i < columns; i++) {
+                if (i > 0) {
+                    json += ',';
+                }
+                appendJsonString(json, sqlite3_column_name(statement, i));
+                json += ':';
+
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(statement, i));
+                if (text != NULL) {
+                    appendJsonString(json, text);
+                } else {
+                    json += "null";
+                }
+            }
+            json += '}';
+
+            // The id is the first column of every log table
+            cursor[table] = sqlite3_column_int(statement, 0);
+            rows++;
+        }
+        sqlite3_finalize(statement);
+
+        if (rows > 0) {
+            json += ']';
+            empty = false;
+        }
+    }
+
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    releaseReader(db);
+
+    json += '}';
+    return not empty;
+}
+
+LogCursor DBHandler::loadLogCursor() {
+    LogCursor cursor;
+
+    // Databases created before the cursor was introduced don't have the table yet
+    queryTable("CREATE TABLE IF NOT EXISTS sync_cursors (table_name VARCHAR PRIMARY KEY, "
+               "last_id INTEGER);");
+
+    int rows = 0, columns = 0;
+    std::vector<std::string> results;
+    try {
+        results = retrieveFromTable("SELECT table_name, last_id FROM sync_cursors;", rows, columns);
+    } catch (const char* error) {
+        Logger::error("%s Error: %s", __PRETTY_FUNCTION__, error);
+        return cursor;
+    }
+
+    for (int i = 1; i <= rows; i++) {
+        cursor[results[i * columns]] = strtol(results[i * columns + 1].c_str(), NULL, 10);
+    }
+    return cursor;
+}
+
+bool DBHandler::saveLogCursor(const LogCursor& cursor) {
+    std::stringstream ss;
+
+    ss << "BEGIN TRANSACTION;";
+    for (auto& tableCursor : cursor) {
+        ss << "INSERT OR REPLACE INTO sync_cursors VALUES('" << tableCursor.first << "', "
+           << tableCursor.second << ");";
+    }
+    ss << "COMMIT;";
+
+    if (not queryTable(ss.str())) {
+        Logger::error("%s Failed to save the log cursor", __PRETTY_FUNCTION__);
+        queryTable("ROLLBACK;");
+        return false;
+    }
+    return true;
+}
+
+void DBHandler::clearLogsUpTo(const LogCursor& cursor) {
+    std::stringstream ss;
+
+    ss << "BEGIN TRANSACTION;";
+    for (auto& tableCursor : cursor) {
+        ss << "DELETE FROM " << tableCursor.first << " WHERE id <= " << tableCursor.second << ";";
+    }
+    ss << "COMMIT;";
+
+    if (not queryTable(ss.str())) {
+        Logger::error("%s Failed to remove the exported logs", __PRETTY_FUNCTION__);
+        queryTable("ROLLBACK;");
+    }
+}
+
 void DBHandler::deleteRow(std::string table, std::string id) {
     queryTable("DELETE FROM " + table + " WHERE id = " + id + ";");
 }
@@ -651,75 +875,63 @@ std::string DBHandler::getIdFromTable(std::string table, bool max) {
     }
 }
 
-std::string DBHandler::getIdFromTable(std::string table, bool max, sqlite3* db) {
-    int rows, columns;
-    std::vector<std::string> results;
-    try {
-        if (max) {
-            results = retrieveFromTable("SELECT MAX(id) FROM " + table + ";", rows, columns, db);
-        } else {
-            results = retrieveFromTable("SELECT MIN(id) FROM " + table + ";", rows, columns, db);
-        }
-    } catch (const char* error) {
-        rows = 0;
-        columns = 0;
-    }
-
-    if (rows * columns < 1) {
-        return "";
-    }
-    if (results[1] == "\0") {
-        return "";
-    } else {
-        return results[1];
-    }
-}
-
 ////////////////////////////////////////////////////////////////////
 // private helpers
 ////////////////////////////////////////////////////////////////////
 
-sqlite3* DBHandler::openDatabase() {
-    m_databaseLock.lock();
+sqlite3* DBHandler::openConnection(bool readOnly) {
     sqlite3* connection;
     int resultcode = 0;
 
-    // check if file exists
-    FILE* db_file = fopen(m_filePath.c_str(), "r");
-    if (db_file == NULL) {
-        Logger::error("%s %s not found", __PRETTY_FUNCTION__, m_filePath.c_str());
-        m_databaseLock.unlock();
-        return NULL;
-    }
-    fclose(db_file);
+    // Without SQLITE_OPEN_CREATE a missing database is an error instead of an empty file
+    int flags = (readOnly ? SQLITE_OPEN_READONLY : SQLITE_OPEN_READWRITE) | SQLITE_OPEN_NOMUTEX;
 
     do {
-        resultcode = sqlite3_open(m_filePath.c_str(), &connection);
+        resultcode = sqlite3_open_v2(m_filePath.c_str(), &connection, flags, NULL);
     } while (resultcode == SQLITE_BUSY);
 
     if (resultcode) {
-        Logger::error("%s Failed to open the database Error %s", __PRETTY_FUNCTION__,
-                      sqlite3_errmsg(connection));
-        m_databaseLock.unlock();
-        return 0;
+        Logger::error("%s Failed to open the database %s Error %s", __PRETTY_FUNCTION__,
+                      m_filePath.c_str(), sqlite3_errmsg(connection));
+        sqlite3_close(connection);
+        return NULL;
     }
 
-    // set a 10 millisecond timeout
-    sqlite3_busy_timeout(connection, 10);
+    sqlite3_busy_timeout(connection, DB_BUSY_TIMEOUT_MS);
+    sqlite3_exec(connection, DB_CONNECTION_PRAGMAS, NULL, NULL, NULL);
     return connection;
 }
 
-void DBHandler::closeDatabase(sqlite3* connection) {
-    if (connection != NULL) {
-        sqlite3_close(connection);
-        connection = NULL;
-        // ENsure it closes properly
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        m_databaseLock.unlock();
-    } else {
-        m_databaseLock.unlock();
-        throw "DBHandler::closeDatabase() : connection is already null";
+sqlite3* DBHandler::acquireReader() {
+    std::unique_lock<std::mutex> lock(m_readMutex);
+
+    while (m_idleReaders.empty()) {
+        if (m_openReaders < m_maxReaders) {
+            m_openReaders++;
+            lock.unlock();
+
+            sqlite3* connection = openConnection(true);
+            if (connection == NULL) {
+                lock.lock();
+                m_openReaders--;
+                m_readCondition.notify_one();
+            }
+            return connection;
+        }
+        m_readCondition.wait(lock);
     }
+
+    sqlite3* connection = m_idleReaders.back();
+    m_idleReaders.pop_back();
+    return connection;
+}
+
+void DBHandler::releaseReader(sqlite3* connection) {
+    {
+        std::lock_guard<std::mutex> lock(m_readMutex);
+        m_idleReaders.push_back(connection);
+    }
+    m_readCondition.notify_one();
 }
 
 int DBHandler::getTable(sqlite3* db,
@@ -784,82 +996,30 @@ int DBHandler::getTable(sqlite3* db,
     return SQLITE_OK;
 }
 
-int DBHandler::insertLog(std::string table, std::string values, sqlite3* db) {
-    std::stringstream ss;
-    ss << "INSERT INTO " << table << " VALUES(NULL, " << values << ");";
-
-    if (queryTable(ss.str(), db)) {
-        Timer time_;
-        time_.start();
-        std::string tableId = getIdFromTable(table, true, db);
-        time_.stop();
-        Logger::info("Time passed writing %.5f", time_.timePassed());
-        if (tableId.size() > 0) {
-            return (int)strtol(tableId.c_str(), NULL, 10);
-        }
-    } else {
-        Logger::error("%s Error, failed to insert log Request: %s", __PRETTY_FUNCTION__,
-                      ss.str().c_str());
-    }
-
-    return 0;
-}
-
 bool DBHandler::queryTable(std::string sqlINSERT) {
-    sqlite3* db = openDatabase();
-    m_error = NULL;
-
-    if (db != NULL) {
-        int resultcode = 0;
+    std::lock_guard<std::mutex> lock(m_writeMutex);
 
-        do {
-            if (m_error != NULL) {
-                sqlite3_free(m_error);
-                m_error = NULL;
-            }
-
-            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &m_error);
-        } while (resultcode == SQLITE_BUSY);
-        if (m_error != NULL) {
-            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(db));
-
-            sqlite3_free(m_error);
-            closeDatabase(db);
-            return false;
-        }
-    } else {
+    if (m_writeConnection == NULL && not openWriteConnection()) {
         Logger::error("%s Error: no database found", __PRETTY_FUNCTION__);
-        closeDatabase(db);
         return false;
     }
-    closeDatabase(db);
-    return true;
-}
 
-bool DBHandler::queryTable(std::string sqlINSERT, sqlite3* db) {
+    sqlite3* db = m_writeConnection;
+    int resultcode = 0;
     m_error = NULL;
 
-    if (db != NULL) {
-        int resultcode = 0;
-
-        do {
-            if (m_error != NULL) {
-                sqlite3_free(m_error);
-                m_error = NULL;
-            }
-            sqlite3_exec(db, "BEGIN TRANSACTION", NULL, NULL, &m_error);
-            resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &m_error);
-            sqlite3_exec(db, "END TRANSACTION", NULL, NULL, &m_error);
-        } while (resultcode == SQLITE_BUSY);
-
+    do {
         if (m_error != NULL) {
-            Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(db));
-
             sqlite3_free(m_error);
-            return false;
+            m_error = NULL;
         }
-    } else {
-        Logger::error("%s Error: no database found", __PRETTY_FUNCTION__);
+
+        resultcode = sqlite3_exec(db, sqlINSERT.c_str(), NULL, NULL, &m_error);
+    } while (resultcode == SQLITE_BUSY);
+    if (m_error != NULL) {
+        Logger::error("%s Error: %s", __PRETTY_FUNCTION__, sqlite3_errmsg(db));
+
+        sqlite3_free(m_error);
         return false;
     }
     return true;
@@ -868,36 +1028,20 @@ bool DBHandler::queryTable(std::string sqlINSERT, sqlite3* db) {
 std::vector<std::string> DBHandler::retrieveFromTable(std::string sqlSELECT,
                                                       int& rows,
                                                       int& columns) {
-    sqlite3* db = openDatabase();
+    sqlite3* db = acquireReader();
     std::vector<std::string> results;
 
-    if (db != NULL) {
-        int resultcode = 0;
-
-        do {
-            results = std::vector<std::string>();
-            // resultcode = sqlite3_get_table(db, sqlSELECT.c_str(), &results, &rows, &columns,
-            // &m_error);
-            resultcode = getTable(db, sqlSELECT, results, rows, columns);
-        } while (resultcode == SQLITE_BUSY);
-
-        if (resultcode == SQLITE_EMPTY) {
-            std::vector<std::string> s;
-            closeDatabase(db);
-            return s;
-        }
-
-        if (resultcode != SQLITE_OK) {
-            Logger::error("%s SQL statement: %s Error: %s", __PRETTY_FUNCTION__, sqlSELECT.c_str(),
-                          sqlite3_errstr(resultcode));
-            closeDatabase(db);
-            throw "retrieveFromTable";
-        }
-    } else {
-        closeDatabase(db);
+    if (db == NULL) {
         throw "DBHandler::retrieveFromTable(), no db connection";
     }
-    closeDatabase(db);
+
+    try {
+        results = retrieveFromTable(sqlSELECT, rows, columns, db);
+    } catch (const char*) {
+        releaseReader(db);
+        throw;
+    }
+    releaseReader(db);
     return results;
 }
 
@@ -1051,6 +1195,24 @@ bool DBHandler::getWaypointValues(int& nextId,
     return true;
 }
 
+bool DBHandler::countUnharvestedWaypoints(int& count) {
+    int rows, columns;
+    std::vector<std::string> results;
+    try {
+        results = retrieveFromTable("SELECT COUNT(*) FROM currentMission WHERE harvested = 0;",
+                                    rows, columns);
+    } catch (const char* error) {
+        Logger::error("%s Error: %s", __PRETTY_FUNCTION__, error);
+        return false;
+    }
+
+    if (rows * columns < 1) {
+        return false;
+    }
+    count = safe_stoi(results[1]);
+    return true;
+}
+
 std::string DBHandler::getConfigs() {
     Json js;
 
@@ -1076,5 +1238,81 @@ bool DBHandler::changeOneValue(std::string table,
         Logger::error("Error %s", __PRETTY_FUNCTION__);
         return false;
     }
+    configTableChanged(table);
+    return true;
+}
+
+void DBHandler::reloadConfigs() {
+    sqlite3* db = acquireReader();
+    if (db == NULL) {
+        Logger::error("%s Error: no db connection", __PRETTY_FUNCTION__);
+        return;
+    }
+
+    std::shared_ptr<ConfigSnapshot> configs = std::make_shared<ConfigSnapshot>();
+    sqlite3_stmt* tables = NULL;
+
+    // Same tables as getConfigs(), only the row with id 1 is used
+    const char* tablesQuery =
+        "SELECT name FROM sqlite_master WHERE type='table' AND name LIKE 'config_%';";
+
+    if (sqlite3_prepare_v2(db, tablesQuery, -1, &tables, NULL) == SQLITE_OK) {
+        while (sqlite3_step(tables) == SQLITE_ROW) {
+            std::string table = reinterpret_cast<const char*>(sqlite3_column_text(tables, 0));
+            std::string query = "SELECT * FROM " + table + " WHERE id = 1;";
+            sqlite3_stmt* row = NULL;
+
+            if (sqlite3_prepare_v2(db, query.c_str(), -1, &row, NULL) == SQLITE_OK &&
+                sqlite3_step(row) == SQLITE_ROW) {
+                for (int i = 0; i < sqlite3_column_count(row); i++) {
+                    const char* text = reinterpret_cast<const char*>(sqlite3_column_text(row, i));
+
+                    // NULL cells are left to the database, which reports them as before
+                    if (text != NULL) {
+                        ConfigValue& value = (*configs)[table + "." + sqlite3_column_name(row, i)];
+                        value.text = text;
+                        value.asInt = strtol(text, NULL, 10);
+                        value.asDouble = strtod(text, NULL);
+                    }
+                }
+            }
+            sqlite3_finalize(row);
+        }
+    }
+    sqlite3_finalize(tables);
+    releaseReader(db);
+
+    std::atomic_store(&m_configs, std::shared_ptr<const ConfigSnapshot>(configs));
+}
+
+void DBHandler::configTableChanged(const std::string& table) {
+    if (table.compare(0, 7, "config_") == 0) {
+        reloadConfigs();
+    }
+}
+
+bool DBHandler::findConfig(const std::string& table,
+                           const std::string& id,
+                           const std::string& column,
+                           ConfigValue& value) {
+    if (id != "1" || table.compare(0, 7, "config_") != 0) {
+        return false;
+    }
+
+    // Keeps the snapshot alive while it is read, even if a reload replaces it meanwhile
+    std::shared_ptr<const ConfigSnapshot> configs = std::atomic_load(&m_configs);
+    if (not configs) {
+        reloadConfigs();
+        configs = std::atomic_load(&m_configs);
+        if (not configs) {
+            return false;
+        }
+    }
+
+    auto it = configs->find(table + "." + column);
+    if (it == configs->end()) {
+        return false;
+    }
+    value = it->second;
     return true;
 }
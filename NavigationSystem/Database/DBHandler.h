@@ -2,10 +2,14 @@
 #define __DBHANDLER_H__  //__DATACOLLECT_H__
 
 #include <sqlite3.h>
+#include <condition_variable>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "../Messages/CurrentSensorDataMsg.h"
 #include "../Messages/WindStateMsg.h"
@@ -14,6 +18,9 @@
 #include "../Libs/json/include/nlohmann/json.hpp"
 using Json = nlohmann::json;
 
+// How many connections can read the database at the same time
+#define DB_READER_CONNECTIONS 4
+
 struct LogItem {
     double m_rudderPosition;  // dataLogs_actuator_feedback
     double m_wingsailPosition;
@@ -59,17 +66,73 @@ struct LogItem {
     std::string m_timestamp_str;
 };
 
+// A config cell, parsed once when the configs are loaded
+struct ConfigValue {
+    std::string text;
+    int asInt;
+    double asDouble;
+};
+
+// The row with id 1 of every config_* table, keyed by "table.column"
+typedef std::unordered_map<std::string, ConfigValue> ConfigSnapshot;
+
+// Id of the last row exported from each dataLogs_* table, keyed by table name
+typedef std::map<std::string, int> LogCursor;
+
 class DBHandler {
    private:
+    // Tables written for every LogItem, the statements inserting into them are prepared
+    // once and kept with the log connection
+    enum DataLogTable {
+        ActuatorFeedbackLog = 0,
+        CompassLog,
+        CourseCalculationLog,
+        CurrentSensorsLog,
+        GPSLog,
+        MarineSensorsLog,
+        VesselStateLog,
+        WindStateLog,
+        WindsensorLog,
+        SystemLog,
+        DataLogTableCount
+    };
+
     char* m_error;
     int m_latestDataLogId;
     std::string m_currentWaypointId = "";
     std::string m_filePath;
-    static std::mutex m_databaseLock;
+
+    // All writes go through one connection, reads are spread over a pool of read only
+    // connections. With the database in WAL mode the readers never wait for the writer.
+    std::mutex m_writeMutex;     // Serialises the use of the writer connection
+    sqlite3* m_writeConnection;  // Opened on first use, kept until destruction
+    sqlite3_stmt* m_logStatements[DataLogTableCount];
+    sqlite3_stmt* m_currentMissionStatement;
+
+    std::mutex m_readMutex;  // Guards the reader pool
+    std::condition_variable m_readCondition;
+    std::vector<sqlite3*> m_idleReaders;
+    unsigned int m_openReaders;
+    unsigned int m_maxReaders;
+
+    // Replaced as a whole whenever a config table changes, readers keep using the snapshot
+    // they loaded until they are done with it. Only accessed through std::atomic_load/store.
+    std::shared_ptr<const ConfigSnapshot> m_configs;
+
+    // looks a cell up in the config snapshot, only config_* tables with id 1 are in it
+    bool findConfig(const std::string& table,
+                    const std::string& id,
+                    const std::string& column,
+                    ConfigValue& value);
+
+    // reloads the config snapshot if the table is a config table
+    void configTableChanged(const std::string& table);
+
+    // updateTableJson without reloading the configs
+    bool writeTableJson(std::string table, std::string data);
 
     // execute INSERT query and add new row into table
     bool queryTable(std::string sqlINSERT);
-    bool queryTable(std::string sqlINSERT, sqlite3* db);
 
     // retrieve data from given table/tables, return value is a C 2D char array
     // rows and columns also return values (through a reference) about rows and columns in the
@@ -100,8 +163,22 @@ class DBHandler {
     // gets information(for instance: name/datatype) about all columns
     std::vector<std::string> getColumnInfo(std::string info, std::string table);
 
-    // help function used in insertDataLog
-    int insertLog(std::string table, std::string values, sqlite3* db);
+    // opens the writer connection and prepares the INSERT statements of the data log tables
+    bool openWriteConnection();
+
+    // finalizes the prepared statements and closes the writer connection
+    void closeWriteConnection();
+
+    // takes a connection from the reader pool, opening one if none is idle and the pool
+    // isn't full, otherwise waits for one to be released
+    sqlite3* acquireReader();
+    void releaseReader(sqlite3* connection);
+
+    // inserts one row in every data log table, returns false on error
+    bool insertLogItem(const LogItem& log, int currentMissionId);
+
+    // runs a prepared INSERT and returns the id of the new row, 0 on error
+    int stepLogStatement(DataLogTable table);
 
     // own implementation of deprecated sqlite3_get_table()
     int getTable(sqlite3* db,
@@ -110,19 +187,19 @@ class DBHandler {
                  int& rows,
                  int& columns);
 
-    sqlite3* openDatabase();
-
-    void closeDatabase(sqlite3* connection);
+    // opens a connection to an existing database and sets its pragmas
+    sqlite3* openConnection(bool readOnly);
 
    public:
-    DBHandler(std::string filePath);
+    DBHandler(std::string filePath, unsigned int readerCount = DB_READER_CONNECTIONS);
     ~DBHandler(void);
 
     bool initialise();
 
     int getRows(std::string table);
 
-    void insertDataLogs(std::vector<LogItem>& logs);
+    // inserts the logs in one transaction, returns false if none of them were inserted
+    bool insertDataLogs(std::vector<LogItem>& logs);
 
     void insertMessageLog(std::string gps_time, std::string type, std::string msg);
 
@@ -141,25 +218,39 @@ class DBHandler {
     // retrieve one value from a table as string
     std::string retrieveCell(std::string table, std::string id, std::string column);
 
-    // retrieve one value from a table as integer
+    // retrieve one value from a table as integer, config values come from the config snapshot
     int retrieveCellAsInt(std::string table, std::string id, std::string column);
 
-    // retrieve one value from a table as double
+    // retrieve one value from a table as double, config values come from the config snapshot
     double retrieveCellAsDouble(std::string table, std::string id, std::string column);
 
+    // reads all the config tables in one go and atomically replaces the config snapshot,
+    // done by initialise and whenever DBHandler writes to a config table
+    void reloadConfigs();
+
     // returns all logs in database as json; supply onlyLatest to get only the ones with the highest
     // id
     std::string getLogs(bool onlyLatest);
 
-    void forceUnlock() { m_databaseLock.unlock(); }
-
     void clearLogs();
 
+    // writes the rows of the dataLogs_* tables newer than the cursor as json, in the same
+    // layout as getLogs, and moves the cursor past them. At most maxRows rows are taken from
+    // each table, so a big backlog is exported in several calls. Returns false if there
+    // was nothing new.
+    bool getLogsSince(LogCursor& cursor, unsigned int maxRows, std::string& json);
+
+    // the cursor of the logs acknowledged by the server, persisted in sync_cursors
+    LogCursor loadLogCursor();
+    bool saveLogCursor(const LogCursor& cursor);
+
+    // removes the exported rows, everything up to the cursor
+    void clearLogsUpTo(const LogCursor& cursor);
+
     // get id from table returns either max or min id from table.
     // max = false -> min id
     // max = true -> max id
     std::string getIdFromTable(std::string table, bool max);
-    std::string getIdFromTable(std::string table, bool max, sqlite3* db);
 
     void deleteRow(std::string table, std::string id);
 
@@ -177,6 +268,9 @@ class DBHandler {
                            int& prevRadius,
                            bool& foundPrev);
 
+    // counts the waypoints of the current mission not harvested yet, returns false on error
+    bool countUnharvestedWaypoints(int& count);
+
     bool insert(std::string table, std::string fields, std::string values);
 
     // inserts area scanning measurements into db
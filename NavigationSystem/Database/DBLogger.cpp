@@ -8,58 +8,176 @@
  *		worker thread.
  *
  * Developer Notes:
- *
+ *		The ring is the bounded queue described by D. Vyukov: every slot carries a
+ *		sequence number telling whether it is free for the producer or ready for a
+ *		consumer, so a slot is never written while it is being read. There is a single
+ *		producer (the thread calling log()), but two consumers: the worker thread, and
+ *		the producer itself when it drops the oldest item.
  *
  ***************************************************************************************/
 
 
 #include "DBLogger.h"
 
+#include <chrono>
+
+// How long log() waits before checking for room again with the Block policy
+#define DBLOGGER_ROOM_RECHECK_MS	10
 
-DBLogger::DBLogger(unsigned int logBufferSize, DBHandler& dbHandler)
-	:m_dbHandler(dbHandler), m_bufferSize(logBufferSize)
+
+DBLogger::DBLogger(unsigned int logBufferSize, DBHandler& dbHandler, LogSink* sink, LogBackpressure policy)
+	:m_thread(NULL), m_sink(sink), m_bufferSize(logBufferSize), m_policy(policy), m_enqueuePos(0),
+	m_dequeuePos(0), m_hasPending(false), m_logged(0), m_dropped(0), m_coalesced(0), m_blocked(0),
+	m_reportedLosses(0)
 {
-	m_logBufferFront = new std::vector<LogItem>();
-	m_logBufferFront->reserve(logBufferSize);
+	if(m_sink == NULL)
+	{
+		m_databaseSink.reset(new DatabaseLogSink(dbHandler));
+		m_sink = m_databaseSink.get();
+	}
+
+	if(m_bufferSize == 0)
+	{
+		m_bufferSize = 1;
+	}
+
+	size_t capacity = 1;
+	while(capacity < m_bufferSize * DBLOGGER_RING_BATCHES)
+	{
+		capacity <<= 1;
+	}
+
+	m_slots.reset(new LogSlot[capacity]);
+	m_mask = capacity - 1;
+	for(size_t i = 0; i < capacity; i++)
+	{
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
 
-	m_logBufferBack = new std::vector<LogItem>();
-	m_logBufferBack->reserve(logBufferSize);
 	m_working = false;
 }
 
 DBLogger::~DBLogger()
 {
+	stopWorkerThread();
+}
+
+void DBLogger::startWorkerThread()
+{
+	if(m_thread != NULL)
+	{
+		return;
+	}
+
+	m_working.store(true);
+	m_thread = new std::thread(workerThread, this);
+}
+
+void DBLogger::stopWorkerThread()
+{
+	std::vector<LogItem> batch;
+
+	// The item coalesced last hasn't been queued yet
+	while(m_hasPending && not tryPush(m_pending))
+	{
+		if(m_thread == NULL)
+		{
+			drain(batch);
+		}
+		else
+		{
+			std::unique_lock<std::mutex> lk(m_mutex);
+			m_roomCondition.wait_for(lk, std::chrono::milliseconds(DBLOGGER_ROOM_RECHECK_MS));
+		}
+	}
+	m_hasPending = false;
+
 	m_working.store(false);
 
 	// Wait for the mutex to be unlocked.
 	{
 		std::lock_guard<std::mutex> lk(m_mutex);
 	}
-	// instruct the worker thread to work
+	// instruct the worker thread to write what is left and stop
 	m_cv.notify_one();
 
-	//m_thread->join();
-
-	//delete m_thread;
+	if(m_thread != NULL)
+	{
+		m_thread->join();
+		delete m_thread;
+		m_thread = NULL;
+	}
+	else
+	{
+		drain(batch);
+		reportLosses();
+	}
 }
 
-void DBLogger::startWorkerThread()
+void DBLogger::log(const LogItem& item)
 {
-	m_working.store(true);
-	m_thread = new std::thread(workerThread, this);
-}
+	switch(m_policy)
+	{
+		case LogBackpressure::Block:
+			if(tryPush(item))
+			{
+				break;
+			}
 
-void DBLogger::log(LogItem& item)
-{
-	m_logBufferFront->push_back(item);
+			m_blocked.fetch_add(1, std::memory_order_relaxed);
+			while(not tryPush(item))
+			{
+				// Nothing would ever make room
+				if(not m_working.load())
+				{
+					m_dropped.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+
+				std::unique_lock<std::mutex> lk(m_mutex);
+				m_roomCondition.wait_for(lk, std::chrono::milliseconds(DBLOGGER_ROOM_RECHECK_MS));
+			}
+		break;
+
+		case LogBackpressure::DropOldest:
+			while(not tryPush(item))
+			{
+				// Only the item in the slot to push to is dropped, the worker may be reading
+				// it and then it makes room on its own
+				size_t oldest = m_enqueuePos.load(std::memory_order_relaxed) - (m_mask + 1);
+				if(tryDrop(oldest))
+				{
+					m_dropped.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		break;
+
+		case LogBackpressure::Coalesce:
+			if(m_hasPending && tryPush(m_pending))
+			{
+				m_hasPending = false;
+			}
+
+			if(m_hasPending || not tryPush(item))
+			{
+				if(m_hasPending)
+				{
+					m_coalesced.fetch_add(1, std::memory_order_relaxed);
+				}
+				m_pending = item;
+				m_hasPending = true;
+				return;
+			}
+		break;
+	}
 
 	// Kick off the worker thread
-	if(m_logBufferFront->size() >= m_bufferSize)
+	if(queuedCount() >= m_bufferSize)
 	{
-		std::vector<LogItem>* tmp = m_logBufferBack;
-		m_logBufferBack = m_logBufferFront;
-		m_logBufferFront = tmp;
-
 		// Wait for the mutex to be unlocked.
 		{
 			std::lock_guard<std::mutex> lk(m_mutex);
@@ -69,6 +187,129 @@ void DBLogger::log(LogItem& item)
 	}
 }
 
+bool DBLogger::tryPush(const LogItem& item)
+{
+	size_t position = m_enqueuePos.load(std::memory_order_relaxed);
+	LogSlot& slot = m_slots[position & m_mask];
+
+	// Still holding an item from the previous turn of the ring, or being read
+	if(slot.sequence.load(std::memory_order_acquire) != position)
+	{
+		return false;
+	}
+
+	slot.item = item;
+	slot.sequence.store(position + 1, std::memory_order_release);
+	m_enqueuePos.store(position + 1, std::memory_order_relaxed);
+
+	m_logged.fetch_add(1, std::memory_order_relaxed);
+	return true;
+}
+
+bool DBLogger::tryPop(LogItem* item)
+{
+	size_t position = m_dequeuePos.load(std::memory_order_relaxed);
+	LogSlot* slot;
+
+	while(true)
+	{
+		slot = &m_slots[position & m_mask];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+
+		if(difference == 0)
+		{
+			if(m_dequeuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(difference < 0)
+		{
+			// Empty
+			return false;
+		}
+		else
+		{
+			// Taken by the other consumer
+			position = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	if(item != NULL)
+	{
+		*item = std::move(slot->item);
+	}
+	slot->sequence.store(position + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+bool DBLogger::tryDrop(size_t position)
+{
+	LogSlot& slot = m_slots[position & m_mask];
+
+	// Not holding that item anymore
+	if(slot.sequence.load(std::memory_order_acquire) != position + 1)
+	{
+		return false;
+	}
+
+	// The worker took it first, it is reading the slot
+	if(not m_dequeuePos.compare_exchange_strong(position, position + 1, std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+size_t DBLogger::queuedCount() const
+{
+	return m_enqueuePos.load(std::memory_order_relaxed) - m_dequeuePos.load(std::memory_order_relaxed);
+}
+
+void DBLogger::drain(std::vector<LogItem>& batch)
+{
+	while(true)
+	{
+		batch.clear();
+		while(batch.size() < m_bufferSize)
+		{
+			batch.emplace_back();
+			if(not tryPop(&batch.back()))
+			{
+				batch.pop_back();
+				break;
+			}
+		}
+
+		if(batch.empty())
+		{
+			return;
+		}
+
+		// The slots are free again, a blocked log() can go on while the batch is written
+		{
+			std::lock_guard<std::mutex> lk(m_mutex);
+		}
+		m_roomCondition.notify_one();
+
+		m_sink->writeLogs(batch);
+	}
+}
+
+void DBLogger::reportLosses()
+{
+	uint64_t losses = droppedCount() + coalescedCount();
+	if(losses != m_reportedLosses)
+	{
+		Logger::warning("%s The logs can't be written fast enough, %llu samples dropped and %llu coalesced so far",
+			__PRETTY_FUNCTION__, (unsigned long long)droppedCount(), (unsigned long long)coalescedCount());
+		m_reportedLosses = losses;
+	}
+}
+
 template<typename FloatOrDouble>
 FloatOrDouble DBLogger::setValue(FloatOrDouble value) //Function to check if value is NaN before setting the value
 {
@@ -82,14 +323,27 @@ FloatOrDouble DBLogger::setValue(FloatOrDouble value) //Function to check if val
 
 void DBLogger::workerThread(DBLogger* ptr)
 {
-	while(ptr->m_working.load() == true)
+	std::vector<LogItem> batch;
+	batch.reserve(ptr->m_bufferSize);
+
+	while(true)
 	{
-		std::unique_lock<std::mutex> lk(ptr->m_mutex);
-		ptr->m_cv.wait(lk);
-		if(ptr->m_logBufferBack->size() > 0)
 		{
-			ptr->m_dbHandler.insertDataLogs(*ptr->m_logBufferBack);
-			ptr->m_logBufferBack->clear();
+			std::unique_lock<std::mutex> lk(ptr->m_mutex);
+			ptr->m_cv.wait(lk, [ptr] {
+				return not ptr->m_working.load() || ptr->queuedCount() >= ptr->m_bufferSize;
+			});
+		}
+
+		// Everything logged before stopping is in the ring by now
+		bool stopping = not ptr->m_working.load();
+
+		ptr->drain(batch);
+		ptr->reportLosses();
+
+		if(stopping)
+		{
+			return;
 		}
 	}
 }
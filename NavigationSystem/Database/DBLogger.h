@@ -8,43 +8,123 @@
  *		worker thread.
  *
  * Developer Notes:
+ *		The logs go to the database unless another LogSink is given, e.g. a
+ *		TelemetryLog.
  *
+ *		Logged items are queued in a bounded ring of preallocated slots, the worker
+ *		thread writes them out once bufferSize of them are waiting. The ring is lock-free
+ *		(a bounded queue with a sequence number per slot), log() only takes the mutex to
+ *		wake the worker up or, with the Block policy, to wait for room.
+ *
+ *		What happens when the sink can't keep up and the ring is full is chosen with a
+ *		LogBackpressure policy, the samples dropped or merged that way are counted and
+ *		reported by the worker thread.
  *
  ***************************************************************************************/
 
 #pragma once
 
+#include <stdint.h>
 #include <atomic>
 #include <condition_variable>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
 #include "DBHandler.h"
+#include "LogSink.h"
+
+// How many batches of bufferSize items the ring can hold
+#define DBLOGGER_RING_BATCHES 8
+
+enum class LogBackpressure {
+    Block,       // log() waits for room, nothing is lost
+    DropOldest,  // the oldest item waiting is discarded
+    Coalesce     // the items logged while the ring is full are merged, only the latest is kept
+};
 
 class DBLogger {
    public:
-    DBLogger(unsigned int LogBufferSize, DBHandler& dbHandler);
+    DBLogger(unsigned int LogBufferSize,
+             DBHandler& dbHandler,
+             LogSink* sink = NULL,
+             LogBackpressure policy = LogBackpressure::Block);
     ~DBLogger();
 
     void startWorkerThread();
 
-    void log(LogItem& item);
+    ///----------------------------------------------------------------------------------
+    /// Writes everything still queued to the sink and stops the worker thread.
+    ///----------------------------------------------------------------------------------
+    void stopWorkerThread();
+
+    ///----------------------------------------------------------------------------------
+    /// Queues a copy of the item. Must always be called from the same thread.
+    ///----------------------------------------------------------------------------------
+    void log(const LogItem& item);
 
     unsigned int bufferSize() { return m_bufferSize; }
 
+    unsigned int capacity() { return m_mask + 1; }
+
+    uint64_t loggedCount() const { return m_logged.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t coalescedCount() const { return m_coalesced.load(std::memory_order_relaxed); }
+
+    // How many times log() had to wait for room with the Block policy
+    uint64_t blockedCount() const { return m_blocked.load(std::memory_order_relaxed); }
+
    private:
+    struct LogSlot {
+        std::atomic<size_t> sequence;
+        LogItem item;
+    };
+
     template <typename FloatOrDouble>
     FloatOrDouble setValue(FloatOrDouble value);
 
+    // Only called by the thread logging
+    bool tryPush(const LogItem& item);
+
+    // Called by the worker thread, or by stopWorkerThread() when there is none
+    bool tryPop(LogItem* item);
+
+    // Called by the thread logging, takes the item at that position out of the ring
+    // unless the worker took it already
+    bool tryDrop(size_t position);
+
+    size_t queuedCount() const;
+
+    // Writes what is queued to the sink, in batches of at most bufferSize items
+    void drain(std::vector<LogItem>& batch);
+
+    void reportLosses();
+
     static void workerThread(DBLogger* ptr);
 
     std::thread* m_thread;
     std::atomic<bool> m_working;
     std::mutex m_mutex;
-    std::condition_variable m_cv;
-    DBHandler& m_dbHandler;
+    std::condition_variable m_cv;             // Wakes the worker up
+    std::condition_variable m_roomCondition;  // Wakes log() up with the Block policy
+    std::unique_ptr<LogSink> m_databaseSink;  // Only used when no other sink is given
+    LogSink* m_sink;
     unsigned int m_bufferSize;
-    std::vector<LogItem>* m_logBufferFront;
-    std::vector<LogItem>* m_logBufferBack;
+    LogBackpressure m_policy;
+
+    std::unique_ptr<LogSlot[]> m_slots;
+    size_t m_mask;  // The number of slots is a power of two
+    std::atomic<size_t> m_enqueuePos;
+    std::atomic<size_t> m_dequeuePos;
+
+    // Coalesce policy: the latest item which didn't fit in the ring yet
+    LogItem m_pending;
+    bool m_hasPending;
+
+    std::atomic<uint64_t> m_logged;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_coalesced;
+    std::atomic<uint64_t> m_blocked;
+    uint64_t m_reportedLosses;  // Only used by the worker thread
 };
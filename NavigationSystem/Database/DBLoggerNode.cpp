@@ -20,10 +20,10 @@
 //Debug for alternating current sensors
 //int debug_count = 0;
 
-DBLoggerNode::DBLoggerNode(MessageBus& msgBus, DBHandler& db,int queueSize)
+DBLoggerNode::DBLoggerNode(MessageBus& msgBus, DBHandler& db,int queueSize, LogSink* sink)
 :   ActiveNode(NodeID::DBLoggerNode, msgBus),
     m_db(db),
-    m_dbLogger(queueSize, db),
+    m_dbLogger(queueSize, db, sink),
     m_loopTime(0.5),
     m_queueSize(queueSize)
 
@@ -185,6 +185,7 @@ void DBLoggerNode::start() {
 void DBLoggerNode::stop() {
     m_Running.store(false);
     stopThread(this);
+    m_dbLogger.stopWorkerThread();
 }
 
 
@@ -202,6 +203,7 @@ void DBLoggerNode::DBLoggerNodeThreadFunc(ActiveNode* nodePtr) {
 
     DBLoggerNode* node = dynamic_cast<DBLoggerNode*> (nodePtr);
     std::string timestamp_str;
+    LogItem item;
     Timer timer;
     Timer timer2;
     timer.start();
@@ -214,10 +216,12 @@ void DBLoggerNode::DBLoggerNodeThreadFunc(ActiveNode* nodePtr) {
         timestamp_str+= ".";
         timestamp_str+= std::to_string(SysClock::millis());
 
-        node->item.m_timestamp_str = timestamp_str;
+        // Logging may wait for room in the logger, the messages keep being processed meanwhile
         node->m_lock.lock();
-        node->m_dbLogger.log(node->item);
+        node->item.m_timestamp_str = timestamp_str;
+        item = node->item;
         node->m_lock.unlock();
+        node->m_dbLogger.log(item);
         timer.sleepUntil(node->m_loopTime);
         timer.reset();
 
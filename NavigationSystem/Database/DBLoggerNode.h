@@ -10,7 +10,8 @@
 
 class DBLoggerNode : public ActiveNode {
    public:
-    DBLoggerNode(MessageBus& msgBus, DBHandler& db, int queueSize);
+    // The logs are written to the database unless another sink is given
+    DBLoggerNode(MessageBus& msgBus, DBHandler& db, int queueSize, LogSink* sink = NULL);
 
     void processMessage(const Message* message);
 
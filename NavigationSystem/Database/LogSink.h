@@ -0,0 +1,35 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		LogSink.h
+ *
+ * Purpose:
+ *		Where DBLogger writes its batches of LogItems. The default sink is the
+ *		database, TelemetryLog writes to a binary file instead.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <vector>
+#include "DBHandler.h"
+
+class LogSink {
+   public:
+    virtual ~LogSink() {}
+
+    ///----------------------------------------------------------------------------------
+    /// Writes a batch of logs, called from DBLogger's worker thread.
+    ///----------------------------------------------------------------------------------
+    virtual void writeLogs(std::vector<LogItem>& logs) = 0;
+};
+
+class DatabaseLogSink : public LogSink {
+   public:
+    DatabaseLogSink(DBHandler& dbHandler) : m_dbHandler(dbHandler) {}
+
+    void writeLogs(std::vector<LogItem>& logs) { m_dbHandler.insertDataLogs(logs); }
+
+   private:
+    DBHandler& m_dbHandler;
+};
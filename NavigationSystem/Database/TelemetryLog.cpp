@@ -0,0 +1,571 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		TelemetryLog.cpp
+ *
+ * Purpose:
+ *		A DBLogger sink writing the LogItems to an append-only, memory mapped binary file
+ *		instead of the database, and the reader used to import such a file into the
+ *		database afterwards.
+ *
+ * Developer Notes:
+ *		See TelemetryLog.h for the file layout.
+ *
+ ***************************************************************************************/
+
+
+#include "TelemetryLog.h"
+#include "../SystemServices/Logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+
+
+#define TELEMETRY_COLUMN_WIDTH(field, type)	sizeof(type) +
+#define TELEMETRY_COLUMN_ONE(field, type)	1 +
+
+// The timestamp and element_str columns aren't part of TELEMETRY_LOG_COLUMNS
+static const uint32_t TELEMETRY_ROW_SIZE = sizeof(int64_t) + TELEMETRY_LOG_COLUMNS(TELEMETRY_COLUMN_WIDTH) TELEMETRY_TEXT_LENGTH;
+static const uint32_t TELEMETRY_COLUMN_COUNT = 2 + TELEMETRY_LOG_COLUMNS(TELEMETRY_COLUMN_ONE) 0;
+
+static const uint64_t DATA_BLOCK_SIZE = sizeof(TelemetryBlockHeader) + (uint64_t)TELEMETRY_ROW_SIZE * TELEMETRY_BLOCK_ROWS;
+static const uint64_t INDEX_BLOCK_SIZE = sizeof(TelemetryBlockHeader) + sizeof(TelemetryIndexEntry) * TELEMETRY_INDEX_INTERVAL;
+
+
+// Columns aren't necessarily aligned for their type, memcpy compiles to a plain move
+// where unaligned accesses are allowed
+template<typename T>
+static void storeValue(uint8_t* column, uint32_t row, T value)
+{
+	memcpy(column + row * sizeof(T), &value, sizeof(T));
+}
+
+template<typename T>
+static T loadValue(const uint8_t* column, uint32_t row)
+{
+	T value;
+	memcpy(&value, column + row * sizeof(T), sizeof(T));
+	return value;
+}
+
+static bool validHeader(const TelemetryLogHeader* header)
+{
+	return strncmp(header->magic, TELEMETRY_LOG_MAGIC, sizeof(header->magic)) == 0 &&
+		header->version == TELEMETRY_LOG_VERSION && header->columnCount == TELEMETRY_COLUMN_COUNT &&
+		header->rowSize == TELEMETRY_ROW_SIZE && header->blockRows > 0;
+}
+
+
+int64_t parseLogTimestamp(const std::string& timestamp)
+{
+	struct tm time;
+	int milliseconds = 0;
+	memset(&time, 0, sizeof(time));
+
+	if(sscanf(timestamp.c_str(), "%d-%d-%d %d:%d:%d.%d", &time.tm_year, &time.tm_mon, &time.tm_mday,
+		&time.tm_hour, &time.tm_min, &time.tm_sec, &milliseconds) < 6)
+	{
+		return 0;
+	}
+
+	time.tm_year -= 1900;
+	time.tm_mon -= 1;
+	return (int64_t)timegm(&time) * 1000 + milliseconds;
+}
+
+std::string formatLogTimestamp(int64_t unixTimeMs)
+{
+	char date[24];
+	char timestamp[32];
+
+	time_t seconds = (time_t)(unixTimeMs / 1000);
+	strftime(date, sizeof(date), "%F %T", gmtime(&seconds));
+	// DBLoggerNode doesn't zero pad the milliseconds
+	snprintf(timestamp, sizeof(timestamp), "%s.%d", date, (int)(unixTimeMs % 1000));
+
+	return std::string(timestamp);
+}
+
+
+TelemetryLog::TelemetryLog()
+	:m_fd(-1), m_map(NULL), m_mappedSize(0), m_blockOffset(0)
+{
+	m_pendingIndex.reserve(TELEMETRY_INDEX_INTERVAL);
+}
+
+TelemetryLog::~TelemetryLog()
+{
+	close();
+}
+
+bool TelemetryLog::open(const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if(m_map != NULL)
+	{
+		Logger::error("%s Telemetry log already open", __PRETTY_FUNCTION__);
+		return false;
+	}
+
+	m_fd = ::open(filePath.c_str(), O_RDWR | O_CREAT, 0644);
+	struct stat fileStat;
+	if(m_fd < 0 || fstat(m_fd, &fileStat) != 0)
+	{
+		Logger::error("%s Could not open %s: %s", __PRETTY_FUNCTION__, filePath.c_str(), strerror(errno));
+		if(m_fd >= 0)
+		{
+			::close(m_fd);
+			m_fd = -1;
+		}
+		return false;
+	}
+
+	bool newFile = (fileStat.st_size == 0);
+	m_mappedSize = newFile ? TELEMETRY_GROW_SIZE : fileStat.st_size;
+
+	if((newFile && ftruncate(m_fd, m_mappedSize) != 0) || m_mappedSize < sizeof(TelemetryLogHeader))
+	{
+		Logger::error("%s %s is not a telemetry log", __PRETTY_FUNCTION__, filePath.c_str());
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	void* map = mmap(NULL, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	if(map == MAP_FAILED)
+	{
+		Logger::error("%s Could not map %s: %s", __PRETTY_FUNCTION__, filePath.c_str(), strerror(errno));
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+	m_map = static_cast<uint8_t*>(map);
+
+	if(newFile)
+	{
+		strncpy(header()->magic, TELEMETRY_LOG_MAGIC, sizeof(header()->magic));
+		header()->version = TELEMETRY_LOG_VERSION;
+		header()->blockRows = TELEMETRY_BLOCK_ROWS;
+		header()->columnCount = TELEMETRY_COLUMN_COUNT;
+		header()->rowSize = TELEMETRY_ROW_SIZE;
+		header()->committedSize = sizeof(TelemetryLogHeader);
+		header()->lastIndexOffset = 0;
+		return true;
+	}
+
+	if(not validHeader(header()) || header()->blockRows != TELEMETRY_BLOCK_ROWS ||
+		header()->committedSize > m_mappedSize)
+	{
+		Logger::error("%s %s was written with a different layout", __PRETTY_FUNCTION__, filePath.c_str());
+		munmap(m_map, m_mappedSize);
+		m_map = NULL;
+		::close(m_fd);
+		m_fd = -1;
+		return false;
+	}
+
+	// The blocks written since the last index block go into the next one
+	uint64_t offset = sizeof(TelemetryLogHeader);
+	if(header()->lastIndexOffset != 0)
+	{
+		offset = header()->lastIndexOffset + INDEX_BLOCK_SIZE;
+	}
+
+	while(offset + sizeof(TelemetryBlockHeader) <= header()->committedSize)
+	{
+		const TelemetryBlockHeader* block = reinterpret_cast<const TelemetryBlockHeader*>(m_map + offset);
+		if(block->size < sizeof(TelemetryBlockHeader) || offset + block->size > header()->committedSize)
+		{
+			break;
+		}
+
+		if(block->type == TELEMETRY_DATA_BLOCK && block->count > 0)
+		{
+			m_pendingIndex.push_back({ offset, block->firstTimeMs, block->lastTimeMs });
+		}
+		offset += block->size;
+	}
+
+	if(offset != header()->committedSize)
+	{
+		Logger::warning("%s Dropping the truncated end of %s", __PRETTY_FUNCTION__, filePath.c_str());
+		header()->committedSize = offset;
+	}
+
+	return true;
+}
+
+void TelemetryLog::close()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if(m_map == NULL)
+	{
+		return;
+	}
+
+	uint64_t committedSize = header()->committedSize;
+	msync(m_map, committedSize, MS_SYNC);
+	munmap(m_map, m_mappedSize);
+
+	// The rows written since the last index block are indexed again when reopening
+	if(ftruncate(m_fd, committedSize) != 0)
+	{
+		Logger::warning("%s Could not trim the telemetry log: %s", __PRETTY_FUNCTION__, strerror(errno));
+	}
+	::close(m_fd);
+
+	m_fd = -1;
+	m_map = NULL;
+	m_mappedSize = 0;
+	m_blockOffset = 0;
+	m_pendingIndex.clear();
+}
+
+void TelemetryLog::writeLogs(std::vector<LogItem>& logs)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if(m_map == NULL)
+	{
+		return;
+	}
+
+	for(const LogItem& item : logs)
+	{
+		// The log was closed when it couldn't grow nor be mapped again
+		if(m_map == NULL)
+		{
+			return;
+		}
+		append(item);
+	}
+}
+
+void TelemetryLog::flush()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if(m_map != NULL)
+	{
+		msync(m_map, header()->committedSize, MS_SYNC);
+	}
+}
+
+void TelemetryLog::append(const LogItem& item)
+{
+	if(m_blockOffset != 0 &&
+		reinterpret_cast<TelemetryBlockHeader*>(m_map + m_blockOffset)->count == TELEMETRY_BLOCK_ROWS)
+	{
+		endBlock();
+	}
+
+	if(m_blockOffset == 0 && not startBlock())
+	{
+		return;
+	}
+
+	TelemetryBlockHeader* block = reinterpret_cast<TelemetryBlockHeader*>(m_map + m_blockOffset);
+	uint8_t* column = m_map + m_blockOffset + sizeof(TelemetryBlockHeader);
+	uint32_t row = block->count;
+
+	int64_t timestamp = parseLogTimestamp(item.m_timestamp_str);
+	storeValue<int64_t>(column, row, timestamp);
+	column += sizeof(int64_t) * TELEMETRY_BLOCK_ROWS;
+
+	#define TELEMETRY_STORE_COLUMN(field, type) \
+		storeValue<type>(column, row, static_cast<type>(item.field)); \
+		column += sizeof(type) * TELEMETRY_BLOCK_ROWS;
+	TELEMETRY_LOG_COLUMNS(TELEMETRY_STORE_COLUMN)
+	#undef TELEMETRY_STORE_COLUMN
+
+	char* text = reinterpret_cast<char*>(column) + row * TELEMETRY_TEXT_LENGTH;
+	size_t length = std::min(item.m_element_str.size(), (size_t)TELEMETRY_TEXT_LENGTH - 1);
+	memcpy(text, item.m_element_str.data(), length);
+	memset(text + length, 0, TELEMETRY_TEXT_LENGTH - length);
+
+	if(row == 0)
+	{
+		block->firstTimeMs = timestamp;
+	}
+	block->lastTimeMs = timestamp;
+
+	// Only now is the row visible to readers
+	block->count = row + 1;
+}
+
+bool TelemetryLog::startBlock()
+{
+	if(m_pendingIndex.size() >= TELEMETRY_INDEX_INTERVAL && not writeIndexBlock())
+	{
+		return false;
+	}
+
+	if(not reserve(DATA_BLOCK_SIZE))
+	{
+		return false;
+	}
+
+	uint64_t offset = header()->committedSize;
+	TelemetryBlockHeader* block = reinterpret_cast<TelemetryBlockHeader*>(m_map + offset);
+	block->type = TELEMETRY_DATA_BLOCK;
+	block->count = 0;
+	block->size = DATA_BLOCK_SIZE;
+	block->previous = 0;
+	block->firstTimeMs = 0;
+	block->lastTimeMs = 0;
+
+	header()->committedSize = offset + DATA_BLOCK_SIZE;
+	m_blockOffset = offset;
+	return true;
+}
+
+void TelemetryLog::endBlock()
+{
+	const TelemetryBlockHeader* block = reinterpret_cast<const TelemetryBlockHeader*>(m_map + m_blockOffset);
+	m_pendingIndex.push_back({ m_blockOffset, block->firstTimeMs, block->lastTimeMs });
+
+	// The block won't change anymore, it can go to storage in one go
+	uint64_t pageSize = sysconf(_SC_PAGESIZE);
+	uint64_t start = m_blockOffset - (m_blockOffset % pageSize);
+	msync(m_map + start, m_blockOffset + DATA_BLOCK_SIZE - start, MS_ASYNC);
+
+	m_blockOffset = 0;
+}
+
+bool TelemetryLog::reserve(uint64_t size)
+{
+	uint64_t required = header()->committedSize + size;
+	if(required <= m_mappedSize)
+	{
+		return true;
+	}
+
+	uint64_t newSize = ((required / TELEMETRY_GROW_SIZE) + 1) * TELEMETRY_GROW_SIZE;
+
+	munmap(m_map, m_mappedSize);
+	m_map = NULL;
+
+	void* map = MAP_FAILED;
+	if(ftruncate(m_fd, newSize) == 0)
+	{
+		map = mmap(NULL, newSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+	}
+
+	if(map == MAP_FAILED)
+	{
+		// Keep what is already logged, the new rows are lost
+		Logger::error("%s Could not grow the telemetry log: %s", __PRETTY_FUNCTION__, strerror(errno));
+		map = mmap(NULL, m_mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+		if(map == MAP_FAILED)
+		{
+			::close(m_fd);
+			m_fd = -1;
+			m_mappedSize = 0;
+			m_blockOffset = 0;
+			return false;
+		}
+		m_map = static_cast<uint8_t*>(map);
+		return false;
+	}
+
+	m_map = static_cast<uint8_t*>(map);
+	m_mappedSize = newSize;
+	return true;
+}
+
+bool TelemetryLog::writeIndexBlock()
+{
+	if(not reserve(INDEX_BLOCK_SIZE))
+	{
+		return false;
+	}
+
+	uint64_t offset = header()->committedSize;
+	TelemetryBlockHeader* block = reinterpret_cast<TelemetryBlockHeader*>(m_map + offset);
+	block->type = TELEMETRY_INDEX_BLOCK;
+	block->count = m_pendingIndex.size();
+	block->size = INDEX_BLOCK_SIZE;
+	block->previous = header()->lastIndexOffset;
+	block->firstTimeMs = m_pendingIndex.front().firstTimeMs;
+	block->lastTimeMs = m_pendingIndex.back().lastTimeMs;
+	memcpy(m_map + offset + sizeof(TelemetryBlockHeader), m_pendingIndex.data(),
+		m_pendingIndex.size() * sizeof(TelemetryIndexEntry));
+
+	header()->committedSize = offset + INDEX_BLOCK_SIZE;
+	header()->lastIndexOffset = offset;
+	m_pendingIndex.clear();
+	return true;
+}
+
+
+TelemetryLogReader::TelemetryLogReader()
+	:m_fd(-1), m_map(NULL), m_mappedSize(0), m_size(0), m_blockRows(0), m_offset(0), m_row(0), m_timestamp(0)
+{
+}
+
+TelemetryLogReader::~TelemetryLogReader()
+{
+	close();
+}
+
+bool TelemetryLogReader::open(const std::string& filePath)
+{
+	close();
+
+	m_fd = ::open(filePath.c_str(), O_RDONLY);
+	struct stat fileStat;
+	if(m_fd < 0 || fstat(m_fd, &fileStat) != 0 || (uint64_t)fileStat.st_size < sizeof(TelemetryLogHeader))
+	{
+		Logger::error("%s Could not open %s", __PRETTY_FUNCTION__, filePath.c_str());
+		close();
+		return false;
+	}
+
+	void* map = mmap(NULL, fileStat.st_size, PROT_READ, MAP_SHARED, m_fd, 0);
+	if(map == MAP_FAILED)
+	{
+		Logger::error("%s Could not map %s: %s", __PRETTY_FUNCTION__, filePath.c_str(), strerror(errno));
+		close();
+		return false;
+	}
+	m_map = static_cast<const uint8_t*>(map);
+	m_mappedSize = fileStat.st_size;
+
+	const TelemetryLogHeader* header = reinterpret_cast<const TelemetryLogHeader*>(m_map);
+	if(not validHeader(header))
+	{
+		Logger::error("%s %s is not a telemetry log this version can read", __PRETTY_FUNCTION__, filePath.c_str());
+		close();
+		return false;
+	}
+
+	// Only the part already written, the rest is preallocated space
+	m_size = std::min(m_mappedSize, header->committedSize);
+	m_blockRows = header->blockRows;
+	m_offset = sizeof(TelemetryLogHeader);
+	m_row = 0;
+	return true;
+}
+
+void TelemetryLogReader::close()
+{
+	if(m_map != NULL)
+	{
+		munmap(const_cast<uint8_t*>(m_map), m_mappedSize);
+		m_map = NULL;
+		m_mappedSize = 0;
+		m_size = 0;
+	}
+	if(m_fd >= 0)
+	{
+		::close(m_fd);
+		m_fd = -1;
+	}
+}
+
+void TelemetryLogReader::seek(int64_t unixTimeMs)
+{
+	const TelemetryLogHeader* header = reinterpret_cast<const TelemetryLogHeader*>(m_map);
+	m_offset = sizeof(TelemetryLogHeader);
+	m_row = 0;
+
+	// Walks back to the oldest index block reaching the time
+	const TelemetryBlockHeader* found = NULL;
+	uint64_t indexOffset = header->lastIndexOffset;
+	while(indexOffset != 0)
+	{
+		const TelemetryBlockHeader* index = block(indexOffset);
+		if(index == NULL || index->type != TELEMETRY_INDEX_BLOCK || index->lastTimeMs < unixTimeMs)
+		{
+			break;
+		}
+		found = index;
+		indexOffset = index->previous;
+	}
+
+	if(found == NULL)
+	{
+		// Everything indexed is older, only the blocks after the last index block are left
+		const TelemetryBlockHeader* last = block(header->lastIndexOffset);
+		if(last != NULL && last->type == TELEMETRY_INDEX_BLOCK && last->lastTimeMs < unixTimeMs)
+		{
+			m_offset = header->lastIndexOffset + last->size;
+		}
+		return;
+	}
+
+	const uint8_t* entries = reinterpret_cast<const uint8_t*>(found) + sizeof(TelemetryBlockHeader);
+	for(uint32_t i = 0; i < found->count && i < TELEMETRY_INDEX_INTERVAL; i++)
+	{
+		TelemetryIndexEntry entry = loadValue<TelemetryIndexEntry>(entries, i);
+		if(entry.lastTimeMs >= unixTimeMs)
+		{
+			m_offset = entry.offset;
+			return;
+		}
+	}
+}
+
+bool TelemetryLogReader::next(LogItem& item)
+{
+	if(m_map == NULL)
+	{
+		return false;
+	}
+
+	const TelemetryBlockHeader* current = block(m_offset);
+	while(current != NULL && (current->type != TELEMETRY_DATA_BLOCK || m_row >= current->count ||
+		current->count > m_blockRows))
+	{
+		m_offset += current->size;
+		m_row = 0;
+		current = block(m_offset);
+	}
+
+	if(current == NULL)
+	{
+		return false;
+	}
+
+	const uint8_t* column = m_map + m_offset + sizeof(TelemetryBlockHeader);
+
+	m_timestamp = loadValue<int64_t>(column, m_row);
+	column += sizeof(int64_t) * m_blockRows;
+
+	#define TELEMETRY_LOAD_COLUMN(field, type) \
+		item.field = static_cast<decltype(item.field)>(loadValue<type>(column, m_row)); \
+		column += sizeof(type) * m_blockRows;
+	TELEMETRY_LOG_COLUMNS(TELEMETRY_LOAD_COLUMN)
+	#undef TELEMETRY_LOAD_COLUMN
+
+	const char* text = reinterpret_cast<const char*>(column) + m_row * TELEMETRY_TEXT_LENGTH;
+	item.m_element_str.assign(text, strnlen(text, TELEMETRY_TEXT_LENGTH));
+	item.m_timestamp_str = formatLogTimestamp(m_timestamp);
+
+	m_row++;
+	return true;
+}
+
+const TelemetryBlockHeader* TelemetryLogReader::block(uint64_t offset) const
+{
+	if(offset < sizeof(TelemetryLogHeader) || offset + sizeof(TelemetryBlockHeader) > m_size)
+	{
+		return NULL;
+	}
+
+	const TelemetryBlockHeader* header = reinterpret_cast<const TelemetryBlockHeader*>(m_map + offset);
+	if(header->size < sizeof(TelemetryBlockHeader) || offset + header->size > m_size)
+	{
+		return NULL;
+	}
+	return header;
+}
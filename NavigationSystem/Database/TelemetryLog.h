@@ -0,0 +1,219 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		TelemetryLog.h
+ *
+ * Purpose:
+ *		A DBLogger sink writing the LogItems to an append-only, memory mapped binary file
+ *		instead of the database, and the reader used to import such a file into the
+ *		database afterwards (see telemetry_log_converter.cpp).
+ *
+ * Developer Notes:
+ *		The file is a TelemetryLogHeader followed by blocks. A data block holds up to
+ *		TELEMETRY_BLOCK_ROWS rows stored column by column: every LogItem field has a
+ *		fixed width column of TELEMETRY_BLOCK_ROWS values, preceded by the timestamp
+ *		column (unix time in milliseconds). After every TELEMETRY_INDEX_INTERVAL data
+ *		blocks an index block lists their offsets and time spans, each index block
+ *		pointing to the previous one, so a reader can find a time without scanning the
+ *		whole file.
+ *
+ *		The file grows in steps of TELEMETRY_GROW_SIZE, the header's committedSize
+ *		tells how much of it is in use. A row is only counted in its block once all its
+ *		columns are written, and a block is only synced to storage once it is full (or
+ *		when the log is closed), the kernel writes the block being filled back on its
+ *		own schedule.
+ *
+ *		Values are stored in the byte order of the machine writing them.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DBHandler.h"
+#include "LogSink.h"
+
+#define TELEMETRY_LOG_MAGIC "SRTELEM"
+#define TELEMETRY_LOG_VERSION 1
+
+#define TELEMETRY_BLOCK_ROWS 256
+#define TELEMETRY_INDEX_INTERVAL 32
+#define TELEMETRY_GROW_SIZE (4 * 1024 * 1024)
+
+// Width of the element_str column, longer strings are truncated
+#define TELEMETRY_TEXT_LENGTH 24
+
+#define TELEMETRY_DATA_BLOCK 1
+#define TELEMETRY_INDEX_BLOCK 2
+
+// The fixed width columns, in the order they are stored in a block. The timestamp
+// column comes first and the element_str column last.
+#define TELEMETRY_LOG_COLUMNS(COLUMN)      \
+    COLUMN(m_rudderPosition, double)       \
+    COLUMN(m_wingsailPosition, double)     \
+    COLUMN(m_radioControllerOn, uint8_t)   \
+    COLUMN(m_windVaneAngle, double)        \
+    COLUMN(m_compassHeading, double)       \
+    COLUMN(m_compassPitch, double)         \
+    COLUMN(m_compassRoll, double)          \
+    COLUMN(m_distanceToWaypoint, double)   \
+    COLUMN(m_bearingToWaypoint, double)    \
+    COLUMN(m_courseToSteer, double)        \
+    COLUMN(m_tack, uint8_t)                \
+    COLUMN(m_goingStarboard, uint8_t)      \
+    COLUMN(m_gpsHasFix, uint8_t)           \
+    COLUMN(m_gpsOnline, uint8_t)           \
+    COLUMN(m_gpsLat, double)               \
+    COLUMN(m_gpsLon, double)               \
+    COLUMN(m_gpsUnixTime, double)          \
+    COLUMN(m_gpsSpeed, double)             \
+    COLUMN(m_gpsCourse, double)            \
+    COLUMN(m_gpsSatellite, int32_t)        \
+    COLUMN(m_routeStarted, uint8_t)        \
+    COLUMN(m_temperature, float)           \
+    COLUMN(m_conductivity, float)          \
+    COLUMN(m_ph, float)                    \
+    COLUMN(m_salinity, float)              \
+    COLUMN(m_vesselHeading, double)        \
+    COLUMN(m_vesselLat, double)            \
+    COLUMN(m_vesselLon, double)            \
+    COLUMN(m_vesselSpeed, double)          \
+    COLUMN(m_vesselCourse, double)         \
+    COLUMN(m_trueWindSpeed, double)        \
+    COLUMN(m_trueWindDir, double)          \
+    COLUMN(m_apparentWindSpeed, double)    \
+    COLUMN(m_apparentWindDir, double)      \
+    COLUMN(m_windDir, float)               \
+    COLUMN(m_windSpeed, float)             \
+    COLUMN(m_windTemp, float)              \
+    COLUMN(m_current, float)               \
+    COLUMN(m_voltage, float)               \
+    COLUMN(m_element, uint8_t)
+
+struct TelemetryLogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t blockRows;
+    uint32_t columnCount;
+    uint32_t rowSize;          // Sum of the column widths
+    uint64_t committedSize;    // Bytes of the file in use, the rest is preallocated
+    uint64_t lastIndexOffset;  // 0 until the first index block is written
+};
+
+struct TelemetryBlockHeader {
+    uint32_t type;      // TELEMETRY_DATA_BLOCK or TELEMETRY_INDEX_BLOCK
+    uint32_t count;     // Rows in a data block, entries in an index block
+    uint64_t size;      // Size of the whole block, header included
+    uint64_t previous;  // Index blocks: offset of the previous index block, 0 if none
+    int64_t firstTimeMs;
+    int64_t lastTimeMs;
+};
+
+struct TelemetryIndexEntry {
+    uint64_t offset;
+    int64_t firstTimeMs;
+    int64_t lastTimeMs;
+};
+
+///----------------------------------------------------------------------------------
+/// Parses a LogItem timestamp ("yyyy-mm-dd hh:mm:ss.ms", UTC) into unix time in
+/// milliseconds, returns 0 if it can't be parsed.
+///----------------------------------------------------------------------------------
+int64_t parseLogTimestamp(const std::string& timestamp);
+
+///----------------------------------------------------------------------------------
+/// The reverse of parseLogTimestamp.
+///----------------------------------------------------------------------------------
+std::string formatLogTimestamp(int64_t unixTimeMs);
+
+class TelemetryLog : public LogSink {
+   public:
+    TelemetryLog();
+    ~TelemetryLog();
+
+    ///----------------------------------------------------------------------------------
+    /// Opens the log, appending to it if it already exists. Returns false if the file
+    /// can't be mapped or was written with a different layout.
+    ///----------------------------------------------------------------------------------
+    bool open(const std::string& filePath);
+
+    ///----------------------------------------------------------------------------------
+    /// Syncs the file, trims the preallocated space and unmaps it.
+    ///----------------------------------------------------------------------------------
+    void close();
+
+    bool isOpen() const { return m_map != NULL; }
+
+    ///----------------------------------------------------------------------------------
+    /// Appends the rows, called by DBLogger's worker thread.
+    ///----------------------------------------------------------------------------------
+    void writeLogs(std::vector<LogItem>& logs);
+
+    ///----------------------------------------------------------------------------------
+    /// Writes everything logged so far to storage.
+    ///----------------------------------------------------------------------------------
+    void flush();
+
+   private:
+    void append(const LogItem& item);
+
+    // Starts a new data block, writing an index block first if one is due
+    bool startBlock();
+
+    // Records the current block in the pending index entries
+    void endBlock();
+
+    // Makes sure the mapping can hold size more bytes after the committed ones
+    bool reserve(uint64_t size);
+
+    bool writeIndexBlock();
+
+    TelemetryLogHeader* header() { return reinterpret_cast<TelemetryLogHeader*>(m_map); }
+
+    std::mutex m_mutex;
+    int m_fd;
+    uint8_t* m_map;
+    uint64_t m_mappedSize;
+    uint64_t m_blockOffset;  // The data block being filled, 0 if none
+    std::vector<TelemetryIndexEntry> m_pendingIndex;
+};
+
+class TelemetryLogReader {
+   public:
+    TelemetryLogReader();
+    ~TelemetryLogReader();
+
+    bool open(const std::string& filePath);
+    void close();
+
+    ///----------------------------------------------------------------------------------
+    /// Moves to the first block which may hold rows logged at or after the given time,
+    /// using the index blocks. Assumes the timestamps only go forward.
+    ///----------------------------------------------------------------------------------
+    void seek(int64_t unixTimeMs);
+
+    ///----------------------------------------------------------------------------------
+    /// Reads the next row, returns false at the end of the log.
+    ///----------------------------------------------------------------------------------
+    bool next(LogItem& item);
+
+    ///----------------------------------------------------------------------------------
+    /// Timestamp of the last row returned by next, in unix time milliseconds.
+    ///----------------------------------------------------------------------------------
+    int64_t timestamp() const { return m_timestamp; }
+
+   private:
+    const TelemetryBlockHeader* block(uint64_t offset) const;
+
+    int m_fd;
+    const uint8_t* m_map;
+    uint64_t m_mappedSize;
+    uint64_t m_size;  // The committed part of the mapping
+    uint32_t m_blockRows;
+    uint64_t m_offset;  // Current block
+    uint32_t m_row;     // Next row in the current block
+    int64_t m_timestamp;
+};
@@ -9,11 +9,11 @@ bool readConfig::exists(json &cfg, const std::string &key){
   return cfg[key]!=NULL;
 }
 
-void readConfig::waypointsInJson(json& wp, DBHandler db) {
+void readConfig::waypointsInJson(json& wp, DBHandler& db) {
   wp = db.getWaypoints();
 }
 
-bool readConfig::updateConfiguration(const std::string& file, DBHandler db) {
+bool readConfig::updateConfiguration(const std::string& file, DBHandler& db) {
   json cfg;
   readFromJsonFile(file, cfg);
   json idconst = {{"id", "1"}};
@@ -23,13 +23,13 @@ class readConfig {
     /*
      * Returns the waypoints in the db in the json object wp
      */
-    static void waypointsInJson(json& cfg, DBHandler db);
+    static void waypointsInJson(json& cfg, DBHandler& db);
 
     /*
      * Updates the database with the data in the file
      * (Reads the file and puts it in the database)
      */
-    static bool updateConfiguration(const std::string& file, DBHandler db);
+    static bool updateConfiguration(const std::string& file, DBHandler& db);
 
    private:
     /*
@@ -47,6 +47,7 @@ bool HTTPSyncNode::init() {
     m_shipID = m_dbHandler->retrieveCell("config_httpsync", "1", "boat_id");
     m_shipPWD = m_dbHandler->retrieveCell("config_httpsync", "1", "boat_pwd");
     updateConfigsFromDB();
+    m_logCursor = m_dbHandler->loadLogCursor();
 
     m_initialised = true;
 
@@ -120,16 +121,45 @@ void HTTPSyncNode::HTTPSyncThread(ActiveNode* nodePtr) {
 bool HTTPSyncNode::pushDatalogs() {
     std::string response = "";
 
-    if (performCURLCall(m_dbHandler->getLogs(m_pushOnlyLatestLogs), "pushAllLogs", response)) {
+    if (m_pushOnlyLatestLogs) {
+        if (performCURLCall(m_dbHandler->getLogs(true), "pushAllLogs", response)) {
+            // remove logs after push
+            if (m_removeLogs) {
+                m_dbHandler->clearLogs();
+            }
+            return true;
+        } else if (!m_reportedConnectError) {
+            Logger::warning("%s Could not push logs to server:", __PRETTY_FUNCTION__);
+        }
+        return false;
+    }
+
+    // Only the rows the server hasn't acknowledged yet are sent, a chunk at a time. The
+    // cursor only moves once a chunk went through, a failed chunk is sent again next time.
+    for (int chunk = 0; chunk < LOG_CHUNKS_PER_PUSH; chunk++) {
+        LogCursor cursor = m_logCursor;
+        std::string logs;
+
+        if (not m_dbHandler->getLogsSince(cursor, LOG_CHUNK_ROWS, logs)) {
+            break;
+        }
+
+        if (not performCURLCall(logs, "pushAllLogs", response)) {
+            if (!m_reportedConnectError) {
+                Logger::warning("%s Could not push logs to server:", __PRETTY_FUNCTION__);
+            }
+            return false;
+        }
+
+        m_logCursor = cursor;
+        m_dbHandler->saveLogCursor(m_logCursor);
+
         // remove logs after push
         if (m_removeLogs) {
-            m_dbHandler->clearLogs();
+            m_dbHandler->clearLogsUpTo(m_logCursor);
         }
-        return true;
-    } else if (!m_reportedConnectError) {
-        Logger::warning("%s Could not push logs to server:", __PRETTY_FUNCTION__);
     }
-    return false;
+    return true;
 }
 
 bool HTTPSyncNode::pushWaypoints() {
@@ -227,15 +257,18 @@ bool HTTPSyncNode::getWaypointsFromServer() {
     return false;
 }
 
-bool HTTPSyncNode::performCURLCall(std::string data, std::string call, std::string& response) {
-    std::string serverCall = "";
+bool HTTPSyncNode::performCURLCall(const std::string& data,
+                                   std::string call,
+                                   std::string& response) {
+    std::string serverCall =
+        "serv=" + call + "&id=" + m_shipID + "&gen=aspire" + "&pwd=" + m_shipPWD;
 
     // std::cout << "/* Request : " << call << " */" << '\n';
     if (data != "") {
-        serverCall = "serv=" + call + "&id=" + m_shipID + "&gen=aspire" + "&pwd=" + m_shipPWD +
-                     "&data=" + data;
-    } else {
-        serverCall = "serv=" + call + "&id=" + m_shipID + "&gen=aspire" + "&pwd=" + m_shipPWD;
+        // Appended in place, the logs can be large
+        serverCall.reserve(serverCall.size() + 6 + data.size());
+        serverCall += "&data=";
+        serverCall += data;
     }
     // example: serv=getAllConfigs&id=BOATID&pwd=BOATPW
     // std::cout << "/* Server call : " << serverCall.substr(0, 150) << " */" << '\n';
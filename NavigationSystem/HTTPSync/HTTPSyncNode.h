@@ -11,6 +11,12 @@
 #include <string>
 #include <thread>
 
+// How many rows of each log table are sent in one request
+#define LOG_CHUNK_ROWS 200
+// How many requests pushDatalogs makes at most, so a big backlog doesn't hold up the
+// config and waypoint syncing
+#define LOG_CHUNKS_PER_PUSH 10
+
 class HTTPSyncNode : public ActiveNode {
    public:
     HTTPSyncNode(MessageBus& msgBus, DBHandler* dbhandler);
@@ -50,7 +56,7 @@ class HTTPSyncNode : public ActiveNode {
     ///----------------------------------------------------------------------------------
     /// Sends server request in curl format - used for all syncing functionality
     ///----------------------------------------------------------------------------------
-    bool performCURLCall(std::string data, std::string call, std::string& response);
+    bool performCURLCall(const std::string& data, std::string call, std::string& response);
 
     bool checkIfNewConfigs();
     bool checkIfNewWaypoints();
@@ -83,6 +89,7 @@ class HTTPSyncNode : public ActiveNode {
     bool m_removeLogs;
     double m_LoopTime;  // units : seconds (ex : 0.5 s)
     int m_pushOnlyLatestLogs;
+    LogCursor m_logCursor;  // Last log rows acknowledged by the server
 
     std::atomic<bool> m_Running;
     DBHandler* m_dbHandler;
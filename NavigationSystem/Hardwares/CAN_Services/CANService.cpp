@@ -1,4 +1,5 @@
 #include "CANService.h"
+#include "MCP2515Transport.h"
 #include "can_rpi_defs.h"
 
 #include <fstream>
@@ -6,10 +7,49 @@
 #include <chrono>
 #include <thread>
 #include <future>
+#include <sstream>
+#include <stdio.h>
 #include <stdlib.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
 
 #define SLEEP_TIME_MS 50
 
+// Safety net in case an event is missed (e.g. an interrupt edge), the transport is read
+// at least this often
+#define CAN_INTERRUPT_TIMEOUT_MS 100
+
+// How often a transport which can't be waited on is read
+#define CAN_FALLBACK_POLL_MS 2
+
+// How soon sending is retried when the transport is busy
+#define CAN_TX_RETRY_MS 1
+
+CANService::CANService()
+  : m_LastEvictionMs(0), m_OwnedTransport(new MCP2515Transport()), m_Transport(*m_OwnedTransport),
+  m_Running(false), m_StatsEnabled(false), m_FinishReported(false)
+{
+  m_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  m_N2kMsg.Data.reserve(FAST_PACKET_MAX_LENGTH);
+}
+
+CANService::CANService(CANTransport& transport)
+  : m_LastEvictionMs(0), m_Transport(transport), m_Running(false), m_StatsEnabled(false),
+  m_FinishReported(false)
+{
+  m_WakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  m_N2kMsg.Data.reserve(FAST_PACKET_MAX_LENGTH);
+}
+
+CANService::~CANService()
+{
+  if(m_WakeFd >= 0)
+  {
+    close(m_WakeFd);
+  }
+}
+
 bool CANService::registerForReading(CANPGNReceiver& receiver, uint32_t PGN)
 {
 
@@ -42,8 +82,11 @@ bool CANService::registerForReading(CANFrameReceiver& receiver, uint32_t ID)
 
 void CANService::sendCANMessage(CanMsg& msg)
 {
-  std::lock_guard<std::mutex> lock (m_QueueMutex);
-  m_MsgQueue.push(msg);
+  {
+    std::lock_guard<std::mutex> lock (m_QueueMutex);
+    m_MsgQueue.push(msg);
+  }
+  wakeUp();
 }
 
 CanMsg CANService::getCANMessage()
@@ -58,77 +101,217 @@ std::future<void> CANService::start()
 {
 
   m_Running.store(true);
-  wiringPiSetup();
-  int SPISpeed = 1000000;
-
-	if(wiringPiSPISetup(CHANNEL, SPISpeed) == -1)	//channel, SPI speed
-	{
-		std::cout << "Could not setup wiring pi" << std::endl;
-	}
-
-  bool mcp_initialized = MCP2515_Init();
-  if(!mcp_initialized)
+  if(!m_Transport.open())
   {
-    std::cout << "Could not initialize hardware" << std::endl;
+    Logger::error("%s Could not open the CAN transport", __PRETTY_FUNCTION__);
   }
+
   return std::async(std::launch::async, &CANService::run, this);
 }
 
 void CANService::run()
 {
-  bool ParsedEntireMessage;
-  N2kMsg Nmsg;
   while(m_Running.load() == true)
   {
-    static CanMsg Cmsg;
+    // Frames arriving from now on wake the next poll up, so none is missed while reading
+    receiveFrames();
+    bool sentAll = sendQueuedFrames();
 
-    if(MCP2515_GetMessage(&Cmsg,0))
+    if(m_Transport.finished() && !m_FinishReported)
     {
-      if(Cmsg.header.ide == 1)
+      m_FinishReported = true;
+      if(m_StatsEnabled)
       {
-        ParsedEntireMessage = false;
-        IdToN2kMsg(Nmsg, Cmsg.id);
-        if (IsFastPackage(Nmsg)) {
-          ParsedEntireMessage = ParseFastPkg(Cmsg, Nmsg);
-        }
-        else {
-          CanMsgToN2kMsg(Cmsg, Nmsg);
-          ParsedEntireMessage = true;
-        }
-        auto receiverIt = m_RegisteredPGNReceivers.find(Nmsg.PGN);
-
-        if (ParsedEntireMessage) {
-          if(receiverIt != m_RegisteredPGNReceivers.end())
-          {  // Iterator is a pair, of which the second element is the actual receiver.
-            CANPGNReceiver* receiver = receiverIt->second;
-            receiver->processPGN(Nmsg);
-          }
+        std::stringstream report(statisticsReport());
+        std::string line;
+        while(std::getline(report, line))
+        {
+          Logger::info("%s", line.c_str());
         }
       }
+    }
 
-      else if(Cmsg.header.ide == 0)
-      {
-        auto receiverIt = m_RegisteredFrameReceivers.find(Cmsg.id);
+    int timeoutMs = (m_Transport.pollFd() >= 0) ? CAN_INTERRUPT_TIMEOUT_MS : CAN_FALLBACK_POLL_MS;
+    if(!sentAll)
+    {
+      timeoutMs = CAN_TX_RETRY_MS;
+    }
+    waitForEvent(timeoutMs);
+  }
+}
 
-        if(receiverIt != m_RegisteredFrameReceivers.end())
-        { // Iterator is a pair, of which the second element is the actual receiver.
-          CANFrameReceiver* receiver = receiverIt->second;
-          receiver->processFrameAndLogErrors(Cmsg);
-        }
-      }
-      else
-      {
-        std::cout << "Error: Cmsg.header.ide = " << Cmsg.header.ide;
-        std::cout << " - should be 0 or 1" << std::endl;
+void CANService::receiveFrames()
+{
+  CanMsg Cmsg;
+  while(m_Running.load() == true && m_Transport.receive(Cmsg))
+  {
+    if(!m_StatsEnabled)
+    {
+      processFrame(Cmsg);
+      continue;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    processFrame(Cmsg);
+    auto duration = std::chrono::steady_clock::now() - start;
+
+    uint32_t key = Cmsg.id;
+    if(Cmsg.header.ide == 1)
+    {
+      key = m_N2kMsg.PGN;
+    }
+    recordFrameTime(Cmsg.header.ide == 1, key,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+  }
+}
+
+void CANService::processFrame(CanMsg& Cmsg)
+{
+  if(Cmsg.header.ide == 1)
+  {
+    N2kMsg& Nmsg = m_N2kMsg;
+    bool ParsedEntireMessage = false;
+    IdToN2kMsg(Nmsg, Cmsg.id);
+    if (IsFastPackage(Nmsg)) {
+      ParsedEntireMessage = ParseFastPkg(Cmsg, Nmsg);
+    }
+    else {
+      CanMsgToN2kMsg(Cmsg, Nmsg);
+      ParsedEntireMessage = true;
+    }
+    auto receiverIt = m_RegisteredPGNReceivers.find(Nmsg.PGN);
+
+    if (ParsedEntireMessage) {
+      if(receiverIt != m_RegisteredPGNReceivers.end())
+      {  // Iterator is a pair, of which the second element is the actual receiver.
+        CANPGNReceiver* receiver = receiverIt->second;
+        receiver->processPGN(Nmsg);
       }
     }
+  }
+
+  else if(Cmsg.header.ide == 0)
+  {
+    auto receiverIt = m_RegisteredFrameReceivers.find(Cmsg.id);
 
-    if(!m_MsgQueue.empty())
+    if(receiverIt != m_RegisteredFrameReceivers.end())
+    { // Iterator is a pair, of which the second element is the actual receiver.
+      CANFrameReceiver* receiver = receiverIt->second;
+      receiver->processFrameAndLogErrors(Cmsg);
+    }
+  }
+  else
+  {
+    std::cout << "Error: Cmsg.header.ide = " << Cmsg.header.ide;
+    std::cout << " - should be 0 or 1" << std::endl;
+  }
+}
+
+bool CANService::sendQueuedFrames()
+{
+  std::lock_guard<std::mutex> lock (m_QueueMutex);
+  while(!m_MsgQueue.empty())
+  {
+    // Keep the frame queued until the transport accepts it
+    if(!m_Transport.send(m_MsgQueue.front()))
+    {
+      return false;
+    }
+    m_MsgQueue.pop();
+  }
+  return true;
+}
+
+void CANService::waitForEvent(int timeoutMs)
+{
+  struct pollfd fds[2];
+  int count = 0;
+
+  fds[count].fd = m_WakeFd;
+  fds[count].events = POLLIN;
+  count++;
+
+  if(m_Transport.pollFd() >= 0)
+  {
+    fds[count].fd = m_Transport.pollFd();
+    fds[count].events = m_Transport.pollEvents();
+    count++;
+  }
+
+  if(poll(fds, count, timeoutMs) <= 0)
+  {
+    return;
+  }
+
+  if(fds[0].revents & POLLIN)
+  {
+    uint64_t value;
+    if(read(m_WakeFd, &value, sizeof(value)) < 0)
     {
-      CanMsg CmsgSend = getCANMessage();
-      MCP2515_SendMessage(&CmsgSend, 0);
+      // Nothing to clear, another read got it
     }
   }
+
+  if(count > 1 && (fds[1].revents & fds[1].events))
+  {
+    m_Transport.acknowledge();
+  }
+}
+
+void CANService::wakeUp()
+{
+  uint64_t one = 1;
+  if(m_WakeFd >= 0 && write(m_WakeFd, &one, sizeof(one)) < 0)
+  {
+    // The counter is already signalled
+  }
+}
+
+void CANService::enableStatistics()
+{
+  m_StatsEnabled = true;
+}
+
+std::string CANService::statisticsReport()
+{
+  std::lock_guard<std::mutex> lock(m_StatsMutex);
+  std::stringstream report;
+  char line[192];
+
+  for(int extended = 1; extended >= 0; extended--)
+  {
+    for(auto& entry : extended ? m_PGNStats : m_FrameStats)
+    {
+      const CANFrameStats& stats = entry.second;
+      double seconds = stats.totalNs / 1e9;
+      snprintf(line, sizeof(line), "%s %u: %llu frames, mean %.1f us, max %.1f us, capacity %.0f frames/s",
+        extended ? "PGN" : "Frame id", entry.first, (unsigned long long)stats.count,
+        stats.totalNs / 1000.0 / stats.count, stats.maxNs / 1000.0,
+        seconds > 0 ? stats.count / seconds : 0.0);
+      report << line << "\n";
+    }
+  }
+
+  const FastPacketStats& fastPackets = m_FastPackets.stats();
+  snprintf(line, sizeof(line), "Fast packets: %llu completed, %llu started, %llu orphaned, %llu timed out, "
+    "%llu evicted, at most %u in progress", (unsigned long long)fastPackets.completed,
+    (unsigned long long)fastPackets.started, (unsigned long long)fastPackets.orphaned,
+    (unsigned long long)fastPackets.timedOut, (unsigned long long)fastPackets.evicted,
+    fastPackets.maxInProgress);
+  report << line << "\n";
+  return report.str();
+}
+
+void CANService::recordFrameTime(bool extended, uint32_t key, uint64_t durationNs)
+{
+  std::lock_guard<std::mutex> lock(m_StatsMutex);
+  CANFrameStats& stats = (extended ? m_PGNStats : m_FrameStats)[key];
+  stats.count++;
+  stats.totalNs += durationNs;
+  if(durationNs > stats.maxNs)
+  {
+    stats.maxNs = durationNs;
+  }
 }
 
 void CANService::SetLoopBackMode()
@@ -165,70 +348,20 @@ bool CANService::checkMissedMessages()
 void CANService::stop()
 {
   m_Running.store(false);
+  wakeUp();
 }
 
 bool CANService::ParseFastPkg(CanMsg& msg, N2kMsg& nMsg) {
-  /*
-  * More in-depth about fast packages:
-  * All messages have a data part 8 bytes long but some of it is used to ID the message
-  * The first message has message ID and sequnce ID and Number in byte 0
-  * and how many bytes the entire fast package is in byte 1
-  * Bytes 2-7 is the actual data
-  * The rest of the messages will have the message ID and Sequnce number and ID in byte 0
-  * and the rest of the bytes (1-7) will contain the data!
-  */
-
-	IDsID Key = IDsID(msg.id, msg.data[0]&0xE0);		//message ID and sequence ID
-	uint8_t SequenceNumber = msg.data[0]&0x1F;
-
-	auto it = FastPackages.find(Key);
-
-  if(SequenceNumber != 0) {				//have parts of the message already
-		int LastByte;
-    if (it == FastPackages.end()) { // Not in the map, even though SequenceNumber > 0 -> message received in wrong order
-      return false;
-    } else if (FastPackages[Key].latestSeqnumber+1 != SequenceNumber) { // Messages received in wrong order, remove the key entirely to avoid memory issues (It will get resent later)
-      FastPackages.erase(Key);
-      return false;
-    }
-		if(it->second.bytesLeft >= 7)	{		//check if less than 7 bytes left, 1st byte is the sequence ID and Sequence number followed by 7 bytes of data
-			LastByte = 8;
-		}
-		else {
-			LastByte = it->second.bytesLeft +1;
-		}
-
-		for(int i = 1; i < LastByte; ++i) {
-			FastPackages[Key].n2kmsg.Data[6+(SequenceNumber-1)*7 +i-1] = msg.data[i];
-		}
-		it->second.bytesLeft -= 7;				//decrease bytes left
-    it->second.latestSeqnumber = SequenceNumber;
-		if(it->second.bytesLeft <= 0) {	//have the whole message, erase key and return true
-			nMsg = FastPackages[Key].n2kmsg;
-			FastPackages.erase(Key);
-			return true;
-		}
-		else { // Still bytes left to be received from another message
-			return false;
-		}
-	}
-	else {        //not found, create new N2kMsg
-		uint8_t BytesInMsg = msg.data[1];
-		nMsg.DataLen = BytesInMsg;
-		nMsg.Data.resize(BytesInMsg);
-		for(int i = 2; i < 8; ++i) {
-			nMsg.Data[i-2] = msg.data[i];
-		}
-		if(BytesInMsg <= 6) {
-			return true;
-		}
-		else {
-			FastPackages[Key].bytesLeft = BytesInMsg-6;		//how many bytes left
-      FastPackages[Key].latestSeqnumber = SequenceNumber;
-			FastPackages[Key].n2kmsg = nMsg;
-			return false;
-		}
-	}
+  int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+
+  // Packets from a device which went quiet would otherwise hold their slot until the table is full
+  if(nowMs - m_LastEvictionMs >= FAST_PACKET_TIMEOUT_MS) {
+    m_FastPackets.evictStale(nowMs);
+    m_LastEvictionMs = nowMs;
+  }
+
+  return m_FastPackets.addFrame(msg, nMsg, nowMs);
 }
 
 bool CANService::IsFastPackage(const N2kMsg &nMsg) {
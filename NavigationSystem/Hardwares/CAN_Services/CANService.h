@@ -8,39 +8,55 @@
  *
  *
  * Developer Notes:
+ *		The frames come from a CANTransport, the MCP2515 unless another one is given.
+ *		The service thread sleeps in poll() until the transport has frames (for the
+ *		MCP2515, a falling edge of its interrupt line) or a frame is queued for
+ *		sending, so it uses no CPU while the bus is idle. A transport which can't be
+ *		waited on is checked every CAN_FALLBACK_POLL_MS.
  *
+ *		SetLoopBackMode, SetNormalMode and checkMissedMessages talk to the MCP2515
+ *		directly whatever the transport.
  *
- *
- *
+ *		Fast packets are put back together by a FastPacketAssembler and every frame is
+ *		decoded into the same N2kMsg, so receiving does no heap allocation.
  *
  ***************************************************************************************/
 
 #pragma once
 
+#include <stdint.h>
 #include <atomic>
 #include <future>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <string>
 #include <vector>
 #include "../SystemServices/Logger.h"
 #include "CANFrameReceiver.h"
 #include "CANPGNReceiver.h"
+#include "CANTransport.h"
+#include "FastPacketAssembler.h"
 #include "N2kMsg.h"
 #include "mcp2515.h"
 
-struct FastPKGInfo {
-    N2kMsg n2kmsg;
-    int bytesLeft;
-    uint8_t latestSeqnumber;
+// Time spent processing the frames of one PGN (or standard frame id)
+struct CANFrameStats {
+    uint64_t count;
+    uint64_t totalNs;
+    uint64_t maxNs;
 };
 
 class CANService {
    public:
-    CANService() {}
+    /* Uses the MCP2515 on the SPI bus */
+    CANService();
 
-    ~CANService() {}
+    /* Uses the given transport, which must outlive the service */
+    CANService(CANTransport& transport);
+
+    ~CANService();
 
     /*  Registers a CAN receiver with an associated PGN-number     *
      *  which will receive any message with that number sent into  *
@@ -69,12 +85,38 @@ class CANService {
     /* Stops the service */
     void stop();
 
+    /* Times the processing of every frame, per PGN. Call before start() */
+    void enableStatistics();
+
+    /* One line per PGN or frame id: frames processed, mean and max time *
+     * and the resulting throughput                                      */
+    std::string statisticsReport();
+
+    /* Only consistent once the service is stopped */
+    FastPacketStats fastPacketStats() const { return m_FastPackets.stats(); }
+
    private:
     /* Starts the CANService */
     void run();
 
+    /* Reads every frame waiting in the transport and hands them to the receivers */
+    void receiveFrames();
+
+    void processFrame(CanMsg& Cmsg);
+
+    /* Sends the queued frames, returns false if some are still waiting *
+     * for the transport to accept them                                 */
+    bool sendQueuedFrames();
+
+    /* Blocks until the transport has frames, wakeUp() is called or the timeout expires */
+    void waitForEvent(int timeoutMs);
+
+    void wakeUp();
+
+    void recordFrameTime(bool extended, uint32_t key, uint64_t durationNs);
+
     /* Recieves and parses the fast messages and stores everything *
-     * in the N2kMsg                                               */
+     * in the N2kMsg once the last frame is received               */
     bool ParseFastPkg(CanMsg& msg, N2kMsg& nMsg);
 
     /* Checks if the message is a NMEA2000 fast package */
@@ -84,9 +126,21 @@ class CANService {
 
     std::map<uint32_t, CANPGNReceiver*> m_RegisteredPGNReceivers;
     std::map<uint32_t, CANFrameReceiver*> m_RegisteredFrameReceivers;
-    std::map<IDsID, FastPKGInfo> FastPackages;
+    FastPacketAssembler m_FastPackets;
+    int64_t m_LastEvictionMs;
+    N2kMsg m_N2kMsg;  // Every frame received is decoded into it
     std::queue<CanMsg> m_MsgQueue;
     std::mutex m_QueueMutex;
 
+    std::unique_ptr<CANTransport> m_OwnedTransport;  // Only set by the default constructor
+    CANTransport& m_Transport;
+
     std::atomic<bool> m_Running;
+    int m_WakeFd;  // eventfd signalled when a frame is queued or the service stops
+
+    bool m_StatsEnabled;
+    bool m_FinishReported;
+    std::mutex m_StatsMutex;
+    std::map<uint32_t, CANFrameStats> m_PGNStats;
+    std::map<uint32_t, CANFrameStats> m_FrameStats;
 };
@@ -0,0 +1,275 @@
+#include "CANTrace.h"
+#include "../SystemServices/Logger.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/timerfd.h>
+
+// Buffer of the recorded log, written out when full or when the recorder is destroyed
+#define RECORD_BUFFER_SIZE (64 * 1024)
+
+static int hexValue(char c)
+{
+  if(c >= '0' && c <= '9') return c - '0';
+  if(c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if(c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+bool parseCandumpLine(const std::string& line, double& timestamp, CanMsg& msg)
+{
+  const char* text = line.c_str();
+  char* end;
+
+  // (seconds.micros)
+  const char* open = strchr(text, '(');
+  if(open == NULL)
+  {
+    return false;
+  }
+  timestamp = strtod(open + 1, &end);
+  if(end == open + 1 || *end != ')')
+  {
+    return false;
+  }
+
+  // The interface name, then the frame
+  const char* frame = strchr(end + 1, ' ');
+  if(frame != NULL)
+  {
+    frame = strchr(frame + 1, ' ');
+  }
+  if(frame == NULL)
+  {
+    return false;
+  }
+  frame++;
+
+  const char* hash = strchr(frame, '#');
+  if(hash == NULL || hash[1] == '#' || hash[1] == 'R')
+  {
+    // CAN FD or remote frame
+    return false;
+  }
+
+  size_t idDigits = hash - frame;
+  uint32_t id = 0;
+  for(size_t i = 0; i < idDigits; i++)
+  {
+    int value = hexValue(frame[i]);
+    if(value < 0)
+    {
+      return false;
+    }
+    id = (id << 4) | value;
+  }
+
+  memset(&msg, 0, sizeof(msg));
+  msg.id = id;
+  msg.header.ide = (idDigits > 3) ? 1 : 0;
+
+  uint8_t length = 0;
+  const char* data = hash + 1;
+  while(length < 8 && hexValue(data[0]) >= 0 && hexValue(data[1]) >= 0)
+  {
+    msg.data[length++] = (hexValue(data[0]) << 4) | hexValue(data[1]);
+    data += 2;
+  }
+  msg.header.length = length;
+  return true;
+}
+
+std::string formatCandumpLine(double timestamp, const std::string& interface, const CanMsg& msg)
+{
+  char line[96];
+  int length = snprintf(line, sizeof(line), msg.header.ide ? "(%.6f) %s %08X#" : "(%.6f) %s %03X#",
+    timestamp, interface.c_str(), msg.id);
+
+  for(int i = 0; i < msg.header.length && i < 8 && length + 2 < (int)sizeof(line); i++)
+  {
+    length += snprintf(line + length, sizeof(line) - length, "%02X", msg.data[i]);
+  }
+  return std::string(line);
+}
+
+
+CANTraceRecorder::CANTraceRecorder(std::unique_ptr<CANTransport> transport,
+  const std::string& filePath, const std::string& interface)
+  : m_Transport(std::move(transport)), m_FilePath(filePath), m_Interface(interface), m_File(NULL)
+{
+}
+
+CANTraceRecorder::~CANTraceRecorder()
+{
+  if(m_File != NULL)
+  {
+    fclose(m_File);
+  }
+}
+
+bool CANTraceRecorder::open()
+{
+  if(m_File == NULL)
+  {
+    m_File = fopen(m_FilePath.c_str(), "a");
+    if(m_File == NULL)
+    {
+      Logger::error("%s Could not open %s: %s", __PRETTY_FUNCTION__, m_FilePath.c_str(), strerror(errno));
+    }
+    else
+    {
+      setvbuf(m_File, NULL, _IOFBF, RECORD_BUFFER_SIZE);
+    }
+  }
+  return m_Transport->open();
+}
+
+bool CANTraceRecorder::receive(CanMsg& msg)
+{
+  if(m_Transport->receive(msg))
+  {
+    record(msg);
+    return true;
+  }
+  return false;
+}
+
+bool CANTraceRecorder::send(CanMsg& msg)
+{
+  if(m_Transport->send(msg))
+  {
+    record(msg);
+    return true;
+  }
+  return false;
+}
+
+void CANTraceRecorder::record(const CanMsg& msg)
+{
+  if(m_File == NULL)
+  {
+    return;
+  }
+
+  struct timeval now;
+  gettimeofday(&now, NULL);
+  double timestamp = now.tv_sec + now.tv_usec / 1000000.0;
+
+  fprintf(m_File, "%s\n", formatCandumpLine(timestamp, m_Interface, msg).c_str());
+}
+
+
+CANTraceReplayer::CANTraceReplayer(const std::string& filePath, double speed)
+  : m_FilePath(filePath), m_Speed(speed), m_TimerFd(-1), m_NextDueNs(0), m_FirstTimestamp(-1),
+  m_StartNs(0), m_Finished(true), m_Replayed(0), m_Sent(0)
+{
+}
+
+CANTraceReplayer::~CANTraceReplayer()
+{
+  if(m_TimerFd >= 0)
+  {
+    close(m_TimerFd);
+  }
+}
+
+bool CANTraceReplayer::open()
+{
+  m_File.open(m_FilePath);
+  if(!m_File.is_open())
+  {
+    Logger::error("%s Could not open %s", __PRETTY_FUNCTION__, m_FilePath.c_str());
+    return false;
+  }
+
+  if(m_TimerFd < 0)
+  {
+    m_TimerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  }
+
+  m_StartNs = monotonicNs();
+  m_FirstTimestamp = -1;
+  m_Finished = false;
+  readNext();
+  return true;
+}
+
+bool CANTraceReplayer::receive(CanMsg& msg)
+{
+  if(m_Finished)
+  {
+    return false;
+  }
+
+  if(m_NextDueNs > monotonicNs())
+  {
+    // Wakes CANService up when the frame is due
+    struct itimerspec timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = m_NextDueNs / 1000000000;
+    timer.it_value.tv_nsec = m_NextDueNs % 1000000000;
+    timerfd_settime(m_TimerFd, TFD_TIMER_ABSTIME, &timer, NULL);
+    return false;
+  }
+
+  msg = m_Next;
+  m_Replayed++;
+  readNext();
+  return true;
+}
+
+bool CANTraceReplayer::send(CanMsg& /*msg*/)
+{
+  m_Sent++;
+  return true;
+}
+
+void CANTraceReplayer::acknowledge()
+{
+  uint64_t expirations;
+  if(read(m_TimerFd, &expirations, sizeof(expirations)) < 0)
+  {
+    // Already read, nothing to clear
+  }
+}
+
+void CANTraceReplayer::readNext()
+{
+  std::string line;
+  double timestamp;
+
+  while(std::getline(m_File, line))
+  {
+    if(!parseCandumpLine(line, timestamp, m_Next))
+    {
+      continue;
+    }
+
+    if(m_FirstTimestamp < 0)
+    {
+      m_FirstTimestamp = timestamp;
+    }
+
+    m_NextDueNs = m_StartNs;
+    if(m_Speed > 0)
+    {
+      m_NextDueNs += (int64_t)((timestamp - m_FirstTimestamp) / m_Speed * 1e9);
+    }
+    return;
+  }
+
+  m_Finished = true;
+  Logger::info("%s Replayed %llu frames from %s", __PRETTY_FUNCTION__,
+    (unsigned long long)m_Replayed, m_FilePath.c_str());
+}
+
+int64_t CANTraceReplayer::monotonicNs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
@@ -0,0 +1,111 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		CANTrace.h
+ *
+ * Purpose:
+ *		Records the frames going through a CAN transport to a candump log, and replays
+ *		such a log (recorded on the boat, or with 'candump -l can0') as a transport, so
+ *		the CAN nodes can be run and load tested off the boat.
+ *
+ * Developer Notes:
+ *		The candump log format has one frame per line:
+ *
+ *			(1436509052.249713) can0 19F51323#01020304AABBCCDD
+ *
+ *		an 8 digit id being an extended (NMEA2000) frame and a 3 digit id a standard
+ *		one. Remote and CAN FD frames are skipped when replaying.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "CANTransport.h"
+
+/* Parses a line of a candump log, returns false if it doesn't hold a frame */
+bool parseCandumpLine(const std::string& line, double& timestamp, CanMsg& msg);
+
+std::string formatCandumpLine(double timestamp, const std::string& interface, const CanMsg& msg);
+
+class CANTraceRecorder : public CANTransport {
+   public:
+    /* Records the frames received and sent through the transport, *
+     * the interface is only the name written in the log           */
+    CANTraceRecorder(std::unique_ptr<CANTransport> transport,
+                     const std::string& filePath,
+                     const std::string& interface = "can0");
+    ~CANTraceRecorder();
+
+    bool open();
+
+    bool receive(CanMsg& msg);
+
+    bool send(CanMsg& msg);
+
+    int pollFd() const { return m_Transport->pollFd(); }
+
+    short pollEvents() const { return m_Transport->pollEvents(); }
+
+    void acknowledge() { m_Transport->acknowledge(); }
+
+    bool finished() const { return m_Transport->finished(); }
+
+   private:
+    void record(const CanMsg& msg);
+
+    std::unique_ptr<CANTransport> m_Transport;
+    std::string m_FilePath;
+    std::string m_Interface;
+    FILE* m_File;
+};
+
+class CANTraceReplayer : public CANTransport {
+   public:
+    /* Replays the log at the given speed (1 is real time, 100 a hundred times faster), *
+     * 0 replays it as fast as the frames can be processed                             */
+    CANTraceReplayer(const std::string& filePath, double speed = 1);
+    ~CANTraceReplayer();
+
+    bool open();
+
+    /* Returns the next frame once it is due */
+    bool receive(CanMsg& msg);
+
+    /* Frames sent by the nodes are counted and discarded */
+    bool send(CanMsg& msg);
+
+    /* A timer expiring when the next frame is due */
+    int pollFd() const { return m_TimerFd; }
+
+    void acknowledge();
+
+    bool finished() const { return m_Finished; }
+
+    uint64_t replayedCount() const { return m_Replayed; }
+    uint64_t sentCount() const { return m_Sent; }
+
+   private:
+    /* Reads the next frame of the log, sets m_Finished at the end */
+    void readNext();
+
+    static int64_t monotonicNs();
+
+    std::string m_FilePath;
+    double m_Speed;
+    std::ifstream m_File;
+    int m_TimerFd;
+
+    CanMsg m_Next;
+    int64_t m_NextDueNs;  // CLOCK_MONOTONIC time the next frame is due at
+    double m_FirstTimestamp;
+    int64_t m_StartNs;
+    bool m_Finished;
+
+    uint64_t m_Replayed;
+    uint64_t m_Sent;
+};
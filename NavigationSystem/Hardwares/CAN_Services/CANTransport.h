@@ -0,0 +1,46 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		CANTransport.h
+ *
+ * Purpose:
+ *		Where CANService gets its frames from and sends them to: the MCP2515 over SPI
+ *		(MCP2515Transport), a SocketCAN interface (SocketCANTransport) or a recorded
+ *		candump trace (CANTraceReplayer).
+ *
+ * Developer Notes:
+ *		A transport never blocks. CANService waits on pollFd() for pollEvents() and
+ *		then reads with receive() until it returns false.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <poll.h>
+#include "N2kMsg.h"
+
+class CANTransport {
+   public:
+    virtual ~CANTransport() {}
+
+    /* Prepares the hardware or opens the interface */
+    virtual bool open() = 0;
+
+    /* Reads the next frame, returns false if none is waiting */
+    virtual bool receive(CanMsg& msg) = 0;
+
+    /* Sends a frame, returns false if it can't be sent right now and should be retried */
+    virtual bool send(CanMsg& msg) = 0;
+
+    /* File descriptor becoming ready when frames arrive, -1 if the transport can't be *
+     * waited on and has to be polled                                                   */
+    virtual int pollFd() const { return -1; }
+
+    virtual short pollEvents() const { return POLLIN; }
+
+    /* Called once pollFd() is ready, before the frames are read */
+    virtual void acknowledge() {}
+
+    /* True once a transport with a finite amount of frames has delivered them all */
+    virtual bool finished() const { return false; }
+};
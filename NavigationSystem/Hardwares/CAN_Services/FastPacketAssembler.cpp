@@ -0,0 +1,220 @@
+#include "FastPacketAssembler.h"
+
+#include <string.h>
+
+// PGNs are 18 bits long, so no key made from a PGN and a source address is ever this
+#define FAST_PACKET_EMPTY_KEY 0xFFFFFFFF
+
+#define FAST_PACKET_SLOT_MASK (FAST_PACKET_SLOTS - 1)
+
+// How many packets can be in progress before the oldest one is dropped, keeping the probes short
+#define FAST_PACKET_MAX_IN_PROGRESS (FAST_PACKET_SLOTS * 3 / 4)
+
+// Data bytes in the first frame of a packet and in the following ones
+#define FIRST_FRAME_DATA 6
+#define NEXT_FRAME_DATA 7
+
+FastPacketAssembler::FastPacketAssembler()
+  : m_InProgress(0)
+{
+  memset(&m_Stats, 0, sizeof(m_Stats));
+  for(int i = 0; i < FAST_PACKET_SLOTS; i++)
+  {
+    m_Slots[i].key = FAST_PACKET_EMPTY_KEY;
+  }
+}
+
+bool FastPacketAssembler::addFrame(const CanMsg& frame, N2kMsg& msg, int64_t nowMs)
+{
+  uint32_t key = makeKey(msg.PGN, msg.Source);
+  uint8_t sequenceId = frame.data[0] & 0xE0;
+  uint8_t frameNumber = frame.data[0] & 0x1F;
+
+  if(frameNumber == 0)
+  {
+    uint8_t length = frame.data[1];
+    m_Stats.started++;
+
+    int index = find(key);
+
+    if(length <= FIRST_FRAME_DATA)
+    {
+      if(index >= 0)
+      {
+        remove(index);
+        m_Stats.orphaned++;
+      }
+      msg.DataLen = length;
+      msg.Data.assign(frame.data + 2, frame.data + 2 + length);
+      m_Stats.completed++;
+      return true;
+    }
+
+    if(length > FAST_PACKET_MAX_LENGTH)
+    {
+      m_Stats.orphaned++;
+      return false;
+    }
+
+    if(index >= 0)
+    {
+      // The packet in progress never got its last frames, start over
+      m_Stats.orphaned++;
+    }
+    else
+    {
+      index = insert(key);
+    }
+
+    Slot& slot = m_Slots[index];
+    slot.sequenceId = sequenceId;
+    slot.nextFrame = 1;
+    slot.length = length;
+    slot.received = FIRST_FRAME_DATA;
+    slot.lastFrameMs = nowMs;
+    memcpy(slot.data, frame.data + 2, FIRST_FRAME_DATA);
+    return false;
+  }
+
+  int index = find(key);
+  if(index < 0 || m_Slots[index].sequenceId != sequenceId)
+  {
+    // Its first frame was missed
+    m_Stats.orphaned++;
+    return false;
+  }
+
+  Slot& slot = m_Slots[index];
+  if(nowMs - slot.lastFrameMs > FAST_PACKET_TIMEOUT_MS)
+  {
+    remove(index);
+    m_Stats.timedOut++;
+    return false;
+  }
+  if(slot.nextFrame != frameNumber)
+  {
+    // A frame was missed, the packet will be sent again
+    remove(index);
+    m_Stats.orphaned++;
+    return false;
+  }
+
+  int count = slot.length - slot.received;
+  if(count > NEXT_FRAME_DATA)
+  {
+    count = NEXT_FRAME_DATA;
+  }
+  memcpy(slot.data + slot.received, frame.data + 1, count);
+  slot.received += count;
+  slot.nextFrame++;
+  slot.lastFrameMs = nowMs;
+
+  if(slot.received < slot.length)
+  {
+    return false;
+  }
+
+  msg.DataLen = slot.length;
+  msg.Data.assign(slot.data, slot.data + slot.length);
+  remove(index);
+  m_Stats.completed++;
+  return true;
+}
+
+void FastPacketAssembler::evictStale(int64_t nowMs)
+{
+  int i = 0;
+  while(i < FAST_PACKET_SLOTS)
+  {
+    if(m_Slots[i].key != FAST_PACKET_EMPTY_KEY && nowMs - m_Slots[i].lastFrameMs > FAST_PACKET_TIMEOUT_MS)
+    {
+      // Another packet may be moved into this slot, so check it again
+      remove(i);
+      m_Stats.timedOut++;
+    }
+    else
+    {
+      i++;
+    }
+  }
+}
+
+uint32_t FastPacketAssembler::home(uint32_t key)
+{
+  // Fibonacci hashing, the PGNs of one device only differ in a few bits
+  return ((key * 2654435761u) >> 16) & FAST_PACKET_SLOT_MASK;
+}
+
+int FastPacketAssembler::find(uint32_t key) const
+{
+  uint32_t index = home(key);
+  while(m_Slots[index].key != FAST_PACKET_EMPTY_KEY)
+  {
+    if(m_Slots[index].key == key)
+    {
+      return index;
+    }
+    index = (index + 1) & FAST_PACKET_SLOT_MASK;
+  }
+  return -1;
+}
+
+int FastPacketAssembler::insert(uint32_t key)
+{
+  if(m_InProgress >= FAST_PACKET_MAX_IN_PROGRESS)
+  {
+    int oldest = -1;
+    for(int i = 0; i < FAST_PACKET_SLOTS; i++)
+    {
+      if(m_Slots[i].key != FAST_PACKET_EMPTY_KEY &&
+        (oldest < 0 || m_Slots[i].lastFrameMs < m_Slots[oldest].lastFrameMs))
+      {
+        oldest = i;
+      }
+    }
+    remove(oldest);
+    m_Stats.evicted++;
+  }
+
+  uint32_t index = home(key);
+  while(m_Slots[index].key != FAST_PACKET_EMPTY_KEY)
+  {
+    index = (index + 1) & FAST_PACKET_SLOT_MASK;
+  }
+
+  m_Slots[index].key = key;
+  m_InProgress++;
+  if(m_InProgress > m_Stats.maxInProgress)
+  {
+    m_Stats.maxInProgress = m_InProgress;
+  }
+  return index;
+}
+
+void FastPacketAssembler::remove(int index)
+{
+  uint32_t hole = index;
+  uint32_t next = index;
+
+  while(true)
+  {
+    next = (next + 1) & FAST_PACKET_SLOT_MASK;
+    if(m_Slots[next].key == FAST_PACKET_EMPTY_KEY)
+    {
+      break;
+    }
+
+    // The packet can fill the hole unless its home slot lies between the hole and itself
+    uint32_t slotHome = home(m_Slots[next].key);
+    bool canMove = (next > hole) ? (slotHome <= hole || slotHome > next)
+                                 : (slotHome <= hole && slotHome > next);
+    if(canMove)
+    {
+      m_Slots[hole] = m_Slots[next];
+      hole = next;
+    }
+  }
+
+  m_Slots[hole].key = FAST_PACKET_EMPTY_KEY;
+  m_InProgress--;
+}
@@ -0,0 +1,93 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		FastPacketAssembler.h
+ *
+ * Purpose:
+ *		Puts NMEA2000 fast packets (e.g. the AIS PGNs) back together from their frames.
+ *
+ * Developer Notes:
+ *		The first frame of a fast packet holds the sequence id and frame counter in
+ *		byte 0, the length of the whole packet in byte 1 and 6 bytes of data. The
+ *		following frames hold the sequence id and frame counter in byte 0 and 7 bytes
+ *		of data, so a packet is at most 6 + 31 * 7 = 223 bytes.
+ *
+ *		The packets being assembled are kept in a fixed table of FAST_PACKET_SLOTS
+ *		slots, found by hashing the PGN and source address (open addressing with linear
+ *		probing), each slot holding the data in place. Nothing is allocated once the
+ *		assembler is constructed, provided the N2kMsg handed in already has room for
+ *		FAST_PACKET_MAX_LENGTH bytes.
+ *
+ *		A packet whose next frame doesn't come within FAST_PACKET_TIMEOUT_MS is
+ *		dropped, as is the oldest packet when the table is full.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include "N2kMsg.h"
+
+#define FAST_PACKET_MAX_LENGTH 223
+
+// Must be a power of two, at most three quarters of the slots are used
+#define FAST_PACKET_SLOTS 64
+
+// NMEA2000 requires the frames of a fast packet to be sent within 750 ms of each other
+#define FAST_PACKET_TIMEOUT_MS 750
+
+struct FastPacketStats {
+    uint64_t completed;  // Packets put back together
+    uint64_t started;    // First frames received
+    uint64_t orphaned;   // Frames received without their first frame, or out of order
+    uint64_t timedOut;   // Packets whose next frame never came
+    uint64_t evicted;    // Packets dropped to make room in a full table
+    uint32_t maxInProgress;
+};
+
+class FastPacketAssembler {
+   public:
+    FastPacketAssembler();
+
+    ///----------------------------------------------------------------------------------
+    /// Adds a frame of a fast packet. Once the packet is complete its data is copied to
+    /// msg and true is returned. The PGN and source of msg must already be set from the
+    /// frame id.
+    ///----------------------------------------------------------------------------------
+    bool addFrame(const CanMsg& frame, N2kMsg& msg, int64_t nowMs);
+
+    /* Drops the packets which haven't had a frame in FAST_PACKET_TIMEOUT_MS */
+    void evictStale(int64_t nowMs);
+
+    uint32_t inProgress() const { return m_InProgress; }
+
+    const FastPacketStats& stats() const { return m_Stats; }
+
+   private:
+    struct Slot {
+        uint32_t key;  // FAST_PACKET_EMPTY_KEY when free
+        uint8_t sequenceId;
+        uint8_t nextFrame;
+        uint8_t length;
+        uint8_t received;
+        int64_t lastFrameMs;
+        uint8_t data[FAST_PACKET_MAX_LENGTH];
+    };
+
+    static uint32_t makeKey(uint32_t PGN, uint8_t source) { return (PGN << 8) | source; }
+
+    static uint32_t home(uint32_t key);
+
+    /* Index of the slot holding the key, -1 if there is none */
+    int find(uint32_t key) const;
+
+    /* Claims a slot for the key, dropping the oldest packet if the table is full */
+    int insert(uint32_t key);
+
+    /* Frees the slot and moves the following ones back so every key stays reachable */
+    void remove(int index);
+
+    Slot m_Slots[FAST_PACKET_SLOTS];
+    uint32_t m_InProgress;
+    FastPacketStats m_Stats;
+};
@@ -0,0 +1,121 @@
+#include "MCP2515Transport.h"
+#include "can_rpi_defs.h"
+#include "mcp2515.h"
+#include "../SystemServices/Logger.h"
+
+#include <fstream>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+// How long to wait for udev to give access to a freshly exported GPIO
+#define GPIO_EXPORT_WAIT_MS 50
+
+MCP2515Transport::MCP2515Transport()
+  : m_InterruptFd(-1)
+{
+}
+
+MCP2515Transport::~MCP2515Transport()
+{
+  if(m_InterruptFd >= 0)
+  {
+    close(m_InterruptFd);
+  }
+}
+
+bool MCP2515Transport::open()
+{
+  wiringPiSetup();
+  int SPISpeed = 1000000;
+
+	if(wiringPiSPISetup(CHANNEL, SPISpeed) == -1)	//channel, SPI speed
+	{
+		std::cout << "Could not setup wiring pi" << std::endl;
+	}
+
+  bool mcp_initialized = MCP2515_Init();
+  if(!mcp_initialized)
+  {
+    std::cout << "Could not initialize hardware" << std::endl;
+  }
+
+  if(m_InterruptFd < 0)
+  {
+    m_InterruptFd = openInterruptPin(CAN_INTERRUPT_GPIO);
+    if(m_InterruptFd < 0)
+    {
+      Logger::warning("%s Can't use the MCP2515 interrupt pin, the chip will be polled", __PRETTY_FUNCTION__);
+    }
+  }
+  return mcp_initialized;
+}
+
+bool MCP2515Transport::receive(CanMsg& msg)
+{
+  return MCP2515_GetMessage(&msg, 0);
+}
+
+bool MCP2515Transport::send(CanMsg& msg)
+{
+  // 0 when every transmit buffer is busy
+  return MCP2515_SendMessage(&msg, 0) != 0;
+}
+
+void MCP2515Transport::acknowledge()
+{
+  char value[4];
+  lseek(m_InterruptFd, 0, SEEK_SET);
+  if(read(m_InterruptFd, value, sizeof(value)) < 0)
+  {
+    Logger::warning("%s Could not read the interrupt pin: %s", __PRETTY_FUNCTION__, strerror(errno));
+  }
+}
+
+int MCP2515Transport::openInterruptPin(int gpio)
+{
+  std::string pin = std::to_string(gpio);
+  std::string directory = "/sys/class/gpio/gpio" + pin;
+
+  // Already exported if the directory exists
+  if(access(directory.c_str(), F_OK) != 0)
+  {
+    std::ofstream exportFile("/sys/class/gpio/export");
+    exportFile << pin;
+    exportFile.close();
+
+    // udev may take a moment to make the new files accessible
+    std::this_thread::sleep_for(std::chrono::milliseconds(GPIO_EXPORT_WAIT_MS));
+  }
+
+  std::ofstream direction(directory + "/direction");
+  direction << "in";
+  direction.close();
+
+  // The MCP2515 pulls INT low while a received frame is waiting
+  std::ofstream edge(directory + "/edge");
+  edge << "falling";
+  edge.close();
+  if(edge.fail())
+  {
+    return -1;
+  }
+
+  int fd = ::open((directory + "/value").c_str(), O_RDONLY | O_CLOEXEC);
+  if(fd >= 0)
+  {
+    // Clear the initial state so the first poll waits for an edge
+    char value[4];
+    if(read(fd, value, sizeof(value)) < 0)
+    {
+      close(fd);
+      return -1;
+    }
+  }
+  return fd;
+}
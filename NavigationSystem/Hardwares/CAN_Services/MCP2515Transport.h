@@ -0,0 +1,43 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MCP2515Transport.h
+ *
+ * Purpose:
+ *		Frames to and from the MCP2515 CAN controller on the SPI bus.
+ *
+ * Developer Notes:
+ *		Frames are waited for on the MCP2515 interrupt line, a falling edge on
+ *		CAN_INTERRUPT_GPIO watched through sysfs. If that pin can't be set up, pollFd()
+ *		is -1 and CANService polls the chip instead.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "CANTransport.h"
+
+class MCP2515Transport : public CANTransport {
+   public:
+    MCP2515Transport();
+    ~MCP2515Transport();
+
+    bool open();
+
+    bool receive(CanMsg& msg);
+
+    bool send(CanMsg& msg);
+
+    int pollFd() const { return m_InterruptFd; }
+
+    short pollEvents() const { return POLLPRI | POLLERR; }
+
+    /* Reading the value of the pin acknowledges the edge */
+    void acknowledge();
+
+   private:
+    /* Exports the GPIO through sysfs and returns a file to poll for falling edges, -1 on failure */
+    static int openInterruptPin(int gpio);
+
+    int m_InterruptFd;  // sysfs value file of the interrupt pin, -1 if not available
+};
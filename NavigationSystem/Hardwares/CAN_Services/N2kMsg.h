@@ -5,8 +5,6 @@
 #include <vector>
 #include "CanBusCommon/canbus_defs.h"
 
-typedef std::tuple<uint32_t, uint8_t> IDsID;
-
 struct N2kMsg {
     uint32_t PGN;
     uint8_t Priority;
@@ -0,0 +1,129 @@
+#include "SocketCANTransport.h"
+#include "../SystemServices/Logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+
+SocketCANTransport::SocketCANTransport(const std::string& interface)
+  : m_Interface(interface), m_Socket(-1)
+{
+}
+
+SocketCANTransport::~SocketCANTransport()
+{
+  if(m_Socket >= 0)
+  {
+    close(m_Socket);
+  }
+}
+
+bool SocketCANTransport::open()
+{
+  if(m_Socket >= 0)
+  {
+    return true;
+  }
+
+  m_Socket = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, CAN_RAW);
+  if(m_Socket < 0)
+  {
+    Logger::error("%s Could not create a CAN socket: %s", __PRETTY_FUNCTION__, strerror(errno));
+    return false;
+  }
+
+  struct ifreq request;
+  memset(&request, 0, sizeof(request));
+  strncpy(request.ifr_name, m_Interface.c_str(), IFNAMSIZ - 1);
+
+  struct sockaddr_can address;
+  memset(&address, 0, sizeof(address));
+  address.can_family = AF_CAN;
+
+  bool bound = false;
+  if(ioctl(m_Socket, SIOCGIFINDEX, &request) == 0)
+  {
+    address.can_ifindex = request.ifr_ifindex;
+    bound = (bind(m_Socket, (struct sockaddr*)&address, sizeof(address)) == 0);
+  }
+
+  if(!bound)
+  {
+    Logger::error("%s Could not open the CAN interface %s: %s", __PRETTY_FUNCTION__,
+      m_Interface.c_str(), strerror(errno));
+    close(m_Socket);
+    m_Socket = -1;
+    return false;
+  }
+
+  return true;
+}
+
+bool SocketCANTransport::receive(CanMsg& msg)
+{
+  if(m_Socket < 0)
+  {
+    return false;
+  }
+
+  struct can_frame frame;
+  while(read(m_Socket, &frame, sizeof(frame)) == sizeof(frame))
+  {
+    // Remote and error frames aren't used on the boat
+    if(frame.can_id & (CAN_RTR_FLAG | CAN_ERR_FLAG))
+    {
+      continue;
+    }
+
+    if(frame.can_id & CAN_EFF_FLAG)
+    {
+      msg.header.ide = 1;
+      msg.id = frame.can_id & CAN_EFF_MASK;
+    }
+    else
+    {
+      msg.header.ide = 0;
+      msg.id = frame.can_id & CAN_SFF_MASK;
+    }
+
+    msg.header.length = frame.can_dlc;
+    memcpy(msg.data, frame.data, sizeof(msg.data));
+    return true;
+  }
+  return false;
+}
+
+bool SocketCANTransport::send(CanMsg& msg)
+{
+  if(m_Socket < 0)
+  {
+    // Nowhere to send it, retrying won't help
+    return true;
+  }
+
+  struct can_frame frame;
+  memset(&frame, 0, sizeof(frame));
+  frame.can_id = msg.header.ide ? ((msg.id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (msg.id & CAN_SFF_MASK);
+  frame.can_dlc = msg.header.length;
+  memcpy(frame.data, msg.data, sizeof(frame.data));
+
+  if(write(m_Socket, &frame, sizeof(frame)) == sizeof(frame))
+  {
+    return true;
+  }
+
+  // The transmit queue of the interface is full
+  if(errno == EAGAIN || errno == ENOBUFS)
+  {
+    return false;
+  }
+
+  Logger::warning("%s Could not send a frame on %s: %s", __PRETTY_FUNCTION__, m_Interface.c_str(), strerror(errno));
+  return true;
+}
@@ -0,0 +1,36 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		SocketCANTransport.h
+ *
+ * Purpose:
+ *		Frames to and from a Linux SocketCAN interface, e.g. can0 with a kernel driver
+ *		for the MCP2515, or a virtual vcan0 to run the CAN nodes on any Linux box:
+ *
+ *			sudo modprobe vcan
+ *			sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <string>
+#include "CANTransport.h"
+
+class SocketCANTransport : public CANTransport {
+   public:
+    SocketCANTransport(const std::string& interface);
+    ~SocketCANTransport();
+
+    bool open();
+
+    bool receive(CanMsg& msg);
+
+    bool send(CanMsg& msg);
+
+    int pollFd() const { return m_Socket; }
+
+   private:
+    std::string m_Interface;
+    int m_Socket;
+};
@@ -3,4 +3,7 @@
 
 #define CHANNEL 0
 
+// BCM number of the GPIO the MCP2515 INT pin is wired to (GPIO 25 on the PiCAN2)
+#define CAN_INTERRUPT_GPIO 25
+
 #endif
@@ -19,7 +19,6 @@
 #include <cstring>
 
 #include <stdio.h>
-#include <regex>
 
 #include <unistd.h>
 #include <cerrno>
@@ -109,11 +108,7 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 	CV7Node* node = dynamic_cast<CV7Node*> (nodePtr);
 
 	const int DATA_BUFFER_SIZE = 1;
-	const int BUFF_SIZE = 255;
-	char buffer[BUFF_SIZE];
 
-
-	std::string buffer_to_parse;
 	std::vector<float> windDirData(DATA_BUFFER_SIZE);
 	std::vector<float> windSpeedData(DATA_BUFFER_SIZE);
 	std::vector<float> windTempData(DATA_BUFFER_SIZE);
@@ -123,7 +118,6 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 
 
 	Logger::info("Wind sensor thread  ");
-	buffer_to_parse.reserve(255);
 
 	float windDir = 0;
 	float windSpeed = 0;
@@ -134,7 +128,6 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
     int bytes = 0;
 		wait_time.tv_sec = 10;
 		wait_time.tv_usec = 0;
-		bzero(buffer, BUFF_SIZE);
 
     FD_ZERO(&fd_read_set);
     FD_SET(node->m_fd, &fd_read_set);
@@ -144,7 +137,14 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 
     if (FD_ISSET(node->m_fd, &fd_read_set))
     {
-        bytes = read(node->m_fd, buffer, BUFF_SIZE);
+        // Read straight into the parser, it is drained below so there is always room
+        char* at;
+        size_t space = node->m_Parser.writable(at);
+        bytes = read(node->m_fd, at, space);
+        if(bytes > 0)
+        {
+            node->m_Parser.commit(bytes);
+        }
     }
 		else
 		{
@@ -155,10 +155,7 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 		// Parse the data and send out messages
 		if(bytes > 0 )
 		{
-			buffer_to_parse+=buffer;
-
-      //Logger::info("buffer windsensor %s",buffer_to_parse.c_str());
-			if(node->parseString(buffer_to_parse, windDir, windSpeed, windTemp))
+			if(node->parseSentences(windDir, windSpeed, windTemp))
 			{
 				if(windDirData.size() < DATA_BUFFER_SIZE)
 				{
@@ -192,55 +189,44 @@ void CV7Node::WindSensorThread(ActiveNode* nodePtr)
 	}
 }
 
-bool CV7Node::parseString(std::string& buffer_to_parse, float& windDir, float& windSpeed, float& windTemp) const
+bool CV7Node::parse(const char* data, size_t length, float& windDir, float& windSpeed, float& windTemp)
 {
-	const int IIMWV = 0;
-	const int WIXDR = 1;
-	bool updated[] = { false, false };
-	/*"$IIMWV,%03.1f,R,%03.1f,M,*AB
-	   $WIXDR,C,%03.1f,C,,*AB",*/
-	std::regex iimwv_regex ("\\$IIMWV,([^,]{0,6}),.,([^,]{0,6}),.,[^\\$]{0,4}\\n?");
-	std::regex wixdir_regex ("\\$WIXDR,.,([^,]{0,6}),.,.?,[^\\$]{0,4}");
-
-  // erase everything before first $ -
-  std::size_t found_begin = buffer_to_parse.find_first_of("$");
-  buffer_to_parse.erase(0,found_begin);
-	//----------------------------------
-
-  if (buffer_to_parse.size()>0)
+	bool updated = false;
+	size_t written = 0;
+
+	// More than the parser buffers is parsed a buffer at a time
+	while(written < length)
 	{
+		written += m_Parser.write(data + written, length - written);
+		updated |= parseSentences(windDir, windSpeed, windTemp);
+	}
+	return updated;
+}
 
-		std::smatch sm;
-		bool erase = false;
+bool CV7Node::parseSentences(float& windDir, float& windSpeed, float& windTemp)
+{
+	/*"$IIMWV,%03.1f,R,%03.1f,N,A*hh
+	   $WIXDR,C,%03.1f,C,,*hh",*/
+	bool updated = false;
+	NMEASentence sentence;
 
-		/* while there still interesting data in the buffer*/
-		while(std::regex_search (buffer_to_parse,iimwv_regex) || std::regex_search (buffer_to_parse,wixdir_regex))
+	while(m_Parser.next(sentence))
+	{
+		if(sentence.is("IIMWV"))
 		{
-      erase = true;
-			/*get the specific match string with regex groups (with smatch)*/
-			if(std::regex_search( buffer_to_parse, sm,iimwv_regex ))
+			// The last field is V when the sensor has no valid reading
+			float direction, speed;
+			if(strcmp(sentence.field(5), "V") != 0 && sentence.toFloat(1, direction) && sentence.toFloat(3, speed))
 			{
-				windDir = stof(sm[1].str()); //sm[1] is the first substring in parenthesis in the regular expression
-				windSpeed = stof(sm[2].str());
-				updated[IIMWV] = true;
+				windDir = direction;
+				windSpeed = speed;
+				updated = true;
 			}
-			else
-			{
-				std::regex_search ( buffer_to_parse, sm,wixdir_regex );
-        windTemp = stof(sm[1].str());
-				updated[WIXDR] = true;
-			}
-			buffer_to_parse.erase(sm.position(0),sm[0].str().size());//erase the match from buffer
-
 		}
-		if (erase)// if find match in buffer erase everything before the match
+		else if(sentence.is("WIXDR") && strcmp(sentence.field(1), "C") == 0)
 		{
-		  buffer_to_parse.erase(0,sm.position(0));
+			sentence.toFloat(2, windTemp);
 		}
 	}
-	else
-	{
-		return false;
-	}
-	return (updated[IIMWV]); //|| updated[WIXDR]); we dont care much for temperature for the moment
+	return updated; // we dont care much for temperature for the moment
 }
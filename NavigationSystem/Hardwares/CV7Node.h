@@ -16,6 +16,7 @@
 #include <map>
 #include "../Database/DBHandler.h"
 #include "../MessageBus/ActiveNode.h"
+#include "NMEAParser.h"
 
 class CV7Node : public ActiveNode {
    public:
@@ -43,27 +44,36 @@ class CV7Node : public ActiveNode {
     void processMessage(const Message* message);
 
     ///----------------------------------------------------------------------------------
-    /// The CV7 Node's thread function.
+    /// Parses the wind sensor's NMEA sentences in the data, and returns true if a wind
+    /// reading was parsed. The data that is parsed is put into a number of referenced
+    /// values. A sentence cut at the end of the data completes with the next call.
+    ///
+    ///	@param data			The bytes read from the sensor
+    ///	@param length		The number of bytes
+    ///	@param windDir		Extracted from the $IIMWV sentence, the direction of the wind.
+    ///	@param windSpeed	Extracted from the $IIMWV sentence, the speed of the wind.
+    /// @param windTemp		Extracted from the $WIXDR sentence, the temperature of the wind.
+    ///
+    /// @returns			Returns true if a wind reading was parsed.
     ///
     ///----------------------------------------------------------------------------------
-    bool parseString(std::string& buffer_to_parse,
-                     float& windDir,
-                     float& windSpeed,
-                     float& windTemp) const;
+    bool parse(const char* data,
+               size_t length,
+               float& windDir,
+               float& windSpeed,
+               float& windTemp);
 
    private:
     void updateConfigsFromDB();
 
     ///----------------------------------------------------------------------------------
-    /// Parses a NMEA wind sensor string and returns true if the parse was successful.
-    /// The data that is parsed is put into a number of referenced values.
-    ///
-    ///	@param buffer		Pointer to the char buffer with data in it
-    ///	@param windDir		Extracted from the NMEA string, the direction of the wind.
-    ///	@param windSpeed	Extracted from the NMEA string, the speed of the wind.
-    /// @param windTemp		Extracted from the NMEA string, the temperature of the wind.
+    /// Parses the sentences buffered in the parser, see parse().
     ///
-    /// @returns			Returns true if the buffer was successfully parsed.
+    ///----------------------------------------------------------------------------------
+    bool parseSentences(float& windDir, float& windSpeed, float& windTemp);
+
+    ///----------------------------------------------------------------------------------
+    /// The CV7 Node's thread function.
     ///
     ///----------------------------------------------------------------------------------
     static void WindSensorThread(ActiveNode* nodePtr);
@@ -77,4 +87,5 @@ class CV7Node : public ActiveNode {
     float m_MeanWindTemp;
     double m_LoopTime;
     DBHandler& m_db;
+    NMEAParser m_Parser;
 };
@@ -0,0 +1,221 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NMEAParser.cpp
+ *
+ * Purpose:
+ *		Picks the NMEA 0183 sentences out of the bytes read from a serial sensor.
+ *
+ * Developer Notes:
+ *
+ *
+ ***************************************************************************************/
+
+#include "NMEAParser.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NMEA_BUFFER_MASK (NMEA_BUFFER_SIZE - 1)
+
+
+// Returns the value of a hex digit, -1 if it isn't one
+static int hexValue(char c)
+{
+	if(c >= '0' && c <= '9')
+	{
+		return c - '0';
+	}
+	if(c >= 'A' && c <= 'F')
+	{
+		return c - 'A' + 10;
+	}
+	if(c >= 'a' && c <= 'f')
+	{
+		return c - 'a' + 10;
+	}
+	return -1;
+}
+
+bool NMEASentence::is(const char* address) const
+{
+	return m_FieldCount > 0 && strcmp(m_Fields[0], address) == 0;
+}
+
+bool NMEASentence::toFloat(unsigned int index, float& value) const
+{
+	const char* text = field(index);
+	if(text[0] == '\0')
+	{
+		return false;
+	}
+
+	char* end;
+	float parsed = strtof(text, &end);
+	if(*end != '\0')
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+}
+
+
+NMEAParser::NMEAParser()
+	:m_ReadIndex(0), m_WriteIndex(0), m_State(State::Start), m_Length(0), m_FieldCount(0),
+	m_Checksum(0), m_ReceivedChecksum(0)
+{
+	memset(&m_Stats, 0, sizeof(m_Stats));
+}
+
+size_t NMEAParser::writable(char*& at)
+{
+	uint32_t start = m_WriteIndex & NMEA_BUFFER_MASK;
+	uint32_t free = NMEA_BUFFER_SIZE - (m_WriteIndex - m_ReadIndex);
+
+	// Up to the end of the buffer, the rest wraps around to its start
+	at = m_Buffer + start;
+	return free < NMEA_BUFFER_SIZE - start ? free : NMEA_BUFFER_SIZE - start;
+}
+
+void NMEAParser::commit(size_t length)
+{
+	m_WriteIndex += length;
+}
+
+size_t NMEAParser::write(const char* data, size_t length)
+{
+	size_t written = 0;
+	while(written < length)
+	{
+		char* at;
+		size_t space = writable(at);
+		if(space == 0)
+		{
+			break;
+		}
+		if(space > length - written)
+		{
+			space = length - written;
+		}
+		memcpy(at, data + written, space);
+		commit(space);
+		written += space;
+	}
+	return written;
+}
+
+bool NMEAParser::next(NMEASentence& sentence)
+{
+	while(m_ReadIndex != m_WriteIndex)
+	{
+		char c = m_Buffer[m_ReadIndex & NMEA_BUFFER_MASK];
+		m_ReadIndex++;
+
+		if(parse(c))
+		{
+			sentence.m_FieldCount = m_FieldCount;
+			for(unsigned int i = 0; i < m_FieldCount; i++)
+			{
+				sentence.m_Fields[i] = m_Sentence + m_FieldStarts[i];
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void NMEAParser::startSentence()
+{
+	m_State = State::Body;
+	m_Length = 0;
+	m_FieldStarts[0] = 0;
+	m_FieldCount = 1;
+	m_Checksum = 0;
+}
+
+bool NMEAParser::parse(char c)
+{
+	// A new sentence starts whatever came before
+	if(c == '$' || c == '!')
+	{
+		if(m_State != State::Start)
+		{
+			m_Stats.dropped++;
+		}
+		startSentence();
+		return false;
+	}
+
+	switch(m_State)
+	{
+		case State::Start:
+			// Noise or the end of line of the last sentence
+			return false;
+
+		case State::Body:
+			if(c == '*')
+			{
+				m_Sentence[m_Length] = '\0';
+				m_State = State::ChecksumHigh;
+			}
+			else if(c == '\r' || c == '\n')
+			{
+				m_Stats.checksumErrors++;
+				m_State = State::Start;
+			}
+			else if(m_Length == NMEA_MAX_SENTENCE - 1 || c < ' ' || c > '~')
+			{
+				m_Stats.dropped++;
+				m_State = State::Start;
+			}
+			else
+			{
+				m_Checksum ^= (uint8_t)c;
+				if(c == ',')
+				{
+					if(m_FieldCount == NMEA_MAX_FIELDS)
+					{
+						m_Stats.dropped++;
+						m_State = State::Start;
+						return false;
+					}
+					m_Sentence[m_Length++] = '\0';
+					m_FieldStarts[m_FieldCount++] = m_Length;
+				}
+				else
+				{
+					m_Sentence[m_Length++] = c;
+				}
+			}
+			return false;
+
+		case State::ChecksumHigh:
+		{
+			int value = hexValue(c);
+			if(value < 0)
+			{
+				m_Stats.checksumErrors++;
+				m_State = State::Start;
+				return false;
+			}
+			m_ReceivedChecksum = value << 4;
+			m_State = State::ChecksumLow;
+			return false;
+		}
+
+		case State::ChecksumLow:
+		{
+			int value = hexValue(c);
+			m_State = State::Start;
+			if(value < 0 || (m_ReceivedChecksum | value) != m_Checksum)
+			{
+				m_Stats.checksumErrors++;
+				return false;
+			}
+			m_Stats.sentences++;
+			return true;
+		}
+	}
+	return false;
+}
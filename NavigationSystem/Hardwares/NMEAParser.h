@@ -0,0 +1,133 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NMEAParser.h
+ *
+ * Purpose:
+ *		Picks the NMEA 0183 sentences out of the bytes read from a serial sensor, and
+ *		splits them into their fields once their checksum is checked.
+ *
+ * Developer Notes:
+ *		A sentence is $ (or ! for encapsulated ones), the address (talker and sentence
+ *		type, e.g. IIMWV), the comma separated fields, * and the two hex digits of the
+ *		checksum, the XOR of every character between $ and *. It usually ends with
+ *		CR LF, but the parser doesn't need it: a sentence is complete with its checksum.
+ *		Sentences without a checksum are dropped.
+ *
+ *		The bytes are read straight into a fixed ring buffer, see writable() and
+ *		commit(). next() runs them through a state machine one at a time, copying the
+ *		sentence being received to a buffer of its own where the commas become NULs, so
+ *		the fields can be read in place. Nothing is allocated.
+ *
+ *		A sentence is at most NMEA_MAX_SENTENCE characters long, a longer one is noise
+ *		and dropped.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// NMEA 0183 allows 82 characters, $ and CR LF included
+#define NMEA_MAX_SENTENCE 82
+
+#define NMEA_MAX_FIELDS 32
+
+// Must be a power of two
+#define NMEA_BUFFER_SIZE 512
+
+struct NMEAParserStats {
+    uint64_t sentences;       // Complete sentences with a valid checksum
+    uint64_t checksumErrors;  // Sentences with a wrong or missing checksum
+    uint64_t dropped;         // Sentences cut short by the next one, or too long
+};
+
+///----------------------------------------------------------------------------------
+/// A sentence as parsed, the fields point into the parser and are only valid until
+/// its next call to next().
+///----------------------------------------------------------------------------------
+class NMEASentence {
+   public:
+    NMEASentence() : m_FieldCount(0) {}
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true if the sentence has this address, e.g. "IIMWV".
+    ///----------------------------------------------------------------------------------
+    bool is(const char* address) const;
+
+    const char* address() const { return field(0); }
+
+    ///----------------------------------------------------------------------------------
+    /// The number of fields after the address.
+    ///----------------------------------------------------------------------------------
+    unsigned int fieldCount() const { return m_FieldCount > 0 ? m_FieldCount - 1 : 0; }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns a field, numbered from 1 after the address, or "" if there isn't one.
+    ///----------------------------------------------------------------------------------
+    const char* field(unsigned int index) const {
+        return index < m_FieldCount ? m_Fields[index] : "";
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Reads a field as a number, returns false if it is empty or not a number.
+    ///----------------------------------------------------------------------------------
+    bool toFloat(unsigned int index, float& value) const;
+
+   private:
+    friend class NMEAParser;
+
+    unsigned int m_FieldCount;
+    const char* m_Fields[NMEA_MAX_FIELDS];
+};
+
+class NMEAParser {
+   public:
+    NMEAParser();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns where the next bytes can be read to, and how many fit there in one go.
+    /// Call commit() with the number of bytes written.
+    ///----------------------------------------------------------------------------------
+    size_t writable(char*& at);
+    void commit(size_t length);
+
+    ///----------------------------------------------------------------------------------
+    /// Copies bytes into the buffer, returns how many there was room for.
+    ///----------------------------------------------------------------------------------
+    size_t write(const char* data, size_t length);
+
+    ///----------------------------------------------------------------------------------
+    /// Parses the buffered bytes until a sentence is complete. Returns false once they
+    /// have all been parsed, a sentence started may complete with the next bytes.
+    ///----------------------------------------------------------------------------------
+    bool next(NMEASentence& sentence);
+
+    const NMEAParserStats& stats() const { return m_Stats; }
+
+   private:
+    enum class State { Start, Body, ChecksumHigh, ChecksumLow };
+
+    ///----------------------------------------------------------------------------------
+    /// Runs a character through the state machine, returns true if it completes a
+    /// sentence.
+    ///----------------------------------------------------------------------------------
+    bool parse(char c);
+
+    void startSentence();
+
+    char m_Buffer[NMEA_BUFFER_SIZE];
+    uint32_t m_ReadIndex;  // Both only ever grow, the buffer index is the lowest bits
+    uint32_t m_WriteIndex;
+
+    State m_State;
+    char m_Sentence[NMEA_MAX_SENTENCE];
+    unsigned int m_Length;
+    uint16_t m_FieldStarts[NMEA_MAX_FIELDS];
+    unsigned int m_FieldCount;
+    uint8_t m_Checksum;
+    uint8_t m_ReceivedChecksum;
+
+    NMEAParserStats m_Stats;
+};
@@ -138,7 +138,7 @@ void SailControlNode::SailControlNodeThreadFunc(ActiveNode* nodePtr)
 
     // An initial sleep, its purpose is to ensure that most if not all the sensor data arrives
     // at the start before we send out the state message.
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
+    SimulatedClock::sleepFor(std::chrono::milliseconds(INITIAL_SLEEP));
 
     Timer timer;
     timer.start();
@@ -0,0 +1,175 @@
+#include "CollisionMath.h"
+#include "Utility.h"
+
+#include <math.h>
+#include <string.h>
+
+#define EARTH_RADIUS_METRES 6371000.0
+
+// Four floats, handled by one SSE or NEON instruction
+typedef float FloatVector __attribute__((vector_size(16)));
+typedef int32_t MaskVector __attribute__((vector_size(16)));
+
+#define VECTOR_LANES 4
+
+
+LocalTangentPlane::LocalTangentPlane()
+	:m_OriginLat(0), m_OriginLon(0), m_MetresPerDegreeLon(EARTH_RADIUS_METRES * M_PI / 180)
+{
+}
+
+LocalTangentPlane::LocalTangentPlane(double originLat, double originLon)
+	:m_OriginLat(originLat), m_OriginLon(originLon)
+{
+	m_MetresPerDegreeLon = EARTH_RADIUS_METRES * M_PI / 180 * cos(Utility::degreeToRadian(originLat));
+}
+
+void LocalTangentPlane::project(double lat, double lon, double& east, double& north) const
+{
+	double deltaLon = lon - m_OriginLon;
+	if(deltaLon > 180)
+	{
+		deltaLon -= 360;
+	}
+	else if(deltaLon < -180)
+	{
+		deltaLon += 360;
+	}
+
+	east = deltaLon * m_MetresPerDegreeLon;
+	north = (lat - m_OriginLat) * (EARTH_RADIUS_METRES * M_PI / 180);
+}
+
+void LocalTangentPlane::unproject(double east, double north, double& lat, double& lon) const
+{
+	lat = m_OriginLat + north / (EARTH_RADIUS_METRES * M_PI / 180);
+	lon = m_OriginLon + east / m_MetresPerDegreeLon;
+	if(lon > 180)
+	{
+		lon -= 360;
+	}
+	else if(lon < -180)
+	{
+		lon += 360;
+	}
+}
+
+
+void CollisionMath::courseToVelocity(float course, float speed, float& east, float& north)
+{
+	double courseInRadian = Utility::degreeToRadian(course);
+	east = sin(courseInRadian) * speed;
+	north = cos(courseInRadian) * speed;
+}
+
+static inline FloatVector loadVector(const float* values)
+{
+	FloatVector vector;
+	memcpy(&vector, values, sizeof(vector));
+	return vector;
+}
+
+static inline void storeVector(float* values, FloatVector vector)
+{
+	memcpy(values, &vector, sizeof(vector));
+}
+
+// Lanes of the mask set pick a, the others b
+static inline FloatVector select(MaskVector mask, FloatVector a, FloatVector b)
+{
+	return (FloatVector)((mask & (MaskVector)a) | (~mask & (MaskVector)b));
+}
+
+static inline void computeOneCPA(float east, float north, float velocityEast, float velocityNorth,
+	float ownVelocityEast, float ownVelocityNorth, float& cpa, float& tcpa)
+{
+	float relativeEast = velocityEast - ownVelocityEast;
+	float relativeNorth = velocityNorth - ownVelocityNorth;
+
+	float dotProduct = east * relativeEast + north * relativeNorth;
+	float squaredVelocity = relativeEast * relativeEast + relativeNorth * relativeNorth;
+
+	// Parallel courses, or moving away
+	if(dotProduct >= 0)
+	{
+		cpa = -1;
+		tcpa = 0;
+		return;
+	}
+
+	tcpa = -dotProduct / squaredVelocity;
+
+	// From the positions at the CPA, the difference of squared distances loses too much
+	float closestEast = east + relativeEast * tcpa;
+	float closestNorth = north + relativeNorth * tcpa;
+	cpa = sqrtf(closestEast * closestEast + closestNorth * closestNorth);
+}
+
+void CollisionMath::computeCPA(const float* east, const float* north, const float* velocityEast,
+	const float* velocityNorth, uint32_t count, float ownVelocityEast, float ownVelocityNorth,
+	float* cpa, float* tcpa)
+{
+	const FloatVector ownEast = {ownVelocityEast, ownVelocityEast, ownVelocityEast, ownVelocityEast};
+	const FloatVector ownNorth = {ownVelocityNorth, ownVelocityNorth, ownVelocityNorth, ownVelocityNorth};
+	const FloatVector zero = {0, 0, 0, 0};
+	const FloatVector one = {1, 1, 1, 1};
+
+	uint32_t i = 0;
+	for(; i + VECTOR_LANES <= count; i += VECTOR_LANES)
+	{
+		FloatVector x = loadVector(east + i);
+		FloatVector y = loadVector(north + i);
+		FloatVector relativeEast = loadVector(velocityEast + i) - ownEast;
+		FloatVector relativeNorth = loadVector(velocityNorth + i) - ownNorth;
+
+		FloatVector dotProduct = x * relativeEast + y * relativeNorth;
+		FloatVector squaredVelocity = relativeEast * relativeEast + relativeNorth * relativeNorth;
+
+		// Only the contacts getting closer have a CPA ahead, the others would divide by zero
+		MaskVector closing = dotProduct < zero;
+		squaredVelocity = select(closing, squaredVelocity, one);
+
+		FloatVector time = -dotProduct / squaredVelocity;
+		FloatVector closestEast = x + relativeEast * time;
+		FloatVector closestNorth = y + relativeNorth * time;
+		FloatVector squaredCPA = closestEast * closestEast + closestNorth * closestNorth;
+
+		float lanes[VECTOR_LANES];
+		storeVector(lanes, squaredCPA);
+		for(int lane = 0; lane < VECTOR_LANES; lane++)
+		{
+			lanes[lane] = sqrtf(lanes[lane]);
+		}
+
+		storeVector(cpa + i, select(closing, loadVector(lanes), -one));
+		storeVector(tcpa + i, select(closing, time, zero));
+	}
+
+	for(; i < count; i++)
+	{
+		computeOneCPA(east[i], north[i], velocityEast[i], velocityNorth[i], ownVelocityEast,
+			ownVelocityNorth, cpa[i], tcpa[i]);
+	}
+}
+
+void CollisionMath::computeCPAForHeadings(const float* east, const float* north,
+	const float* velocityEast, const float* velocityNorth, uint32_t count, float ownSpeed,
+	uint16_t headingStep, float* cpa, float* tcpa)
+{
+	if(headingStep == 0)
+	{
+		headingStep = 1;
+	}
+
+	uint32_t row = 0;
+	for(uint16_t heading = 0; heading < 360; heading += headingStep)
+	{
+		float ownVelocityEast;
+		float ownVelocityNorth;
+		courseToVelocity(heading, ownSpeed, ownVelocityEast, ownVelocityNorth);
+
+		computeCPA(east, north, velocityEast, velocityNorth, count, ownVelocityEast, ownVelocityNorth,
+			cpa + row * count, tcpa + row * count);
+		row++;
+	}
+}
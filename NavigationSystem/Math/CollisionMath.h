@@ -0,0 +1,93 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		CollisionMath.h
+ *
+ * Purpose:
+ *		Positions on a local tangent plane, and the closest point of approach (CPA) and
+ *		time to it (TCPA) computed for many contacts and headings at once.
+ *
+ * Developer Notes:
+ *		The plane is flat around its origin (an equirectangular projection), which is
+ *		precise enough a few tens of kilometres around it.
+ *
+ *		The CPA functions take the contacts column by column and work on four of them
+ *		at a time with GCC vector extensions, which become SSE or NEON instructions.
+ *		Positions are relative to the boat in metres, velocities in any unit as long as
+ *		it's the same for the boat and the contacts; TCPA is in that unit of time.
+ *
+ ***************************************************************************************/
+
+#ifndef __COLLISIONMATH_H__
+#define __COLLISIONMATH_H__
+
+#include <stdint.h>
+
+class LocalTangentPlane {
+   public:
+    LocalTangentPlane();
+    LocalTangentPlane(double originLat, double originLon);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the position in metres east and north of the origin.
+    ///----------------------------------------------------------------------------------
+    void project(double lat, double lon, double& east, double& north) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the position of a point given in metres east and north of the origin.
+    ///----------------------------------------------------------------------------------
+    void unproject(double east, double north, double& lat, double& lon) const;
+
+    double originLat() const { return m_OriginLat; }
+    double originLon() const { return m_OriginLon; }
+
+   private:
+    double m_OriginLat;
+    double m_OriginLon;
+    double m_MetresPerDegreeLon;
+};
+
+class CollisionMath {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// Splits a speed along a course (degrees clockwise from north) into its east and
+    /// north components.
+    ///----------------------------------------------------------------------------------
+    static void courseToVelocity(float course, float speed, float& east, float& north);
+
+    ///----------------------------------------------------------------------------------
+    /// Computes the CPA and TCPA of every contact to the boat moving at the given
+    /// velocity. Like MidRangeVoter::getCPA, the CPA is -1 (and the TCPA 0) for a
+    /// contact getting further away or keeping its distance.
+    ///----------------------------------------------------------------------------------
+    static void computeCPA(const float* east,
+                           const float* north,
+                           const float* velocityEast,
+                           const float* velocityNorth,
+                           uint32_t count,
+                           float ownVelocityEast,
+                           float ownVelocityNorth,
+                           float* cpa,
+                           float* tcpa);
+
+    ///----------------------------------------------------------------------------------
+    /// Computes the CPA and TCPA of every contact for the boat sailing at the given
+    /// speed along each heading 0, headingStep, 2 * headingStep... below 360. The
+    /// results of heading h are at [(h / headingStep) * count], the arrays must hold
+    /// (360 / headingStep) * count values.
+    ///----------------------------------------------------------------------------------
+    static void computeCPAForHeadings(const float* east,
+                                      const float* north,
+                                      const float* velocityEast,
+                                      const float* velocityNorth,
+                                      uint32_t count,
+                                      float ownSpeed,
+                                      uint16_t headingStep,
+                                      float* cpa,
+                                      float* tcpa);
+
+   private:
+    CollisionMath(){};
+};
+
+#endif
@@ -13,6 +13,8 @@
 
 #include "../MessageBus/ActiveNode.h"
 
+#include <pthread.h>
+#include <time.h>
 #include <iostream>
 void ActiveNode::runThread(void(*func)(ActiveNode*))
 {
@@ -23,3 +25,15 @@ void ActiveNode::stopThread(ActiveNode* node)
 {
     node->m_Thread->join();
 }
+
+double ActiveNode::threadCpuTime()
+{
+    clockid_t clock;
+    timespec time;
+    if(m_Thread == NULL || pthread_getcpuclockid(m_Thread->native_handle(), &clock) != 0 ||
+        clock_gettime(clock, &time) != 0)
+    {
+        return 0;
+    }
+    return time.tv_sec + time.tv_nsec / 1e9;
+}
@@ -18,7 +18,7 @@
 
 class ActiveNode : public Node {
    public:
-    ActiveNode(NodeID id, MessageBus& msgBus) : Node(id, msgBus) {}
+    ActiveNode(NodeID id, MessageBus& msgBus) : Node(id, msgBus), m_Thread(NULL) {}
 
     ///----------------------------------------------------------------------------------
     /// This function should be used to start the active nodes thread.
@@ -26,6 +26,12 @@ class ActiveNode : public Node {
     ///----------------------------------------------------------------------------------
     virtual void start() = 0;
 
+    ///----------------------------------------------------------------------------------
+    /// Returns the CPU time the node's thread has used so far, in seconds, 0 until the
+    /// thread is started.
+    ///----------------------------------------------------------------------------------
+    double threadCpuTime();
+
    protected:
     void runThread(void (*func)(ActiveNode*));
     void stopThread(ActiveNode* node);
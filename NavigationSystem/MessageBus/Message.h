@@ -14,15 +14,12 @@
 #pragma once
 
 #include "../MessageBus/MessageDeserialiser.h"
+#include "../MessageBus/MessagePool.h"
 #include "../MessageBus/MessageSerialiser.h"
 #include "../MessageBus/MessageTypes.h"
 #include "../MessageBus/NodeIDs.h"
 
-#define LOG_MESSAGES
-
-#ifdef LOG_MESSAGES
-#include "../SystemServices/SysClock.h"
-#endif
+#include <stdint.h>
 
 class Message {
    public:
@@ -98,9 +95,8 @@ class Message {
         serialiser.serialise(m_DestinationID);
     }
 
-#ifdef LOG_MESSAGES
-    TimeStamp timeReceived;
-#endif
+    // Monotonic microseconds, set by the bus while tracing or collecting statistics
+    uint64_t timeEnqueued = 0;
 
    protected:
     bool m_valid;  // Indicates that the message was correctl created
@@ -11,19 +11,25 @@
 
 #include "../MessageBus/MessageBus.h"
 #include "../SystemServices/Logger.h"
-#include <sys/time.h>
-#include "../SystemServices/SysClock.h"
+
+#include <algorithm>
 
 // For std::this_thread
 #include <chrono>
 #include <thread>
 #include <iostream>
 
-#define SLEEP_TIME_MS	50
+// Upper bound on how long the bus waits for a message before re-checking whether it
+// should keep running. Messages themselves wake the bus immediately.
+#define MAX_WAIT_TIME_MS	50
+
+// Most messages delivered in one go, the rest of a burst waits for the next round so
+// a stop request is noticed and the batch statistics stay meaningful
+#define MAX_BATCH_SIZE		64
 
 
 MessageBus::MessageBus()
-	:m_Running(false)
+	:m_Running(false), m_Processing(false), m_StatsRequested(false), m_StatsLogPeriod(0)
 {
 	m_FrontMessages = new std::queue<MessagePtr>();
 	m_BackMessages = new std::queue<MessagePtr>();
@@ -65,50 +71,177 @@ bool MessageBus::registerNode(Node& node, MessageType msgType)
 	return false;
 }
 
+bool MessageBus::setNodePriority(Node& node, NodePriority priority)
+{
+	if(not m_Running)
+	{
+		for(auto regNode : m_RegisteredNodes)
+		{
+			if(regNode->nodeRef.nodeID() == node.nodeID())
+			{
+				regNode->priority = priority;
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool MessageBus::enableWorkerPool(unsigned int workerCount, unsigned int mailboxSize)
+{
+	if(not m_Running)
+	{
+		m_WorkerPool.reset(new NodeWorkerPool(workerCount, mailboxSize, &m_Stats));
+		return true;
+	}
+	return false;
+}
+
+unsigned long MessageBus::droppedMessages(Node& node) const
+{
+	if(m_WorkerPool)
+	{
+		return m_WorkerPool->droppedMessages(node.nodeID());
+	}
+	return 0;
+}
+
 void MessageBus::sendMessage(MessagePtr msg)
 {
 	if(msg != NULL)
 	{
+		bool wasEmpty;
+		bool stats = m_Stats.enabled();
+
+		if(m_Tracer.enabled() || stats)
+		{
+			msg->timeEnqueued = MessageTracer::now();
+		}
+
 		m_FrontQueueMutex.lock();
-		Message* logMsg = msg.get();
+		wasEmpty = m_FrontMessages->empty();
 		m_FrontMessages->push(std::move(msg));
-		logMessageReceived(logMsg);
+		if(stats)
+		{
+			m_Stats.recordQueueDepth(m_FrontMessages->size());
+		}
 		m_FrontQueueMutex.unlock();
+
+		// Only the first message of a batch needs to wake the bus, the others are
+		// picked up by the same queue swap.
+		if(wasEmpty)
+		{
+			m_FrontQueueCondition.notify_one();
+		}
 	}
 }
 
+bool MessageBus::idle()
+{
+	std::lock_guard<std::mutex> lock(m_FrontQueueMutex);
+	return m_FrontMessages->empty() && not m_Processing.load() &&
+		(not m_WorkerPool || m_WorkerPool->idle());
+}
+
 void MessageBus::run()
 {
 	// Prevent nodes from being registered now
 	m_Running.store(true);
-	startMessageLog();
+	buildRoutingTables();
 
-	while(m_Running.load() == true)
+	if(m_StatsRequested)
 	{
-		// TODO - Jordan: Wake up only when messages have been pushed into the queue.
+		// Messages can be sent directly with a type nobody subscribed to
+		m_Stats.setup(m_DirectRoutes.size(), MESSAGE_TYPE_COUNT);
+		m_Stats.enable(m_StatsLogPeriod);
+	}
 
-		std::this_thread::sleep_for(std::chrono::milliseconds(SLEEP_TIME_MS));
+	if(m_WorkerPool)
+	{
+		for(auto regNode : m_RegisteredNodes)
+		{
+			m_WorkerPool->addNode(regNode->nodeRef, regNode->priority);
+		}
+		m_WorkerPool->start();
+	}
 
-		// If we have messages, flip the two queues and begin processing messages
-		if(m_FrontMessages->size() > 0)
+	while(m_Running.load() == true)
+	{
+		// Only take new messages once the previous ones are all delivered, so the
+		// messages stay in the order they were sent in
+		if(m_BackMessages->empty())
 		{
-			std::queue<MessagePtr>* tmpPtr;
+			std::unique_lock<std::mutex> lock(m_FrontQueueMutex);
 
-			m_FrontQueueMutex.lock();
+			// Sleep until a node sends a message, the wait is bounded so a stop request
+			// is always noticed.
+			m_FrontQueueCondition.wait_for(lock, std::chrono::milliseconds(MAX_WAIT_TIME_MS),
+				[this]() { return not m_FrontMessages->empty() || not m_Running.load(); });
 
-			tmpPtr = m_FrontMessages;
-			m_FrontMessages = m_BackMessages;
-			m_FrontQueueMutex.unlock();
+			if(m_FrontMessages->empty())
+			{
+				continue;
+			}
 
+			// Flip the two queues, messages sent while processing end up in the front one
+			std::queue<MessagePtr>* tmpPtr = m_FrontMessages;
+			m_FrontMessages = m_BackMessages;
 			m_BackMessages = tmpPtr;
-			processMessages();
+			m_Processing.store(true);
 		}
+
+		size_t batchSize = std::min(m_BackMessages->size(), (size_t)MAX_BATCH_SIZE);
+		if(m_Stats.enabled())
+		{
+			m_Stats.recordBatch(batchSize);
+		}
+		processMessages(batchSize);
+
+		if(m_BackMessages->empty())
+		{
+			m_Processing.store(false);
+		}
+	}
+
+	if(m_WorkerPool)
+	{
+		m_WorkerPool->stop();
 	}
 }
 
+bool MessageBus::startTracing(const std::string& filePath)
+{
+	return m_Tracer.start(filePath);
+}
+
+void MessageBus::stopTracing()
+{
+	m_Tracer.stop();
+}
+
+bool MessageBus::enableStatistics(unsigned int logPeriod)
+{
+	if(not m_Running)
+	{
+		m_StatsRequested = true;
+		m_StatsLogPeriod = logPeriod;
+		return true;
+	}
+	return false;
+}
+
+std::string MessageBus::statisticsReport() const
+{
+	return m_Stats.report();
+}
+
 void MessageBus::stop()
 {
+	m_FrontQueueMutex.lock();
 	m_Running.store(false);
+	m_FrontQueueMutex.unlock();
+
+	m_FrontQueueCondition.notify_all();
 }
 
 //TODO - Jordan: What would cause this to return a null pointer?
@@ -129,116 +262,119 @@ MessageBus::RegisteredNode* MessageBus::getRegisteredNode(Node& node)
 	return newRegNode;
 }
 
-void MessageBus::processMessages()
+void MessageBus::buildRoutingTables()
 {
-	while(m_BackMessages->size() > 0)
+	m_Subscribers.clear();
+	m_DirectRoutes.clear();
+
+	for(auto regNode : m_RegisteredNodes)
+	{
+		Node* node = &regNode->nodeRef;
+
+		for(auto msgType : regNode->interests())
+		{
+			size_t typeIndex = static_cast<size_t>(msgType);
+			if(typeIndex >= m_Subscribers.size())
+			{
+				m_Subscribers.resize(typeIndex + 1);
+			}
+			m_Subscribers[typeIndex].push_back(node);
+		}
+
+		size_t idIndex = static_cast<size_t>(node->nodeID());
+		if(idIndex >= m_DirectRoutes.size())
+		{
+			m_DirectRoutes.resize(idIndex + 1, NULL);
+		}
+		m_DirectRoutes[idIndex] = node;
+	}
+}
+
+void MessageBus::processMessages(size_t count)
+{
+	for(size_t i = 0; i < count; i++)
 	{
-		// std::cout << "/* Size back message queue " << m_BackMessages->size() << " */" << '\n';
 		MessagePtr msgPtr = std::move(m_BackMessages->front());
+		m_BackMessages->pop();
 		Message* msg = msgPtr.get();
+		bool delivered = false;
+
+		uint64_t dequeueTime = 0;
+		if(m_Tracer.enabled())
+		{
+			dequeueTime = MessageTracer::now();
+		}
 
-		logMessage(msg);
+		// The workers share the message, it is freed once the last node processed it
+		SharedMessagePtr sharedMsg;
+		if(m_WorkerPool)
+		{
+			sharedMsg = std::move(msgPtr);
+		}
 
-		for(auto node : m_RegisteredNodes)
+		// Distribute to everyone interested
+		if(msg->destinationID() == NodeID::None)
 		{
-			// Distribute to everyone interested
-			if(msg->destinationID() == NodeID::None)
+			size_t typeIndex = static_cast<size_t>(msg->messageType());
+			if(typeIndex < m_Subscribers.size())
 			{
-				if(node->isInterested( msg->messageType() ))
+				for(auto node : m_Subscribers[typeIndex])
 				{
-					// std::cout << std::endl << "## Before processing " << nodeToString(node->nodeRef.nodeID()) << " Message : " << msgToString(msg->messageType()) << std::endl;
-					node->nodeRef.processMessage(msg);
-					logMessageConsumer(node->nodeRef.nodeID());
-
+					deliverMessage(*node, msg, sharedMsg, dequeueTime);
+					delivered = true;
 				}
 			}
-			// Distribute to the node the message is directed at then move onto the next message
-			else
+		}
+		// Distribute to the node the message is directed at
+		else
+		{
+			size_t idIndex = static_cast<size_t>(msg->destinationID());
+			if(idIndex < m_DirectRoutes.size() && m_DirectRoutes[idIndex] != NULL)
 			{
-				if(node->nodeRef.nodeID() == msg->destinationID())
-				{
-					node->nodeRef.processMessage(msg);
-					logMessageConsumer(node->nodeRef.nodeID());
-
-					continue;
-				}
+				deliverMessage(*m_DirectRoutes[idIndex], msg, sharedMsg, dequeueTime);
+				delivered = true;
 			}
 		}
 
-		m_BackMessages->pop();
-
-		// delete msg; Don't need for unique pointers
+		if(not delivered && m_Tracer.enabled())
+		{
+			m_Tracer.trace(msg, dequeueTime, 0, NodeID::None);
+		}
 	}
-
 }
 
-void MessageBus::startMessageLog()
+void MessageBus::deliverMessage(Node& node, Message* msg, const SharedMessagePtr& sharedMsg,
+								uint64_t dequeueTime)
 {
-#ifdef LOG_MESSAGES
-	m_LogFile = new std::ofstream("./Messages.log", std::ios::out | std::ios::trunc);
-	if(m_LogFile->is_open())
+	bool tracing = m_Tracer.enabled();
+	bool stats = m_Stats.enabled();
+	uint64_t deliverTime = 0;
+	if(tracing || stats)
 	{
-		Logger::info("Message log file created!");
+		deliverTime = MessageTracer::now();
 	}
-	else
+
+	if(m_WorkerPool)
 	{
-		Logger::error("Message log file not created!");
-		delete m_LogFile;
-		m_LogFile = NULL;
+		// The workers record the handler statistics themselves
+		m_WorkerPool->deliver(node.nodeID(), sharedMsg);
 	}
-#endif
-}
-
-void MessageBus::logMessageReceived(Message* msg)
-{
-#ifdef LOG_MESSAGES
-	msg->timeReceived = SysClock::timeStamp();
-#endif
-}
-
-void MessageBus::logMessage(Message* msg)
-{
-#ifdef LOG_MESSAGES
-	if(m_LogFile != NULL)
+	else
 	{
-		char buff[256];
+		node.processMessage(msg);
 
-		snprintf(buff, 256, "[%s] Type=%s(%d) SourceID=%d Destination=%d Received=%s", 	SysClock::hh_mm_ss_ms().c_str(),
-																						msgToString(msg->messageType()).c_str(),
-																						(int) msg->messageType(), (int) msg->sourceID(),
-																						(int) msg->destinationID(),
-																						SysClock::hh_mm_ss_ms(msg->timeReceived).c_str());
-		*m_LogFile << buff << "\n";
-		m_LogFile->flush();
+		if(stats)
+		{
+			m_Stats.recordHandler(node.nodeID(), msg->messageType(), MessageTracer::now() - deliverTime);
+			if(msg->timeEnqueued != 0)
+			{
+				m_Stats.recordLatency(msg->messageType(), deliverTime - msg->timeEnqueued);
+			}
+		}
 	}
-#endif
-}
 
-void MessageBus::logMessageConsumer(NodeID id)
-{
-#ifdef LOG_MESSAGES
-	if(m_LogFile != NULL)
+	if(tracing)
 	{
-		char buff[256];
-
-		snprintf(buff, 256, "\t%s Consumed by Node: %s(%d)", SysClock::hh_mm_ss_ms().c_str(), nodeToString(id).c_str(), (int) id);
-		*m_LogFile << buff << "\n";
-		m_LogFile->flush();
+		m_Tracer.trace(msg, dequeueTime, deliverTime, node.nodeID());
 	}
-#endif
-}
-
-void MessageBus::messageTimeStamp(unsigned long unixTime, char* buffer)
-{
-	char buff[9];
-	time_t unix_time = (time_t)unixTime;
-	strftime(buff, 9, "%H:%M:%S", gmtime(&unix_time));
-
-	// Get Milliseconds
-	timeval curTime;
-	gettimeofday(&curTime, NULL);
-	int milli = curTime.tv_usec / 1000;
-
-	sprintf(buffer, "%s:%d", buff, milli);
-
 }
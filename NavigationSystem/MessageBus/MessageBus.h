@@ -18,14 +18,17 @@
 #pragma once
 
 #include <atomic>
-#include <fstream>
+#include <condition_variable>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <vector>
 #include "../MessageBus/Message.h"
+#include "../MessageBus/MessageBusStats.h"
+#include "../MessageBus/MessageTracer.h"
 #include "../MessageBus/Node.h"
+#include "../MessageBus/NodeWorkerPool.h"
 
 typedef std::unique_ptr<Message> MessagePtr;
 
@@ -62,6 +65,33 @@ class MessageBus {
     ///----------------------------------------------------------------------------------
     bool registerNode(Node& node, MessageType msgType);
 
+    ///----------------------------------------------------------------------------------
+    /// Sets the priority a node is given when messages are delivered by a worker pool.
+    /// Nodes are Normal priority by default. The node must already be registered.
+    ///
+    /// @param node 			The node whose priority is set.
+    /// @param priority 		High priority nodes are served first and have a worker
+    ///							of their own.
+    ///----------------------------------------------------------------------------------
+    bool setNodePriority(Node& node, NodePriority priority);
+
+    ///----------------------------------------------------------------------------------
+    /// Makes the message bus hand messages to a pool of worker threads instead of
+    /// calling Node::processMessage itself, so a slow node doesn't delay the others.
+    /// Each node gets a bounded mailbox, messages are dropped for a node whose mailbox
+    /// is full. Must be called before the bus is running.
+    ///
+    /// @param workerCount 		How many worker threads deliver messages.
+    /// @param mailboxSize 		How many messages can wait for each node.
+    ///----------------------------------------------------------------------------------
+    bool enableWorkerPool(unsigned int workerCount, unsigned int mailboxSize = 256);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how many messages were dropped for a node because its worker pool
+    /// mailbox was full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedMessages(Node& node) const;
+
     ///----------------------------------------------------------------------------------
     /// Enqueues a message onto the message queue for distribution through the message
     /// bus.
@@ -71,12 +101,51 @@ class MessageBus {
     ///----------------------------------------------------------------------------------
     void sendMessage(MessagePtr msg);
 
+    ///----------------------------------------------------------------------------------
+    /// Returns true if no message is waiting or being delivered, used by the simulation
+    /// to know when the nodes are done with a tick.
+    ///----------------------------------------------------------------------------------
+    bool idle();
+
     ///----------------------------------------------------------------------------------
     /// Begins running the message bus and distributing messages to nodes that have been
-    /// registered. This function won't ever return.
+    /// registered. The bus sleeps until a message is sent and then distributes the
+    /// messages that were queued since the last batch, at most MAX_BATCH_SIZE at a
+    /// time. This function only returns once stop() has been called.
     ///----------------------------------------------------------------------------------
     void run();
 
+    ///----------------------------------------------------------------------------------
+    /// Starts recording every message going through the bus to a binary trace file,
+    /// can be called at any time. Use the message trace decoder to read the file.
+    ///
+    /// @param filePath 		Path of the trace file, it is overwritten.
+    ///----------------------------------------------------------------------------------
+    bool startTracing(const std::string& filePath);
+
+    ///----------------------------------------------------------------------------------
+    /// Stops recording messages and closes the trace file.
+    ///----------------------------------------------------------------------------------
+    void stopTracing();
+
+    ///----------------------------------------------------------------------------------
+    /// Starts measuring how long each node takes to process each message type, how long
+    /// messages wait in the queues and how deep the queue gets. Must be called before
+    /// the bus is running. See MessageBusStats::dumpOnSignal to get a report on demand.
+    ///
+    /// @param logPeriod 		How often the statistics are logged in seconds, 0 to only
+    ///							log them on demand.
+    ///----------------------------------------------------------------------------------
+    bool enableStatistics(unsigned int logPeriod = 60);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the statistics collected so far, one line per node and message type.
+    ///----------------------------------------------------------------------------------
+    std::string statisticsReport() const;
+
+    ///----------------------------------------------------------------------------------
+    /// Stops the message bus, wakes it up if it is waiting for messages.
+    ///----------------------------------------------------------------------------------
     void stop();
 
    private:
@@ -85,9 +154,10 @@ class MessageBus {
     /// in.
     ///----------------------------------------------------------------------------------
     struct RegisteredNode {
-        RegisteredNode(Node& node) : nodeRef(node) {}
+        RegisteredNode(Node& node) : nodeRef(node), priority(NodePriority::Normal) {}
 
         Node& nodeRef;
+        NodePriority priority;
 
         ///------------------------------------------------------------------------------
         /// Returns true if a registered node is interested in a message type.
@@ -115,6 +185,11 @@ class MessageBus {
             }
         }
 
+        ///------------------------------------------------------------------------------
+        /// Returns the message types the registered node is subscribed to.
+        ///------------------------------------------------------------------------------
+        const std::vector<MessageType>& interests() const { return interestedList; }
+
        private:
         std::vector<MessageType> interestedList;
     };
@@ -127,51 +202,41 @@ class MessageBus {
     RegisteredNode* getRegisteredNode(Node& node);
 
     ///----------------------------------------------------------------------------------
-    /// Goes through the back message queue and distributes messages, calling
-    /// Node::processMessage(Message*) on nodes that are interested in any given message.
-    ///----------------------------------------------------------------------------------
-    void processMessages();
-
-    ///----------------------------------------------------------------------------------
-    /// Creates a log file for the messages.
-    ///----------------------------------------------------------------------------------
-    void startMessageLog();
-
-    ///----------------------------------------------------------------------------------
-    /// Logs that a message was received.
-    ///----------------------------------------------------------------------------------
-    void logMessageReceived(Message* msg);
-
-    ///----------------------------------------------------------------------------------
-    /// Logs a message that is being processed.
-    ///----------------------------------------------------------------------------------
-    void logMessage(Message* msg);
-
-    ///----------------------------------------------------------------------------------
-    /// Logs that a node consumed the current message being processed.
+    /// Builds the routing tables from the registered nodes. Called once when the bus
+    /// starts running, the registrations can't change afterwards.
     ///----------------------------------------------------------------------------------
-    void logMessageConsumer(NodeID id);
+    void buildRoutingTables();
 
     ///----------------------------------------------------------------------------------
-    /// Logs that the current message being processed has finished being processed.
+    /// Distributes that many messages from the back message queue, calling
+    /// Node::processMessage(Message*) on nodes that are interested in any given message.
+    /// Only the subscribers of a message type (or the destination node) are visited.
     ///----------------------------------------------------------------------------------
-    // void logMessageProcessed(Message* msg);
+    void processMessages(size_t count);
 
     ///----------------------------------------------------------------------------------
-    /// Returns a message time stamp in the format HH:MM:SS:MS, a char buffer of 14
-    /// characters needs to be provided.
+    /// Hands a message to a node, either directly or through its worker pool mailbox.
+    /// The dequeue time is only used when tracing.
     ///----------------------------------------------------------------------------------
-    void messageTimeStamp(unsigned long unixTime, char* buffer);
+    void deliverMessage(Node& node, Message* msg, const SharedMessagePtr& sharedMsg,
+                        uint64_t dequeueTime);
 
     std::vector<RegisteredNode*> m_RegisteredNodes;
+    std::vector<std::vector<Node*>> m_Subscribers;  // Subscribed nodes, indexed by
+                                                    // MessageType.
+    std::vector<Node*> m_DirectRoutes;              // Registered nodes, indexed by NodeID.
     std::queue<MessagePtr>* m_FrontMessages;  // The forward facing message queue
                                               // which messages are append to.
     std::queue<MessagePtr>* m_BackMessages;   // The backend message queue which
                                               // contains messages to distribute.
     std::mutex m_FrontQueueMutex;             // Guards the front message queue.
+    std::condition_variable m_FrontQueueCondition;  // Signalled when the front queue
+                                                    // receives its first message.
     std::atomic<bool> m_Running;
-
-#ifdef LOG_MESSAGES
-    std::ofstream* m_LogFile;
-#endif
+    std::atomic<bool> m_Processing;  // True while a batch of messages is delivered
+    std::unique_ptr<NodeWorkerPool> m_WorkerPool;  // Delivers messages when enabled
+    MessageTracer m_Tracer;
+    MessageBusStats m_Stats;
+    bool m_StatsRequested;
+    unsigned int m_StatsLogPeriod;
 };
@@ -0,0 +1,264 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusStats.cpp
+ *
+ * Purpose:
+ *		Collects timing statistics of the message bus: how long each node takes to
+ *		process each type of message, how long messages wait before being delivered
+ *		and how deep the message queue gets.
+ *
+ ***************************************************************************************/
+
+#include "../MessageBus/MessageBusStats.h"
+#include "../SystemServices/Logger.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <chrono>
+#include <sstream>
+
+// How often the logger thread checks whether a dump was requested
+#define DUMP_CHECK_PERIOD_MS	500
+
+
+std::atomic<bool> MessageBusStats::s_DumpRequested(false);
+
+
+LatencyHistogram::LatencyHistogram()
+	:m_Count(0), m_Total(0), m_Max(0)
+{
+	for(int i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		m_Buckets[i].store(0);
+	}
+}
+
+void LatencyHistogram::record(uint64_t durationUs)
+{
+	int bucket = 0;
+	while(bucket < LATENCY_BUCKETS - 1 && durationUs >= (1ULL << bucket))
+	{
+		bucket++;
+	}
+
+	m_Buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	m_Count.fetch_add(1, std::memory_order_relaxed);
+	m_Total.fetch_add(durationUs, std::memory_order_relaxed);
+
+	uint64_t max = m_Max.load(std::memory_order_relaxed);
+	while(durationUs > max && not m_Max.compare_exchange_weak(max, durationUs, std::memory_order_relaxed))
+	{
+	}
+}
+
+double LatencyHistogram::meanUs() const
+{
+	uint64_t count = this->count();
+	if(count == 0)
+	{
+		return 0;
+	}
+	return (double)m_Total.load(std::memory_order_relaxed) / count;
+}
+
+uint64_t LatencyHistogram::percentileUs(double percentile) const
+{
+	uint64_t count = this->count();
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	uint64_t target = (uint64_t)(count * percentile / 100.0);
+	uint64_t cumulated = 0;
+	for(int i = 0; i < LATENCY_BUCKETS - 1; i++)
+	{
+		cumulated += m_Buckets[i].load(std::memory_order_relaxed);
+		if(cumulated >= target && cumulated > 0)
+		{
+			return 1ULL << i;
+		}
+	}
+	return maxUs();
+}
+
+
+MessageBusStats::MessageBusStats()
+	:m_Enabled(false), m_NodeIDCount(0), m_MessageTypeCount(0), m_QueueHighWaterMark(0),
+	m_LargestBatch(0), m_Batches(0), m_LogPeriod(0), m_LoggerThread(NULL), m_StopLogger(false)
+{
+}
+
+MessageBusStats::~MessageBusStats()
+{
+	if(m_LoggerThread != NULL)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_LoggerMutex);
+			m_StopLogger = true;
+		}
+		m_LoggerCondition.notify_one();
+
+		m_LoggerThread->join();
+		delete m_LoggerThread;
+	}
+}
+
+void MessageBusStats::setup(size_t nodeIDCount, size_t messageTypeCount)
+{
+	m_NodeIDCount = nodeIDCount;
+	m_MessageTypeCount = messageTypeCount;
+	m_Handlers.reset(new LatencyHistogram[nodeIDCount * messageTypeCount]);
+	m_Latencies.reset(new LatencyHistogram[messageTypeCount]);
+}
+
+void MessageBusStats::enable(unsigned int logPeriod)
+{
+	m_LogPeriod = logPeriod;
+	m_Enabled.store(true);
+
+	if(m_LoggerThread == NULL)
+	{
+		m_LoggerThread = new std::thread(loggerThread, this);
+	}
+}
+
+void MessageBusStats::recordHandler(NodeID node, MessageType type, uint64_t durationUs)
+{
+	LatencyHistogram* histogram = handlerHistogram(node, type);
+	if(histogram != NULL)
+	{
+		histogram->record(durationUs);
+	}
+}
+
+void MessageBusStats::recordLatency(MessageType type, uint64_t latencyUs)
+{
+	size_t typeIndex = static_cast<size_t>(type);
+	if(typeIndex < m_MessageTypeCount)
+	{
+		m_Latencies[typeIndex].record(latencyUs);
+	}
+}
+
+void MessageBusStats::recordQueueDepth(size_t depth)
+{
+	uint64_t highWaterMark = m_QueueHighWaterMark.load(std::memory_order_relaxed);
+	while(depth > highWaterMark &&
+		not m_QueueHighWaterMark.compare_exchange_weak(highWaterMark, depth, std::memory_order_relaxed))
+	{
+	}
+}
+
+void MessageBusStats::recordBatch(size_t size)
+{
+	m_Batches.fetch_add(1, std::memory_order_relaxed);
+
+	uint64_t largest = m_LargestBatch.load(std::memory_order_relaxed);
+	while(size > largest &&
+		not m_LargestBatch.compare_exchange_weak(largest, size, std::memory_order_relaxed))
+	{
+	}
+}
+
+std::string MessageBusStats::report() const
+{
+	std::stringstream report;
+	char line[256];
+
+	snprintf(line, sizeof(line), "Message bus: %lu batches, largest batch %lu, queue high-water mark %lu",
+		(unsigned long)m_Batches.load(), (unsigned long)m_LargestBatch.load(),
+		(unsigned long)m_QueueHighWaterMark.load());
+	report << line << "\n";
+
+	for(size_t node = 0; node < m_NodeIDCount; node++)
+	{
+		for(size_t type = 0; type < m_MessageTypeCount; type++)
+		{
+			const LatencyHistogram& histogram = m_Handlers[node * m_MessageTypeCount + type];
+			if(histogram.count() == 0)
+			{
+				continue;
+			}
+
+			snprintf(line, sizeof(line), "Handler %s/%s: count %lu, mean %.1f us, p50 < %lu us, p99 < %lu us, max %lu us",
+				nodeToString((NodeID)node).c_str(), msgToString((MessageType)type).c_str(),
+				(unsigned long)histogram.count(), histogram.meanUs(),
+				(unsigned long)histogram.percentileUs(50), (unsigned long)histogram.percentileUs(99),
+				(unsigned long)histogram.maxUs());
+			report << line << "\n";
+		}
+	}
+
+	for(size_t type = 0; type < m_MessageTypeCount; type++)
+	{
+		const LatencyHistogram& histogram = m_Latencies[type];
+		if(histogram.count() == 0)
+		{
+			continue;
+		}
+
+		snprintf(line, sizeof(line), "Latency %s: count %lu, mean %.1f us, p50 < %lu us, p99 < %lu us, max %lu us",
+			msgToString((MessageType)type).c_str(),
+			(unsigned long)histogram.count(), histogram.meanUs(),
+			(unsigned long)histogram.percentileUs(50), (unsigned long)histogram.percentileUs(99),
+			(unsigned long)histogram.maxUs());
+		report << line << "\n";
+	}
+
+	return report.str();
+}
+
+void MessageBusStats::dumpOnSignal(int signalNumber)
+{
+	signal(signalNumber, signalHandler);
+}
+
+LatencyHistogram* MessageBusStats::handlerHistogram(NodeID node, MessageType type) const
+{
+	size_t nodeIndex = static_cast<size_t>(node);
+	size_t typeIndex = static_cast<size_t>(type);
+	if(nodeIndex < m_NodeIDCount && typeIndex < m_MessageTypeCount)
+	{
+		return &m_Handlers[nodeIndex * m_MessageTypeCount + typeIndex];
+	}
+	return NULL;
+}
+
+void MessageBusStats::logReport() const
+{
+	std::stringstream report(this->report());
+	std::string line;
+
+	while(std::getline(report, line))
+	{
+		Logger::info("%s", line.c_str());
+	}
+}
+
+void MessageBusStats::signalHandler(int /*signalNumber*/)
+{
+	s_DumpRequested.store(true);
+}
+
+void MessageBusStats::loggerThread(MessageBusStats* stats)
+{
+	auto lastReport = std::chrono::steady_clock::now();
+	std::unique_lock<std::mutex> lock(stats->m_LoggerMutex);
+
+	while(not stats->m_StopLogger)
+	{
+		stats->m_LoggerCondition.wait_for(lock, std::chrono::milliseconds(DUMP_CHECK_PERIOD_MS));
+
+		auto now = std::chrono::steady_clock::now();
+		bool periodElapsed = stats->m_LogPeriod > 0 &&
+			now - lastReport >= std::chrono::seconds(stats->m_LogPeriod);
+
+		if(s_DumpRequested.exchange(false) || periodElapsed)
+		{
+			stats->logReport();
+			lastReport = now;
+		}
+	}
+}
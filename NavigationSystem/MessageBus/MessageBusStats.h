@@ -0,0 +1,138 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusStats.h
+ *
+ * Purpose:
+ *		Collects timing statistics of the message bus: how long each node takes to
+ *		process each type of message, how long messages wait before being delivered
+ *		and how deep the message queue gets.
+ *
+ * Developer Notes:
+ *		Durations are kept in histograms with power of two buckets (in microseconds),
+ *		percentiles are therefore reported as "less than" the upper bound of a bucket.
+ *
+ *		The counters are relaxed atomics so they can be updated by the message bus and
+ *		the worker pool threads while a report is being made, a report may be slightly
+ *		inconsistent but never blocks the bus.
+ *
+ *		The report is logged periodically and whenever dumpOnSignal's signal is
+ *		received (e.g. 'kill -USR1 <pid>').
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "../MessageBus/MessageTypes.h"
+#include "../MessageBus/NodeIDs.h"
+
+// Bucket 0 counts durations under 1 us, bucket i durations in [2^(i-1), 2^i[ us. The
+// last bucket also counts everything longer.
+#define LATENCY_BUCKETS 24
+
+class LatencyHistogram {
+   public:
+    LatencyHistogram();
+
+    void record(uint64_t durationUs);
+
+    uint64_t count() const { return m_Count.load(std::memory_order_relaxed); }
+    uint64_t maxUs() const { return m_Max.load(std::memory_order_relaxed); }
+    double meanUs() const;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the upper bound, in microseconds, of the bucket containing the given
+    /// percentile (0 to 100).
+    ///----------------------------------------------------------------------------------
+    uint64_t percentileUs(double percentile) const;
+
+   private:
+    std::atomic<uint64_t> m_Buckets[LATENCY_BUCKETS];
+    std::atomic<uint64_t> m_Count;
+    std::atomic<uint64_t> m_Total;
+    std::atomic<uint64_t> m_Max;
+};
+
+class MessageBusStats {
+   public:
+    MessageBusStats();
+    ~MessageBusStats();
+
+    ///----------------------------------------------------------------------------------
+    /// Allocates the per node and per message type histograms. Called by the message
+    /// bus when it starts running, before enable().
+    ///----------------------------------------------------------------------------------
+    void setup(size_t nodeIDCount, size_t messageTypeCount);
+
+    ///----------------------------------------------------------------------------------
+    /// Starts collecting statistics and logs a report every logPeriod seconds, 0 for
+    /// no periodic report.
+    ///----------------------------------------------------------------------------------
+    void enable(unsigned int logPeriod);
+
+    bool enabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    ///----------------------------------------------------------------------------------
+    /// Records how long a node took to process a message.
+    ///----------------------------------------------------------------------------------
+    void recordHandler(NodeID node, MessageType type, uint64_t durationUs);
+
+    ///----------------------------------------------------------------------------------
+    /// Records how long a message waited between being sent and being delivered.
+    ///----------------------------------------------------------------------------------
+    void recordLatency(MessageType type, uint64_t latencyUs);
+
+    ///----------------------------------------------------------------------------------
+    /// Records the depth of the front queue after a message was added.
+    ///----------------------------------------------------------------------------------
+    void recordQueueDepth(size_t depth);
+
+    ///----------------------------------------------------------------------------------
+    /// Records the number of messages distributed in one batch.
+    ///----------------------------------------------------------------------------------
+    void recordBatch(size_t size);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns a human readable report, one line per item.
+    ///----------------------------------------------------------------------------------
+    std::string report() const;
+
+    ///----------------------------------------------------------------------------------
+    /// Logs the report when the given signal is received.
+    ///----------------------------------------------------------------------------------
+    static void dumpOnSignal(int signalNumber);
+
+   private:
+    LatencyHistogram* handlerHistogram(NodeID node, MessageType type) const;
+
+    void logReport() const;
+
+    static void signalHandler(int signalNumber);
+
+    static void loggerThread(MessageBusStats* stats);
+
+    std::atomic<bool> m_Enabled;
+    size_t m_NodeIDCount;
+    size_t m_MessageTypeCount;
+    std::unique_ptr<LatencyHistogram[]> m_Handlers;   // [node * m_MessageTypeCount + type]
+    std::unique_ptr<LatencyHistogram[]> m_Latencies;  // [type]
+
+    std::atomic<uint64_t> m_QueueHighWaterMark;
+    std::atomic<uint64_t> m_LargestBatch;
+    std::atomic<uint64_t> m_Batches;
+
+    unsigned int m_LogPeriod;
+    std::thread* m_LoggerThread;
+    std::mutex m_LoggerMutex;
+    std::condition_variable m_LoggerCondition;
+    bool m_StopLogger;
+
+    static std::atomic<bool> s_DumpRequested;
+};
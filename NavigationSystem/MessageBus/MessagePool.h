@@ -0,0 +1,142 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessagePool.h
+ *
+ * Purpose:
+ *		Recycles the memory of high rate message types so that sending them does not
+ *		hit the heap once the system is running.
+ *
+ * Developer Notes:
+ *		A message class opts in with POOLED_MESSAGE(ClassName), which gives it class
+ *		specific operator new/delete backed by a MessagePool. Nodes keep creating
+ *		messages with std::make_unique and the MessageBus keeps deleting them through
+ *		MessagePtr, the memory just goes back to the pool instead of the heap.
+ *
+ *		Freed blocks are kept on a free list and handed out again on the next
+ *		allocation. A miss (empty free list) falls back to the heap, so after the
+ *		first few messages every allocation is a hit. The pool is never freed, it
+ *		lives until the process ends.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <mutex>
+#include <new>
+
+struct MessagePoolStats {
+    MessagePoolStats() : hits(0), misses(0), freeBlocks(0) {}
+
+    unsigned long hits;        // Allocations served from the free list
+    unsigned long misses;      // Allocations that went to the heap
+    unsigned long freeBlocks;  // Blocks currently waiting on the free list
+};
+
+template <class T>
+class MessagePool {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// Returns a block big enough for a T. Anything that isn't a T (a derived class)
+    /// goes straight to the heap.
+    ///----------------------------------------------------------------------------------
+    static void* allocate(size_t size) {
+        if (size != sizeof(T)) {
+            return ::operator new(size);
+        }
+
+        Pool& pool = instance();
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            if (pool.freeList != NULL) {
+                FreeBlock* block = pool.freeList;
+                pool.freeList = block->next;
+                pool.stats.hits++;
+                pool.stats.freeBlocks--;
+                return block;
+            }
+            pool.stats.misses++;
+        }
+        return ::operator new(BLOCK_SIZE);
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Gives a block back to the pool.
+    ///----------------------------------------------------------------------------------
+    static void release(void* ptr, size_t size) {
+        if (ptr == NULL) {
+            return;
+        }
+        if (size != sizeof(T)) {
+            ::operator delete(ptr);
+            return;
+        }
+
+        Pool& pool = instance();
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        block->next = pool.freeList;
+        pool.freeList = block;
+        pool.stats.freeBlocks++;
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Puts blocks on the free list ahead of time, so that even the first messages
+    /// don't allocate. Reserved blocks don't count as misses.
+    ///----------------------------------------------------------------------------------
+    static void reserve(unsigned int count) {
+        Pool& pool = instance();
+
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        for (unsigned int i = 0; i < count; i++) {
+            FreeBlock* block = static_cast<FreeBlock*>(::operator new(BLOCK_SIZE));
+            block->next = pool.freeList;
+            pool.freeList = block;
+            pool.stats.freeBlocks++;
+        }
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the hit/miss counters of the pool.
+    ///----------------------------------------------------------------------------------
+    static MessagePoolStats stats() {
+        Pool& pool = instance();
+
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        return pool.stats;
+    }
+
+   private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Pool {
+        Pool() : freeList(NULL) {}
+
+        std::mutex mutex;  // Guards the free list and the counters
+        FreeBlock* freeList;
+        MessagePoolStats stats;
+    };
+
+    static const size_t BLOCK_SIZE = sizeof(T) > sizeof(FreeBlock) ? sizeof(T) : sizeof(FreeBlock);
+
+    // Never destroyed, messages may still be released while the program exits
+    static Pool& instance() {
+        static Pool* pool = new Pool();
+        return *pool;
+    }
+};
+
+///--------------------------------------------------------------------------------------
+/// Place in the public section of a message class to allocate it from its pool.
+///--------------------------------------------------------------------------------------
+#define POOLED_MESSAGE(MessageClass)                                       \
+    static void* operator new(size_t size) {                               \
+        return MessagePool<MessageClass>::allocate(size);                  \
+    }                                                                      \
+    static void operator delete(void* ptr, size_t size) {                  \
+        MessagePool<MessageClass>::release(ptr, size);                     \
+    }
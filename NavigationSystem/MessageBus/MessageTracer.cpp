@@ -0,0 +1,189 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageTracer.cpp
+ *
+ * Purpose:
+ *		Records the path of every message through the message bus as fixed size binary
+ *		records, which are written to file by a background thread.
+ *
+ ***************************************************************************************/
+
+#include "../MessageBus/MessageTracer.h"
+#include "../SystemServices/Logger.h"
+
+#include <string.h>
+#include <sys/time.h>
+#include <algorithm>
+#include <chrono>
+
+// How often the writer thread empties the ring buffer
+#define WRITE_PERIOD_MS	100
+
+
+MessageTracer::MessageTracer(unsigned int ringSize)
+	:m_Head(0), m_Tail(0), m_Dropped(0), m_Enabled(false), m_File(NULL), m_Thread(NULL),
+	m_StopRequested(false), m_StartTime(0)
+{
+	size_t size = 2;
+	while(size < ringSize)
+	{
+		size <<= 1;
+	}
+	m_Ring.resize(size);
+	m_Mask = size - 1;
+}
+
+MessageTracer::~MessageTracer()
+{
+	stop();
+}
+
+bool MessageTracer::start(const std::string& filePath)
+{
+	if(m_Thread != NULL)
+	{
+		stop();
+	}
+
+	m_File = fopen(filePath.c_str(), "wb");
+	if(m_File == NULL)
+	{
+		Logger::error("%s Failed to create message trace file %s", __PRETTY_FUNCTION__, filePath.c_str());
+		return false;
+	}
+
+	timeval unixTime;
+	gettimeofday(&unixTime, NULL);
+
+	MessageTraceHeader header;
+	memset(&header, 0, sizeof(header));
+	strncpy(header.magic, MESSAGE_TRACE_MAGIC, sizeof(header.magic));
+	header.version = MESSAGE_TRACE_VERSION;
+	header.recordSize = sizeof(MessageTraceRecord);
+	header.unixTimeOffset = (int64_t)unixTime.tv_sec * 1000000 + unixTime.tv_usec - (int64_t)now();
+	fwrite(&header, sizeof(header), 1, m_File);
+
+	// Throw away whatever was left over from a previous trace. The message bus thread
+	// may still be delivering a message it started tracing before the previous stop(),
+	// the writer drops that record by its time.
+	m_Head.store(m_Tail.load());
+	m_Dropped.store(0);
+	m_StartTime = now();
+
+	m_StopRequested = false;
+	m_Thread = new std::thread(writerThread, this);
+	m_Enabled.store(true);
+
+	Logger::info("Message trace started: %s", filePath.c_str());
+	return true;
+}
+
+void MessageTracer::stop()
+{
+	if(m_Thread == NULL)
+	{
+		return;
+	}
+
+	m_Enabled.store(false);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_StopRequested = true;
+	}
+	m_StopCondition.notify_one();
+
+	m_Thread->join();
+	delete m_Thread;
+	m_Thread = NULL;
+
+	fclose(m_File);
+	m_File = NULL;
+
+	if(m_Dropped.load() > 0)
+	{
+		Logger::warning("Message trace stopped, %lu records were dropped", m_Dropped.load());
+	}
+}
+
+void MessageTracer::trace(const Message* msg, uint64_t dequeueTime, uint64_t deliverTime, NodeID consumer)
+{
+	size_t tail = m_Tail.load(std::memory_order_relaxed);
+	if(tail - m_Head.load(std::memory_order_acquire) > m_Mask)
+	{
+		m_Dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	MessageTraceRecord& record = m_Ring[tail & m_Mask];
+	record.enqueueTime = msg->timeEnqueued;
+	record.dequeueTime = dequeueTime;
+	record.deliverTime = deliverTime;
+	record.messageType = (uint16_t)msg->messageType();
+	record.sourceID = (uint8_t)msg->sourceID();
+	record.destinationID = (uint8_t)msg->destinationID();
+	record.consumerID = (uint8_t)consumer;
+	memset(record.reserved, 0, sizeof(record.reserved));
+
+	m_Tail.store(tail + 1, std::memory_order_release);
+}
+
+uint64_t MessageTracer::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MessageTracer::writeRecords()
+{
+	size_t head = m_Head.load(std::memory_order_relaxed);
+	size_t tail = m_Tail.load(std::memory_order_acquire);
+
+	while(head != tail)
+	{
+		// Write up to the end of the ring, or to a record left over from the previous
+		// trace, in one go
+		size_t index = head & m_Mask;
+		size_t available = std::min(tail - head, m_Ring.size() - index);
+		size_t count = 0;
+		while(count < available && not fromPreviousTrace(m_Ring[index + count]))
+		{
+			count++;
+		}
+
+		if(count > 0)
+		{
+			fwrite(&m_Ring[index], sizeof(MessageTraceRecord), count, m_File);
+		}
+		else
+		{
+			// Skip the left over record
+			count = 1;
+		}
+		head += count;
+		m_Head.store(head, std::memory_order_release);
+	}
+	fflush(m_File);
+}
+
+bool MessageTracer::fromPreviousTrace(const MessageTraceRecord& record) const
+{
+	return std::max(record.dequeueTime, record.deliverTime) < m_StartTime;
+}
+
+void MessageTracer::writerThread(MessageTracer* tracer)
+{
+	std::unique_lock<std::mutex> lock(tracer->m_Mutex);
+
+	while(not tracer->m_StopRequested)
+	{
+		tracer->m_StopCondition.wait_for(lock, std::chrono::milliseconds(WRITE_PERIOD_MS));
+
+		lock.unlock();
+		tracer->writeRecords();
+		lock.lock();
+	}
+
+	// Whatever was recorded just before stopping
+	tracer->writeRecords();
+}
@@ -0,0 +1,128 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageTracer.h
+ *
+ * Purpose:
+ *		Records the path of every message through the message bus as fixed size binary
+ *		records, which are written to file by a background thread. The trace file can
+ *		be turned into text with the message trace decoder (message_trace_decoder.cpp).
+ *
+ * Developer Notes:
+ *		Only the message bus thread adds records, so the ring buffer between it and the
+ *		writer thread is a lock-free single producer/single consumer queue. If the
+ *		writer can't keep up, records are dropped and counted rather than slowing down
+ *		the message bus.
+ *
+ *		A message the bus started tracing before stop() can still be recorded after the
+ *		next start(), the writer thread leaves such records out of the new file.
+ *
+ *		All times are microseconds of the monotonic clock. The file header stores the
+ *		unix time matching a monotonic time of zero so the decoder can print wall
+ *		clock times.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../MessageBus/Message.h"
+
+#define MESSAGE_TRACE_MAGIC "SRTRACE"
+#define MESSAGE_TRACE_VERSION 1
+
+struct MessageTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    int64_t unixTimeOffset;  // Unix time in microseconds when the monotonic clock was zero
+};
+
+struct MessageTraceRecord {
+    uint64_t enqueueTime;  // When the message was sent
+    uint64_t dequeueTime;  // When the message bus started distributing it
+    uint64_t deliverTime;  // When it was handed to the consumer, 0 if nobody consumed it
+    uint16_t messageType;
+    uint8_t sourceID;
+    uint8_t destinationID;
+    uint8_t consumerID;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(MessageTraceRecord) == 32, "The trace file format relies on 32 byte records");
+
+class MessageTracer {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param ringSize 		How many records can wait for the writer thread, rounded
+    ///							up to a power of two.
+    ///----------------------------------------------------------------------------------
+    explicit MessageTracer(unsigned int ringSize = 8192);
+
+    ~MessageTracer();
+
+    ///----------------------------------------------------------------------------------
+    /// Creates the trace file and starts recording. Returns false if the file can't be
+    /// created.
+    ///----------------------------------------------------------------------------------
+    bool start(const std::string& filePath);
+
+    ///----------------------------------------------------------------------------------
+    /// Stops recording, writes the remaining records and closes the file.
+    ///----------------------------------------------------------------------------------
+    void stop();
+
+    bool enabled() const { return m_Enabled.load(std::memory_order_relaxed); }
+
+    ///----------------------------------------------------------------------------------
+    /// Records that a message was handed to a consumer. Pass NodeID::None as the
+    /// consumer and 0 as the deliver time for a message nobody was interested in. Only
+    /// called by the message bus thread.
+    ///----------------------------------------------------------------------------------
+    void trace(const Message* msg, uint64_t dequeueTime, uint64_t deliverTime, NodeID consumer);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how many records were lost because the ring buffer was full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedRecords() const { return m_Dropped.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the current monotonic time in microseconds.
+    ///----------------------------------------------------------------------------------
+    static uint64_t now();
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// Writes all the records waiting in the ring buffer to the file.
+    ///----------------------------------------------------------------------------------
+    void writeRecords();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true if the record was dequeued and delivered before the trace started,
+    /// i.e. the message bus was tracing it for the previous trace when that stopped.
+    ///----------------------------------------------------------------------------------
+    bool fromPreviousTrace(const MessageTraceRecord& record) const;
+
+    static void writerThread(MessageTracer* tracer);
+
+    std::vector<MessageTraceRecord> m_Ring;
+    size_t m_Mask;
+    std::atomic<size_t> m_Head;  // Next record to write to file
+    std::atomic<size_t> m_Tail;  // Next free record
+    std::atomic<unsigned long> m_Dropped;
+
+    std::atomic<bool> m_Enabled;
+    FILE* m_File;
+    std::thread* m_Thread;
+    std::mutex m_Mutex;  // Used by the writer thread to sleep
+    std::condition_variable m_StopCondition;
+    bool m_StopRequested;
+    uint64_t m_StartTime;  // Set by start() before the writer thread starts
+};
@@ -15,6 +15,7 @@
 
 #pragma once
 
+#include <stddef.h>
 #include <string>
 
 enum class MessageType {
@@ -45,9 +46,14 @@ enum class MessageType {
     SailCommand,
     DataCollectionStart,
     DataCollectionStop,
-    CurrentSensorData
+    CurrentSensorData,
+
+    // Not a message type but the number of them, new types go above it
+    MessageTypeCount
 };
 
+#define MESSAGE_TYPE_COUNT static_cast<size_t>(MessageType::MessageTypeCount)
+
 inline std::string msgToString(MessageType msgType) {
     switch (msgType) {
         case MessageType::DataRequest:
@@ -106,6 +112,8 @@ inline std::string msgToString(MessageType msgType) {
             return "DataCollectionStop";
         case MessageType::CurrentSensorData:
             return "CurrentSensorData";
+        case MessageType::MessageTypeCount:
+            break;
     }
     return "";
 }
@@ -0,0 +1,84 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NodeMailbox.h
+ *
+ * Purpose:
+ *		A bounded, lock-free single producer/single consumer queue of messages waiting
+ *		to be processed by one node.
+ *
+ * Developer Notes:
+ *		The message bus thread is the only producer. Consumers are the worker threads of
+ *		the NodeWorkerPool, which only let one worker at a time drain a given mailbox,
+ *		so the mailbox never sees two concurrent consumers.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "../MessageBus/Message.h"
+
+// A message shared between the mailboxes of all the nodes it is delivered to.
+typedef std::shared_ptr<const Message> SharedMessagePtr;
+
+class NodeMailbox {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// Creates a mailbox that can hold at least the given number of messages, the
+    /// capacity is rounded up to a power of two.
+    ///----------------------------------------------------------------------------------
+    explicit NodeMailbox(size_t capacity) : m_Head(0), m_Tail(0) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_Slots.resize(size);
+        m_Mask = size - 1;
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Appends a message to the mailbox. Returns false if the mailbox is full, in which
+    /// case the message is not queued. Only called by the producer.
+    ///----------------------------------------------------------------------------------
+    bool push(const SharedMessagePtr& msg) {
+        size_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail - m_Head.load(std::memory_order_acquire) > m_Mask) {
+            return false;
+        }
+        m_Slots[tail & m_Mask] = msg;
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Takes the oldest message out of the mailbox. Returns false if the mailbox is
+    /// empty. Only called by the consumer.
+    ///----------------------------------------------------------------------------------
+    bool pop(SharedMessagePtr& msg) {
+        size_t head = m_Head.load(std::memory_order_relaxed);
+        if (head == m_Tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        msg = std::move(m_Slots[head & m_Mask]);
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true if there are no messages waiting in the mailbox.
+    ///----------------------------------------------------------------------------------
+    bool empty() const {
+        return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return m_Slots.size(); }
+
+   private:
+    std::vector<SharedMessagePtr> m_Slots;
+    size_t m_Mask;
+    std::atomic<size_t> m_Head;  // Index of the next message to pop
+    std::atomic<size_t> m_Tail;  // Index of the next free slot
+};
@@ -0,0 +1,222 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NodeWorkerPool.cpp
+ *
+ * Purpose:
+ *		Delivers messages to nodes from a small pool of worker threads, so a slow node
+ *		does not hold up the delivery of messages to the other nodes.
+ *
+ ***************************************************************************************/
+
+#include "../MessageBus/NodeWorkerPool.h"
+#include "../MessageBus/MessageTracer.h"
+#include "../MessageBus/Node.h"
+#include "../SystemServices/Logger.h"
+
+// How many messages a worker processes for a node before giving other nodes a turn
+#define MAX_DRAIN_BATCH	16
+
+
+NodeWorkerPool::NodeWorkerPool(unsigned int workerCount, unsigned int mailboxSize,
+							   MessageBusStats* stats)
+	:m_WorkerCount(workerCount), m_MailboxSize(mailboxSize), m_Stats(stats), m_Running(false)
+{
+	if(m_WorkerCount == 0)
+	{
+		m_WorkerCount = 1;
+	}
+}
+
+NodeWorkerPool::~NodeWorkerPool()
+{
+	stop();
+}
+
+void NodeWorkerPool::addNode(Node& node, NodePriority priority)
+{
+	size_t idIndex = static_cast<size_t>(node.nodeID());
+	if(idIndex >= m_Entries.size())
+	{
+		m_Entries.resize(idIndex + 1);
+	}
+	m_Entries[idIndex].reset(new NodeEntry(node, priority, m_MailboxSize));
+}
+
+void NodeWorkerPool::start()
+{
+	if(m_Running.load())
+	{
+		return;
+	}
+
+	m_Running.store(true);
+	for(unsigned int i = 0; i < m_WorkerCount; i++)
+	{
+		m_Workers.emplace_back(workerThread, this, i);
+	}
+}
+
+void NodeWorkerPool::stop()
+{
+	m_ReadyMutex.lock();
+	m_Running.store(false);
+	m_ReadyMutex.unlock();
+
+	m_ReadyCondition.notify_all();
+
+	for(auto& worker : m_Workers)
+	{
+		worker.join();
+	}
+	m_Workers.clear();
+}
+
+bool NodeWorkerPool::deliver(NodeID id, const SharedMessagePtr& msg)
+{
+	NodeEntry* entry = getEntry(id);
+	if(entry == NULL)
+	{
+		return false;
+	}
+
+	if(not entry->mailbox.push(msg))
+	{
+		if(entry->dropped.fetch_add(1) == 0)
+		{
+			Logger::warning("%s: mailbox of node %s is full, dropping messages", __PRETTY_FUNCTION__,
+				nodeToString(id).c_str());
+		}
+		return false;
+	}
+
+	if(not entry->scheduled.exchange(true))
+	{
+		schedule(entry);
+	}
+	return true;
+}
+
+unsigned long NodeWorkerPool::droppedMessages(NodeID id) const
+{
+	NodeEntry* entry = getEntry(id);
+	if(entry == NULL)
+	{
+		return 0;
+	}
+	return entry->dropped.load();
+}
+
+bool NodeWorkerPool::idle() const
+{
+	for(auto& entry : m_Entries)
+	{
+		if(entry && entry->scheduled.load())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+NodeWorkerPool::NodeEntry* NodeWorkerPool::getEntry(NodeID id) const
+{
+	size_t idIndex = static_cast<size_t>(id);
+	if(idIndex < m_Entries.size())
+	{
+		return m_Entries[idIndex].get();
+	}
+	return NULL;
+}
+
+void NodeWorkerPool::schedule(NodeEntry* entry)
+{
+	m_ReadyMutex.lock();
+	m_ReadyNodes[static_cast<int>(entry->priority)].push_back(entry);
+	m_ReadyMutex.unlock();
+
+	// Any worker can take a high priority node, the others can't be given to the
+	// reserved worker so everyone needs to check.
+	if(entry->priority == NodePriority::High)
+	{
+		m_ReadyCondition.notify_one();
+	}
+	else
+	{
+		m_ReadyCondition.notify_all();
+	}
+}
+
+NodeWorkerPool::NodeEntry* NodeWorkerPool::takeReadyNode(bool highPriorityOnly)
+{
+	int levels = highPriorityOnly ? 1 : NODE_PRIORITY_LEVELS;
+
+	for(int level = 0; level < levels; level++)
+	{
+		if(not m_ReadyNodes[level].empty())
+		{
+			NodeEntry* entry = m_ReadyNodes[level].front();
+			m_ReadyNodes[level].pop_front();
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+void NodeWorkerPool::drain(NodeEntry* entry)
+{
+	SharedMessagePtr msg;
+
+	for(int i = 0; i < MAX_DRAIN_BATCH && entry->mailbox.pop(msg); i++)
+	{
+		if(m_Stats != NULL && m_Stats->enabled())
+		{
+			uint64_t start = MessageTracer::now();
+			entry->nodeRef.processMessage(msg.get());
+
+			m_Stats->recordHandler(entry->nodeRef.nodeID(), msg->messageType(), MessageTracer::now() - start);
+			if(msg->timeEnqueued != 0)
+			{
+				m_Stats->recordLatency(msg->messageType(), start - msg->timeEnqueued);
+			}
+		}
+		else
+		{
+			entry->nodeRef.processMessage(msg.get());
+		}
+		msg.reset();
+	}
+
+	// Give the node back, unless the bus delivered more messages in the meantime and
+	// nobody else has rescheduled it yet.
+	entry->scheduled.store(false);
+	if(not entry->mailbox.empty() && not entry->scheduled.exchange(true))
+	{
+		schedule(entry);
+	}
+}
+
+void NodeWorkerPool::workerThread(NodeWorkerPool* pool, unsigned int workerIndex)
+{
+	// With several workers, the first one is kept for the high priority nodes.
+	bool highPriorityOnly = (workerIndex == 0 && pool->m_WorkerCount > 1);
+
+	while(true)
+	{
+		NodeEntry* entry = NULL;
+
+		std::unique_lock<std::mutex> lock(pool->m_ReadyMutex);
+		pool->m_ReadyCondition.wait(lock, [&]() {
+			return not pool->m_Running.load() || (entry = pool->takeReadyNode(highPriorityOnly)) != NULL;
+		});
+
+		if(entry == NULL)
+		{
+			// Stopped
+			return;
+		}
+		lock.unlock();
+
+		pool->drain(entry);
+	}
+}
@@ -0,0 +1,130 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NodeWorkerPool.h
+ *
+ * Purpose:
+ *		Delivers messages to nodes from a small pool of worker threads, so a slow node
+ *		does not hold up the delivery of messages to the other nodes.
+ *
+ * Developer Notes:
+ *		Every node gets its own bounded mailbox. When the message bus puts a message
+ *		in an idle node's mailbox, the node is scheduled on the ready queue of its
+ *		priority. A worker takes the highest priority ready node and drains a batch of
+ *		its messages. A node is only ever processed by one worker at a time, so nodes
+ *		still receive their messages one by one and in order.
+ *
+ *		When there is more than one worker, the first worker only serves high priority
+ *		nodes, so control nodes are never starved by busy logging nodes.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../MessageBus/MessageBusStats.h"
+#include "../MessageBus/NodeIDs.h"
+#include "../MessageBus/NodeMailbox.h"
+
+class Node;
+
+enum class NodePriority { High = 0, Normal, Low };
+
+#define NODE_PRIORITY_LEVELS 3
+
+class NodeWorkerPool {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param workerCount 		How many worker threads deliver messages.
+    /// @param mailboxSize 		How many messages can wait for each node.
+    /// @param stats 			Where handler timings are recorded when enabled, may be
+    ///							NULL.
+    ///----------------------------------------------------------------------------------
+    NodeWorkerPool(unsigned int workerCount, unsigned int mailboxSize,
+                   MessageBusStats* stats = NULL);
+
+    ///----------------------------------------------------------------------------------
+    /// Stops the workers, messages still waiting in the mailboxes are discarded.
+    ///----------------------------------------------------------------------------------
+    ~NodeWorkerPool();
+
+    ///----------------------------------------------------------------------------------
+    /// Creates a mailbox for a node. Must be called before the workers are started.
+    ///----------------------------------------------------------------------------------
+    void addNode(Node& node, NodePriority priority);
+
+    ///----------------------------------------------------------------------------------
+    /// Starts the worker threads.
+    ///----------------------------------------------------------------------------------
+    void start();
+
+    ///----------------------------------------------------------------------------------
+    /// Stops and joins the worker threads.
+    ///----------------------------------------------------------------------------------
+    void stop();
+
+    ///----------------------------------------------------------------------------------
+    /// Puts a message in the mailbox of a node and schedules the node if it was idle.
+    /// Returns false if the node has no mailbox or its mailbox is full, in which case
+    /// the message is dropped for that node.
+    ///----------------------------------------------------------------------------------
+    bool deliver(NodeID id, const SharedMessagePtr& msg);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how many messages were dropped because the node's mailbox was full.
+    ///----------------------------------------------------------------------------------
+    unsigned long droppedMessages(NodeID id) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns true if no node has messages waiting or being processed.
+    ///----------------------------------------------------------------------------------
+    bool idle() const;
+
+   private:
+    struct NodeEntry {
+        NodeEntry(Node& node, NodePriority priority, unsigned int mailboxSize)
+            : nodeRef(node), priority(priority), mailbox(mailboxSize), scheduled(false), dropped(0) {}
+
+        Node& nodeRef;
+        NodePriority priority;
+        NodeMailbox mailbox;
+        std::atomic<bool> scheduled;  // True while the node is queued or being drained
+        std::atomic<unsigned long> dropped;
+    };
+
+    NodeEntry* getEntry(NodeID id) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Puts a node on the ready queue of its priority and wakes a worker.
+    ///----------------------------------------------------------------------------------
+    void schedule(NodeEntry* entry);
+
+    ///----------------------------------------------------------------------------------
+    /// Takes the highest priority ready node, must be called with m_ReadyMutex held.
+    /// Returns NULL if there is no suitable node.
+    ///----------------------------------------------------------------------------------
+    NodeEntry* takeReadyNode(bool highPriorityOnly);
+
+    ///----------------------------------------------------------------------------------
+    /// Processes a batch of messages of a node and reschedules it if messages are left.
+    ///----------------------------------------------------------------------------------
+    void drain(NodeEntry* entry);
+
+    static void workerThread(NodeWorkerPool* pool, unsigned int workerIndex);
+
+    unsigned int m_WorkerCount;
+    unsigned int m_MailboxSize;
+    MessageBusStats* m_Stats;
+    std::vector<std::unique_ptr<NodeEntry>> m_Entries;  // Indexed by NodeID
+    std::deque<NodeEntry*> m_ReadyNodes[NODE_PRIORITY_LEVELS];
+    std::mutex m_ReadyMutex;  // Guards the ready queues
+    std::condition_variable m_ReadyCondition;
+    std::vector<std::thread> m_Workers;
+    std::atomic<bool> m_Running;
+};
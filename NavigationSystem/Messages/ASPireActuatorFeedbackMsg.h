@@ -4,6 +4,8 @@
 
 class ASPireActuatorFeedbackMsg : public Message {
    public:
+    POOLED_MESSAGE(ASPireActuatorFeedbackMsg)
+
     ASPireActuatorFeedbackMsg(NodeID sourceID,
                               NodeID destinationID,
                               double wingsailFeedback,
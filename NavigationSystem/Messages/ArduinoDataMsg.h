@@ -17,6 +17,8 @@
 
 class ArduinoDataMsg : public Message {
    public:
+    POOLED_MESSAGE(ArduinoDataMsg)
+
     ArduinoDataMsg(NodeID destinationID,
                    NodeID sourceID,
                    int pressure,
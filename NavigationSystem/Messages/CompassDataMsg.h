@@ -17,6 +17,8 @@
 
 class CompassDataMsg : public Message {
    public:
+    POOLED_MESSAGE(CompassDataMsg)
+
     CompassDataMsg(NodeID destinationID, NodeID sourceID, int heading, int pitch, int roll)
         : Message(MessageType::CompassData, sourceID, destinationID),
           m_Heading(heading),
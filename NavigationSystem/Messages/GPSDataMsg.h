@@ -23,6 +23,8 @@ enum class GPSMode {
 
 class GPSDataMsg : public Message {
    public:
+    POOLED_MESSAGE(GPSDataMsg)
+
     GPSDataMsg(NodeID destinationID,
                NodeID sourceID,
                bool hasFix,
@@ -4,6 +4,8 @@
 
 class LocalNavigationMsg : public Message {
    public:
+    POOLED_MESSAGE(LocalNavigationMsg)
+
     LocalNavigationMsg(NodeID sourceID,
                        NodeID destinationID,
                        float targetCourse,
@@ -17,6 +17,8 @@
 
 class MarineSensorDataMsg : public Message {
    public:
+    POOLED_MESSAGE(MarineSensorDataMsg)
+
     MarineSensorDataMsg(NodeID destinationID,
                         NodeID sourceID,
                         float temperature,
@@ -4,6 +4,8 @@
 
 class RudderCommandMsg : public Message {
    public:
+    POOLED_MESSAGE(RudderCommandMsg)
+
     RudderCommandMsg(NodeID sourceID, NodeID destinationID, float rudderAngle)
         : Message(MessageType::RudderCommand, sourceID, destinationID),
           m_RudderAngle(rudderAngle) {}
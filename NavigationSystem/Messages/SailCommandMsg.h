@@ -4,6 +4,8 @@
 
 class SailCommandMsg : public Message {
    public:
+    POOLED_MESSAGE(SailCommandMsg)
+
     SailCommandMsg(NodeID sourceID, NodeID destinationID, float maxSailAngle)
         : Message(MessageType::SailCommand, sourceID, destinationID),
           m_MaxSailAngle(maxSailAngle) {}
@@ -17,6 +17,8 @@
 
 class StateMessage : public Message {
    public:
+    POOLED_MESSAGE(StateMessage)
+
     StateMessage(NodeID destinationID,
                  NodeID sourceID,
                  float compassHeading,
@@ -17,6 +17,8 @@
 
 class VesselStateMsg : public Message {
    public:
+    POOLED_MESSAGE(VesselStateMsg)
+
     VesselStateMsg(NodeID destinationID,
                    NodeID sourceID,
                    int compassHeading,
@@ -17,6 +17,8 @@
 
 class WindDataMsg : public Message {
    public:
+    POOLED_MESSAGE(WindDataMsg)
+
     WindDataMsg(NodeID destinationID,
                 NodeID sourceID,
                 float windDir,
@@ -9,6 +9,8 @@
 
 class WindStateMsg : public Message {
    public:
+    POOLED_MESSAGE(WindStateMsg)
+
     WindStateMsg(NodeID sourceID,
                  NodeID destinationID,
                  double trueWindSpeed,
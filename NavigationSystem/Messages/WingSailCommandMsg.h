@@ -4,6 +4,8 @@
 
 class WingSailCommandMsg : public Message {
    public:
+    POOLED_MESSAGE(WingSailCommandMsg)
+
     WingSailCommandMsg(NodeID sourceID, NodeID destinationID, float tailAngle)
         : Message(MessageType::WingSailCommand, sourceID, destinationID), m_TailAngle(tailAngle) {}
 
@@ -271,7 +271,7 @@ void LineFollowNode::LineFollowNodeThreadFunc(ActiveNode* nodePtr)
 {
     LineFollowNode* node = dynamic_cast<LineFollowNode*> (nodePtr);
 
-    std::this_thread::sleep_for(std::chrono::milliseconds( INITIAL_SLEEP ));
+    SimulatedClock::sleepFor(std::chrono::milliseconds( INITIAL_SLEEP ));
 
     Timer timer;
     timer.start();
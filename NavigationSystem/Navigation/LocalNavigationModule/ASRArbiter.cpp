@@ -27,28 +27,14 @@ ASRArbiter::ASRArbiter()
 ///----------------------------------------------------------------------------------
 void ASRArbiter::castVote( const int16_t weight, const ASRCourseBallot& ballot )
 {
-    for( uint16_t i = 0; i < 360; i+= ASRCourseBallot::COURSE_RESOLUTION )
-    {
-        courseBallot.add( i, ballot.get(i) * weight );
-    }
+    courseBallot.addWeighted( ballot, weight );
 }
 
 ///----------------------------------------------------------------------------------
 const uint16_t ASRArbiter::getWinner() const
 {
-    uint16_t highestIndex;
-    int16_t highestValue = -1;
-
-    for( uint16_t i = 0; i < 360; i+= ASRCourseBallot::COURSE_RESOLUTION )
-    {
-        if( courseBallot.get(i) > highestValue )
-        {
-            highestIndex = i;
-            highestValue = courseBallot.get(i);
-        }
-    }
-
-    
+    uint16_t highestIndex = courseBallot.highestCourse();
+    int16_t highestValue = courseBallot.get( highestIndex );
 
     printf("Winning Course: %d With Votes: %d\n", highestIndex, highestValue);
 
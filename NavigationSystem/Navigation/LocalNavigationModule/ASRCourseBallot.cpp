@@ -16,9 +16,77 @@
 #include "ASRCourseBallot.h"
 #include "../Math/Utility.h"
 
+#include <algorithm>
+
 
 #define CALCULATE_INDEX( index ) index / ASRCourseBallot::COURSE_RESOLUTION;
 
+// Eight votes, handled by one SSE or NEON instruction
+typedef int16_t VoteVector __attribute__((vector_size(16)));
+
+// Four votes, widened so that the sums and products can't overflow
+typedef int16_t HalfVoteVector __attribute__((vector_size(8)));
+typedef int32_t WideVector __attribute__((vector_size(16)));
+
+#define VECTOR_LANES 8
+
+
+///----------------------------------------------------------------------------------
+static inline int16_t saturate( int32_t value, int16_t maxVotes )
+{
+    if( value > maxVotes )
+    {
+        return maxVotes;
+    }
+    if( value < INT16_MIN )
+    {
+        return INT16_MIN;
+    }
+    return value;
+}
+
+///----------------------------------------------------------------------------------
+static inline WideVector saturate( WideVector value, WideVector low, WideVector high )
+{
+    WideVector tooHigh = value > high;
+    value = (tooHigh & high) | (~tooHigh & value);
+    WideVector tooLow = value < low;
+    return (tooLow & low) | (~tooLow & value);
+}
+
+///----------------------------------------------------------------------------------
+/// votes[i] = votes[i] + values[i] * weight, saturated, for the count first votes.
+///----------------------------------------------------------------------------------
+static void accumulate( int16_t* votes, const int16_t* values, int32_t weight, uint16_t count, int16_t maxVotes )
+{
+    const WideVector weights = { weight, weight, weight, weight };
+    const WideVector low = { INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN };
+    const WideVector high = { maxVotes, maxVotes, maxVotes, maxVotes };
+
+    uint16_t i = 0;
+    for( ; i + VECTOR_LANES <= count; i += VECTOR_LANES )
+    {
+        HalfVoteVector current[2];
+        HalfVoteVector added[2];
+        memcpy( current, votes + i, sizeof(current) );
+        memcpy( added, values + i, sizeof(added) );
+
+        for( int half = 0; half < 2; half++ )
+        {
+            WideVector sum = __builtin_convertvector( current[half], WideVector ) +
+                __builtin_convertvector( added[half], WideVector ) * weights;
+            current[half] = __builtin_convertvector( saturate( sum, low, high ), HalfVoteVector );
+        }
+
+        memcpy( votes + i, current, sizeof(current) );
+    }
+
+    for( ; i < count; i++ )
+    {
+        votes[i] = saturate( votes[i] + values[i] * weight, maxVotes );
+    }
+}
+
 
 ///----------------------------------------------------------------------------------
 ASRCourseBallot::ASRCourseBallot( int16_t maxVotes )
@@ -50,15 +118,67 @@ void ASRCourseBallot::add( uint16_t course, int16_t value )
     course = Utility::wrapAngle( course );
 
     course = CALCULATE_INDEX( course );
-    value += courses[course];
 
     // cap the vote
-    if( value > MAX_VOTES )
+    courses[course] = saturate( courses[course] + value, MAX_VOTES );
+}
+
+///----------------------------------------------------------------------------------
+void ASRCourseBallot::addKernel( int16_t firstCourse, const int16_t* kernel, uint16_t length )
+{
+    uint16_t index = Utility::wrapAngle( firstCourse );
+    index = CALCULATE_INDEX( index );
+
+    // At most once around, then again from course 0
+    while( length > 0 )
     {
-        value = MAX_VOTES;
+        uint16_t run = std::min( length, (uint16_t)(ASRCourseBallot::ELEMENT_COUNT - index) );
+        accumulate( courses + index, kernel, 1, run, MAX_VOTES );
+
+        kernel += run;
+        length -= run;
+        index = 0;
     }
+}
 
-    courses[course] = value;
+///----------------------------------------------------------------------------------
+void ASRCourseBallot::addWeighted( const ASRCourseBallot& ballot, int16_t weight )
+{
+    accumulate( courses, ballot.courses, weight, ASRCourseBallot::ELEMENT_COUNT, MAX_VOTES );
+}
+
+///----------------------------------------------------------------------------------
+uint16_t ASRCourseBallot::highestCourse() const
+{
+    // The highest vote, lane by lane then across the lanes
+    VoteVector highestVotes;
+    for( int lane = 0; lane < VECTOR_LANES; lane++ )
+    {
+        highestVotes[lane] = INT16_MIN;
+    }
+
+    int i = 0;
+    for( ; i + VECTOR_LANES <= ASRCourseBallot::ELEMENT_COUNT; i += VECTOR_LANES )
+    {
+        VoteVector votes;
+        memcpy( &votes, courses + i, sizeof(votes) );
+        VoteVector higher = votes > highestVotes;
+        highestVotes = (higher & votes) | (~higher & highestVotes);
+    }
+
+    int16_t highest = INT16_MIN;
+    for( int lane = 0; lane < VECTOR_LANES; lane++ )
+    {
+        highest = std::max( highest, (int16_t)highestVotes[lane] );
+    }
+    for( ; i < ASRCourseBallot::ELEMENT_COUNT; i++ )
+    {
+        highest = std::max( highest, courses[i] );
+    }
+
+    // The first course that has it
+    const int16_t* first = std::find( courses, courses + ASRCourseBallot::ELEMENT_COUNT, highest );
+    return (first - courses) * ASRCourseBallot::COURSE_RESOLUTION;
 }
 
 ///----------------------------------------------------------------------------------
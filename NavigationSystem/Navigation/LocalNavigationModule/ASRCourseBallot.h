@@ -8,6 +8,14 @@
  *      course headings and their votes. It provides functions for setting and clearing
  *      the voting scores, as well as accessing the underlying structure.
  *
+ * Developer Notes:
+ *		The bulk operations (addKernel, addWeighted and highestCourse) work on eight
+ *		votes at a time with GCC vector extensions, which become SSE or NEON
+ *		instructions. The votes are kept aligned on 16 bytes for them.
+ *
+ *		Adding votes saturates: the result is capped at maxVotes() and never wraps
+ *		around below INT16_MIN.
+ *
  * License:
  *      This file is subject to the terms and conditions defined in the file
  *      'LICENSE.txt', which is part of this source code package.
@@ -39,6 +47,22 @@ class ASRCourseBallot {
     ///----------------------------------------------------------------------------------
     void add(uint16_t course, int16_t value);
 
+    ///----------------------------------------------------------------------------------
+    /// Adds kernel[i] to the i-th course from firstCourse, for i below length, wrapping
+    /// around 360. The kernel is in ballot elements, not degrees.
+    ///----------------------------------------------------------------------------------
+    void addKernel(int16_t firstCourse, const int16_t* kernel, uint16_t length);
+
+    ///----------------------------------------------------------------------------------
+    /// Adds weight times the votes of another ballot to every course.
+    ///----------------------------------------------------------------------------------
+    void addWeighted(const ASRCourseBallot& ballot, int16_t weight);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the course with the most votes, the lowest one when several have them.
+    ///----------------------------------------------------------------------------------
+    uint16_t highestCourse() const;
+
     ///----------------------------------------------------------------------------------
     /// Resets the ballot, clearing all set votes.
     ///----------------------------------------------------------------------------------
@@ -72,5 +96,5 @@ class ASRCourseBallot {
 
    private:
     const int16_t MAX_VOTES;
-    int16_t courses[ELEMENT_COUNT];
+    alignas(16) int16_t courses[ELEMENT_COUNT];
 };
\ No newline at end of file
@@ -70,6 +70,7 @@ bool LocalNavigationModule::init()
 ///----------------------------------------------------------------------------------
 void LocalNavigationModule::start()
 {
+    m_VoterPool.start();
     runThread(WakeupThreadFunc);
 }
 
@@ -156,26 +157,14 @@ void LocalNavigationModule::startBallot()
         boatState.lastWaypointLon = boatState.lon;
     }
 
-    std::vector<ASRVoter*>::iterator it;
+    m_VoterPool.vote( voters, boatState );
 
-    for( it = voters.begin(); it != voters.end(); it++ )
+    // Always in the same order, the ballot saturates so the order could change the result
+    for( size_t i = 0; i < voters.size(); i++ )
     {
-        ASRVoter* voter = (*it);
-        arbiter.castVote( voter->weight(), voter->vote( boatState ) );
+        arbiter.castVote( voters[i]->weight(), m_VoterPool.ballot(i) );
     }
 
-    printf("[Voters] "); // Debug
-    for( it = voters.begin(); it != voters.end(); it++ )
-    {
-        ASRVoter* voter = (*it);
-        int16_t votes = 0;
-        uint16_t bestCourse = voter->getBestCourse(votes);
-
-        std::string name = voter->getName();
-        printf("%s : %d %d ", name.c_str(), bestCourse, votes); // Debug: Prints out some voting information
-    }
-    printf("\n");
-
     uint16_t targetCourse = arbiter.getWinner();
     bool targetTackStarboard = getTargetTackStarboard((double) targetCourse);
     MessagePtr msg = std::make_unique<LocalNavigationMsg>((float) targetCourse, NO_COMMAND, 0, targetTackStarboard);
@@ -201,7 +190,7 @@ void LocalNavigationModule::WakeupThreadFunc( ActiveNode* nodePtr )
 
 	// An initial sleep, its purpose is to ensure that most if not all the sensor data arrives
 	// at the start before we send out the vessel state message.
-	std::this_thread::sleep_for( std::chrono::milliseconds( WAKEUP_INTIAL_SLEEP ) );
+	SimulatedClock::sleepFor( std::chrono::milliseconds( WAKEUP_INTIAL_SLEEP ) );
 
     Timer timer;
     timer.start();
@@ -20,6 +20,7 @@
 #include "ASRArbiter.h"
 #include "ASRVoter.h"
 #include "BoatState.h"
+#include "VoterPool.h"
 
 class LocalNavigationModule : public ActiveNode {
    public:
@@ -34,7 +35,7 @@ class LocalNavigationModule : public ActiveNode {
     bool init();
 
     ///----------------------------------------------------------------------------------
-    /// Starts the quick hack wakeup thread
+    /// Starts the voter pool and the quick hack wakeup thread
     ///----------------------------------------------------------------------------------
     void start();
 
@@ -53,10 +54,17 @@ class LocalNavigationModule : public ActiveNode {
     ///----------------------------------------------------------------------------------
     void registerVoter(ASRVoter* voter);
 
+    ///----------------------------------------------------------------------------------
+    /// The pool the voters vote from, it records how long each voter takes. The voters
+    /// are in the order they were registered in.
+    ///----------------------------------------------------------------------------------
+    const VoterPool& voterPool() const { return m_VoterPool; }
+
    private:
     ///----------------------------------------------------------------------------------
-    /// Starts a ballot, asking every registered voter to vote. Once that is done it
-    /// the final result is generated and a Local Navigation message is created.
+    /// Starts a ballot, asking every registered voter to vote at the same time. Once
+    /// they all have, their ballots are merged in the order the voters were registered
+    /// in, the final result is generated and a Local Navigation message is created.
     ///----------------------------------------------------------------------------------
     void startBallot();
 
@@ -77,6 +85,7 @@ class LocalNavigationModule : public ActiveNode {
     static void WakeupThreadFunc(ActiveNode* nodePtr);
 
     std::vector<ASRVoter*> voters;
+    VoterPool m_VoterPool;
     BoatState_t boatState;
     ASRArbiter arbiter;
     double m_LoopTime;
@@ -0,0 +1,152 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		VoterPool.cpp
+ *
+ * Purpose:
+ *		Asks the voters of a ballot to vote from a small fixed pool of threads.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+
+#include "VoterPool.h"
+
+#include <chrono>
+
+
+///----------------------------------------------------------------------------------
+VoterPool::VoterPool( unsigned int workerCount )
+    :m_WorkerCount( workerCount ), m_Running( false ), m_Ballot( 0 ), m_Remaining( 0 ),
+    m_Voters( NULL ), m_BoatState( NULL ), m_VoterCount( 0 ), m_NextVoter( 0 )
+{
+}
+
+///----------------------------------------------------------------------------------
+VoterPool::~VoterPool()
+{
+    stop();
+}
+
+///----------------------------------------------------------------------------------
+void VoterPool::start()
+{
+    std::lock_guard<std::mutex> lock( m_Mutex );
+    if( m_Running )
+    {
+        return;
+    }
+
+    m_Running = true;
+    for( unsigned int i = 0; i < m_WorkerCount; i++ )
+    {
+        m_Workers.emplace_back( workerThread, this );
+    }
+}
+
+///----------------------------------------------------------------------------------
+void VoterPool::stop()
+{
+    m_Mutex.lock();
+    m_Running = false;
+    m_Mutex.unlock();
+
+    m_StartCondition.notify_all();
+
+    for( auto& worker : m_Workers )
+    {
+        worker.join();
+    }
+    m_Workers.clear();
+}
+
+///----------------------------------------------------------------------------------
+void VoterPool::vote( const std::vector<ASRVoter*>& voters, const BoatState_t& boatState )
+{
+    m_Ballots.resize( voters.size() );
+    m_LastDurationUs.resize( voters.size() );
+    while( m_Durations.size() < voters.size() )
+    {
+        m_Durations.emplace_back( new LatencyHistogram() );
+    }
+
+    uint64_t ballot;
+    {
+        std::lock_guard<std::mutex> lock( m_Mutex );
+        m_Voters = &voters;
+        m_BoatState = &boatState;
+        m_Remaining = voters.size();
+        m_VoterCount = voters.size();
+        m_NextVoter = 0;
+        ballot = ++m_Ballot;
+    }
+    m_StartCondition.notify_all();
+
+    runVoters( &voters, &boatState, ballot );
+
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    m_DoneCondition.wait( lock, [this]() { return m_Remaining == 0; } );
+}
+
+///----------------------------------------------------------------------------------
+void VoterPool::runVoters( const std::vector<ASRVoter*>* voters, const BoatState_t* boatState,
+    uint64_t ballot )
+{
+    std::unique_lock<std::mutex> lock( m_Mutex );
+    while( true )
+    {
+        // While a voter is left the ballot hasn't returned, so the voters are still there
+        if( m_Ballot != ballot || m_NextVoter >= m_VoterCount )
+        {
+            return;
+        }
+        size_t index = m_NextVoter++;
+        lock.unlock();
+
+        ASRVoter* voter = (*voters)[index];
+        auto start = std::chrono::steady_clock::now();
+        m_Ballots[index] = &voter->vote( *boatState );
+        uint64_t duration = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start ).count();
+
+        m_LastDurationUs[index] = duration;
+        m_Durations[index]->record( duration );
+
+        lock.lock();
+        if( --m_Remaining == 0 )
+        {
+            m_DoneCondition.notify_all();
+        }
+    }
+}
+
+///----------------------------------------------------------------------------------
+void VoterPool::workerThread( VoterPool* pool )
+{
+    uint64_t lastBallot = 0;
+
+    while( true )
+    {
+        const std::vector<ASRVoter*>* voters;
+        const BoatState_t* boatState;
+        {
+            std::unique_lock<std::mutex> lock( pool->m_Mutex );
+            pool->m_StartCondition.wait( lock, [&]() {
+                return not pool->m_Running || pool->m_Ballot != lastBallot;
+            });
+
+            if( not pool->m_Running )
+            {
+                return;
+            }
+            lastBallot = pool->m_Ballot;
+            voters = pool->m_Voters;
+            boatState = pool->m_BoatState;
+        }
+
+        pool->runVoters( voters, boatState, lastBallot );
+    }
+}
@@ -0,0 +1,116 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		VoterPool.h
+ *
+ * Purpose:
+ *		Asks the voters of a ballot to vote from a small fixed pool of threads, so an
+ *		expensive voter doesn't add its time to every other voter's.
+ *
+ * Developer Notes:
+ *		The thread that starts the ballot votes too, the workers only help it: with no
+ *		workers started the voters simply vote one after the other on that thread.
+ *
+ *		Every voter writes its own ballot, and a voter only ever votes on one thread
+ *		at a time. The voters are handed out under the mutex, and only for the ballot
+ *		the worker woke up for: a worker that wakes up late finds none left rather than
+ *		reading the voters of a ballot that has finished. The ballots are kept in the
+ *		order the voters were given in, so the arbiter can merge them in the same order
+ *		whichever voter finished first.
+ *
+ *		How long each voter took is recorded in a histogram per voter.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../MessageBus/MessageBusStats.h"
+#include "ASRCourseBallot.h"
+#include "ASRVoter.h"
+#include "BoatState.h"
+
+#define VOTER_POOL_WORKERS 2
+
+class VoterPool {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param workerCount 		How many threads help the one starting the ballot.
+    ///----------------------------------------------------------------------------------
+    VoterPool(unsigned int workerCount = VOTER_POOL_WORKERS);
+
+    ///----------------------------------------------------------------------------------
+    /// Stops the workers.
+    ///----------------------------------------------------------------------------------
+    ~VoterPool();
+
+    ///----------------------------------------------------------------------------------
+    /// Starts the worker threads.
+    ///----------------------------------------------------------------------------------
+    void start();
+
+    ///----------------------------------------------------------------------------------
+    /// Stops and joins the worker threads.
+    ///----------------------------------------------------------------------------------
+    void stop();
+
+    ///----------------------------------------------------------------------------------
+    /// Asks every voter to vote and returns once they all have. Only one ballot can be
+    /// held at a time.
+    ///----------------------------------------------------------------------------------
+    void vote(const std::vector<ASRVoter*>& voters, const BoatState_t& boatState);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the ballot of the n-th voter of the last vote.
+    ///----------------------------------------------------------------------------------
+    const ASRCourseBallot& ballot(size_t voter) const { return *m_Ballots[voter]; }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how long the n-th voter took to vote the last time, in microseconds.
+    ///----------------------------------------------------------------------------------
+    uint64_t lastDurationUs(size_t voter) const { return m_LastDurationUs[voter]; }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how long the n-th voter took to vote, over all the votes.
+    ///----------------------------------------------------------------------------------
+    const LatencyHistogram& durations(size_t voter) const { return *m_Durations[voter]; }
+
+    unsigned int workerCount() const { return m_WorkerCount; }
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// Takes voters of the ballot that haven't voted yet and asks them to vote, until
+    /// none are left or another ballot started.
+    ///----------------------------------------------------------------------------------
+    void runVoters(const std::vector<ASRVoter*>* voters,
+                   const BoatState_t* boatState,
+                   uint64_t ballot);
+
+    static void workerThread(VoterPool* pool);
+
+    unsigned int m_WorkerCount;
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;  // Guards the fields below up to m_NextVoter
+    std::condition_variable m_StartCondition;
+    std::condition_variable m_DoneCondition;
+    bool m_Running;
+    uint64_t m_Ballot;  // Increases with every vote, so the workers know there is a new one
+    size_t m_Remaining;  // Voters that haven't finished voting yet
+    const std::vector<ASRVoter*>* m_Voters;
+    const BoatState_t* m_BoatState;
+    size_t m_VoterCount;
+    size_t m_NextVoter;
+
+    std::vector<const ASRCourseBallot*> m_Ballots;
+    std::vector<uint64_t> m_LastDurationUs;
+    std::vector<std::unique_ptr<LatencyHistogram>> m_Durations;
+};
@@ -16,6 +16,7 @@
 #include "MidRangeVoter.h"
 
 
+#include "../Math/CollisionMath.h"
 #include "../Math/CourseMath.h"
 #include "../Math/Utility.h"
 #include "../SystemServices/Logger.h"
@@ -48,33 +49,57 @@ const ASRCourseBallot& MidRangeVoter::vote( const BoatState_t& boatState )
     static const double MAX_DISTANCE = 1000; // 1KM
     static const double DEFAULT_SAFE_DISTANCE = 100;
     double SAFE_DISTANCE, cpa_weight, cpa_current_weight = 1., safe_dist_cpa = DEFAULT_SAFE_DISTANCE;
-    CollidableList<AISCollidable_t> aisContacts = collidableMgr.getAISContacts();
+
+    // Only the contacts within MAX_DISTANCE are looked at, their CPA is worked out for
+    // every course at once
+    std::shared_ptr<const AISContactSnapshot_t> snapshot = collidableMgr.getAISSnapshot();
+    const AISContactGrid& grid = snapshot->grid;
+
+    double boatEast, boatNorth;
+    grid.plane().project(boatState.lat, boatState.lon, boatEast, boatNorth);
+    grid.query(boatEast, boatNorth, MAX_DISTANCE, m_rows);
+
+    m_east.clear();
+    m_north.clear();
+    m_velocityEast.clear();
+    m_velocityNorth.clear();
+    m_length.clear();
+    for(uint32_t row : m_rows)
+    {
+        float east = grid.m_east[row] - boatEast;
+        float north = grid.m_north[row] - boatNorth;
+        if(east * east + north * north < MIN_DISTANCE * MIN_DISTANCE)
+        {
+            continue;
+        }
+
+        const AISCollidable_t& collidable = snapshot->items[grid.m_item[row]];
+        m_east.push_back(east);
+        m_north.push_back(north);
+        m_velocityEast.push_back(grid.m_velocityEast[row]);
+        m_velocityNorth.push_back(grid.m_velocityNorth[row]);
+        m_length.push_back((collidable.length != 0 && collidable.beam != 0) ? collidable.length : 0);
+    }
+
+    uint32_t count = m_east.size();
+    m_cpa.resize(count * 360);
+    m_tcpa.resize(count * 360);
+    CollisionMath::computeCPAForHeadings(m_east.data(), m_north.data(), m_velocityEast.data(),
+        m_velocityNorth.data(), count, boatState.speed, 1, m_cpa.data(), m_tcpa.data());
 
     for(uint16_t i = 0; i < 360; i++)
     {
         float closestCPA = 10000;
-        //float closestTime = 0;
         double riskOfCollision = 0;
-        float distance = 0;
         SAFE_DISTANCE = DEFAULT_SAFE_DISTANCE;
 
-        for(uint16_t j = 0; j < aisContacts.length(); j++)
+        const float* cpas = &m_cpa[i * count];
+        for(uint32_t j = 0; j < count; j++)
         {
-            AISCollidable_t collidable = aisContacts.next();
-            distance = CourseMath::calculateDTW(boatState.lon, boatState.lat, collidable.longitude, collidable.latitude);
+            //Make sure size data is available
+            SAFE_DISTANCE = std::max(SAFE_DISTANCE, 1.5*m_length[j]);
 
-            if(distance < MIN_DISTANCE || distance > MAX_DISTANCE)
-            {
-                continue;
-            }
-
-            if (collidable.length != 0 && collidable.beam != 0) { //Make sure size data is available
-
-              SAFE_DISTANCE = std::max(SAFE_DISTANCE, 1.5*collidable.length);
-            }
-
-            double time = 0;
-            float cpa = getCPA( collidable, boatState, i, time);
+            float cpa = cpas[j];
             cpa_weight = DEFAULT_SAFE_DISTANCE/SAFE_DISTANCE;
             if(std::max(20.0,cpa*cpa_weight) < closestCPA*cpa_current_weight && cpa < SAFE_DISTANCE && cpa >= 0)
             {
@@ -89,15 +114,8 @@ const ASRCourseBallot& MidRangeVoter::vote( const BoatState_t& boatState )
             riskOfCollision = (safe_dist_cpa - closestCPA) / safe_dist_cpa;
         }
         assignVotes(i, riskOfCollision);
-
-        if(closestCPA < 100)
-        {
-        //Logger::info("CPA %f at %d so votes is %d", closestCPA, i, courseBallot.get(i));
-        //Logger::info("Distance: %f ", distance);
-        }
-
-        aisContacts.reset();
     }
+    courseBallot.addKernel(0, m_votes, 360);
 
     return courseBallot;
 }
@@ -105,8 +123,7 @@ const ASRCourseBallot& MidRangeVoter::vote( const BoatState_t& boatState )
 ///----------------------------------------------------------------------------------
 const void MidRangeVoter::assignVotes( uint16_t course, float collisionRisk )
 {
-    int16_t vote = courseBallot.maxVotes() - (collisionRisk * courseBallot.maxVotes());
-    courseBallot.add(course, vote);
+    m_votes[course] = courseBallot.maxVotes() - (collisionRisk * courseBallot.maxVotes());
 }
 
 ///----------------------------------------------------------------------------------
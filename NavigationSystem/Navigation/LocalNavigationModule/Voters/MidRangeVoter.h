@@ -15,6 +15,8 @@
 
 #pragma once
 
+#include <stdint.h>
+#include <vector>
 #include "../ASRVoter.h"
 #include "../WorldState/CollidableMgr/CollidableMgr.h"
 
@@ -30,6 +32,10 @@ class MidRangeVoter : public ASRVoter {
     ///----------------------------------------------------------------------------------
     const ASRCourseBallot& vote(const BoatState_t& boatState);
 
+    ///----------------------------------------------------------------------------------
+    /// Works out the votes of a course, they are added to the ballot all at once at the
+    /// end of the vote.
+    ///----------------------------------------------------------------------------------
     const void assignVotes(uint16_t course, float collisionRisk);
 
     ///----------------------------------------------------------------------------------
@@ -43,4 +49,15 @@ class MidRangeVoter : public ASRVoter {
 
    private:
     CollidableMgr& collidableMgr;
+
+    // Kept between the votes so they don't allocate once big enough
+    std::vector<uint32_t> m_rows;
+    std::vector<float> m_east;
+    std::vector<float> m_north;
+    std::vector<float> m_velocityEast;
+    std::vector<float> m_velocityNorth;
+    std::vector<float> m_length;
+    std::vector<float> m_cpa;   // 360 rows, one per course, of one CPA per contact
+    std::vector<float> m_tcpa;
+    int16_t m_votes[360];
 };
\ No newline at end of file
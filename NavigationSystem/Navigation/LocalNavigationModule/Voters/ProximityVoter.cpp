@@ -19,6 +19,12 @@
 #include <vector>
 #include "../Math/Utility.h"
 
+// Contacts further away than this are left alone, in metres
+#define AIS_AVOIDANCE_DISTANCE 100.f
+
+// The grid's flat distances differ a little from the great circle ones aisAvoidance uses
+#define AIS_QUERY_MARGIN 1.1
+
 
 ///----------------------------------------------------------------------------------
 ProximityVoter::ProximityVoter( int16_t maxVotes, int16_t weight, CollidableMgr& collidableMgr )
@@ -33,16 +39,19 @@ const ASRCourseBallot& ProximityVoter::vote( const BoatState_t& boatState )
     //test1(boatState, courseBallot, collidableMgr);
     courseBallot.clear();
 
-    CollidableList<AISCollidable_t> aisContacts = collidableMgr.getAISContacts();
+    std::shared_ptr<const AISContactSnapshot_t> aisContacts = collidableMgr.getAISSnapshot();
 
     float currClosest = 2016; // Default high value
     static float lifeTimeClosest = 2016;
 
-    // AIS Contacts
-    for(uint16_t i = 0; i < aisContacts.length(); i++)
-    {
-        AISCollidable_t collidable = aisContacts.next();
+    // AIS Contacts, only those close enough to be avoided
+    double boatEast, boatNorth;
+    aisContacts->grid.plane().project(boatState.lat, boatState.lon, boatEast, boatNorth);
+    aisContacts->grid.query(boatEast, boatNorth, AIS_AVOIDANCE_DISTANCE * AIS_QUERY_MARGIN, m_rows);
 
+    for(uint32_t row : m_rows)
+    {
+        const AISCollidable_t& collidable = aisContacts->items[aisContacts->grid.m_item[row]];
         float distance = aisAvoidance( boatState, collidable );
 
         if(distance < currClosest)
@@ -96,12 +105,12 @@ const ASRCourseBallot& ProximityVoter::vote( const BoatState_t& boatState )
 }
 
 void ProximityVoter::visualAvoidance(){
-    VisualField_t visualField = collidableMgr.getVisualField();
-    if (visualField.bearingToRelativeObstacleDistance.empty()){
+    std::shared_ptr<const VisualField_t> visualField = collidableMgr.getVisualField();
+    if (visualField->bearingToRelativeObstacleDistance.empty()){
         return;
     }
-    avoidOutsideVisualField(visualField.visualFieldLowBearing, visualField.visualFieldHighBearing);
-    for(auto it : visualField.bearingToRelativeObstacleDistance ){
+    avoidOutsideVisualField(visualField->visualFieldLowBearing, visualField->visualFieldHighBearing);
+    for(auto it : visualField->bearingToRelativeObstacleDistance ){
         bearingAvoidanceSmoothed(it.first, it.second);
         bearingPreferenceSmoothed(it.first, it.second);
    }
@@ -134,13 +143,18 @@ void ProximityVoter::bearingAvoidanceSmoothed( int16_t bearing, uint16_t relativ
     if (relativeFreeDistance < 100){
         Logger::info("Decreasing votes around bearing %d with %f", bearing, vote*normalizedVoteAdjust);
     }
-    courseBallot.add(bearing, -vote * normalizedVoteAdjust);
+
+    // Centred on the bearing, decreasing on both sides
+    const uint16_t centre = avoidanceBearingRange - 1;
+    int16_t kernel[2 * avoidanceBearingRange - 1];
+    kernel[centre] = -vote * normalizedVoteAdjust;
     for(uint16_t j = 1; j < avoidanceBearingRange; j++)
     {
         double voteAdjust = vote * normalizedVoteAdjust * (avoidanceNormalization - j)/avoidanceNormalization;
-        courseBallot.add(bearing+j, -voteAdjust);        
-        courseBallot.add(bearing-j, -voteAdjust);        
+        kernel[centre + j] = -voteAdjust;
+        kernel[centre - j] = -voteAdjust;
     }
+    courseBallot.addKernel(bearing - centre, kernel, 2 * avoidanceBearingRange - 1);
 }
 
 void ProximityVoter::bearingPreferenceSmoothed( int16_t bearing, uint16_t relativeFreeDistance )
@@ -157,24 +171,31 @@ void ProximityVoter::bearingPreferenceSmoothed( int16_t bearing, uint16_t relati
     if (relativeFreeDistance < 100){
         Logger::info("Increasing votes around bearing %d with %f", bearing + giveWayAngleStarboard, vote*normalizedVoteAdjustStarboard);        
     }
-    courseBallot.add(bearing + giveWayAngleStarboard, vote * normalizedVoteAdjustStarboard);
-    courseBallot.add(bearing + giveWayAnglePort, vote * normalizedVoteAdjustPort);
+
+    // Centred on the give way angles, decreasing on both sides
+    const uint16_t centre = preferenceBearingRange - 1;
+    int16_t starboardKernel[2 * preferenceBearingRange - 1];
+    int16_t portKernel[2 * preferenceBearingRange - 1];
+    starboardKernel[centre] = vote * normalizedVoteAdjustStarboard;
+    portKernel[centre] = vote * normalizedVoteAdjustPort;
     for(uint16_t j = 1; j < preferenceBearingRange; j++)
     {
         double voteAdjustStarboard =  vote * normalizedVoteAdjustStarboard * (preferenceNormalization - j)/preferenceNormalization;
         double voteAdjustPort =  vote * normalizedVoteAdjustPort * (preferenceNormalization - j)/preferenceNormalization;
-        courseBallot.add(bearing + giveWayAngleStarboard + j, voteAdjustStarboard);        
-        courseBallot.add(bearing + giveWayAngleStarboard - j, voteAdjustStarboard);        
-        courseBallot.add(bearing + giveWayAnglePort + j, voteAdjustPort);        
-        courseBallot.add(bearing + giveWayAnglePort - j, voteAdjustPort);        
+        starboardKernel[centre + j] = voteAdjustStarboard;
+        starboardKernel[centre - j] = voteAdjustStarboard;
+        portKernel[centre + j] = voteAdjustPort;
+        portKernel[centre - j] = voteAdjustPort;
     }
+    courseBallot.addKernel(bearing + giveWayAngleStarboard - centre, starboardKernel, 2 * preferenceBearingRange - 1);
+    courseBallot.addKernel(bearing + giveWayAnglePort - centre, portKernel, 2 * preferenceBearingRange - 1);
 }
 
 ///----------------------------------------------------------------------------------
-float ProximityVoter::aisAvoidance( const BoatState_t& boatState, AISCollidable_t& collidable )
+float ProximityVoter::aisAvoidance( const BoatState_t& boatState, const AISCollidable_t& collidable )
 {
     const float MIN_DISTANCE = 50.f; // Metres
-    const float MAX_DISTANCE = 100.f; // Metres
+    const float MAX_DISTANCE = AIS_AVOIDANCE_DISTANCE;
     const uint16_t AVOIDANCE_BEARING_RANGE = 40;
     uint16_t courseOfEscape = 0;
 
@@ -202,17 +223,26 @@ float ProximityVoter::aisAvoidance( const BoatState_t& boatState, AISCollidable_
             //Logger::info("Course of escape on port of target");
         }
 
+        const uint16_t centre = AVOIDANCE_BEARING_RANGE - 1;
+        int16_t towardsKernel[2 * AVOIDANCE_BEARING_RANGE - 1];
+        int16_t awayKernel[2 * AVOIDANCE_BEARING_RANGE - 1];
+        int16_t vote = (MIN_DISTANCE / distance) * courseBallot.maxVotes();
         for(uint16_t j = 0; j < AVOIDANCE_BEARING_RANGE; j++)
         {
-            int16_t vote = (MIN_DISTANCE / distance) * courseBallot.maxVotes();
             // Towards the target's course, reduce votes
-            courseBallot.add(courseOfEscape + 180 + j, -(vote / (j + 1)));
-            courseBallot.add(courseOfEscape + 180 - j, -(vote / (j + 1)));
+            towardsKernel[centre + j] = -(vote / (j + 1));
+            towardsKernel[centre - j] = -(vote / (j + 1));
 
             // Away from the target's course, increase votes
-            courseBallot.add(courseOfEscape + j, vote - (j/2));
-            courseBallot.add(courseOfEscape - j, vote - (j/2));
+            awayKernel[centre + j] = vote - (j/2);
+            awayKernel[centre - j] = vote - (j/2);
         }
+        courseBallot.addKernel(courseOfEscape + 180 - centre, towardsKernel, 2 * AVOIDANCE_BEARING_RANGE - 1);
+        courseBallot.addKernel(courseOfEscape - centre, awayKernel, 2 * AVOIDANCE_BEARING_RANGE - 1);
+
+        // Both sides start on the courses themselves, they get the votes twice
+        courseBallot.add(courseOfEscape + 180, towardsKernel[centre]);
+        courseBallot.add(courseOfEscape, awayKernel[centre]);
     }
 
     return distance;
@@ -40,6 +40,7 @@ class ProximityVoter : public ASRVoter {
     void bearingAvoidanceSmoothed(int16_t bearing, uint16_t relativeObstacleDistance);
     void bearingPreferenceSmoothed(int16_t bearing, uint16_t relativeObstacleDistance);
 
-    float aisAvoidance(const BoatState_t& boatState, AISCollidable_t& collidable);
+    float aisAvoidance(const BoatState_t& boatState, const AISCollidable_t& collidable);
     CollidableMgr& collidableMgr;
+    std::vector<uint32_t> m_rows;  // The grid rows of the contacts near the boat
 };
\ No newline at end of file
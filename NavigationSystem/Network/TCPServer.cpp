@@ -17,23 +17,37 @@
 #include <arpa/inet.h>  //inet_addr
 #include <errno.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <unistd.h>
+#include <chrono>
 #include <cstring>
 
 #include "../SystemServices/Logger.h"
-#include "../SystemServices/SysClock.h"
 
 #define ERROR -1
-#define SELECT_TIMEOUT_SEC 0
-#define SELECT_TIMEOUT_USEC 500
+#define LENGTH_PREFIX_SIZE 2
+#define RECEIVE_BUFFER_SIZE 4096
+#define MAX_EVENTS 16
 
 ///----------------------------------------------------------------------------------
-TCPServer::TCPServer() : serverSocket(-1), highestFD(0) {
-    printf("%d\n", (int)clients.size());
+/// Returns how many milliseconds are left until the deadline, -1 if there is no
+/// deadline (a timeout of 0) and 0 if it has passed.
+///----------------------------------------------------------------------------------
+static int remainingMs(uint32_t timeout, std::chrono::steady_clock::time_point deadline) {
+    if (timeout == 0) {
+        return -1;
+    }
+
+    auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now());
+    return remaining.count() > 0 ? remaining.count() : 0;
 }
 
+///----------------------------------------------------------------------------------
+TCPServer::TCPServer() : serverSocket(-1), epollFD(-1), nextClient(0) {}
+
 ///----------------------------------------------------------------------------------
 int TCPServer::start(int port) {
     int optionOn = 1;
@@ -97,29 +111,52 @@ int TCPServer::start(int port) {
         return ERROR;
     }
 
-    FD_ZERO(&fdSet);
-    FD_SET(serverSocket, &fdSet);
-    highestFD = serverSocket;
+    // The server socket and the clients' are all waited on together
+    epollFD = epoll_create1(EPOLL_CLOEXEC);
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = serverSocket;
+
+    if (epollFD < 0 || epoll_ctl(epollFD, EPOLL_CTL_ADD, serverSocket, &event) < 0) {
+        Logger::error("Failed to set up the server socket events!");
+        if (epollFD >= 0) {
+            close(epollFD);
+            epollFD = -1;
+        }
+        close(serverSocket);
+        serverSocket = -1;
+        return ERROR;
+    }
 
     return 1;
 }
 
 ///----------------------------------------------------------------------------------
 void TCPServer::shutdown() {
+    while (not clients.empty()) {
+        removeClient(clients.size() - 1);
+    }
+
+    if (epollFD >= 0) {
+        close(epollFD);
+        epollFD = -1;
+    }
+
     close(serverSocket);
     serverSocket = -1;
-
-    // TODO: Disconnect clients
 }
 
 ///----------------------------------------------------------------------------------
 void TCPServer::broadcast(const uint8_t* data, const uint16_t size) {
-    int bytesLeft = size;
-    int bytesSent = 0;
     int rc = 0;
 
     for (size_t i = 0; i < clients.size(); i++) {
-        tcpClient_t client = clients[i];
+        tcpClient_t& client = clients[i];
+        int bytesLeft = size;
+        int bytesSent = 0;
+
         while (bytesLeft > 0) {
             rc = send(client.socketFD, &data[bytesSent], bytesLeft, MSG_NOSIGNAL);
 
@@ -138,31 +175,12 @@ void TCPServer::broadcast(const uint8_t* data, const uint16_t size) {
 ///----------------------------------------------------------------------------------
 void TCPServer::acceptConnections() {
     if (serverSocket > 0) {
-        int eventCount = 0;
-
-        struct timeval timeout;
-        timeout.tv_sec = SELECT_TIMEOUT_SEC;
-        timeout.tv_usec = SELECT_TIMEOUT_USEC;
-
-        // Make a copy
-        fd_set tmp = fdSet;
-
-        eventCount = select(highestFD + 1, &tmp, NULL, NULL, &timeout);
-
-        if (eventCount == -1) {
-            Logger::error("Failed to process server socket events!");
-        }
-
-        // Check the listener socket, this would be a incoming connection.
-        if (eventCount > 0 && FD_ISSET(serverSocket, &tmp)) {
-            int clientFD = 0;
-            int rc = 0;
+        // The server socket is non-blocking, accept fails once nobody is waiting
+        int clientFD = accept(serverSocket, NULL, NULL);
 
-            do {
-                clientFD = accept(serverSocket, NULL, NULL);
-                rc = setupClient(clientFD);
-
-            } while (rc <= 0);
+        while (clientFD >= 0) {
+            setupClient(clientFD);
+            clientFD = accept(serverSocket, NULL, NULL);
         }
     }
 }
@@ -170,20 +188,29 @@ void TCPServer::acceptConnections() {
 ///----------------------------------------------------------------------------------
 int TCPServer::acceptConnection(uint32_t timeout) {
     if (serverSocket > 0) {
-        bool timedOut = false;
-        int clientFD = 0;
-        int startTime = SysClock::unixTime();
-        unsigned long endTime = startTime + timeout;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
 
-        while (!timedOut) {
-            clientFD = accept(serverSocket, NULL, NULL);
+        while (true) {
+            int clientFD = accept(serverSocket, NULL, NULL);
 
-            if (clientFD > 0 && setupClient(clientFD)) {
-                return 1;
+            if (clientFD >= 0) {
+                return setupClient(clientFD);
+            }
+
+            int waitMs = remainingMs(timeout, deadline);
+            if (waitMs == 0) {
+                // Timed out
+                return 0;
             }
 
-            if (timeout > 0 && (SysClock::unixTime() > endTime)) {
-                timedOut = false;
+            pollfd serverEvents;
+            serverEvents.fd = serverSocket;
+            serverEvents.events = POLLIN;
+            serverEvents.revents = 0;
+
+            if (poll(&serverEvents, 1, waitMs) < 0 && errno != EINTR) {
+                Logger::error("Failed to wait for a connection! %s", strerror(errno));
+                return 0;
             }
         }
     }
@@ -193,45 +220,64 @@ int TCPServer::acceptConnection(uint32_t timeout) {
 
 ///----------------------------------------------------------------------------------
 int TCPServer::readPacket(TCPPacket_t& packet, uint32_t timeout) {
-    if (serverSocket > 0) {
-        // Makes things a little more thread safe, but still not truely thread safe,
-        // our weakness being this copy
-        std::vector<tcpClient_t> clientCopy = clients;
-
-        int bytesRead = 0;
-        uint16_t length = 0;
-        bool timedOut = false;
-        int startTime = SysClock::unixTime();
-        unsigned long endTime = startTime + timeout;
-
-        while (!timedOut) {
-            for (uint16_t i = 0; i < clientCopy.size(); i++) {
-                tcpClient_t* client = &clientCopy[i];
-                bytesRead = read(client->socketFD, &length, 2);
-
-                // We have a packet read for us
-                if (bytesRead == 2) {
-                    bytesRead = read(client->socketFD, packet.data, length);
-
-                    // Valid packet
-                    if (bytesRead == length) {
-                        packet.socketFD = client->socketFD;
-                        packet.length = length;
-
-                        return 1;
-                    } else {
-                        Logger::info("invalid packet, length: %i", length);
-                        Logger::info("invalid packet, bytes read: %i", bytesRead);
-                    }
-                }
+    if (serverSocket <= 0) {
+        return 0;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+    epoll_event events[MAX_EVENTS];
+
+    while (true) {
+        // The packets already received first, starting after the client the last packet
+        // came from
+        size_t i = 0;
+        while (i < clients.size()) {
+            size_t index = (nextClient + i) % clients.size();
+            int rc = nextPacket(clients[index], packet);
+
+            if (rc > 0) {
+                nextClient = index + 1;
+                return 1;
+            } else if (rc < 0) {
+                Logger::warning("Invalid packet from a client, disconnecting it");
+                removeClient(index);
+                i = 0;
+            } else {
+                i++;
             }
+        }
+
+        int waitMs = remainingMs(timeout, deadline);
+        if (waitMs == 0) {
+            // Timed out
+            return 0;
+        }
 
-            if (timeout > 0 && (SysClock::unixTime() > endTime)) {
-                timedOut = false;
+        int eventCount = epoll_wait(epollFD, events, MAX_EVENTS, waitMs);
+
+        if (eventCount < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error("Failed to wait for the server socket events! %s", strerror(errno));
+            return 0;
+        }
+
+        for (int event = 0; event < eventCount; event++) {
+            int socketFD = events[event].data.fd;
+
+            if (socketFD == serverSocket) {
+                acceptConnections();
+                continue;
+            }
+
+            int index = findClient(socketFD);
+            if (index >= 0 && not receive(clients[index])) {
+                Logger::info("A client has disconnected!");
+                removeClient(index);
             }
         }
     }
-    return 0;
 }
 
 ///----------------------------------------------------------------------------------
@@ -240,6 +286,12 @@ void TCPServer::clearSocketBuffer(int socketFD) {
 
     while (read(socketFD, buffer, 512) > 0)
         ;
+
+    int index = findClient(socketFD);
+    if (index >= 0) {
+        clients[index].readStart = 0;
+        clients[index].readEnd = 0;
+    }
 }
 
 ///----------------------------------------------------------------------------------
@@ -269,14 +321,27 @@ int TCPServer::sendData(int socketFD, void* data, uint16_t size) {
 
 ///----------------------------------------------------------------------------------
 int TCPServer::setupClient(int clientFD) {
+    if (clientFD < 0) {
+        return 0;
+    }
+
     // Make the socket non-blocking
-    if (clientFD > 0) {
-        int rc = fcntl(clientFD, F_SETFL, fcntl(clientFD, F_GETFL, 0) | O_NONBLOCK);
-        if (rc < 0) {
-            Logger::error("Failed to make the client socket blocking!");
-            close(clientFD);
-            return 0;
-        }
+    int rc = fcntl(clientFD, F_SETFL, fcntl(clientFD, F_GETFL, 0) | O_NONBLOCK);
+    if (rc < 0) {
+        Logger::error("Failed to make the client socket non-blocking!");
+        close(clientFD);
+        return 0;
+    }
+
+    epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = clientFD;
+
+    if (epoll_ctl(epollFD, EPOLL_CTL_ADD, clientFD, &event) < 0) {
+        Logger::error("Failed to wait for the client socket events!");
+        close(clientFD);
+        return 0;
     }
 
     Logger::info("New client has connected!");
@@ -284,6 +349,89 @@ int TCPServer::setupClient(int clientFD) {
     tcpClient_t client;
     client.socketFD = clientFD;
     client.connected = true;
-    clients.push_back(client);
+    client.readBuffer.resize(RECEIVE_BUFFER_SIZE);
+    client.readStart = 0;
+    client.readEnd = 0;
+    clients.push_back(std::move(client));
+    return 1;
+}
+
+///----------------------------------------------------------------------------------
+void TCPServer::removeClient(size_t index) {
+    epoll_ctl(epollFD, EPOLL_CTL_DEL, clients[index].socketFD, NULL);
+    close(clients[index].socketFD);
+    clients.erase(clients.begin() + index);
+
+    if (nextClient > index) {
+        nextClient--;
+    }
+}
+
+///----------------------------------------------------------------------------------
+bool TCPServer::receive(tcpClient_t& client) {
+    uint8_t* buffer = client.readBuffer.data();
+
+    if (client.readStart == client.readEnd) {
+        client.readStart = 0;
+        client.readEnd = 0;
+    } else if (client.readBuffer.size() - client.readEnd < TCP_MAX_PACKET_LENGTH + LENGTH_PREFIX_SIZE) {
+        // Not enough room left for a whole packet, move what remains to the front. It is
+        // never more than a packet as the complete ones are taken out first.
+        memmove(buffer, buffer + client.readStart, client.readEnd - client.readStart);
+        client.readEnd -= client.readStart;
+        client.readStart = 0;
+    }
+
+    if (client.readEnd == client.readBuffer.size()) {
+        return true;
+    }
+
+    ssize_t bytesRead = recv(client.socketFD, buffer + client.readEnd,
+                             client.readBuffer.size() - client.readEnd, 0);
+
+    if (bytesRead > 0) {
+        client.readEnd += bytesRead;
+        return true;
+    } else if (bytesRead == 0) {
+        return false;
+    }
+
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+///----------------------------------------------------------------------------------
+int TCPServer::nextPacket(tcpClient_t& client, TCPPacket_t& packet) {
+    uint32_t available = client.readEnd - client.readStart;
+    if (available < LENGTH_PREFIX_SIZE) {
+        return 0;
+    }
+
+    const uint8_t* start = client.readBuffer.data() + client.readStart;
+    uint16_t length = 0;
+    memcpy(&length, start, LENGTH_PREFIX_SIZE);
+
+    if (length > TCP_MAX_PACKET_LENGTH) {
+        Logger::info("invalid packet, length: %i", length);
+        return -1;
+    }
+
+    if (available < LENGTH_PREFIX_SIZE + (uint32_t)length) {
+        return 0;
+    }
+
+    packet.socketFD = client.socketFD;
+    packet.length = length;
+    packet.data = start + LENGTH_PREFIX_SIZE;
+    client.readStart += LENGTH_PREFIX_SIZE + length;
     return 1;
 }
+
+///----------------------------------------------------------------------------------
+int TCPServer::findClient(int socketFD) const {
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (clients[i].socketFD == socketFD) {
+            return i;
+        }
+    }
+    return -1;
+}
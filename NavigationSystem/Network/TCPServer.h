@@ -9,17 +9,23 @@
  *      The TCP server expects its data in a packet like format. Each of this packets
  *      must start with a packet length(2 bytes, unsigned short) followed by the data.
  *      Packet data cannot be over 512 bytes. This was a limit imposed by the original
- *      author.
+ *      author. A client sending a longer packet is disconnected.
  *
  * Developer Notes:
  *      * All timeouts are in seconds
  *
+ *      * The server waits on its sockets with epoll, readPacket sleeps until data
+ *        arrives or the timeout expires.
+ *
+ *      * Every client has a receive buffer the packets are parsed from as their bytes
+ *        arrive, however they are split across reads. readPacket hands out a view of
+ *        the packet in that buffer rather than a copy, the view is valid until the
+ *        next call to the server.
+ *
  *      * Most of the issues related to thread safely are due to clients connecting. If
  *        no clients are expected to connect or disconenct during most of these functions
  *        then there won't be a problem. However always double check the function
  *
- *      * Currently this does not really handle clients disconnecting nicely
- *
  * License:
  *      This file is subject to the terms and conditions defined in the file
  *      'LICENSE.txt', which is part of this source code package.
@@ -28,20 +34,27 @@
 
 #pragma once
 
-#include <sys/select.h>
 #include <vector>
 
+#include <stddef.h>
 #include <stdint.h>
 
+#define TCP_MAX_PACKET_LENGTH 512
+
 struct tcpClient_t {
     int socketFD;
     bool connected;
+
+    // The received bytes not handed out yet are [readStart, readEnd)
+    std::vector<uint8_t> readBuffer;
+    uint32_t readStart;
+    uint32_t readEnd;
 };
 
 struct TCPPacket_t {
-    int socketFD;     // Either the destination or sender, depends on context
-    uint16_t length;  // Data length, max 512
-    uint8_t data[512];
+    int socketFD;         // Either the destination or sender, depends on context
+    uint16_t length;      // Data length, max 512
+    const uint8_t* data;  // In the receive buffer of the client, see readPacket
 };
 
 class TCPServer {
@@ -81,12 +94,16 @@ class TCPServer {
     ///----------------------------------------------------------------------------------
     /// Attempts to read a incoming packet from any connected client. Returns 1 if the
     /// read was succesful, or 0 if the read timed out. A timeout of 0 means the function
-    /// blocks until a packet has been succesfully received. Not thread safe
+    /// blocks until a packet has been succesfully received. New connections are
+    /// accepted while waiting. Not thread safe
+    ///
+    /// The packet's data points into the client's receive buffer, it stays valid until
+    /// the next call to the server.
     ///----------------------------------------------------------------------------------
     int readPacket(TCPPacket_t& packet, uint32_t timeout);
 
     ///----------------------------------------------------------------------------------
-    /// Clears a socket's read buffer
+    /// Clears a socket's read buffer, and the bytes already received from it
     ///----------------------------------------------------------------------------------
     void clearSocketBuffer(int socketFD);
 
@@ -101,8 +118,28 @@ class TCPServer {
     ///----------------------------------------------------------------------------------
     int setupClient(int clientFD);
 
+    ///----------------------------------------------------------------------------------
+    /// Stops tracking a client and closes its socket.
+    ///----------------------------------------------------------------------------------
+    void removeClient(size_t index);
+
+    ///----------------------------------------------------------------------------------
+    /// Reads what a client has sent into its receive buffer. Returns false if the
+    /// client has disconnected.
+    ///----------------------------------------------------------------------------------
+    bool receive(tcpClient_t& client);
+
+    ///----------------------------------------------------------------------------------
+    /// Takes the next complete packet out of a client's receive buffer. Returns 1 if
+    /// there was one, 0 if it hasn't fully arrived yet and -1 if the client sent an
+    /// invalid packet.
+    ///----------------------------------------------------------------------------------
+    int nextPacket(tcpClient_t& client, TCPPacket_t& packet);
+
+    int findClient(int socketFD) const;
+
     int serverSocket;
+    int epollFD;
     std::vector<tcpClient_t> clients;
-    fd_set fdSet;
-    int highestFD;
+    size_t nextClient;  // The client to look at first, so every client gets its turn
 };
\ No newline at end of file
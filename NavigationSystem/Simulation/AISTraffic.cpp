@@ -0,0 +1,63 @@
+/****************************************************************************************
+ *
+ * File:
+ *      AISTraffic.cpp
+ *
+ * Purpose:
+ *      Simulates the vessels around the boat for the in process simulation.
+ *
+ * Developer Notes:
+ *
+ *
+ ***************************************************************************************/
+
+#include "AISTraffic.h"
+
+#include <cmath>
+#include "../Math/Utility.h"
+
+///--------------------------------------------------------------------------------------
+AISTraffic::AISTraffic(double latitude, double longitude) : m_Plane(latitude, longitude) {}
+
+///--------------------------------------------------------------------------------------
+void AISTraffic::addVessel(uint16_t mmsi,
+                           double latitude,
+                           double longitude,
+                           double speed,
+                           double course,
+                           float length,
+                           float beam) {
+    AISVessel_t vessel;
+    vessel.mmsi = mmsi;
+    m_Plane.project(latitude, longitude, vessel.east, vessel.north);
+    vessel.speed = speed;
+    vessel.course = course;
+    vessel.length = length;
+    vessel.beam = beam;
+    m_Vessels.push_back(vessel);
+}
+
+///--------------------------------------------------------------------------------------
+void AISTraffic::step(double seconds) {
+    for (AISVessel_t& vessel : m_Vessels) {
+        double course = Utility::degreeToRadian(vessel.course);
+        vessel.east += vessel.speed * std::sin(course) * seconds;
+        vessel.north += vessel.speed * std::cos(course) * seconds;
+    }
+}
+
+///--------------------------------------------------------------------------------------
+void AISTraffic::contact(size_t index, AISContactPacket_t& packet) const {
+    const AISVessel_t& vessel = m_Vessels[index];
+
+    double latitude, longitude;
+    m_Plane.unproject(vessel.east, vessel.north, latitude, longitude);
+    packet.mmsi = vessel.mmsi;
+    packet.latitude = latitude;
+    packet.longitude = longitude;
+    packet.speed = vessel.speed;
+    packet.course = (int16_t)std::lround(Utility::limitAngleRange(90 - vessel.course));
+    packet.length = vessel.length;
+    packet.beam = vessel.beam;
+}
+
@@ -0,0 +1,66 @@
+/****************************************************************************************
+ *
+ * File:
+ *      AISTraffic.h
+ *
+ * Purpose:
+ *      Simulates the vessels around the boat for the in process simulation, each one
+ *      going straight at a constant speed, and reports them like the simulator's AIS
+ *      contacts.
+ *
+ * Developer Notes:
+ *
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "../Math/CollisionMath.h"
+#include "SimulatorPackets.h"
+
+struct AISVessel_t {
+    uint16_t mmsi;
+    double east;    // m
+    double north;   // m
+    double speed;   // m/s
+    double course;  // Degrees clockwise from north
+    float length;   // m
+    float beam;     // m
+};
+
+class AISTraffic {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param latitude 		The origin of the plane the vessels move in, somewhere
+    /// @param longitude 		around where the boat sails.
+    ///----------------------------------------------------------------------------------
+    AISTraffic(double latitude, double longitude);
+
+    void addVessel(uint16_t mmsi,
+                   double latitude,
+                   double longitude,
+                   double speed,
+                   double course,
+                   float length,
+                   float beam);
+
+    ///----------------------------------------------------------------------------------
+    /// Moves every vessel forward in time.
+    ///----------------------------------------------------------------------------------
+    void step(double seconds);
+
+    size_t size() const { return m_Vessels.size(); }
+    const AISVessel_t& vessel(size_t index) const { return m_Vessels[index]; }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns a vessel as the simulator sends it, course counter clockwise from east.
+    ///----------------------------------------------------------------------------------
+    void contact(size_t index, AISContactPacket_t& packet) const;
+
+   private:
+    LocalTangentPlane m_Plane;
+    std::vector<AISVessel_t> m_Vessels;
+};
@@ -0,0 +1,256 @@
+/****************************************************************************************
+ *
+ * File:
+ *      BoatDynamics.cpp
+ *
+ * Purpose:
+ *      Simulates a sail boat or a wing sail boat in process.
+ *
+ * Developer Notes:
+ *
+ *
+ ***************************************************************************************/
+
+#include "BoatDynamics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "../Libs/json/include/nlohmann/json.hpp"
+#include "../Math/Utility.h"
+
+using Json = nlohmann::json;
+
+// Reads a number of a json section if it is there
+static void readValue(const Json& section, const char* key, double& value) {
+    if (section.is_object() && section.count(key) > 0 && section[key].is_number()) {
+        value = section[key].get<double>();
+    }
+}
+
+// Wraps an angle in radians to ]-pi, pi]
+static double wrapRadian(double angle) {
+    angle = std::fmod(angle, 2 * M_PI);
+    if (angle > M_PI) {
+        angle -= 2 * M_PI;
+    } else if (angle <= -M_PI) {
+        angle += 2 * M_PI;
+    }
+    return angle;
+}
+
+static int16_t roundDegrees(double radians) {
+    return (int16_t)std::lround(Utility::radianToDegree(radians));
+}
+
+///--------------------------------------------------------------------------------------
+BoatDynamics::BoatDynamics(bool wingSail) : m_WingSail(wingSail), m_Rudder(0), m_SailOrTail(0) {
+    reset(60.1, 19.9, 0);
+}
+
+///--------------------------------------------------------------------------------------
+bool BoatDynamics::loadConfig(const std::string& filePath) {
+    std::ifstream file(filePath);
+    if (not file.is_open()) {
+        return false;
+    }
+
+    Json config;
+    try {
+        file >> config;
+    } catch (std::exception&) {
+        return false;
+    }
+
+    if (config.count("boat") > 0) {
+        const Json& boat = config["boat"];
+        readValue(boat, "drift", m_Params.drift);
+        readValue(boat, "hullFriction", m_Params.hullFriction);
+        readValue(boat, "angularFriction", m_Params.angularFriction);
+        readValue(boat, "sailLift", m_Params.sailLift);
+        readValue(boat, "rudderLift", m_Params.rudderLift);
+        readValue(boat, "mastDistance", m_Params.mastDistance);
+        readValue(boat, "sailDistance", m_Params.sailDistance);
+        readValue(boat, "rudderDistance", m_Params.rudderDistance);
+        readValue(boat, "mass", m_Params.mass);
+        readValue(boat, "inertia", m_Params.inertia);
+        readValue(boat, "tailGain", m_Params.tailGain);
+    }
+    if (config.count("wind") > 0) {
+        const Json& wind = config["wind"];
+        readValue(wind, "speed", m_Wind.speed);
+        readValue(wind, "direction", m_Wind.direction);
+        readValue(wind, "gustAmplitude", m_Wind.gustAmplitude);
+        readValue(wind, "gustPeriod", m_Wind.gustPeriod);
+        readValue(wind, "shiftAmplitude", m_Wind.shiftAmplitude);
+        readValue(wind, "shiftPeriod", m_Wind.shiftPeriod);
+    }
+    if (config.count("current") > 0) {
+        readValue(config["current"], "speed", m_Current.speed);
+        readValue(config["current"], "direction", m_Current.direction);
+    }
+
+    double latitude = m_Plane.originLat();
+    double longitude = m_Plane.originLon();
+    double heading = 0;
+    if (config.count("start") > 0) {
+        readValue(config["start"], "latitude", latitude);
+        readValue(config["start"], "longitude", longitude);
+        readValue(config["start"], "heading", heading);
+    }
+    reset(latitude, longitude, heading);
+    return true;
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::reset(double latitude, double longitude, double heading) {
+    m_Plane = LocalTangentPlane(latitude, longitude);
+    m_Time = 0;
+    m_East = 0;
+    m_North = 0;
+    m_Heading = wrapRadian(Utility::degreeToRadian(90 - heading));
+    m_Speed = 0;
+    m_Turn = 0;
+    m_Distance = 0;
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::setCommands(const ActuatorDataSailPacket_t& commands) {
+    m_Rudder = commands.rudderCommand;
+    m_SailOrTail = commands.sailCommand;
+}
+
+void BoatDynamics::setCommands(const ActuatorDataWingPacket_t& commands) {
+    m_Rudder = commands.rudderCommand;
+    m_SailOrTail = commands.tailCommand;
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::step(double seconds) {
+    int steps = (int)std::ceil(seconds / BOAT_DYNAMICS_STEP);
+    for (int i = 0; i < steps; i++) {
+        integrate(seconds / steps);
+    }
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::integrate(double dt) {
+    double apparentSpeed, apparentDirection;
+    apparentWind(apparentSpeed, apparentDirection);
+
+    // Angle of the sail to the hull, the boom pointing aft at 0
+    double sail;
+    if (m_WingSail) {
+        // The tail turns the wing away from the wind, on the other side
+        double attack = -m_Params.tailGain * m_SailOrTail;
+        sail = wrapRadian(apparentDirection - M_PI + attack);
+    } else {
+        // The sheet lets the sail out until it is in the wind or at its max angle
+        double maxSail = std::fabs(m_SailOrTail);
+        double sailOut = std::min(std::fabs(M_PI - std::fabs(apparentDirection)), maxSail);
+        sail = (std::sin(apparentDirection) >= 0) ? -sailOut : sailOut;
+    }
+
+    double sailForce = m_Params.sailLift * apparentSpeed * std::sin(sail - apparentDirection);
+    double rudderForce = m_Params.rudderLift * m_Speed * std::fabs(m_Speed) * std::sin(m_Rudder);
+
+    double acceleration = (sailForce * std::sin(sail) - rudderForce * std::sin(m_Rudder) -
+                           m_Params.hullFriction * m_Speed * std::fabs(m_Speed)) /
+                          m_Params.mass;
+    double angularAcceleration =
+        (sailForce * (m_Params.mastDistance - m_Params.sailDistance * std::cos(sail)) -
+         m_Params.rudderDistance * rudderForce * std::cos(m_Rudder) -
+         m_Params.angularFriction * m_Turn * std::fabs(m_Speed)) /
+        m_Params.inertia;
+
+    m_Speed += acceleration * dt;
+    m_Turn += angularAcceleration * dt;
+    m_Heading = wrapRadian(m_Heading + m_Turn * dt);
+
+    double velocityEast, velocityNorth;
+    groundVelocity(velocityEast, velocityNorth);
+    m_East += velocityEast * dt;
+    m_North += velocityNorth * dt;
+    m_Distance += std::hypot(velocityEast, velocityNorth) * dt;
+    m_Time += dt;
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::trueWind(double& speed, double& direction) const {
+    speed = m_Wind.speed;
+    direction = m_Wind.direction;
+    if (m_Wind.gustPeriod > 0) {
+        speed += m_Wind.gustAmplitude * std::sin(2 * M_PI * m_Time / m_Wind.gustPeriod);
+    }
+    if (m_Wind.shiftPeriod > 0) {
+        direction += m_Wind.shiftAmplitude * std::sin(2 * M_PI * m_Time / m_Wind.shiftPeriod);
+    }
+    speed = std::max(speed, 0.0);
+}
+
+void BoatDynamics::windVector(double& east, double& north) const {
+    double speed, direction;
+    trueWind(speed, direction);
+
+    // Blows towards the opposite of where it comes from
+    east = -speed * std::sin(Utility::degreeToRadian(direction));
+    north = -speed * std::cos(Utility::degreeToRadian(direction));
+}
+
+void BoatDynamics::groundVelocity(double& east, double& north) const {
+    double windEast, windNorth;
+    windVector(windEast, windNorth);
+
+    east = m_Speed * std::cos(m_Heading) + m_Params.drift * windEast +
+           m_Current.speed * std::sin(Utility::degreeToRadian(m_Current.direction));
+    north = m_Speed * std::sin(m_Heading) + m_Params.drift * windNorth +
+            m_Current.speed * std::cos(Utility::degreeToRadian(m_Current.direction));
+}
+
+void BoatDynamics::apparentWind(double& speed, double& direction) const {
+    double windEast, windNorth, velocityEast, velocityNorth;
+    windVector(windEast, windNorth);
+    groundVelocity(velocityEast, velocityNorth);
+
+    double east = windEast - velocityEast;
+    double north = windNorth - velocityNorth;
+    speed = std::hypot(east, north);
+    direction = wrapRadian(std::atan2(north, east) - m_Heading);
+}
+
+///--------------------------------------------------------------------------------------
+void BoatDynamics::position(double& latitude, double& longitude) const {
+    m_Plane.unproject(m_East, m_North, latitude, longitude);
+}
+
+double BoatDynamics::heading() const {
+    return Utility::limitAngleRange(90 - Utility::radianToDegree(m_Heading));
+}
+
+///--------------------------------------------------------------------------------------
+template <typename Packet>
+void BoatDynamics::fillBoatData(Packet& data) const {
+    double latitude, longitude;
+    position(latitude, longitude);
+    data.latitude = latitude;
+    data.longitude = longitude;
+
+    double velocityEast, velocityNorth;
+    groundVelocity(velocityEast, velocityNorth);
+    data.speed = std::hypot(velocityEast, velocityNorth);
+    data.course = roundDegrees(std::atan2(velocityNorth, velocityEast));
+
+    double apparentSpeed, apparentDirection;
+    apparentWind(apparentSpeed, apparentDirection);
+    data.windDir = roundDegrees(apparentDirection);
+    data.windSpeed = apparentSpeed;
+    data.heading = roundDegrees(m_Heading);
+}
+
+void BoatDynamics::boatData(SailBoatDataPacket_t& data) const {
+    fillBoatData(data);
+}
+
+void BoatDynamics::boatData(WingBoatDataPacket_t& data) const {
+    fillBoatData(data);
+}
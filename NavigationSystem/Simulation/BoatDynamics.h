@@ -0,0 +1,166 @@
+/****************************************************************************************
+ *
+ * File:
+ *      BoatDynamics.h
+ *
+ * Purpose:
+ *      Simulates a sail boat or a wing sail boat in process, so the navigation system
+ *      can run without the external simulator. It takes the same actuator packets and
+ *      gives the same boat data packets as the simulator does over TCP.
+ *
+ * Developer Notes:
+ *      The boat moves in the plane (position and heading) following the sail boat model
+ *      of L. Jaulin, Modélisation et commande d'un bateau à voile, 2004: the sail and
+ *      the rudder are flat plates, the hull has a quadratic friction and the wind pushes
+ *      the boat a little sideways. The wing sail is the same plate, set by its tail at an
+ *      angle of attack to the apparent wind.
+ *
+ *      The wind comes from a direction with a speed, both changing slowly as sine waves
+ *      when a period is given, and the boat drifts with a constant current.
+ *
+ *      The defaults can be overridden with a json file, every key is optional:
+ *          { "boat": { "mass": 300, ... }, "wind": { "speed": 6, "direction": 0, ... },
+ *            "current": { "speed": 0.2, "direction": 90 },
+ *            "start": { "latitude": 60.1, "longitude": 19.9, "heading": 0 } }
+ *      with the names of the fields below.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <string>
+#include "../Math/CollisionMath.h"
+#include "SimulatorPackets.h"
+
+// The model is integrated in steps of at most this many seconds
+#define BOAT_DYNAMICS_STEP 0.05
+
+struct BoatDynamicsParams_t {
+    BoatDynamicsParams_t()
+        : drift(0.03),
+          hullFriction(40),
+          angularFriction(6000),
+          sailLift(200),
+          rudderLift(1500),
+          mastDistance(0.5),
+          sailDistance(0.5),
+          rudderDistance(2),
+          mass(300),
+          inertia(10000),
+          tailGain(1) {}
+
+    double drift;            // How much of the wind speed the hull drifts with
+    double hullFriction;     // kg/m
+    double angularFriction;  // kg.m
+    double sailLift;         // kg/s
+    double rudderLift;       // kg/m
+    double mastDistance;     // From the centre of gravity to the mast, m
+    double sailDistance;     // From the mast to the sail's centre of effort, m
+    double rudderDistance;   // From the centre of gravity to the rudder, m
+    double mass;             // kg
+    double inertia;          // kg.m²
+    double tailGain;         // Angle of attack of the wing sail per tail angle
+};
+
+struct WindField_t {
+    WindField_t()
+        : speed(6), direction(0), gustAmplitude(0), gustPeriod(0), shiftAmplitude(0), shiftPeriod(0) {}
+
+    double speed;           // m/s
+    double direction;       // Degrees clockwise from north, where the wind comes from
+    double gustAmplitude;   // m/s
+    double gustPeriod;      // Seconds, no gusts if 0
+    double shiftAmplitude;  // Degrees
+    double shiftPeriod;     // Seconds, no shifts if 0
+};
+
+struct Current_t {
+    Current_t() : speed(0), direction(0) {}
+
+    double speed;      // m/s
+    double direction;  // Degrees clockwise from north, where the current goes to
+};
+
+class BoatDynamics {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// @param wingSail 		True for a wing sail boat, false for a sail boat.
+    ///----------------------------------------------------------------------------------
+    BoatDynamics(bool wingSail);
+
+    ///----------------------------------------------------------------------------------
+    /// Reads the parameters, the wind, the current and the start position from a json
+    /// file and resets the boat to the start position. Returns false if the file can't
+    /// be read.
+    ///----------------------------------------------------------------------------------
+    bool loadConfig(const std::string& filePath);
+
+    ///----------------------------------------------------------------------------------
+    /// Puts the boat still at a position, heading in degrees clockwise from north, and
+    /// the time back to 0.
+    ///----------------------------------------------------------------------------------
+    void reset(double latitude, double longitude, double heading);
+
+    BoatDynamicsParams_t& params() { return m_Params; }
+    WindField_t& wind() { return m_Wind; }
+    Current_t& current() { return m_Current; }
+
+    void setCommands(const ActuatorDataSailPacket_t& commands);
+    void setCommands(const ActuatorDataWingPacket_t& commands);
+
+    ///----------------------------------------------------------------------------------
+    /// Moves the boat forward in time.
+    ///----------------------------------------------------------------------------------
+    void step(double seconds);
+
+    void boatData(SailBoatDataPacket_t& data) const;
+    void boatData(WingBoatDataPacket_t& data) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the wind at the current time, speed in m/s and direction in degrees
+    /// clockwise from north where it comes from.
+    ///----------------------------------------------------------------------------------
+    void trueWind(double& speed, double& direction) const;
+
+    double time() const { return m_Time; }
+    void position(double& latitude, double& longitude) const;
+    double heading() const;  // Degrees clockwise from north
+    double speed() const { return m_Speed; }  // Through the water, m/s
+    double distance() const { return m_Distance; }  // Sailed over ground, m
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// Returns the east and north components of the true wind and of the boat's velocity
+    /// over ground.
+    ///----------------------------------------------------------------------------------
+    void windVector(double& east, double& north) const;
+    void groundVelocity(double& east, double& north) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the apparent wind speed and the direction it blows towards, in radians
+    /// counter clockwise from the bow.
+    ///----------------------------------------------------------------------------------
+    void apparentWind(double& speed, double& direction) const;
+
+    void integrate(double dt);
+
+    template <typename Packet>
+    void fillBoatData(Packet& data) const;
+
+    bool m_WingSail;
+    BoatDynamicsParams_t m_Params;
+    WindField_t m_Wind;
+    Current_t m_Current;
+    LocalTangentPlane m_Plane;
+
+    double m_Time;
+    double m_East;     // m
+    double m_North;    // m
+    double m_Heading;  // Radians counter clockwise from east
+    double m_Speed;    // m/s
+    double m_Turn;     // rad/s
+    double m_Distance;
+
+    double m_Rudder;      // rad
+    double m_SailOrTail;  // Max sail angle or tail angle, rad
+};
@@ -15,8 +15,16 @@
 
 #include "SimulationNode.h"
 
+#include <algorithm>
+
 #define SERVER_PORT 6900
 
+// How long the nodes can take to process a lockstep tick, in real time
+#define LOCKSTEP_TIMEOUT_MS 1000
+
+// How often the in process simulation steps when not in lockstep
+#define IN_PROCESS_TICK_MS 100
+
 SimulationNode::SimulationNode(MessageBus& msgBus, bool boatType)
     : ActiveNode(NodeID::Simulator, msgBus),
       m_RudderCommand(0),
@@ -31,7 +39,11 @@ SimulationNode::SimulationNode(MessageBus& msgBus, bool boatType)
       m_WindSpeed(0),
       m_nextDeclination(0),
       collidableMgr(NULL),
-      m_boatType(boatType) {
+      m_boatType(boatType),
+      m_LockstepTickMs(0),
+      m_LockstepTicks(0),
+      m_Dynamics(NULL),
+      m_Traffic(NULL) {
     msgBus.registerNode(*this, MessageType::SailCommand);
     msgBus.registerNode(*this, MessageType::WingSailCommand);
     msgBus.registerNode(*this, MessageType::RudderCommand);
@@ -54,7 +66,11 @@ SimulationNode::SimulationNode(MessageBus& msgBus, bool boatType, CollidableMgr*
       m_WindSpeed(0),
       m_nextDeclination(0),
       collidableMgr(collidableMgr),
-      m_boatType(boatType) {
+      m_boatType(boatType),
+      m_LockstepTickMs(0),
+      m_LockstepTicks(0),
+      m_Dynamics(NULL),
+      m_Traffic(NULL) {
     msgBus.registerNode(*this, MessageType::SailCommand);
     msgBus.registerNode(*this, MessageType::WingSailCommand);
     msgBus.registerNode(*this, MessageType::RudderCommand);
@@ -64,13 +80,36 @@ SimulationNode::SimulationNode(MessageBus& msgBus, bool boatType, CollidableMgr*
 }
 
 void SimulationNode::start() {
-    runThread(SimulationThreadFunc);
+    if (m_Dynamics != NULL) {
+        runThread(InProcessThreadFunc);
+    } else {
+        runThread(SimulationThreadFunc);
+    }
+}
+
+void SimulationNode::enableLockstep(unsigned int tickMs) {
+    m_LockstepTickMs = tickMs;
+    SimulatedClock::enable(SysClock::unixTime());
+    Logger::info("Simulation in lockstep, %u ms per tick", tickMs);
+}
+
+void SimulationNode::simulateInProcess(BoatDynamics& dynamics) {
+    m_Dynamics = &dynamics;
+}
+
+void SimulationNode::simulateTraffic(AISTraffic& traffic) {
+    m_Traffic = &traffic;
 }
 
 bool SimulationNode::init() {
     bool success = false;
     updateConfigsFromDB();
 
+    if (m_Dynamics != NULL) {
+        Logger::info("Simulating the boat in process");
+        return true;
+    }
+
     int rc = server.start(SERVER_PORT);
 
     if (rc > 0) {
@@ -189,8 +228,7 @@ void SimulationNode::createMarineSensorMessage(WaypointDataMsg* msg) {
 void SimulationNode::processSailBoatData(TCPPacket_t& packet) {
     if (packet.length - 1 == sizeof(SailBoatDataPacket_t)) {
         // The first byte is the packet type, lets skip that
-        uint8_t* ptr = packet.data + 1;
-        SailBoatDataPacket_t* boatData = (SailBoatDataPacket_t*)ptr;
+        const SailBoatDataPacket_t* boatData = (const SailBoatDataPacket_t*)(packet.data + 1);
 
         m_CompassHeading = Utility::limitAngleRange(90 - boatData->heading -
                                                     m_nextDeclination);  // [0, 360] north east down
@@ -221,8 +259,7 @@ void SimulationNode::processSailBoatData(TCPPacket_t& packet) {
 void SimulationNode::processWingBoatData(TCPPacket_t& packet) {
     if (packet.length - 1 == sizeof(WingBoatDataPacket_t)) {
         // The first byte is the packet type, lets skip that
-        uint8_t* ptr = packet.data + 1;
-        WingBoatDataPacket_t* boatData = (WingBoatDataPacket_t*)ptr;
+        const WingBoatDataPacket_t* boatData = (const WingBoatDataPacket_t*)(packet.data + 1);
 
         m_CompassHeading = Utility::limitAngleRange(90 - boatData->heading -
                                                     m_nextDeclination);  // [0, 360] north east down
@@ -251,10 +288,9 @@ void SimulationNode::processWingBoatData(TCPPacket_t& packet) {
 
 ///--------------------------------------------------------------------------------------
 void SimulationNode::processAISContact(TCPPacket_t& packet) {
-    if (this->collidableMgr != NULL) {
+    if (this->collidableMgr != NULL && packet.length - 1 >= (int)sizeof(AISContactPacket_t)) {
         // The first byte is the packet type, lets skip that
-        uint8_t* ptr = packet.data + 1;
-        AISContactPacket_t* aisData = (AISContactPacket_t*)ptr;
+        const AISContactPacket_t* aisData = (const AISContactPacket_t*)(packet.data + 1);
 
         this->collidableMgr->addAISContact(
             aisData->mmsi, aisData->latitude, aisData->longitude, aisData->speed,
@@ -263,12 +299,35 @@ void SimulationNode::processAISContact(TCPPacket_t& packet) {
     }
 }
 
+///--------------------------------------------------------------------------------------
+void SimulationNode::reportTraffic() {
+    uint8_t buffer[1 + sizeof(AISContactPacket_t)];
+    TCPPacket_t packet;
+    packet.socketFD = 0;
+    packet.data = buffer;
+    packet.length = sizeof(buffer);
+    buffer[0] = SimulatorPacket::AISData;
+
+    // All the vessels in one snapshot
+    if (collidableMgr != NULL) {
+        collidableMgr->beginAISUpdate();
+    }
+    for (size_t i = 0; i < m_Traffic->size(); i++) {
+        AISContactPacket_t contact;
+        m_Traffic->contact(i, contact);
+        memcpy(buffer + 1, &contact, sizeof(contact));
+        processAISContact(packet);
+    }
+    if (collidableMgr != NULL) {
+        collidableMgr->endAISUpdate();
+    }
+}
+
 ///--------------------------------------------------------------------------------------
 void SimulationNode::processVisualField(TCPPacket_t& packet) {
-    if (this->collidableMgr != NULL) {
+    if (this->collidableMgr != NULL && packet.length - 1 >= (int)sizeof(VisualFieldPacket_t)) {
         // The first byte is the packet type, lets skip that
-        uint8_t* ptr = packet.data + 1;
-        VisualFieldPacket_t* data = reinterpret_cast<VisualFieldPacket_t*>(ptr);
+        const VisualFieldPacket_t* data = reinterpret_cast<const VisualFieldPacket_t*>(packet.data + 1);
         std::map<int16_t, uint16_t> bearingToRelativeObstacleDistance;
         for (int i = 0; i < 24; ++i) {
             bearingToRelativeObstacleDistance[12 - i] = data->relativeObstacleDistances[i];
@@ -281,17 +340,22 @@ void SimulationNode::processVisualField(TCPPacket_t& packet) {
 }
 
 ///--------------------------------------------------------------------------------------
-void SimulationNode::sendActuatorDataWing(int socketFD) {
+void SimulationNode::updateActuatorData() {
     actuatorDataWing.rudderCommand = -Utility::degreeToRadian(m_RudderCommand);
     actuatorDataWing.tailCommand = -Utility::degreeToRadian(m_TailCommand);
 
+    actuatorDataSail.rudderCommand = -Utility::degreeToRadian(m_RudderCommand);
+    actuatorDataSail.sailCommand = Utility::degreeToRadian(m_SailCommand);
+}
+
+///--------------------------------------------------------------------------------------
+void SimulationNode::sendActuatorDataWing(int socketFD) {
+    updateActuatorData();
     server.sendData(socketFD, &actuatorDataWing, sizeof(ActuatorDataWingPacket_t));
 }
 
 void SimulationNode::sendActuatorDataSail(int socketFD) {
-    actuatorDataSail.rudderCommand = -Utility::degreeToRadian(m_RudderCommand);
-    actuatorDataSail.sailCommand = Utility::degreeToRadian(m_SailCommand);
-
+    updateActuatorData();
     server.sendData(socketFD, &actuatorDataSail, sizeof(ActuatorDataSailPacket_t));
 }
 
@@ -305,16 +369,35 @@ void SimulationNode::sendMarineSensor(int socketFD) {
     server.sendData(socketFD, &marineSensorData, sizeof(MarineSensorDataPacket_t));
 }
 
+///--------------------------------------------------------------------------------------
+void SimulationNode::stepLockstep() {
+    auto busIdle = [this]() { return m_MsgBus.idle(); };
+    auto timeout = std::chrono::milliseconds(LOCKSTEP_TIMEOUT_MS);
+
+    // The boat data is delivered before the nodes wake up for the tick
+    bool done = SimulatedClock::waitUntilIdle(busIdle, timeout);
+    SimulatedClock::advance(std::chrono::milliseconds(m_LockstepTickMs));
+    done = SimulatedClock::waitUntilIdle(busIdle, timeout) && done;
+
+    m_LockstepTicks++;
+    if (not done) {
+        Logger::warning("Simulation tick %lu: the nodes didn't finish in time", m_LockstepTicks);
+    }
+}
+
 ///--------------------------------------------------------------------------------------
 void SimulationNode::SimulationThreadFunc(ActiveNode* nodePtr) {
     SimulationNode* node = dynamic_cast<SimulationNode*>(nodePtr);
 
     TCPPacket_t packet;
     int simulatorFD = 0;
+    bool aisUpdate = false;  // The contacts received since the last boat data are pending
 
     while (true) {
         // Don't timeout on a packet read
-        node->server.readPacket(packet, 0);
+        if (node->server.readPacket(packet, 0) == 0 || packet.length == 0) {
+            continue;
+        }
 
         // We only care about the latest packet, so clear out the old ones
         // node->server.clearSocketBuffer( packet.socketFD );
@@ -324,6 +407,22 @@ void SimulationNode::SimulationThreadFunc(ActiveNode* nodePtr) {
         if (simulatorFD == 0) {
             simulatorFD = packet.socketFD;
         }
+
+        // The boat data marks a simulator tick
+        bool tick = packet.data[0] == SimulatorPacket::SailBoatData ||
+                    packet.data[0] == SimulatorPacket::WingBoatData;
+
+        // The AIS contacts of a tick go in one snapshot, published before the next tick
+        if (node->collidableMgr != NULL) {
+            if (packet.data[0] == SimulatorPacket::AISData && not aisUpdate) {
+                node->collidableMgr->beginAISUpdate();
+                aisUpdate = true;
+            } else if (tick && aisUpdate) {
+                node->collidableMgr->endAISUpdate();
+                aisUpdate = false;
+            }
+        }
+
         // First byte is the message type
         switch (packet.data[0]) {
             case SimulatorPacket::SailBoatData:
@@ -354,6 +453,10 @@ void SimulationNode::SimulationThreadFunc(ActiveNode* nodePtr) {
         packet.socketFD = 0;
         packet.length = 0;
 
+        if (node->m_LockstepTickMs > 0 && tick) {
+            node->stepLockstep();
+        }
+
         if (node->m_boatType == 0) {
             node->sendActuatorDataSail(simulatorFD);
         } else if (node->m_boatType == 1) {
@@ -364,3 +467,54 @@ void SimulationNode::SimulationThreadFunc(ActiveNode* nodePtr) {
         // node->sendMarineSensor( simulatorFD );
     }
 }
+
+///--------------------------------------------------------------------------------------
+void SimulationNode::InProcessThreadFunc(ActiveNode* nodePtr) {
+    SimulationNode* node = dynamic_cast<SimulationNode*>(nodePtr);
+    BoatDynamics& dynamics = *node->m_Dynamics;
+
+    unsigned int tickMs = node->m_LockstepTickMs > 0 ? node->m_LockstepTickMs : IN_PROCESS_TICK_MS;
+
+    // The boat data goes through the same path as the simulator's packets
+    uint8_t buffer[1 + std::max(sizeof(SailBoatDataPacket_t), sizeof(WingBoatDataPacket_t))];
+    TCPPacket_t packet;
+    packet.socketFD = 0;
+    packet.data = buffer;
+
+    while (true) {
+        if (node->m_boatType == 0) {
+            SailBoatDataPacket_t boatData;
+            dynamics.boatData(boatData);
+            buffer[0] = SimulatorPacket::SailBoatData;
+            memcpy(buffer + 1, &boatData, sizeof(boatData));
+            packet.length = 1 + sizeof(boatData);
+            node->processSailBoatData(packet);
+        } else {
+            WingBoatDataPacket_t boatData;
+            dynamics.boatData(boatData);
+            buffer[0] = SimulatorPacket::WingBoatData;
+            memcpy(buffer + 1, &boatData, sizeof(boatData));
+            packet.length = 1 + sizeof(boatData);
+            node->processWingBoatData(packet);
+        }
+
+        if (node->m_LockstepTickMs > 0) {
+            node->stepLockstep();
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(tickMs));
+        }
+
+        node->updateActuatorData();
+        if (node->m_boatType == 0) {
+            dynamics.setCommands(node->actuatorDataSail);
+        } else {
+            dynamics.setCommands(node->actuatorDataWing);
+        }
+        dynamics.step(tickMs / 1000.0);
+
+        if (node->m_Traffic != NULL && node->m_Traffic->size() > 0) {
+            node->m_Traffic->step(tickMs / 1000.0);
+            node->reportTraffic();
+        }
+    }
+}
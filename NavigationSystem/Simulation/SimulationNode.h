@@ -9,7 +9,12 @@
  *      Listen to actuators command messages and send the command datas to the simulator.
  *
  * Developer Notes:
+ *      In lockstep mode the simulator is expected to wait for the actuator data before
+ *      it sends the next boat data, the nodes then run on the SimulatedClock and a
+ *      mission runs as fast as they can process it.
  *
+ *      With a BoatDynamics the boat is simulated in process instead, no simulator
+ *      connects. An AISTraffic then stands in for the simulator's AIS contacts.
  *
  ***************************************************************************************/
 
@@ -43,90 +48,12 @@
 #include "../Messages/WingSailCommandMsg.h"
 #include "../Network/TCPServer.h"
 #include "../SystemServices/Logger.h"
+#include "../SystemServices/SimulatedClock.h"
 #include "../SystemServices/SysClock.h"
 #include "../WorldState/CollidableMgr/CollidableMgr.h"
-
-enum SimulatorPacket : unsigned char {
-    SailBoatData = 0,
-    WingBoatData,
-    AISData,
-    CameraData,
-    WingBoatCmd,
-    SailBoatCmd,
-    WaypointData,
-    MarineSensorData
-};
-
-struct SailBoatDataPacket_t {
-    float latitude;
-    float longitude;
-    float speed;
-    int16_t course;
-    int16_t windDir;
-    float windSpeed;
-    int16_t heading;
-} __attribute__((packed));
-
-struct WingBoatDataPacket_t {
-    float latitude;
-    float longitude;
-    float speed;
-    int16_t course;
-    int16_t windDir;
-    float windSpeed;
-    int16_t heading;
-} __attribute__((packed));
-
-struct AISContactPacket_t {
-    uint16_t mmsi;
-    float latitude;
-    float longitude;
-    float speed;
-    int16_t course;
-    float length;
-    float beam;
-} __attribute__((packed));
-
-struct VisualFieldPacket_t {
-    uint16_t relativeObstacleDistances[24];
-    int16_t heading;
-} __attribute__((packed));
-
-struct ActuatorDataWingPacket_t {
-    unsigned char simulatorPacket = WingBoatCmd;
-    float rudderCommand;
-    float tailCommand;
-} __attribute__((packed));
-
-struct ActuatorDataSailPacket_t {
-    unsigned char simulatorPacket = SailBoatCmd;
-    float rudderCommand;
-    float sailCommand;
-} __attribute__((packed));
-
-struct WaypointPacket_t {
-    unsigned char simulatorPacket = WaypointData;
-    int nextId;
-    double nextLongitude;
-    double nextLatitude;
-    int nextDeclination;
-    int nextRadius;
-    int nextStayTime;
-    // bool isCheckpoint;
-    int prevId;
-    double prevLongitude;
-    double prevLatitude;
-    int prevDeclination;
-    int prevRadius;
-} __attribute__((packed));
-
-struct MarineSensorDataPacket_t {
-    unsigned char simulatorPacket = MarineSensorData;
-    float temperature;
-    float conductivity;
-    float ph;
-    float salinity;
-} __attribute__((packed));
+#include "AISTraffic.h"
+#include "BoatDynamics.h"
+#include "SimulatorPackets.h"
 
 class SimulationNode : public ActiveNode {
    public:
@@ -143,6 +70,26 @@ class SimulationNode : public ActiveNode {
     ///----------------------------------------------------------------------------------
     void start();
 
+    ///----------------------------------------------------------------------------------
+    /// Steps the nodes in lockstep with the simulator: every boat data packet moves the
+    /// SimulatedClock forward by a tick, and the actuator data is only sent back once
+    /// the nodes have processed it. Must be called before any node is started.
+    ///----------------------------------------------------------------------------------
+    void enableLockstep(unsigned int tickMs);
+
+    ///----------------------------------------------------------------------------------
+    /// Simulates the boat in process rather than with the external simulator, a tick
+    /// of the lockstep or IN_PROCESS_TICK_MS of real time at a time. Must be called
+    /// before init().
+    ///----------------------------------------------------------------------------------
+    void simulateInProcess(BoatDynamics& dynamics);
+
+    ///----------------------------------------------------------------------------------
+    /// Moves the traffic along with the in process boat, and reports it as AIS contacts
+    /// every tick. Must be called before start().
+    ///----------------------------------------------------------------------------------
+    void simulateTraffic(AISTraffic& traffic);
+
     void processMessage(const Message* msg);
 
    private:
@@ -182,15 +129,26 @@ class SimulationNode : public ActiveNode {
     void processWingBoatData(TCPPacket_t& packet);
 
     ///----------------------------------------------------------------------------------
-    /// Process a AIS contact data message
+    /// Process a AIS contact data message, within a beginAISUpdate() and endAISUpdate()
+    /// of the CollidableMgr so the contacts of a tick are published together
     ///----------------------------------------------------------------------------------
     void processAISContact(TCPPacket_t& packet);
 
+    ///----------------------------------------------------------------------------------
+    /// Reports the in process traffic like the simulator's AIS contacts
+    ///----------------------------------------------------------------------------------
+    void reportTraffic();
+
     ///----------------------------------------------------------------------------------
     /// Process a visual contact data message
     ///----------------------------------------------------------------------------------
     void processVisualField(TCPPacket_t& packet);
 
+    ///----------------------------------------------------------------------------------
+    /// Converts the latest commands to the actuator packets
+    ///----------------------------------------------------------------------------------
+    void updateActuatorData();
+
     ///----------------------------------------------------------------------------------
     /// Send our actuators data for a wing sail-equipped boat
     ///----------------------------------------------------------------------------------
@@ -216,6 +174,16 @@ class SimulationNode : public ActiveNode {
     ///----------------------------------------------------------------------------------
     static void SimulationThreadFunc(ActiveNode* nodePtr);
 
+    ///----------------------------------------------------------------------------------
+    /// Steps the in process simulation, and sends its boat data to the nodes
+    ///----------------------------------------------------------------------------------
+    static void InProcessThreadFunc(ActiveNode* nodePtr);
+
+    ///----------------------------------------------------------------------------------
+    /// Lets the nodes process the latest boat data and advances the clock by a tick.
+    ///----------------------------------------------------------------------------------
+    void stepLockstep();
+
     void createCompassMessage();
     void createGPSMessage();
     void createWindMessage();
@@ -239,6 +207,10 @@ class SimulationNode : public ActiveNode {
     CollidableMgr* collidableMgr;
 
     bool m_boatType;
+    unsigned int m_LockstepTickMs;  // 0 when not in lockstep
+    unsigned long m_LockstepTicks;
+    BoatDynamics* m_Dynamics;  // NULL when the simulator connects over TCP
+    AISTraffic* m_Traffic;     // NULL without in process traffic
 
     ActuatorDataWingPacket_t actuatorDataWing;
     ActuatorDataSailPacket_t actuatorDataSail;
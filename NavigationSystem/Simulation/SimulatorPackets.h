@@ -0,0 +1,100 @@
+/****************************************************************************************
+ *
+ * File:
+ *      SimulatorPackets.h
+ *
+ * Purpose:
+ *      The packets exchanged with the simulator, whether it runs over TCP or in process.
+ *
+ * Developer Notes:
+ *      Angles are in degrees counter clockwise from the east (or from the bow for the
+ *      wind), speeds in m/s. The wind direction is the direction the apparent wind
+ *      blows towards. The actuator commands are in radians.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+
+enum SimulatorPacket : unsigned char {
+    SailBoatData = 0,
+    WingBoatData,
+    AISData,
+    CameraData,
+    WingBoatCmd,
+    SailBoatCmd,
+    WaypointData,
+    MarineSensorData
+};
+
+struct SailBoatDataPacket_t {
+    float latitude;
+    float longitude;
+    float speed;
+    int16_t course;
+    int16_t windDir;
+    float windSpeed;
+    int16_t heading;
+} __attribute__((packed));
+
+struct WingBoatDataPacket_t {
+    float latitude;
+    float longitude;
+    float speed;
+    int16_t course;
+    int16_t windDir;
+    float windSpeed;
+    int16_t heading;
+} __attribute__((packed));
+
+struct AISContactPacket_t {
+    uint16_t mmsi;
+    float latitude;
+    float longitude;
+    float speed;
+    int16_t course;
+    float length;
+    float beam;
+} __attribute__((packed));
+
+struct VisualFieldPacket_t {
+    uint16_t relativeObstacleDistances[24];
+    int16_t heading;
+} __attribute__((packed));
+
+struct ActuatorDataWingPacket_t {
+    unsigned char simulatorPacket = WingBoatCmd;
+    float rudderCommand;
+    float tailCommand;
+} __attribute__((packed));
+
+struct ActuatorDataSailPacket_t {
+    unsigned char simulatorPacket = SailBoatCmd;
+    float rudderCommand;
+    float sailCommand;
+} __attribute__((packed));
+
+struct WaypointPacket_t {
+    unsigned char simulatorPacket = WaypointData;
+    int nextId;
+    double nextLongitude;
+    double nextLatitude;
+    int nextDeclination;
+    int nextRadius;
+    int nextStayTime;
+    // bool isCheckpoint;
+    int prevId;
+    double prevLongitude;
+    double prevLatitude;
+    int prevDeclination;
+    int prevRadius;
+} __attribute__((packed));
+
+struct MarineSensorDataPacket_t {
+    unsigned char simulatorPacket = MarineSensorData;
+    float temperature;
+    float conductivity;
+    float ph;
+    float salinity;
+} __attribute__((packed));
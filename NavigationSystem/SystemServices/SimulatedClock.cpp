@@ -0,0 +1,191 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		SimulatedClock.cpp
+ *
+ * Purpose:
+ *		A clock that only moves forward when the simulation steps.
+ *
+ * Developer Notes:
+ *		The sleeping threads each leave their wake time in m_Sleepers, the clock is
+ *		idle once there is one per participant and none of them is due yet. A thread
+ *		counts as a participant of the run it last slept in, see t_Run, so enabling the
+ *		clock again starts counting from none. Its place in the run, t_Participant,
+ *		orders the threads due at the same time.
+ *
+ ***************************************************************************************/
+
+#include "SimulatedClock.h"
+#include <thread>
+
+
+// How often the other idle check is repeated while waiting, the message bus doesn't
+// signal when it runs out of messages.
+#define IDLE_POLL_US 50
+
+
+std::atomic<bool>						SimulatedClock::m_Enabled(false);
+std::atomic<int64_t>					SimulatedClock::m_ElapsedUs(0);
+std::chrono::steady_clock::time_point	SimulatedClock::m_Start;
+unsigned long							SimulatedClock::m_StartUnixTime = 0;
+
+std::mutex								SimulatedClock::m_Mutex;
+std::condition_variable					SimulatedClock::m_WakeCondition;
+std::condition_variable					SimulatedClock::m_SleepCondition;
+uint64_t								SimulatedClock::m_Run = 0;
+unsigned int							SimulatedClock::m_Participants = 0;
+uint64_t								SimulatedClock::m_Sleeps = 0;
+std::set<std::pair<int64_t, unsigned int>>	SimulatedClock::m_Sleepers;
+int										SimulatedClock::m_Waking = -1;
+
+// The run the thread last took part in, and its place in that run
+static thread_local uint64_t t_Run = 0;
+static thread_local unsigned int t_Participant = 0;
+
+
+void SimulatedClock::enable(unsigned long unixTime)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Start = std::chrono::steady_clock::now();
+	m_StartUnixTime = unixTime;
+	m_ElapsedUs.store(0);
+	m_Run++;
+	m_Participants = 0;
+	m_Sleepers.clear();
+	m_Waking = -1;
+	m_Enabled.store(true);
+}
+
+void SimulatedClock::disable()
+{
+	m_Mutex.lock();
+	m_Enabled.store(false);
+	m_Mutex.unlock();
+
+	m_WakeCondition.notify_all();
+}
+
+std::chrono::steady_clock::time_point SimulatedClock::now()
+{
+	if(not m_Enabled.load())
+	{
+		return std::chrono::steady_clock::now();
+	}
+	return m_Start + std::chrono::microseconds(m_ElapsedUs.load());
+}
+
+unsigned long SimulatedClock::unixTime()
+{
+	return m_StartUnixTime + m_ElapsedUs.load() / 1000000;
+}
+
+unsigned int SimulatedClock::millis()
+{
+	return (m_ElapsedUs.load() / 1000) % 1000;
+}
+
+void SimulatedClock::sleepFor(std::chrono::microseconds duration)
+{
+	if(not m_Enabled.load())
+	{
+		std::this_thread::sleep_for(duration);
+		return;
+	}
+	if(duration.count() <= 0)
+	{
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	uint64_t run = m_Run;
+	if(t_Run != run)
+	{
+		t_Run = run;
+		t_Participant = m_Participants++;
+	}
+
+	unsigned int participant = t_Participant;
+	int64_t wakeTime = m_ElapsedUs.load() + duration.count();
+	auto sleeper = m_Sleepers.insert(std::make_pair(wakeTime, participant)).first;
+	m_Sleeps++;
+	m_SleepCondition.notify_all();
+
+	m_WakeCondition.wait(lock, [&]() {
+		return m_Waking == (int)participant || not m_Enabled.load() || m_Run != run;
+	});
+
+	// A new run forgot about this sleep already
+	if(m_Run == run)
+	{
+		m_Sleepers.erase(sleeper);
+		if(m_Waking == (int)participant)
+		{
+			m_Waking = -1;
+		}
+	}
+}
+
+void SimulatedClock::advance(std::chrono::microseconds step)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_ElapsedUs.fetch_add(step.count());
+}
+
+bool SimulatedClock::waitUntilIdle(const std::function<bool()>& othersIdle,
+	std::chrono::milliseconds timeout)
+{
+	auto deadline = std::chrono::steady_clock::now() + timeout;
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while(true)
+	{
+		if(allAsleep())
+		{
+			// Nothing wakes the sleeping threads but wakeNext(), so if the others are idle
+			// and nobody went to sleep meanwhile, everything is idle until the next one
+			// due is woken.
+			uint64_t sleeps = m_Sleeps;
+			lock.unlock();
+			bool idle = othersIdle();
+			lock.lock();
+
+			if(idle && sleeps == m_Sleeps && allAsleep())
+			{
+				if(not wakeNext())
+				{
+					return true;
+				}
+				continue;
+			}
+		}
+
+		if(std::chrono::steady_clock::now() >= deadline)
+		{
+			return false;
+		}
+		m_SleepCondition.wait_for(lock, std::chrono::microseconds(IDLE_POLL_US));
+	}
+}
+
+unsigned int SimulatedClock::participants()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Participants;
+}
+
+bool SimulatedClock::allAsleep()
+{
+	return m_Sleepers.size() == m_Participants && m_Waking < 0;
+}
+
+bool SimulatedClock::wakeNext()
+{
+	if(m_Sleepers.empty() || m_Sleepers.begin()->first > m_ElapsedUs.load())
+	{
+		return false;
+	}
+
+	m_Waking = m_Sleepers.begin()->second;
+	m_WakeCondition.notify_all();
+	return true;
+}
@@ -0,0 +1,117 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		SimulatedClock.h
+ *
+ * Purpose:
+ *		A clock that only moves forward when the simulation steps, so a simulated mission
+ *		can run as fast as the nodes are able to process it. The SysClock and the Timers
+ *		read their time from it.
+ *
+ * Developer Notes:
+ *		Until it is enabled the clock is the system's steady clock, and sleeping is a
+ *		plain sleep.
+ *
+ *		Once enabled, a thread sleeping through the clock takes part in the lockstep from
+ *		its first sleep on. The simulation advances the clock by a tick and waits until
+ *		every one of those threads sleeps again until a later time, which is when they
+ *		have all processed the tick. Threads that never sleep through the clock, or wait
+ *		on something else, are not waited for.
+ *
+ *		The threads due are woken one at a time, earliest wake time first and then in
+ *		the order they took part in, each once the previous one sleeps again and the
+ *		others are idle. A tick then always runs the same way, so a simulation repeats
+ *		exactly if the threads took part in the same order.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <utility>
+
+class SimulatedClock {
+   public:
+    ///----------------------------------------------------------------------------------
+    /// Starts the simulated time at a unix time, the clock only moves with advance()
+    /// from then on. Threads that took part in a previous run have to sleep again to
+    /// take part.
+    ///----------------------------------------------------------------------------------
+    static void enable(unsigned long unixTime);
+
+    ///----------------------------------------------------------------------------------
+    /// Goes back to the system clock and wakes every sleeping thread.
+    ///----------------------------------------------------------------------------------
+    static void disable();
+
+    static bool enabled() { return m_Enabled.load(); }
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the current time, the steady clock's when not enabled.
+    ///----------------------------------------------------------------------------------
+    static std::chrono::steady_clock::time_point now();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the simulated unix time and its current millisecond.
+    ///----------------------------------------------------------------------------------
+    static unsigned long unixTime();
+    static unsigned int millis();
+
+    ///----------------------------------------------------------------------------------
+    /// Sleeps until the clock has moved by the given duration.
+    ///----------------------------------------------------------------------------------
+    static void sleepFor(std::chrono::microseconds duration);
+
+    ///----------------------------------------------------------------------------------
+    /// Moves the simulated time forward. The threads that were sleeping until then are
+    /// woken by waitUntilIdle().
+    ///----------------------------------------------------------------------------------
+    static void advance(std::chrono::microseconds step);
+
+    ///----------------------------------------------------------------------------------
+    /// Wakes the threads due one after the other, and waits until every taking part
+    /// thread sleeps until a later time and othersIdle returns true, e.g. the message
+    /// bus has nothing left to deliver. Returns false if that didn't happen before the
+    /// timeout.
+    ///----------------------------------------------------------------------------------
+    static bool waitUntilIdle(const std::function<bool()>& othersIdle,
+                              std::chrono::milliseconds timeout);
+
+    ///----------------------------------------------------------------------------------
+    /// Returns how many threads take part in the lockstep.
+    ///----------------------------------------------------------------------------------
+    static unsigned int participants();
+
+   private:
+    ///----------------------------------------------------------------------------------
+    /// Returns true if all the threads taking part sleep, none of them being woken. Must
+    /// be called with m_Mutex held.
+    ///----------------------------------------------------------------------------------
+    static bool allAsleep();
+
+    ///----------------------------------------------------------------------------------
+    /// Wakes the first thread due, returns false if none is. Must be called with m_Mutex
+    /// held.
+    ///----------------------------------------------------------------------------------
+    static bool wakeNext();
+
+    static std::atomic<bool> m_Enabled;
+    static std::atomic<int64_t> m_ElapsedUs;  // Simulated time since enable()
+    static std::chrono::steady_clock::time_point m_Start;
+    static unsigned long m_StartUnixTime;
+
+    static std::mutex m_Mutex;  // Guards the fields below
+    static std::condition_variable m_WakeCondition;
+    static std::condition_variable m_SleepCondition;
+    static uint64_t m_Run;  // Increases with every enable(), to forget old participants
+    static unsigned int m_Participants;
+    static uint64_t m_Sleeps;  // Increases every time a thread goes to sleep
+    static std::set<std::pair<int64_t, unsigned int>> m_Sleepers;  // Wake time, participant
+    static int m_Waking;  // The participant woken that didn't start running yet, or -1
+};
@@ -13,6 +13,7 @@
  ***************************************************************************************/
 
 #include "SysClock.h"
+#include "SimulatedClock.h"
 #include <stdio.h>
 #include <ctime>
 #include <sys/time.h>
@@ -36,6 +37,12 @@ void SysClock::setTime(unsigned long unixTime)
 // NOTE: Review time!
 unsigned long SysClock::unixTime()
 {
+	// The simulation's time as it is, a time set from the GPS doesn't apply to it
+	if(SimulatedClock::enabled())
+	{
+		return SimulatedClock::unixTime();
+	}
+
 	if(m_LastUpdated != NEVER_UPDATED)
 	{
 		m_LastTimeStamp = m_LastTimeStamp + (GET_UNIX_TIME() - m_LastClockTime);
@@ -49,6 +56,11 @@ unsigned long SysClock::unixTime()
 
 unsigned int SysClock::millis()
 {
+	if(SimulatedClock::enabled())
+	{
+		return SimulatedClock::millis();
+	}
+
 	// Get Milliseconds
 	timeval curTime;
 	gettimeofday(&curTime, NULL);
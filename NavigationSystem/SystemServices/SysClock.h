@@ -9,7 +9,8 @@
  *		Timestamps are in GMT(UTC) time.
  *
  * Developer Notes:
- *
+ *		When the SimulatedClock is enabled the system time is the simulated one, and a
+ *		time set with setTime() is ignored until it is disabled.
  *
  ***************************************************************************************/
 
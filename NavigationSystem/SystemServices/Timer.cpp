@@ -1,12 +1,12 @@
 #include "Timer.h"
-#include <thread>
 
 #define STEADY_CLOCK std::chrono::steady_clock
+#define CLOCK_NOW() SimulatedClock::now()
 #define DURATION_CAST std::chrono::duration_cast
 #define DURATION std::chrono::duration
 
 Timer::Timer() :
-	m_start(STEADY_CLOCK::now()),
+	m_start(CLOCK_NOW()),
 	m_running(false),
 	m_timePassed( 0 )
 {}
@@ -15,14 +15,14 @@ void Timer::start()
 {
 	if (!m_running)
 	{
-		m_start = STEADY_CLOCK::now();
+		m_start = CLOCK_NOW();
 		m_running = true;
 	}
 }
 
 void Timer::reset()
 {
-	m_start = STEADY_CLOCK::now();	
+	m_start = CLOCK_NOW();	
 	m_running = true;
 }
 
@@ -40,7 +40,7 @@ double Timer::timePassed()
 		DURATION<double> time_span;
 
 		// the time to count the difference is not included
-		end = STEADY_CLOCK::now();
+		end = CLOCK_NOW();
 		time_span = DURATION_CAST<DURATION<double>>(end - m_start);
 		return time_span.count();
 	}
@@ -61,7 +61,7 @@ void Timer::sleepUntil(double seconds)
 	int toMicro = 1000*1000;
 
 	microseconds = timeUntil(seconds) * toMicro;
-	std::this_thread::sleep_for(std::chrono::microseconds(microseconds));
+	SimulatedClock::sleepFor(std::chrono::microseconds(microseconds));
 }
 
 bool Timer::timeReached(double seconds)
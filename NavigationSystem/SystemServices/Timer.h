@@ -2,6 +2,7 @@
 #define __TIMER_H__
 
 #include <chrono>
+#include "SimulatedClock.h"
 
 class Timer {
    public:
@@ -34,7 +35,8 @@ class Timer {
      */
     double timeUntil(double seconds);
     /*
-     * sleeps until timer reaches provided time
+     * sleeps until timer reaches provided time, in simulated time
+     * when the SimulatedClock is enabled
      */
     void sleepUntil(double seconds);
 
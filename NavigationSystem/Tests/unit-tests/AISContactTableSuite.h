@@ -0,0 +1,227 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISContactTableSuite.h
+ *
+ * Purpose:
+ *		Checks that AIS contacts are found by MMSI and expired on time, and that the
+ *		CollidableMgr keeps one contact per MMSI and publishes consistent snapshots.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	AISContactTable::find
+ *	AISContactTable::insert
+ *	AISContactTable::touch
+ *	AISContactTable::bucketEntries
+ *	AISContactTable::remove
+ *	AISContactTable::removeExpired
+ *	CollidableMgr::addAISContact
+ *	CollidableMgr::beginAISUpdate
+ *	CollidableMgr::endAISUpdate
+ *	CollidableMgr::getAISContacts
+ *	CollidableMgr::getVisualField
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <map>
+#include <thread>
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "../WorldState/CollidableMgr/AISContactTable.h"
+#include "../WorldState/CollidableMgr/CollidableMgr.h"
+
+#define AIS_TEST_TIMEOUT 600
+
+class AISContactTableSuite : public CxxTest::TestSuite {
+   public:
+    // MMSIs of vessels registered in Sweden and Finland
+    uint32_t mmsiOf(int i) { return (i % 2 ? 265000000 : 230000000) + i * 37; }
+
+    void test_FindAfterRemovals() {
+        AISContactTable table;
+        const int count = 1000;
+        for (int i = 0; i < count; i++) {
+            int row = table.insert(mmsiOf(i), 0);
+            table.m_latitude[row] = i;
+        }
+        TS_ASSERT_EQUALS(table.size(), count);
+
+        // Every other contact, the rows of the others get moved around
+        for (int i = 0; i < count; i += 2) {
+            table.remove(table.find(mmsiOf(i)));
+        }
+        TS_ASSERT_EQUALS(table.size(), count / 2);
+
+        for (int i = 0; i < count; i++) {
+            int row = table.find(mmsiOf(i));
+            if (i % 2 == 0) {
+                TS_ASSERT_EQUALS(row, -1);
+            } else {
+                TS_ASSERT_LESS_THAN_EQUALS(0, row);
+                TS_ASSERT_EQUALS(table.m_mmsi[row], mmsiOf(i));
+                TS_ASSERT_EQUALS(table.m_latitude[row], i);
+            }
+        }
+    }
+
+    void test_FindWhileContactsComeAndGo() {
+        AISContactTable table;
+
+        // Twenty contacts at a time, thousands over time, the slots left by the removed
+        // ones fill the index and get cleared again
+        for (int i = 0; i < 5000; i++) {
+            table.insert(mmsiOf(i), 0);
+            if (i >= 20) {
+                table.remove(table.find(mmsiOf(i - 20)));
+            }
+        }
+        TS_ASSERT_EQUALS(table.size(), 20);
+
+        for (int i = 0; i < 5000; i++) {
+            int row = table.find(mmsiOf(i));
+            if (i < 5000 - 20) {
+                TS_ASSERT_EQUALS(row, -1);
+            } else {
+                TS_ASSERT_LESS_THAN_EQUALS(0, row);
+                TS_ASSERT_EQUALS(table.m_mmsi[row], mmsiOf(i));
+            }
+        }
+    }
+
+    void test_Expiry() {
+        AISContactTable table;
+        for (int i = 0; i < 100; i++) {
+            table.insert(mmsiOf(i), 1000 + i);
+        }
+
+        // The first ten are updated again later
+        for (int i = 0; i < 10; i++) {
+            table.touch(table.find(mmsiOf(i)), 1500);
+        }
+
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1000 + AIS_TEST_TIMEOUT), 0);
+
+        // Contacts last updated before 1050
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1050 + AIS_TEST_TIMEOUT), 40);
+        TS_ASSERT_EQUALS(table.size(), 60);
+        TS_ASSERT_EQUALS(table.find(mmsiOf(49)), -1);
+        TS_ASSERT_LESS_THAN_EQUALS(0, table.find(mmsiOf(50)));
+        TS_ASSERT_LESS_THAN_EQUALS(0, table.find(mmsiOf(5)));
+
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1200 + AIS_TEST_TIMEOUT), 50);
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1501 + AIS_TEST_TIMEOUT), 10);
+        TS_ASSERT_EQUALS(table.size(), 0);
+    }
+
+    void test_ClockGoingBack() {
+        AISContactTable table;
+        table.insert(mmsiOf(1), 1000);
+        table.insert(mmsiOf(2), 1100);
+
+        // Behind the newest bucket, the contact stays listed in it only once
+        for (int i = 0; i < 20; i++) {
+            table.touch(table.find(mmsiOf(2)), 900 + i);
+            table.touch(table.find(mmsiOf(1)), 900 + i);
+        }
+        TS_ASSERT_EQUALS(table.bucketEntries(), 3);
+
+        // Expired with the newest bucket
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1100 + AIS_TEST_TIMEOUT), 0);
+        TS_ASSERT_EQUALS(table.removeExpired(AIS_TEST_TIMEOUT, 1110 + AIS_TEST_TIMEOUT), 2);
+        TS_ASSERT_EQUALS(table.bucketEntries(), 0);
+    }
+
+    void test_CollidableMgrMergesReports() {
+        CollidableMgr collidableMgr;
+
+        collidableMgr.addAISContact(mmsiOf(1), 60.1, 19.9, 5.0f, 90.0f);
+        collidableMgr.addAISContact(mmsiOf(2), 15.0f, 4.0f);
+        collidableMgr.addAISContact(mmsiOf(1), 30.0f, 6.0f);
+        collidableMgr.addAISContact(mmsiOf(2), 60.2, 19.8, 3.0f, 180.0f);
+        collidableMgr.addAISContact(mmsiOf(1), 60.3, 19.7, 6.0f, 95.0f);
+
+        CollidableList<AISCollidable_t> contacts = collidableMgr.getAISContacts();
+        TS_ASSERT_EQUALS(contacts.length(), 2);
+        for (int i = 0; i < 2; i++) {
+            AISCollidable_t contact = contacts.next();
+            if (contact.mmsi == mmsiOf(1)) {
+                TS_ASSERT_EQUALS(contact.latitude, 60.3);
+                TS_ASSERT_EQUALS(contact.length, 30.0f);
+            } else {
+                TS_ASSERT_EQUALS(contact.mmsi, mmsiOf(2));
+                TS_ASSERT_EQUALS(contact.course, 180.0f);
+                TS_ASSERT_EQUALS(contact.beam, 4.0f);
+            }
+        }
+    }
+
+    void test_SnapshotsDontChange() {
+        CollidableMgr collidableMgr;
+        collidableMgr.addAISContact(mmsiOf(1), 60.1, 19.9, 5.0f, 90.0f);
+
+        CollidableList<AISCollidable_t> before = collidableMgr.getAISContacts();
+        collidableMgr.addAISContact(mmsiOf(1), 60.2, 19.9, 5.0f, 90.0f);
+        collidableMgr.addAISContact(mmsiOf(2), 60.3, 19.9, 5.0f, 90.0f);
+        CollidableList<AISCollidable_t> after = collidableMgr.getAISContacts();
+
+        TS_ASSERT_EQUALS(before.length(), 1);
+        TS_ASSERT_EQUALS(before.next().latitude, 60.1);
+        TS_ASSERT_EQUALS(after.length(), 2);
+        TS_ASSERT_LESS_THAN(before.version(), after.version());
+
+        // A batch is published once, at its end
+        collidableMgr.beginAISUpdate();
+        collidableMgr.addAISContact(mmsiOf(3), 60.4, 19.9, 5.0f, 90.0f);
+        collidableMgr.addAISContact(mmsiOf(3), 10.0f, 3.0f);
+        TS_ASSERT_EQUALS(collidableMgr.getAISContacts().version(), after.version());
+        collidableMgr.endAISUpdate();
+        TS_ASSERT_EQUALS(collidableMgr.getAISContacts().version(), after.version() + 1);
+        TS_ASSERT_EQUALS(collidableMgr.getAISContacts().length(), 3);
+
+        std::map<int16_t, uint16_t> field = {{-10, 50}, {10, 80}};
+        std::shared_ptr<const VisualField_t> emptyField = collidableMgr.getVisualField();
+        collidableMgr.addVisualField(field, 90);
+        TS_ASSERT(emptyField->bearingToRelativeObstacleDistance.empty());
+        TS_ASSERT_EQUALS(collidableMgr.getVisualField()->bearingToRelativeObstacleDistance.size(), 2);
+    }
+
+    void test_ReadersSeeWholeBatches() {
+        CollidableMgr collidableMgr;
+        std::atomic<bool> running(true);
+
+        // Every batch moves all the contacts to the same latitude
+        std::thread writer([&] {
+            for (int batch = 1; running.load(); batch++) {
+                collidableMgr.beginAISUpdate();
+                for (int i = 0; i < 50; i++) {
+                    collidableMgr.addAISContact(mmsiOf(i), batch, 19.9, 5.0f, 90.0f);
+                }
+                collidableMgr.endAISUpdate();
+            }
+        });
+
+        int inconsistent = 0;
+        uint64_t lastVersion = 0;
+        // Until a hundred batches were seen, or the writer is very slow
+        for (int read = 0; lastVersion < 100 && read < 10000000; read++) {
+            CollidableList<AISCollidable_t> contacts = collidableMgr.getAISContacts();
+            TS_ASSERT_LESS_THAN_EQUALS(lastVersion, contacts.version());
+            lastVersion = contacts.version();
+            for (const AISCollidable_t& contact : contacts) {
+                if (contact.latitude != contacts.begin()->latitude) {
+                    inconsistent++;
+                }
+            }
+        }
+        running.store(false);
+        writer.join();
+
+        TS_ASSERT_EQUALS(inconsistent, 0);
+        TS_ASSERT_LESS_THAN_EQUALS(100, lastVersion);
+    }
+};
@@ -0,0 +1,61 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISTrafficSuite.h
+ *
+ * Purpose:
+ *		Checks that the simulated vessels go straight at their speed, and are reported
+ *		like the simulator's AIS contacts.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	AISTraffic::addVessel
+ *	AISTraffic::step
+ *	AISTraffic::contact
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../Math/CourseMath.h"
+#include "../Simulation/AISTraffic.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+class AISTrafficSuite : public CxxTest::TestSuite {
+   public:
+    void test_VesselsGoStraight() {
+        AISTraffic traffic(60.1, 19.9);
+        traffic.addVessel(1001, 60.1, 19.9, 5, 90, 40, 10);
+        traffic.addVessel(1002, 60.11, 19.91, 2, 180, 20, 5);
+        TS_ASSERT_EQUALS(traffic.size(), 2);
+
+        traffic.step(100);
+
+        AISContactPacket_t east;
+        traffic.contact(0, east);
+        TS_ASSERT_DELTA(east.latitude, 60.1, 1e-5);
+        TS_ASSERT_LESS_THAN(19.9, east.longitude);
+        TS_ASSERT_DELTA(CourseMath::calculateDTW(19.9, 60.1, east.longitude, east.latitude), 500, 1);
+
+        AISContactPacket_t south;
+        traffic.contact(1, south);
+        TS_ASSERT_DELTA(south.longitude, 19.91, 1e-5);
+        TS_ASSERT_DELTA(CourseMath::calculateDTW(19.91, 60.11, south.longitude, south.latitude), 200, 1);
+    }
+
+    void test_ContactLikeTheSimulator() {
+        AISTraffic traffic(60.1, 19.9);
+        traffic.addVessel(1001, 60.1, 19.9, 5, 30, 40, 10);
+
+        // The simulator's course is counter clockwise from east
+        AISContactPacket_t contact;
+        traffic.contact(0, contact);
+        TS_ASSERT_EQUALS(contact.mmsi, 1001);
+        TS_ASSERT_EQUALS(contact.course, 60);
+        TS_ASSERT_DELTA(contact.speed, 5, 1e-6);
+        TS_ASSERT_DELTA(contact.length, 40, 1e-6);
+        TS_ASSERT_DELTA(contact.beam, 10, 1e-6);
+    }
+};
@@ -18,14 +18,25 @@
  *	set 							clear
  *	ptr								get
  *	add 							maxVotes
+ *	addKernel
+ *	addWeighted
+ *	highestCourse
+ *
+ *	The ballot throughput of the benchmark is only printed as a trace, run the unit
+ *	tests with -v to see it.
  *
  ***************************************************************************************/
 
 #pragma once
 
+#include <stdio.h>
+#include <chrono>
 #include "../Navigation/LocalNavigationModule/ASRCourseBallot.h"
 #include "../cxxtest/cxxtest/TestSuite.h"
 
+#define BENCHMARK_VOTER_COUNT 12
+#define BENCHMARK_BALLOT_COUNT 20000
+
 class ASRCourseBallotSuite : public CxxTest::TestSuite {
    public:
     ///----------------------------------------------------------------------------------
@@ -124,6 +135,149 @@ class ASRCourseBallotSuite : public CxxTest::TestSuite {
         }
     }
 
+    ///----------------------------------------------------------------------------------
+    void test_ASRCourseBallot_addKernel_Wraps() {
+        ASRCourseBallot ballot(100);
+        const int16_t* ptr = ballot.ptr();
+        int16_t kernel[21];
+        for (int i = 0; i < 21; i++) {
+            kernel[i] = i + 1;
+        }
+
+        ballot.addKernel(-10, kernel, 21);
+        TS_ASSERT_EQUALS(ptr[350], 1);
+        TS_ASSERT_EQUALS(ptr[359], 10);
+        TS_ASSERT_EQUALS(ptr[0], 11);
+        TS_ASSERT_EQUALS(ptr[10], 21);
+        TS_ASSERT_EQUALS(ptr[11], 0);
+        TS_ASSERT_EQUALS(ptr[349], 0);
+
+        // Capped like add
+        ballot.addKernel(350, kernel, 21);
+        ballot.addKernel(350, kernel, 21);
+        ballot.addKernel(350, kernel, 21);
+        ballot.addKernel(350, kernel, 21);
+        ballot.addKernel(350, kernel, 21);
+        TS_ASSERT_EQUALS(ptr[350], 6);
+        TS_ASSERT_EQUALS(ptr[10], 100);
+    }
+
+    ///----------------------------------------------------------------------------------
+    void test_ASRCourseBallot_addWeighted_MatchesAdd() {
+        ASRCourseBallot votes(100);
+        for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+            votes.set(i, (i * 37) % 201 - 100);
+        }
+
+        ASRCourseBallot bulk(150);
+        ASRCourseBallot single(150);
+        const int16_t weights[] = {1, 3, -2, 250, -250, 0};
+        for (int16_t weight : weights) {
+            bulk.addWeighted(votes, weight);
+            for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+                single.add(i, votes.get(i) * weight);
+            }
+
+            for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+                TS_ASSERT_EQUALS(bulk.get(i), single.get(i));
+            }
+        }
+
+        // Saturated rather than wrapped around
+        ASRCourseBallot extremes(100);
+        extremes.set(0, 100);
+        extremes.set(1, -100);
+        ASRCourseBallot result(150);
+        result.addWeighted(extremes, 400);
+        TS_ASSERT_EQUALS(result.get(0), 150);
+        TS_ASSERT_EQUALS(result.get(1), -32768);
+        result.addWeighted(extremes, -400);
+        TS_ASSERT_EQUALS(result.get(0), -32768);
+        TS_ASSERT_EQUALS(result.get(1), 150);
+    }
+
+    ///----------------------------------------------------------------------------------
+    void test_ASRCourseBallot_highestCourse() {
+        ASRCourseBallot ballot(100);
+        for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+            ballot.set(i, -5);
+        }
+        TS_ASSERT_EQUALS(ballot.highestCourse(), 0);
+
+        ballot.set(358, 40);
+        TS_ASSERT_EQUALS(ballot.highestCourse(), 358);
+
+        ballot.set(123, 40);
+        ballot.set(200, 40);
+        TS_ASSERT_EQUALS(ballot.highestCourse(), 123);
+    }
+
+    ///----------------------------------------------------------------------------------
+    void test_ASRCourseBallot_Benchmark() {
+        // Voters of the LocalNavigationModule kind, each with a few smoothed peaks
+        ASRCourseBallot* voters[BENCHMARK_VOTER_COUNT];
+        int16_t kernel[41];
+        for (int j = 0; j < 41; j++) {
+            kernel[j] = 20 - (j > 20 ? j - 20 : 20 - j);
+        }
+        for (int v = 0; v < BENCHMARK_VOTER_COUNT; v++) {
+            voters[v] = new ASRCourseBallot(100);
+            for (int peak = 0; peak < 4; peak++) {
+                voters[v]->addKernel(v * 29 + peak * 90, kernel, 41);
+            }
+        }
+
+        // One voter at a time and one course at a time, the way the arbiter used to
+        ASRCourseBallot scalarResult(150);
+        uint16_t scalarWinner = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int ballot = 0; ballot < BENCHMARK_BALLOT_COUNT; ballot++) {
+            scalarResult.clear();
+            for (int v = 0; v < BENCHMARK_VOTER_COUNT; v++) {
+                for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+                    scalarResult.add(i, voters[v]->get(i) * (1 + v % 3));
+                }
+            }
+            int16_t highest = -1;
+            for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+                if (scalarResult.get(i) > highest) {
+                    highest = scalarResult.get(i);
+                    scalarWinner = i;
+                }
+            }
+        }
+        auto scalarTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        ASRCourseBallot result(150);
+        uint16_t winner = 0;
+        start = std::chrono::steady_clock::now();
+        for (int ballot = 0; ballot < BENCHMARK_BALLOT_COUNT; ballot++) {
+            result.clear();
+            for (int v = 0; v < BENCHMARK_VOTER_COUNT; v++) {
+                result.addWeighted(*voters[v], 1 + v % 3);
+            }
+            winner = result.highestCourse();
+        }
+        auto bulkTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start);
+
+        TS_ASSERT_EQUALS(winner, scalarWinner);
+        for (int i = 0; i < ASRCourseBallot::ELEMENT_COUNT; i++) {
+            TS_ASSERT_EQUALS(result.get(i), scalarResult.get(i));
+        }
+
+        char buff[160];
+        snprintf(buff, sizeof(buff), "%d voters: %.0f ballots/s course by course, %.0f ballots/s in bulk",
+                 BENCHMARK_VOTER_COUNT, BENCHMARK_BALLOT_COUNT * 1e6 / (scalarTime.count() + 1),
+                 BENCHMARK_BALLOT_COUNT * 1e6 / (bulkTime.count() + 1));
+        TS_TRACE(buff);
+
+        for (int v = 0; v < BENCHMARK_VOTER_COUNT; v++) {
+            delete voters[v];
+        }
+    }
+
     uint16_t ASRCourseBallot_mock_calculateIndex(uint16_t heading, int courseRes) {
         return heading / courseRes;
     }
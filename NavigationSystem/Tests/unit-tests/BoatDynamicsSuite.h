@@ -0,0 +1,211 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		BoatDynamicsSuite.h
+ *
+ * Purpose:
+ *		Checks that the in process boat sails the way the simulator's boat does: it
+ *		moves with the wind on its sail, turns the way the rudder says, reports the
+ *		apparent wind like the wind sensor, and simulates much faster than real time.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	BoatDynamics::reset				BoatDynamics::params
+ *	BoatDynamics::step
+ *	BoatDynamics::setCommands
+ *	BoatDynamics::boatData
+ *	BoatDynamics::loadConfig
+ *	BoatDynamics::trueWind
+ *	LocalTangentPlane::unproject
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <chrono>
+#include <cmath>
+#include "../Math/CourseMath.h"
+#include "../Math/Utility.h"
+#include "../Simulation/BoatDynamics.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define BOAT_TEST_CONFIG "/tmp/boat_dynamics_test.json"
+
+class BoatDynamicsSuite : public CxxTest::TestSuite {
+   public:
+    ActuatorDataSailPacket_t sailCommands(float rudderDegrees, float sailDegrees) {
+        ActuatorDataSailPacket_t commands;
+        // Like the simulation node sends them
+        commands.rudderCommand = -Utility::degreeToRadian(rudderDegrees);
+        commands.sailCommand = Utility::degreeToRadian(sailDegrees);
+        return commands;
+    }
+
+    // Steers like the course regulator does
+    void sailCourse(BoatDynamics& boat, double course, double seconds) {
+        for (double time = 0; time < seconds; time += 0.5) {
+            double difference = Utility::degreeToRadian(boat.heading() - course);
+            boat.setCommands(sailCommands(std::sin(difference) * 30, 45));
+            boat.step(0.5);
+        }
+    }
+
+    void test_StillWithoutWind() {
+        BoatDynamics boat(false);
+        boat.wind().speed = 0;
+        boat.reset(60.1, 19.9, 45);
+        boat.setCommands(sailCommands(10, 60));
+        boat.step(60);
+
+        SailBoatDataPacket_t data;
+        boat.boatData(data);
+        TS_ASSERT_DELTA(data.latitude, 60.1, 1e-5);
+        TS_ASSERT_DELTA(data.longitude, 19.9, 1e-5);
+        TS_ASSERT_DELTA(data.speed, 0, 1e-6);
+        TS_ASSERT_EQUALS(data.heading, 45);
+        TS_ASSERT_DELTA(boat.heading(), 45, 1e-6);
+    }
+
+    void test_BeamReach() {
+        // Wind from the north, sailing east
+        BoatDynamics boat(false);
+        boat.reset(60.1, 19.9, 90);
+        sailCourse(boat, 90, 120);
+
+        SailBoatDataPacket_t data;
+        boat.boatData(data);
+        TS_ASSERT_LESS_THAN(1, boat.speed());
+        // Mostly east, drifting a little south
+        TS_ASSERT_LESS_THAN(19.9, data.longitude);
+        TS_ASSERT_LESS_THAN_EQUALS(data.latitude, 60.1);
+        TS_ASSERT_DELTA(90 - data.course, 90, 15);
+
+        double distance = CourseMath::calculateDTW(19.9, 60.1, data.longitude, data.latitude);
+        TS_ASSERT_DELTA(boat.distance(), distance, distance * 0.05);
+    }
+
+    void test_RudderTurns() {
+        BoatDynamics boat(false);
+        boat.reset(60.1, 19.9, 90);
+        sailCourse(boat, 90, 60);
+
+        // A positive rudder command decreases the course, like the course regulator
+        // expects
+        BoatDynamics port = boat;
+        port.setCommands(sailCommands(20, 45));
+        port.step(3);
+        TS_ASSERT_LESS_THAN(port.heading(), boat.heading() - 5);
+
+        BoatDynamics starboard = boat;
+        starboard.setCommands(sailCommands(-20, 45));
+        starboard.step(3);
+        TS_ASSERT_LESS_THAN(boat.heading() + 5, starboard.heading());
+    }
+
+    void test_ApparentWindLikeTheSensor() {
+        BoatDynamics boat(false);
+        boat.params().drift = 0;
+
+        // Still and heading north, the wind from the east comes from starboard
+        boat.wind().direction = 90;
+        boat.reset(60.1, 19.9, 0);
+        SailBoatDataPacket_t data;
+        boat.boatData(data);
+        TS_ASSERT_DELTA(Utility::limitAngleRange(180 - data.windDir), 90, 1);
+        TS_ASSERT_DELTA(data.windSpeed, 6, 1e-4);
+
+        // Heading west, it comes from the stern
+        boat.reset(60.1, 19.9, 270);
+        boat.boatData(data);
+        TS_ASSERT_DELTA(Utility::limitAngleRange(180 - data.windDir), 180, 1);
+    }
+
+    void test_WingSailTailSetsTheTack() {
+        // Wind from the north, heading east: the wind comes from port
+        BoatDynamics boat(true);
+        boat.reset(60.1, 19.9, 90);
+        ActuatorDataWingPacket_t commands;
+        commands.rudderCommand = 0;
+
+        // The wing sail controller sets the tail to minus its max angle on port tack
+        commands.tailCommand = -Utility::degreeToRadian(-13);
+        boat.setCommands(commands);
+        boat.step(60);
+        TS_ASSERT_LESS_THAN(0.5, boat.speed());
+
+        // The other way the wing pushes backwards
+        boat.reset(60.1, 19.9, 90);
+        commands.tailCommand = -Utility::degreeToRadian(13);
+        boat.setCommands(commands);
+        boat.step(10);
+        TS_ASSERT_LESS_THAN(boat.speed(), 0);
+    }
+
+    void test_WindField() {
+        BoatDynamics boat(false);
+        boat.wind().speed = 5;
+        boat.wind().direction = 200;
+        boat.wind().gustAmplitude = 2;
+        boat.wind().gustPeriod = 40;
+        boat.wind().shiftAmplitude = 10;
+        boat.wind().shiftPeriod = 80;
+
+        double speed, direction;
+        boat.step(10);
+        boat.trueWind(speed, direction);
+        TS_ASSERT_DELTA(speed, 7, 1e-6);
+        TS_ASSERT_DELTA(direction, 200 + 10 * std::sqrt(0.5), 1e-6);
+    }
+
+    void test_LoadConfig() {
+        FILE* file = fopen(BOAT_TEST_CONFIG, "w");
+        fputs("{ \"boat\": { \"mass\": 500 }, \"wind\": { \"speed\": 8, \"direction\": 45 },"
+              " \"current\": { \"speed\": 0.5, \"direction\": 180 },"
+              " \"start\": { \"latitude\": 60.2, \"longitude\": 20.1, \"heading\": 30 } }",
+              file);
+        fclose(file);
+
+        BoatDynamics boat(false);
+        TS_ASSERT(boat.loadConfig(BOAT_TEST_CONFIG));
+        TS_ASSERT_EQUALS(boat.params().mass, 500);
+        TS_ASSERT_EQUALS(boat.params().inertia, 10000);
+        TS_ASSERT_EQUALS(boat.wind().speed, 8);
+        TS_ASSERT_EQUALS(boat.wind().direction, 45);
+        TS_ASSERT_EQUALS(boat.current().speed, 0.5);
+
+        double latitude, longitude;
+        boat.position(latitude, longitude);
+        TS_ASSERT_DELTA(latitude, 60.2, 1e-9);
+        TS_ASSERT_DELTA(longitude, 20.1, 1e-9);
+        TS_ASSERT_DELTA(boat.heading(), 30, 1e-6);
+
+        // No wind, the current takes the boat south
+        boat.wind().speed = 0;
+        boat.step(100);
+        boat.position(latitude, longitude);
+        TS_ASSERT_DELTA(CourseMath::calculateDTW(20.1, 60.2, longitude, latitude), 50, 0.5);
+        TS_ASSERT_LESS_THAN(latitude, 60.2);
+
+        TS_ASSERT(not boat.loadConfig("/tmp/no_such_boat_dynamics.json"));
+        remove(BOAT_TEST_CONFIG);
+    }
+
+    void test_FasterThanRealTime() {
+        BoatDynamics boat(false);
+        boat.reset(60.1, 19.9, 90);
+        boat.setCommands(sailCommands(5, 45));
+
+        auto start = std::chrono::steady_clock::now();
+        boat.step(36000);
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // Ten simulated hours
+        TS_ASSERT_LESS_THAN(elapsed, 1.0);
+        char rate[64];
+        snprintf(rate, sizeof(rate), "%.0f simulated seconds per second", 36000 / elapsed);
+        TS_TRACE(rate);
+    }
+};
@@ -0,0 +1,199 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		CANTraceSuite.h
+ *
+ * Purpose:
+ *		Checks that candump logs are parsed, replayed at the requested speed and recorded,
+ *		and that CANService reads its frames from a replayed log without any hardware.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	parseCandumpLine				CANTraceReplayer::acknowledge
+ *	formatCandumpLine
+ *	CANTraceReplayer::receive
+ *	CANTraceRecorder::receive
+ *	CANTraceRecorder::send
+ *	CANService::statisticsReport
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include "../Hardwares/CAN_Services/CANPGNReceiver.h"
+#include "../Hardwares/CAN_Services/CANService.h"
+#include "../Hardwares/CAN_Services/CANTrace.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define CAN_TRACE_TEST_LOG "./CANTraceSuite.log"
+#define CAN_TRACE_TEST_RECORD "./CANTraceSuite-record.log"
+
+// PGN 130306 (wind data) from source 0x23, priority 2
+#define CAN_TRACE_WIND_ID 0x09FD0223
+
+class WindPGNCounter : public CANPGNReceiver {
+   public:
+    WindPGNCounter(CANService& service) : CANPGNReceiver(service, 130306), m_count(0) {}
+
+    void processPGN(N2kMsg& /*msg*/) { m_count++; }
+
+    int m_count;
+};
+
+class CANTraceSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() {
+        Logger::DisableLogging();
+        remove(CAN_TRACE_TEST_LOG);
+        remove(CAN_TRACE_TEST_RECORD);
+    }
+
+    void tearDown() {
+        remove(CAN_TRACE_TEST_LOG);
+        remove(CAN_TRACE_TEST_RECORD);
+    }
+
+    // One wind frame every 10 ms, with a remote frame the replayer must skip
+    void writeLog(int frames) {
+        std::ofstream log(CAN_TRACE_TEST_LOG);
+        for (int i = 0; i < frames; i++) {
+            char line[80];
+            snprintf(line, sizeof(line), "(1436509052.%06d) can0 %08X#FF%02X0000FA00FFFF", i * 10000,
+                     CAN_TRACE_WIND_ID, i);
+            log << line << "\n";
+        }
+        log << "(1436509053.000000) can0 123#R\n";
+    }
+
+    int replayAll(CANTransport& transport, int timeoutMs) {
+        int count = 0;
+        CanMsg msg;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (not transport.finished() && std::chrono::steady_clock::now() < deadline) {
+            if (transport.receive(msg)) {
+                count++;
+            } else {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+        return count;
+    }
+
+    void test_CandumpLines() {
+        double timestamp;
+        CanMsg msg;
+
+        TS_ASSERT(parseCandumpLine("(1436509052.249713) can0 19F51323#01020304AABBCCDD", timestamp, msg));
+        TS_ASSERT_DELTA(timestamp, 1436509052.249713, 1e-6);
+        TS_ASSERT_EQUALS(msg.id, 0x19F51323);
+        TS_ASSERT_EQUALS(msg.header.ide, 1);
+        TS_ASSERT_EQUALS(msg.header.length, 8);
+        TS_ASSERT_EQUALS(msg.data[0], 0x01);
+        TS_ASSERT_EQUALS(msg.data[7], 0xDD);
+        TS_ASSERT_EQUALS(formatCandumpLine(timestamp, "can0", msg),
+                         "(1436509052.249713) can0 19F51323#01020304AABBCCDD");
+
+        TS_ASSERT(parseCandumpLine("(0.5) vcan0 2BC#0A0B", timestamp, msg));
+        TS_ASSERT_EQUALS(msg.id, 0x2BC);
+        TS_ASSERT_EQUALS(msg.header.ide, 0);
+        TS_ASSERT_EQUALS(msg.header.length, 2);
+        TS_ASSERT_EQUALS(formatCandumpLine(timestamp, "vcan0", msg), "(0.500000) vcan0 2BC#0A0B");
+
+        TS_ASSERT(not parseCandumpLine("(0.5) can0 123#R", timestamp, msg));
+        TS_ASSERT(not parseCandumpLine("(0.5) can0 123##1AA", timestamp, msg));
+        TS_ASSERT(not parseCandumpLine("not a frame", timestamp, msg));
+    }
+
+    void test_ReplaySpeed() {
+        // 490 ms of frames
+        writeLog(50);
+
+        CANTraceReplayer replayer(CAN_TRACE_TEST_LOG, 10);
+        TS_ASSERT(replayer.open());
+
+        auto start = std::chrono::steady_clock::now();
+        TS_ASSERT_EQUALS(replayAll(replayer, 2000), 50);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+        TS_ASSERT(replayer.finished());
+        TS_ASSERT_EQUALS(replayer.replayedCount(), 50);
+        TS_ASSERT_LESS_THAN_EQUALS(45, elapsed);
+        TS_ASSERT_LESS_THAN(elapsed, 400);
+    }
+
+    void test_ReplayAsFastAsPossible() {
+        writeLog(1000);
+
+        CANTraceReplayer replayer(CAN_TRACE_TEST_LOG, 0);
+        TS_ASSERT(replayer.open());
+
+        CanMsg msg;
+        int count = 0;
+        while (replayer.receive(msg)) {
+            count++;
+        }
+        TS_ASSERT_EQUALS(count, 1000);
+        TS_ASSERT(replayer.finished());
+    }
+
+    void test_RecorderWritesCandump() {
+        writeLog(5);
+
+        std::unique_ptr<CANTransport> replayer(new CANTraceReplayer(CAN_TRACE_TEST_LOG, 0));
+        {
+            CANTraceRecorder recorder(std::move(replayer), CAN_TRACE_TEST_RECORD, "vcan0");
+            TS_ASSERT(recorder.open());
+            TS_ASSERT_EQUALS(replayAll(recorder, 1000), 5);
+
+            // Frames sent by the nodes are recorded too
+            CanMsg msg;
+            double timestamp;
+            TS_ASSERT(parseCandumpLine("(0.0) can0 1AB#0102", timestamp, msg));
+            TS_ASSERT(recorder.send(msg));
+        }
+
+        // Replaying the recording gives the same frames back
+        CANTraceReplayer recorded(CAN_TRACE_TEST_RECORD, 0);
+        TS_ASSERT(recorded.open());
+        CanMsg msg;
+        for (int i = 0; i < 5; i++) {
+            TS_ASSERT(recorded.receive(msg));
+            TS_ASSERT_EQUALS(msg.id, CAN_TRACE_WIND_ID);
+            TS_ASSERT_EQUALS(msg.data[1], i);
+        }
+        TS_ASSERT(recorded.receive(msg));
+        TS_ASSERT_EQUALS(msg.id, 0x1AB);
+        TS_ASSERT(not recorded.receive(msg));
+    }
+
+    void test_ServiceReadsReplay() {
+        writeLog(200);
+
+        CANTraceReplayer replayer(CAN_TRACE_TEST_LOG, 0);
+        CANService service(replayer);
+        WindPGNCounter counter(service);
+        service.enableStatistics();
+
+        auto future = service.start();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (not replayer.finished() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        service.stop();
+        future.get();
+
+        TS_ASSERT_EQUALS(counter.m_count, 200);
+        TS_ASSERT_DIFFERS(service.statisticsReport().find("PGN 130306: 200 frames"), std::string::npos);
+    }
+};
@@ -0,0 +1,212 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		CollisionMathSuite.h
+ *
+ * Purpose:
+ *		Checks the batch CPA computations against a plain double precision one, and the
+ *		AIS contact grid queries against going through every contact.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	LocalTangentPlane::project
+ *	CollisionMath::courseToVelocity
+ *	CollisionMath::computeCPA
+ *	CollisionMath::computeCPAForHeadings
+ *	AISContactGrid::build
+ *	AISContactGrid::query
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "../Math/CollisionMath.h"
+#include "../Math/CourseMath.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "../WorldState/CollidableMgr/AISContactGrid.h"
+
+class CollisionMathSuite : public CxxTest::TestSuite {
+   public:
+    uint32_t m_seed;
+
+    // Same numbers on every run
+    float random(float low, float high) {
+        m_seed = m_seed * 1103515245 + 12345;
+        return low + (high - low) * ((m_seed >> 8) & 0xFFFF) / 65535.0f;
+    }
+
+    void setUp() { m_seed = 2018; }
+
+    void referenceCPA(double east,
+                      double north,
+                      double velocityEast,
+                      double velocityNorth,
+                      double ownEast,
+                      double ownNorth,
+                      double& cpa,
+                      double& tcpa) {
+        double relativeEast = velocityEast - ownEast;
+        double relativeNorth = velocityNorth - ownNorth;
+        double dotProduct = east * relativeEast + north * relativeNorth;
+        if (dotProduct >= 0) {
+            cpa = -1;
+            tcpa = 0;
+            return;
+        }
+        double squaredVelocity = relativeEast * relativeEast + relativeNorth * relativeNorth;
+        tcpa = -dotProduct / squaredVelocity;
+        cpa = hypot(east + relativeEast * tcpa, north + relativeNorth * tcpa);
+    }
+
+    void test_PlaneMatchesGreatCircle() {
+        LocalTangentPlane plane(60.1, 19.9);
+        double east, north;
+
+        plane.project(60.1, 19.9, east, north);
+        TS_ASSERT_DELTA(east, 0, 1e-6);
+        TS_ASSERT_DELTA(north, 0, 1e-6);
+
+        plane.project(60.105, 19.91, east, north);
+        double distance = CourseMath::calculateDTW(19.9, 60.1, 19.91, 60.105);
+        TS_ASSERT_DELTA(hypot(east, north), distance, distance * 0.005);
+        TS_ASSERT_LESS_THAN(0, east);
+        TS_ASSERT_LESS_THAN(0, north);
+    }
+
+    void test_BatchMatchesReference() {
+        // Not a multiple of the vector width, the last contacts go through the scalar code
+        const uint32_t count = 103;
+        std::vector<float> east(count), north(count), velocityEast(count), velocityNorth(count);
+        for (uint32_t i = 0; i < count; i++) {
+            east[i] = random(-1000, 1000);
+            north[i] = random(-1000, 1000);
+            CollisionMath::courseToVelocity(random(0, 360), random(0, 10), velocityEast[i],
+                                            velocityNorth[i]);
+        }
+
+        std::vector<float> cpa(count), tcpa(count);
+        CollisionMath::computeCPA(east.data(), north.data(), velocityEast.data(),
+                                  velocityNorth.data(), count, 1.5f, -2.0f, cpa.data(), tcpa.data());
+
+        int closing = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            double expectedCPA, expectedTCPA;
+            referenceCPA(east[i], north[i], velocityEast[i], velocityNorth[i], 1.5, -2.0,
+                         expectedCPA, expectedTCPA);
+            TS_ASSERT_DELTA(cpa[i], expectedCPA, 0.01 + expectedCPA * 1e-4);
+            TS_ASSERT_DELTA(tcpa[i], expectedTCPA, 0.01 + expectedTCPA * 1e-3);
+            closing += expectedCPA >= 0;
+        }
+        // Both branches were taken
+        TS_ASSERT_LESS_THAN(10, closing);
+        TS_ASSERT_LESS_THAN(closing, (int)count - 10);
+    }
+
+    void test_HeadOnAndMovingAway() {
+        // Straight ahead coming at us, abeam coming at us, and behind sailing away
+        float east[] = {0, 200, 0};
+        float north[] = {500, 0, -300};
+        float velocityEast[] = {0, -2, 0};
+        float velocityNorth[] = {-5, 0, -1};
+        float cpa[3], tcpa[3];
+
+        CollisionMath::computeCPA(east, north, velocityEast, velocityNorth, 3, 0, 5, cpa, tcpa);
+        TS_ASSERT_DELTA(cpa[0], 0, 0.01);
+        TS_ASSERT_DELTA(tcpa[0], 50, 0.01);
+        TS_ASSERT_DELTA(cpa[1], 200 * 5 / hypot(2, 5), 0.01);
+        TS_ASSERT_EQUALS(cpa[2], -1);
+        TS_ASSERT_EQUALS(tcpa[2], 0);
+
+        // Same velocity: the distance never changes
+        float still[] = {0, 0, 0};
+        CollisionMath::computeCPA(east, north, still, still, 3, 0, 0, cpa, tcpa);
+        for (int i = 0; i < 3; i++) {
+            TS_ASSERT_EQUALS(cpa[i], -1);
+        }
+    }
+
+    void test_HeadingsLayout() {
+        const uint32_t count = 9;
+        std::vector<float> east(count), north(count), velocityEast(count), velocityNorth(count);
+        for (uint32_t i = 0; i < count; i++) {
+            east[i] = random(-500, 500);
+            north[i] = random(-500, 500);
+            CollisionMath::courseToVelocity(random(0, 360), random(0, 5), velocityEast[i],
+                                            velocityNorth[i]);
+        }
+
+        const uint16_t step = 10;
+        std::vector<float> cpa(36 * count), tcpa(36 * count);
+        CollisionMath::computeCPAForHeadings(east.data(), north.data(), velocityEast.data(),
+                                             velocityNorth.data(), count, 3.0f, step, cpa.data(),
+                                             tcpa.data());
+
+        float single[count], singleTime[count];
+        for (uint16_t heading = 0; heading < 360; heading += step) {
+            float ownEast, ownNorth;
+            CollisionMath::courseToVelocity(heading, 3.0f, ownEast, ownNorth);
+            CollisionMath::computeCPA(east.data(), north.data(), velocityEast.data(),
+                                      velocityNorth.data(), count, ownEast, ownNorth, single,
+                                      singleTime);
+            for (uint32_t i = 0; i < count; i++) {
+                TS_ASSERT_EQUALS(cpa[(heading / step) * count + i], single[i]);
+                TS_ASSERT_EQUALS(tcpa[(heading / step) * count + i], singleTime[i]);
+            }
+        }
+    }
+
+    void test_GridQueryMatchesFullScan() {
+        std::vector<AISCollidable_t> contacts;
+        for (int i = 0; i < 500; i++) {
+            AISCollidable_t contact;
+            contact.mmsi = 230000000 + i;
+            contact.latitude = 60.1 + random(-0.05, 0.05);
+            contact.longitude = 19.9 + random(-0.1, 0.1);
+            contact.course = random(0, 360);
+            contact.speed = random(0, 10);
+            contact.length = 0;
+            contact.beam = 0;
+            contact.lastUpdated = 0;
+            contacts.push_back(contact);
+        }
+        // Only the static data of this one is known
+        contacts[7].latitude = -100;
+
+        AISContactGrid grid;
+        grid.build(contacts);
+        TS_ASSERT_EQUALS(grid.size(), 499);
+
+        std::vector<uint32_t> rows;
+        const double radiuses[] = {0, 100, 1000, 2500, 50000};
+        for (double radius : radiuses) {
+            double centreEast, centreNorth;
+            grid.plane().project(60.1, 19.9, centreEast, centreNorth);
+            grid.query(centreEast, centreNorth, radius, rows);
+
+            std::vector<uint32_t> expected;
+            for (uint32_t row = 0; row < grid.size(); row++) {
+                if (hypot(grid.m_east[row] - centreEast, grid.m_north[row] - centreNorth) <= radius) {
+                    expected.push_back(grid.m_item[row]);
+                }
+            }
+            std::sort(expected.begin(), expected.end());
+
+            std::vector<uint32_t> found;
+            for (uint32_t row : rows) {
+                found.push_back(grid.m_item[row]);
+            }
+            TS_ASSERT(found == expected);
+        }
+        TS_ASSERT_EQUALS(rows.size(), 499);
+
+        for (uint32_t row = 0; row < grid.size(); row++) {
+            TS_ASSERT_DIFFERS(grid.m_item[row], 7);
+        }
+    }
+};
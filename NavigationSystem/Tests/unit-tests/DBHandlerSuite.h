@@ -0,0 +1,300 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		DBHandlerSuite.h
+ *
+ * Purpose:
+ *		Checks that DBHandler writes the data logs, on a scratch database holding only the
+ *		tables involved.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	initialise
+ *	insertDataLogs
+ *	getRows
+ *	retrieveCellAsInt
+ *	retrieveCellAsDouble
+ *	reloadConfigs
+ *	updateConfigs
+ *	getLogsSince
+ *	loadLogCursor
+ *	saveLogCursor
+ *	clearLogsUpTo
+ *	countUnharvestedWaypoints
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <sqlite3.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "../Database/DBHandler.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "LogItemTestHelper.h"
+
+#define DBHANDLER_TEST_DB "./DBHandlerSuite.db"
+
+class DBHandlerSuite : public CxxTest::TestSuite {
+   public:
+    void removeDatabase() {
+        remove(DBHANDLER_TEST_DB);
+        remove(DBHANDLER_TEST_DB "-wal");
+        remove(DBHANDLER_TEST_DB "-shm");
+    }
+
+    void setUp() {
+        Logger::DisableLogging();
+        removeDatabase();
+
+        sqlite3* db;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_exec(
+            db,
+            "CREATE TABLE dataLogs_actuator_feedback (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "rudder_position DOUBLE, wingsail_position DOUBLE, rc_on BOOLEAN, "
+            "wind_vane_angle DOUBLE, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_compass (id INTEGER PRIMARY KEY AUTOINCREMENT, heading DOUBLE, "
+            "pitch DOUBLE, roll DOUBLE, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_course_calculation (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "distance_to_waypoint DOUBLE, bearing_to_waypoint DOUBLE, course_to_steer DOUBLE, "
+            "tack BOOLEAN, going_starboard BOOLEAN, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_current_sensors (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "current FLOAT, voltage FLOAT, element INTEGER, element_str VARCHAR(50), "
+            "t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_gps (id INTEGER PRIMARY KEY AUTOINCREMENT, has_fix BOOLEAN, "
+            "online BOOLEAN, time TIME, latitude DOUBLE, longitude DOUBLE, speed DOUBLE, "
+            "course DOUBLE, satellites_used INTEGER, route_started BOOLEAN, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_marine_sensors (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "temperature DOUBLE, conductivity DOUBLE, ph DOUBLE, salinity DOUBLE, "
+            "t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_vessel_state (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "heading DOUBLE, latitude DOUBLE, longitude DOUBLE, speed DOUBLE, course DOUBLE, "
+            "t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_wind_state (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "true_wind_speed DOUBLE, true_wind_direction DOUBLE, apparent_wind_speed DOUBLE, "
+            "apparent_wind_direction DOUBLE, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_windsensor (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "direction DOUBLE, speed DOUBLE, temperature DOUBLE, t_timestamp TIMESTAMP);"
+            "CREATE TABLE dataLogs_system (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "actuator_feedback_id INTEGER, compass_id INTEGER, course_calculation_id INTEGER, "
+            "current_sensors_id INTEGER, gps_id INTEGER, marine_sensors_id INTEGER, "
+            "vessel_state_id INTEGER, wind_state_id INTEGER, windsensor_id INTEGER, "
+            "current_mission_id INTEGER);"
+            "CREATE TABLE currentMission (id INTEGER PRIMARY KEY AUTOINCREMENT, name VARCHAR);"
+            "INSERT INTO currentMission VALUES(7, 'test');"
+            "CREATE TABLE config_course_regulator (id INTEGER PRIMARY KEY AUTOINCREMENT, "
+            "loop_time DOUBLE, max_rudder_angle INTEGER);"
+            "INSERT INTO config_course_regulator VALUES(1, 0.5, 30);"
+            "CREATE TABLE sync_cursors (table_name VARCHAR PRIMARY KEY, last_id INTEGER);",
+            NULL, NULL, NULL);
+        sqlite3_close(db);
+    }
+
+    void tearDown() { removeDatabase(); }
+
+    void test_InsertDataLogsWritesEveryTable() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        std::vector<LogItem> logs;
+        logs.push_back(makeLogItem(10));
+        logs.push_back(makeLogItem(20));
+
+        TS_ASSERT(dbHandler.insertDataLogs(logs));
+
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_compass"), 2);
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_gps"), 2);
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_system"), 2);
+        TS_ASSERT_DELTA(dbHandler.retrieveCellAsDouble("dataLogs_compass", "2", "heading"), 20,
+                        1e-9);
+        TS_ASSERT_DELTA(dbHandler.retrieveCellAsDouble("dataLogs_gps", "1", "latitude"),
+                        60.1234567891, 1e-12);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("dataLogs_gps", "1", "satellites_used"), 10);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("dataLogs_current_sensors", "1", "element_str"),
+                         "sail'drive");
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("dataLogs_system", "2", "compass_id"), 2);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("dataLogs_system", "2", "current_mission_id"),
+                         7);
+    }
+
+    void test_InsertDataLogsContinuesIds() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        std::vector<LogItem> logs;
+        logs.push_back(makeLogItem(10));
+
+        dbHandler.insertDataLogs(logs);
+        dbHandler.clearTable("dataLogs_compass");
+        dbHandler.insertDataLogs(logs);
+
+        // The system row must point at the compass row that was really inserted
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_compass"), 1);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("dataLogs_system", "2", "compass_id"), 2);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("dataLogs_compass", "2", "id"), 2);
+    }
+
+    void test_InsertDataLogsReportsFailure() {
+        sqlite3* db;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_exec(db, "DROP TABLE dataLogs_windsensor;", NULL, NULL, NULL);
+        sqlite3_close(db);
+
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        std::vector<LogItem> logs;
+        logs.push_back(makeLogItem(10));
+
+        // Nothing of the batch is kept
+        TS_ASSERT(not dbHandler.insertDataLogs(logs));
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_compass"), 0);
+    }
+
+    void test_CountUnharvestedWaypoints() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        int count = -1;
+
+        // The scratch mission has no harvested column
+        TS_ASSERT(not dbHandler.countUnharvestedWaypoints(count));
+
+        sqlite3* db;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_exec(db,
+                     "ALTER TABLE currentMission ADD COLUMN harvested BOOLEAN DEFAULT 0;"
+                     "INSERT INTO currentMission VALUES(8, 'test', 1);"
+                     "INSERT INTO currentMission VALUES(9, 'test', 0);",
+                     NULL, NULL, NULL);
+        sqlite3_close(db);
+
+        TS_ASSERT(dbHandler.countUnharvestedWaypoints(count));
+        TS_ASSERT_EQUALS(count, 2);
+    }
+
+    void test_InitialiseEnablesWAL() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+
+        sqlite3* db;
+        sqlite3_stmt* statement;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_prepare_v2(db, "PRAGMA journal_mode;", -1, &statement, NULL);
+        TS_ASSERT_EQUALS(sqlite3_step(statement), SQLITE_ROW);
+        TS_ASSERT_EQUALS(std::string((const char*)sqlite3_column_text(statement, 0)), "wal");
+        sqlite3_finalize(statement);
+        sqlite3_close(db);
+    }
+
+    void test_ReadsDontWaitForWrites() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+
+        // Another writer holds the write lock in the middle of a transaction
+        sqlite3* db;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_exec(db, "BEGIN IMMEDIATE; INSERT INTO currentMission VALUES(8, 'next');", NULL,
+                     NULL, NULL);
+
+        TS_ASSERT_EQUALS(dbHandler.getRows("currentMission"), 1);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCell("currentMission", "7", "name"), "test");
+
+        sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+        sqlite3_close(db);
+        TS_ASSERT_EQUALS(dbHandler.getRows("currentMission"), 2);
+    }
+
+    void test_MissingDatabaseFails() {
+        DBHandler dbHandler("./DBHandlerSuite.missing.db");
+        TS_ASSERT(not dbHandler.initialise());
+        TS_ASSERT_EQUALS(dbHandler.getRows("currentMission"), 0);
+        TS_ASSERT_EQUALS(dbHandler.retrieveCellAsInt("config_course_regulator", "1", "loop_time"), 0);
+        TS_ASSERT_EQUALS(fopen("./DBHandlerSuite.missing.db", "r"), (FILE*)NULL);
+    }
+
+    void test_ConfigsReadFromSnapshot() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+        TS_ASSERT_DELTA(
+            dbHandler.retrieveCellAsDouble("config_course_regulator", "1", "loop_time"), 0.5, 1e-9);
+        TS_ASSERT_EQUALS(
+            dbHandler.retrieveCellAsInt("config_course_regulator", "1", "max_rudder_angle"), 30);
+
+        // Changes made behind DBHandler's back only show after a reload
+        sqlite3* db;
+        sqlite3_open(DBHANDLER_TEST_DB, &db);
+        sqlite3_exec(db, "UPDATE config_course_regulator SET loop_time = 0.9;", NULL, NULL, NULL);
+        sqlite3_close(db);
+
+        TS_ASSERT_DELTA(
+            dbHandler.retrieveCellAsDouble("config_course_regulator", "1", "loop_time"), 0.5, 1e-9);
+        dbHandler.reloadConfigs();
+        TS_ASSERT_DELTA(
+            dbHandler.retrieveCellAsDouble("config_course_regulator", "1", "loop_time"), 0.9, 1e-9);
+    }
+
+    void test_ConfigsReloadedOnUpdate() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        TS_ASSERT(dbHandler.initialise());
+
+        dbHandler.updateConfigs(
+            "{\"config_course_regulator\": {\"id\": \"1\", \"loop_time\": \"0.7\", "
+            "\"max_rudder_angle\": \"25\"}}");
+        TS_ASSERT_DELTA(
+            dbHandler.retrieveCellAsDouble("config_course_regulator", "1", "loop_time"), 0.7, 1e-9);
+        TS_ASSERT_EQUALS(
+            dbHandler.retrieveCellAsInt("config_course_regulator", "1", "max_rudder_angle"), 25);
+
+        TS_ASSERT(dbHandler.changeOneValue("config_course_regulator", "1", "20", "max_rudder_angle"));
+        TS_ASSERT_EQUALS(
+            dbHandler.retrieveCellAsInt("config_course_regulator", "1", "max_rudder_angle"), 20);
+    }
+
+    void test_LogsExportedInChunks() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        std::vector<LogItem> logs;
+        for (int i = 0; i < 5; i++) {
+            logs.push_back(makeLogItem(i));
+        }
+        dbHandler.insertDataLogs(logs);
+
+        LogCursor cursor;
+        std::string json;
+        TS_ASSERT(dbHandler.getLogsSince(cursor, 3, json));
+
+        Json js = Json::parse(json);
+        TS_ASSERT_EQUALS(js["dataLogs_compass"].size(), 3);
+        TS_ASSERT_EQUALS(js["dataLogs_compass"][2]["heading"], "2.0");
+        TS_ASSERT_EQUALS(js["dataLogs_current_sensors"][0]["element_str"], "sail'drive");
+        TS_ASSERT_EQUALS(cursor["dataLogs_compass"], 3);
+
+        TS_ASSERT(dbHandler.getLogsSince(cursor, 3, json));
+        js = Json::parse(json);
+        TS_ASSERT_EQUALS(js["dataLogs_compass"].size(), 2);
+        TS_ASSERT_EQUALS(js["dataLogs_compass"][0]["id"], "4");
+        TS_ASSERT_EQUALS(cursor["dataLogs_compass"], 5);
+
+        TS_ASSERT(not dbHandler.getLogsSince(cursor, 3, json));
+    }
+
+    void test_LogCursorPersisted() {
+        DBHandler dbHandler(DBHANDLER_TEST_DB);
+        std::vector<LogItem> logs;
+        logs.push_back(makeLogItem(1));
+        logs.push_back(makeLogItem(2));
+        dbHandler.insertDataLogs(logs);
+
+        LogCursor cursor = dbHandler.loadLogCursor();
+        std::string json;
+        TS_ASSERT(dbHandler.getLogsSince(cursor, 10, json));
+        TS_ASSERT(dbHandler.saveLogCursor(cursor));
+        dbHandler.clearLogsUpTo(cursor);
+        TS_ASSERT_EQUALS(dbHandler.getRows("dataLogs_compass"), 0);
+
+        // Only the rows logged since are exported again
+        dbHandler.insertDataLogs(logs);
+        DBHandler otherHandler(DBHANDLER_TEST_DB);
+        cursor = otherHandler.loadLogCursor();
+        TS_ASSERT_EQUALS(cursor["dataLogs_gps"], 2);
+        TS_ASSERT(otherHandler.getLogsSince(cursor, 10, json));
+        TS_ASSERT_EQUALS(Json::parse(json)["dataLogs_gps"][0]["id"], "3");
+    }
+};
@@ -0,0 +1,189 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		DBLoggerSuite.h
+ *
+ * Purpose:
+ *		Checks that DBLogger hands every item over to its sink, and what happens to the
+ *		items logged when the sink can't keep up.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	log
+ *	startWorkerThread
+ *	stopWorkerThread
+ *	droppedCount
+ *	coalescedCount
+ *	blockedCount
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../Database/DBLogger.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "LogItemTestHelper.h"
+
+// Keeps the sequence numbers of the items it is given, can be held back to act slow
+class RecordingSink : public LogSink {
+   public:
+    RecordingSink() : m_open(true) {}
+
+    void writeLogs(std::vector<LogItem>& logs) {
+        while (not m_open.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_batches++;
+        for (const LogItem& item : logs) {
+            m_written.push_back((int)item.m_compassHeading);
+        }
+    }
+
+    std::vector<int> written() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_written;
+    }
+
+    std::atomic<bool> m_open;
+    int m_batches = 0;
+
+   private:
+    std::mutex m_mutex;
+    std::vector<int> m_written;
+};
+
+class DBLoggerSuite : public CxxTest::TestSuite {
+   public:
+    const unsigned int BUFFER_SIZE = 4;
+
+    void setUp() { Logger::DisableLogging(); }
+
+    bool inOrder(const std::vector<int>& written) {
+        for (size_t i = 1; i < written.size(); i++) {
+            if (written[i] <= written[i - 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void test_EverythingWrittenOnStop() {
+        DBHandler dbHandler("./DBLoggerSuite.db");
+        RecordingSink sink;
+        DBLogger logger(BUFFER_SIZE, dbHandler, &sink);
+        logger.startWorkerThread();
+
+        // Not a multiple of the buffer size, the last items are only written on stop
+        for (int i = 0; i < 10; i++) {
+            logger.log(makeLogItem(i));
+        }
+        logger.stopWorkerThread();
+
+        std::vector<int> written = sink.written();
+        TS_ASSERT_EQUALS(written.size(), 10);
+        TS_ASSERT(inOrder(written));
+        TS_ASSERT_EQUALS(logger.droppedCount(), 0);
+    }
+
+    void test_BlockWaitsForRoom() {
+        DBHandler dbHandler("./DBLoggerSuite.db");
+        RecordingSink sink;
+        sink.m_open.store(false);
+        DBLogger logger(BUFFER_SIZE, dbHandler, &sink, LogBackpressure::Block);
+        logger.startWorkerThread();
+
+        const int count = logger.capacity() * 3;
+        std::atomic<int> logged(0);
+        std::thread producer([&] {
+            for (int i = 0; i < count; i++) {
+                logger.log(makeLogItem(i));
+                logged++;
+            }
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TS_ASSERT_LESS_THAN(logged.load(), count);
+
+        sink.m_open.store(true);
+        producer.join();
+        logger.stopWorkerThread();
+
+        std::vector<int> written = sink.written();
+        TS_ASSERT_EQUALS(written.size(), count);
+        TS_ASSERT(inOrder(written));
+        TS_ASSERT_EQUALS(logger.droppedCount(), 0);
+        TS_ASSERT_LESS_THAN(0, logger.blockedCount());
+    }
+
+    void test_DropOldest() {
+        DBHandler dbHandler("./DBLoggerSuite.db");
+        RecordingSink sink;
+        DBLogger logger(BUFFER_SIZE, dbHandler, &sink, LogBackpressure::DropOldest);
+
+        // Without a worker nothing is taken out of the ring
+        const int count = logger.capacity() + 3;
+        for (int i = 0; i < count; i++) {
+            logger.log(makeLogItem(i));
+        }
+        TS_ASSERT_EQUALS(logger.droppedCount(), 3);
+
+        logger.stopWorkerThread();
+        std::vector<int> written = sink.written();
+        TS_ASSERT_EQUALS(written.size(), logger.capacity());
+        TS_ASSERT_EQUALS(written.front(), 3);
+        TS_ASSERT_EQUALS(written.back(), count - 1);
+    }
+
+    void test_CoalesceKeepsLatest() {
+        DBHandler dbHandler("./DBLoggerSuite.db");
+        RecordingSink sink;
+        DBLogger logger(BUFFER_SIZE, dbHandler, &sink, LogBackpressure::Coalesce);
+
+        const int count = logger.capacity() + 3;
+        for (int i = 0; i < count; i++) {
+            logger.log(makeLogItem(i));
+        }
+        TS_ASSERT_EQUALS(logger.coalescedCount(), 2);
+
+        logger.stopWorkerThread();
+        std::vector<int> written = sink.written();
+        TS_ASSERT_EQUALS(written.size(), logger.capacity() + 1);
+        TS_ASSERT_EQUALS(written[logger.capacity() - 1], (int)logger.capacity() - 1);
+        TS_ASSERT_EQUALS(written.back(), count - 1);
+    }
+
+    void test_DropOldestWhileWriting() {
+        DBHandler dbHandler("./DBLoggerSuite.db");
+        RecordingSink sink;
+        DBLogger logger(BUFFER_SIZE, dbHandler, &sink, LogBackpressure::DropOldest);
+        logger.startWorkerThread();
+
+        // Making room for an item never takes more than the oldest one out
+        const int count = 20000;
+        uint64_t mostDropped = 0;
+        for (int i = 0; i < count; i++) {
+            uint64_t dropped = logger.droppedCount();
+            logger.log(makeLogItem(i));
+            mostDropped = std::max(mostDropped, logger.droppedCount() - dropped);
+        }
+        logger.stopWorkerThread();
+        TS_ASSERT_LESS_THAN_EQUALS(mostDropped, 1);
+
+        // Every item is either written or counted as dropped, never both
+        std::vector<int> written = sink.written();
+        TS_ASSERT_EQUALS(written.size() + logger.droppedCount(), count);
+        TS_ASSERT(inOrder(written));
+        TS_ASSERT_EQUALS(written.back(), count - 1);
+    }
+};
@@ -0,0 +1,216 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		FastPacketAssemblerSuite.h
+ *
+ * Purpose:
+ *		Checks that NMEA2000 fast packets are put back together from their frames,
+ *		including when the frames of several packets are interleaved or get lost.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	addFrame
+ *	evictStale
+ *	inProgress
+ *	stats
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "../Hardwares/CAN_Services/FastPacketAssembler.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+// PGN 129038 (AIS class A position report)
+#define FAST_PACKET_TEST_PGN 129038
+
+class FastPacketAssemblerSuite : public CxxTest::TestSuite {
+   public:
+    // The frames of a fast packet carrying length bytes counting up from first
+    std::vector<CanMsg> makeFrames(uint8_t source, uint8_t sequenceId, int length, uint8_t first) {
+        std::vector<CanMsg> frames;
+        int sent = 0;
+        uint8_t frameNumber = 0;
+
+        while (sent < length) {
+            CanMsg frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.id = (3 << 26) | (FAST_PACKET_TEST_PGN << 8) | source;
+            frame.header.ide = 1;
+            frame.header.length = 8;
+            frame.data[0] = (sequenceId << 5) | frameNumber;
+
+            int offset = 1;
+            if (frameNumber == 0) {
+                frame.data[1] = length;
+                offset = 2;
+            }
+            for (int i = offset; i < 8 && sent < length; i++) {
+                frame.data[i] = first + sent++;
+            }
+            frames.push_back(frame);
+            frameNumber++;
+        }
+        return frames;
+    }
+
+    N2kMsg headerOf(const CanMsg& frame) {
+        N2kMsg msg;
+        uint32_t id = frame.id;
+        IdToN2kMsg(msg, id);
+        msg.Data.reserve(FAST_PACKET_MAX_LENGTH);
+        return msg;
+    }
+
+    bool holdsSequence(const N2kMsg& msg, int length, uint8_t first) {
+        if (msg.DataLen != length || (int)msg.Data.size() != length) {
+            return false;
+        }
+        for (int i = 0; i < length; i++) {
+            if (msg.Data[i] != (uint8_t)(first + i)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void test_Reassembles() {
+        FastPacketAssembler assembler;
+        std::vector<CanMsg> frames = makeFrames(0x10, 2, 53, 0);
+
+        N2kMsg msg = headerOf(frames[0]);
+        for (size_t i = 0; i < frames.size() - 1; i++) {
+            TS_ASSERT(not assembler.addFrame(frames[i], msg, 0));
+        }
+        TS_ASSERT_EQUALS(assembler.inProgress(), 1);
+        TS_ASSERT(assembler.addFrame(frames.back(), msg, 0));
+        TS_ASSERT(holdsSequence(msg, 53, 0));
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+        TS_ASSERT_EQUALS(assembler.stats().completed, 1);
+    }
+
+    void test_LongestPacket() {
+        FastPacketAssembler assembler;
+        std::vector<CanMsg> frames = makeFrames(0x10, 0, FAST_PACKET_MAX_LENGTH, 7);
+        TS_ASSERT_EQUALS(frames.size(), 32);
+
+        N2kMsg msg = headerOf(frames[0]);
+        const uint8_t* storage = msg.Data.data();
+        bool complete = false;
+        for (const CanMsg& frame : frames) {
+            complete = assembler.addFrame(frame, msg, 0);
+        }
+        TS_ASSERT(complete);
+        TS_ASSERT(holdsSequence(msg, FAST_PACKET_MAX_LENGTH, 7));
+        // Filled in place, without reallocating
+        TS_ASSERT_EQUALS(msg.Data.data(), storage);
+    }
+
+    void test_SingleFramePacket() {
+        FastPacketAssembler assembler;
+        std::vector<CanMsg> frames = makeFrames(0x10, 1, 4, 100);
+        N2kMsg msg = headerOf(frames[0]);
+        TS_ASSERT(assembler.addFrame(frames[0], msg, 0));
+        TS_ASSERT(holdsSequence(msg, 4, 100));
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+    }
+
+    void test_InterleavedSources() {
+        FastPacketAssembler assembler;
+        const int sources = 20;
+        std::vector<std::vector<CanMsg>> packets;
+        for (int source = 0; source < sources; source++) {
+            packets.push_back(makeFrames(source, source % 8, 40, source));
+        }
+
+        int completed = 0;
+        for (size_t frame = 0; frame < packets[0].size(); frame++) {
+            for (int source = 0; source < sources; source++) {
+                N2kMsg msg = headerOf(packets[source][frame]);
+                if (assembler.addFrame(packets[source][frame], msg, 0)) {
+                    TS_ASSERT(holdsSequence(msg, 40, source));
+                    completed++;
+                }
+            }
+        }
+        TS_ASSERT_EQUALS(completed, sources);
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+        TS_ASSERT_EQUALS(assembler.stats().maxInProgress, sources);
+    }
+
+    void test_MissingFrames() {
+        FastPacketAssembler assembler;
+        std::vector<CanMsg> frames = makeFrames(0x10, 3, 30, 0);
+        N2kMsg msg = headerOf(frames[0]);
+
+        // Without its first frame
+        TS_ASSERT(not assembler.addFrame(frames[1], msg, 0));
+        TS_ASSERT_EQUALS(assembler.stats().orphaned, 1);
+
+        // A frame skipped drops the packet
+        TS_ASSERT(not assembler.addFrame(frames[0], msg, 0));
+        TS_ASSERT(not assembler.addFrame(frames[2], msg, 0));
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+        TS_ASSERT_EQUALS(assembler.stats().orphaned, 2);
+
+        // Sent again, it goes through
+        bool complete = false;
+        for (const CanMsg& frame : frames) {
+            complete = assembler.addFrame(frame, msg, 0);
+        }
+        TS_ASSERT(complete);
+        TS_ASSERT(holdsSequence(msg, 30, 0));
+    }
+
+    void test_Timeouts() {
+        FastPacketAssembler assembler;
+        std::vector<CanMsg> frames = makeFrames(0x10, 0, 30, 0);
+        N2kMsg msg = headerOf(frames[0]);
+
+        TS_ASSERT(not assembler.addFrame(frames[0], msg, 1000));
+        TS_ASSERT(not assembler.addFrame(frames[1], msg, 1000 + FAST_PACKET_TIMEOUT_MS + 1));
+        TS_ASSERT_EQUALS(assembler.stats().timedOut, 1);
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+
+        for (int source = 0; source < 10; source++) {
+            std::vector<CanMsg> other = makeFrames(source, 0, 30, 0);
+            N2kMsg otherMsg = headerOf(other[0]);
+            assembler.addFrame(other[0], otherMsg, source < 5 ? 0 : 500);
+        }
+        assembler.evictStale(FAST_PACKET_TIMEOUT_MS + 100);
+        TS_ASSERT_EQUALS(assembler.inProgress(), 5);
+        TS_ASSERT_EQUALS(assembler.stats().timedOut, 6);
+    }
+
+    void test_FullTableDropsOldest() {
+        FastPacketAssembler assembler;
+        std::vector<std::vector<CanMsg>> packets;
+        const int sources = FAST_PACKET_SLOTS;
+        for (int source = 0; source < sources; source++) {
+            packets.push_back(makeFrames(source, 0, 30, source));
+            N2kMsg msg = headerOf(packets[source][0]);
+            assembler.addFrame(packets[source][0], msg, source);
+        }
+        TS_ASSERT_LESS_THAN(assembler.inProgress(), FAST_PACKET_SLOTS);
+        TS_ASSERT_EQUALS(assembler.stats().evicted, sources - assembler.inProgress());
+
+        // The latest packets are still complete, every one still in the table can be found
+        int completed = 0;
+        for (int source = 0; source < sources; source++) {
+            N2kMsg msg = headerOf(packets[source][0]);
+            for (size_t frame = 1; frame < packets[source].size(); frame++) {
+                if (assembler.addFrame(packets[source][frame], msg, sources)) {
+                    TS_ASSERT(holdsSequence(msg, 30, source));
+                    completed++;
+                }
+            }
+        }
+        TS_ASSERT_EQUALS(completed, sources - (int)assembler.stats().evicted);
+        TS_ASSERT_EQUALS(assembler.inProgress(), 0);
+    }
+};
@@ -15,7 +15,7 @@
  *
  *	init
  *	start
- *	parseString
+ *	parse
  *	WindSensorThread
  *
  ***************************************************************************************/
@@ -85,7 +85,7 @@ class HardwareCV7Suite : public CxxTest::TestSuite {
         float windSpeed = 0;
         float windTemp = 0;
 
-        TS_ASSERT(cv7->parseString(sensorData, windDir, windSpeed, windTemp));
+        TS_ASSERT(cv7->parse(sensorData.c_str(), sensorData.size(), windDir, windSpeed, windTemp));
 
         TS_ASSERT_EQUALS(windDir, 125.8f);
         TS_ASSERT_EQUALS(windSpeed, 15.8f);
@@ -100,7 +100,7 @@ class HardwareCV7Suite : public CxxTest::TestSuite {
         float windSpeed = 0;
         float windTemp = 0;
 
-        TS_ASSERT(not cv7->parseString(sensorData, windDir, windSpeed, windTemp));
+        TS_ASSERT(not cv7->parse(sensorData.c_str(), sensorData.size(), windDir, windSpeed, windTemp));
     }
 
     void test_CV7Thread() {
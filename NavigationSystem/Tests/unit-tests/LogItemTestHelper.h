@@ -0,0 +1,34 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		LogItemTestHelper.h
+ *
+ * Purpose:
+ *		Makes the log items the database and telemetry log tests write, each one told
+ *		apart by a number.
+ *
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include "../Database/DBHandler.h"
+#include "../Database/TelemetryLog.h"
+
+// 2018-05-04 12:00:00 UTC
+#define LOG_ITEM_TEST_START_MS 1525435200000LL
+
+// The number is the compass heading, the items are 500 ms apart from the start time. The
+// quote in the element name checks that it is escaped.
+inline LogItem makeLogItem(int i) {
+    LogItem item = LogItem();
+    item.m_compassHeading = i;
+    item.m_gpsLat = 60.1234567891;
+    item.m_gpsSatellite = i % 12;
+    item.m_tack = (i % 2 == 0);
+    item.m_windSpeed = 4.5f;
+    item.m_element = SAILDRIVE;
+    item.m_element_str = "sail'drive";
+    item.m_timestamp_str = formatLogTimestamp(LOG_ITEM_TEST_START_MS + i * 500);
+    return item;
+}
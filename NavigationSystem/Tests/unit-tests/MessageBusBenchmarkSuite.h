@@ -0,0 +1,185 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusBenchmarkSuite.h
+ *
+ * Purpose:
+ *		Pushes a large number of messages through a message bus with many nodes to
+ *		make sure every node receives every message meant for it, and compares the
+ *		dispatch throughput to the scan over every registered node the bus did before
+ *		it had routing tables.
+ *
+ * Developer Notes:
+ *		The old scan is replayed here over the same nodes and messages, from a plain
+ *		queue on the test's thread. The messages are queued before either path is
+ *		timed, so the TS_TRACE line compares the dispatch alone. Both paths must
+ *		deliver every message to every node meant to get it, the times are only
+ *		printed.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "../MessageBus/MessageBus.h"
+#include "../MessageBusTestHelper.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define BENCHMARK_NODE_COUNT 30
+#define BENCHMARK_MESSAGE_COUNT 1000000
+#define BENCHMARK_MESSAGE_TYPES 10
+#define BENCHMARK_SUBSCRIPTIONS_PER_NODE 3
+
+// The message types a node subscribes to, a few in a row from its ID on
+inline std::vector<MessageType> subscriptionsOf(NodeID id) {
+    std::vector<MessageType> types;
+    int firstType = static_cast<int>(id) % BENCHMARK_MESSAGE_TYPES;
+    for (int i = 0; i < BENCHMARK_SUBSCRIPTIONS_PER_NODE; i++) {
+        types.push_back(static_cast<MessageType>((firstType + i) % BENCHMARK_MESSAGE_TYPES));
+    }
+    return types;
+}
+
+// Counts the messages it receives
+class CountingNode : public Node {
+   public:
+    CountingNode(NodeID id, MessageBus& msgBus) : Node(id, msgBus), m_Received(0) {
+        msgBus.registerNode(*this);
+        for (MessageType type : subscriptionsOf(id)) {
+            msgBus.registerNode(*this, type);
+        }
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* /*message*/) {
+        m_Received.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<long> m_Received;
+};
+
+class MessageBusBenchmarkSuite : public CxxTest::TestSuite {
+   public:
+    const int WAIT_FOR_MESSAGES_MS = 60000;
+
+    void setUp() { Logger::DisableLogging(); }
+
+    // Every fifth message is sent directly to a node, the others are broadcasted
+    MessagePtr benchmarkMessage(int i) {
+        MessageType type = static_cast<MessageType>(i % BENCHMARK_MESSAGE_TYPES);
+        if (i % 5 == 0) {
+            NodeID dest = static_cast<NodeID>(1 + (i / 5) % BENCHMARK_NODE_COUNT);
+            return std::make_unique<Message>(type, NodeID::None, dest);
+        }
+        return std::make_unique<Message>(type, NodeID::None);
+    }
+
+    // Dispatches like the bus did before, asking every node if it wants the message
+    void scanEveryNode(std::queue<MessagePtr>& messages,
+                       std::vector<std::unique_ptr<CountingNode>>& nodes,
+                       const std::vector<std::vector<MessageType>>& interests) {
+        while (not messages.empty()) {
+            Message* msg = messages.front().get();
+            for (size_t n = 0; n < nodes.size(); n++) {
+                if (msg->destinationID() == NodeID::None) {
+                    if (std::find(interests[n].begin(), interests[n].end(),
+                                  msg->messageType()) != interests[n].end()) {
+                        nodes[n]->processMessage(msg);
+                    }
+                } else if (nodes[n]->nodeID() == msg->destinationID()) {
+                    nodes[n]->processMessage(msg);
+                    continue;
+                }
+            }
+            messages.pop();
+        }
+    }
+
+    void test_MillionMessagesThroughThirtyNodes() {
+        MessageBus messageBus;
+        std::vector<std::unique_ptr<CountingNode>> nodes;
+        std::vector<std::vector<MessageType>> interests;
+
+        // NodeID 0 is None, which is reserved for broadcast messages
+        for (int i = 1; i <= BENCHMARK_NODE_COUNT; i++) {
+            nodes.emplace_back(new CountingNode(static_cast<NodeID>(i), messageBus));
+            interests.push_back(subscriptionsOf(static_cast<NodeID>(i)));
+        }
+
+        // What each node should receive
+        std::vector<long> broadcasts(BENCHMARK_MESSAGE_TYPES, 0);
+        std::vector<long> expected(BENCHMARK_NODE_COUNT, 0);
+        for (int i = 0; i < BENCHMARK_MESSAGE_COUNT; i++) {
+            if (i % 5 == 0) {
+                expected[(i / 5) % BENCHMARK_NODE_COUNT]++;
+            } else {
+                broadcasts[i % BENCHMARK_MESSAGE_TYPES]++;
+            }
+        }
+        long expectedTotal = 0;
+        for (int n = 0; n < BENCHMARK_NODE_COUNT; n++) {
+            for (MessageType type : interests[n]) {
+                expected[n] += broadcasts[static_cast<int>(type)];
+            }
+            expectedTotal += expected[n];
+        }
+
+        // Queued before the bus runs, so only the dispatch is timed
+        for (int i = 0; i < BENCHMARK_MESSAGE_COUNT; i++) {
+            messageBus.sendMessage(benchmarkMessage(i));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        long received = 0;
+        while (received < expectedTotal &&
+               std::chrono::steady_clock::now() - start <
+                   std::chrono::milliseconds(WAIT_FOR_MESSAGES_MS)) {
+            std::this_thread::yield();
+            received = 0;
+            for (auto& node : nodes) {
+                received += node->m_Received.load(std::memory_order_relaxed);
+            }
+        }
+        double busSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        TS_ASSERT_EQUALS(received, expectedTotal);
+        for (int n = 0; n < BENCHMARK_NODE_COUNT; n++) {
+            TS_ASSERT_EQUALS(nodes[n]->m_Received.load(), expected[n]);
+            nodes[n]->m_Received.store(0);
+        }
+
+        // The same messages through the old scan
+        std::queue<MessagePtr> messages;
+        for (int i = 0; i < BENCHMARK_MESSAGE_COUNT; i++) {
+            messages.push(benchmarkMessage(i));
+        }
+        start = std::chrono::steady_clock::now();
+        scanEveryNode(messages, nodes, interests);
+        double scanSeconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (int n = 0; n < BENCHMARK_NODE_COUNT; n++) {
+            TS_ASSERT_EQUALS(nodes[n]->m_Received.load(), expected[n]);
+        }
+
+        char trace[160];
+        snprintf(trace, sizeof(trace),
+                 "%d messages, %ld deliveries: bus %.0f messages/s, scan %.0f messages/s "
+                 "(%.1fx slower)",
+                 BENCHMARK_MESSAGE_COUNT, expectedTotal, BENCHMARK_MESSAGE_COUNT / busSeconds,
+                 BENCHMARK_MESSAGE_COUNT / scanSeconds, scanSeconds / busSeconds);
+        TS_TRACE(trace);
+    }
+};
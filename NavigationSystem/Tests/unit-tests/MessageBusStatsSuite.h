@@ -0,0 +1,154 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusStatsSuite.h
+ *
+ * Purpose:
+ *		Checks the timing statistics collected by the message bus.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	MessageBus::enableStatistics	MessageBusStats::dumpOnSignal
+ *	MessageBus::statisticsReport	MessageBusStats::recordQueueDepth
+ *	LatencyHistogram::record
+ *	LatencyHistogram::percentileUs
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "../MessageBus/MessageBus.h"
+#include "../MessageBus/MessageBusStats.h"
+#include "../MessageBusTestHelper.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+// Takes a known amount of time to process each message
+class SlowNode : public Node {
+   public:
+    SlowNode(MessageBus& msgBus, int processTimeMs)
+        : Node(NodeID::Compass, msgBus), m_ProcessTimeMs(processTimeMs), m_Received(0) {
+        msgBus.registerNode(*this, MessageType::DataRequest);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* /*message*/) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_ProcessTimeMs));
+        m_Received++;
+    }
+
+    int m_ProcessTimeMs;
+    std::atomic<int> m_Received;
+};
+
+class MessageBusStatsSuite : public CxxTest::TestSuite {
+   public:
+    const int MESSAGE_COUNT = 5;
+    const int WAIT_FOR_BUS_MS = 20;
+
+    void setUp() { Logger::DisableLogging(); }
+
+    void test_HistogramPercentiles() {
+        LatencyHistogram histogram;
+        TS_ASSERT_EQUALS(histogram.percentileUs(50), 0);
+
+        for (int i = 0; i < 90; i++) {
+            histogram.record(3);
+        }
+        for (int i = 0; i < 10; i++) {
+            histogram.record(1000);
+        }
+
+        TS_ASSERT_EQUALS(histogram.count(), 100);
+        TS_ASSERT_EQUALS(histogram.maxUs(), 1000);
+        TS_ASSERT_DELTA(histogram.meanUs(), 102.7, 0.01);
+        TS_ASSERT_EQUALS(histogram.percentileUs(50), 4);
+        TS_ASSERT_EQUALS(histogram.percentileUs(99), 1024);
+    }
+
+    void test_HandlerTimesRecorded() {
+        MessageBus messageBus;
+        SlowNode node(messageBus, 2);
+        TS_ASSERT(messageBus.enableStatistics(0));
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        // Messages sent before the bus runs aren't timestamped
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_FOR_BUS_MS));
+        for (int i = 0; i < MESSAGE_COUNT; i++) {
+            messageBus.sendMessage(std::make_unique<Message>(MessageType::DataRequest, NodeID::None));
+        }
+        TS_ASSERT(waitFor(node.m_Received, MESSAGE_COUNT));
+
+        std::string report = messageBus.statisticsReport();
+        TS_ASSERT_DIFFERS(report.find("Handler Compass/DataRequest: count 5"), std::string::npos);
+        TS_ASSERT_DIFFERS(report.find("Latency DataRequest"), std::string::npos);
+    }
+
+    void test_DirectMessagesOfTypesNobodySubscribedTo() {
+        MessageBus messageBus;
+        SlowNode node(messageBus, 0);
+        TS_ASSERT(messageBus.enableStatistics(0));
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_FOR_BUS_MS));
+        messageBus.sendMessage(
+            std::make_unique<Message>(MessageType::CurrentSensorData, NodeID::None, NodeID::Compass));
+        TS_ASSERT(waitFor(node.m_Received, 1));
+
+        std::string report = messageBus.statisticsReport();
+        TS_ASSERT_DIFFERS(report.find("Handler Compass/CurrentSensorData: count 1"), std::string::npos);
+        TS_ASSERT_DIFFERS(report.find("Latency CurrentSensorData"), std::string::npos);
+    }
+
+    void test_BurstDeliveredInBoundedBatches() {
+        MessageBus messageBus;
+        SlowNode node(messageBus, 0);
+        TS_ASSERT(messageBus.enableStatistics(0));
+
+        // Queued before the bus runs, so they would all be in its first batch
+        const int burst = 200;
+        for (int i = 0; i < burst; i++) {
+            messageBus.sendMessage(std::make_unique<Message>(MessageType::DataRequest, NodeID::None));
+        }
+        MessageBusTestHelper messageBusHelper(messageBus);
+        TS_ASSERT(waitFor(node.m_Received, burst));
+
+        std::string report = messageBus.statisticsReport();
+        TS_ASSERT_DIFFERS(report.find("largest batch 64,"), std::string::npos);
+    }
+
+    void test_HandlerTimesRecordedByWorkers() {
+        MessageBus messageBus;
+        SlowNode node(messageBus, 2);
+        TS_ASSERT(messageBus.enableWorkerPool(2));
+        TS_ASSERT(messageBus.enableStatistics(0));
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        for (int i = 0; i < MESSAGE_COUNT; i++) {
+            messageBus.sendMessage(std::make_unique<Message>(MessageType::DataRequest, NodeID::None));
+        }
+        TS_ASSERT(waitFor(node.m_Received, MESSAGE_COUNT));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        std::string report = messageBus.statisticsReport();
+        TS_ASSERT_DIFFERS(report.find("Handler Compass/DataRequest: count 5"), std::string::npos);
+    }
+
+    void test_NoStatisticsWhenDisabled() {
+        MessageBus messageBus;
+        SlowNode node(messageBus, 0);
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        messageBus.sendMessage(std::make_unique<Message>(MessageType::DataRequest, NodeID::None));
+        TS_ASSERT(waitFor(node.m_Received, 1));
+
+        TS_ASSERT_EQUALS(messageBus.statisticsReport().find("Handler"), std::string::npos);
+    }
+};
@@ -12,7 +12,10 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <future>
+#include <thread>
 #include "../MessageBus/MessageBus.h"
 
 // Starts the message bus as an asyncrounous
@@ -33,3 +36,13 @@ class MessageBusTestHelper {
         m_fut.get();
     };
 };
+
+// Waits until the counter reaches the expected value, false if it didn't in time
+inline bool waitFor(std::atomic<int>& counter, int expected, int timeoutMs = 2000) {
+    auto start = std::chrono::steady_clock::now();
+    while (counter.load() < expected &&
+           std::chrono::steady_clock::now() - start < std::chrono::milliseconds(timeoutMs)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return counter.load() >= expected;
+}
@@ -0,0 +1,141 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageBusWorkerPoolSuite.h
+ *
+ * Purpose:
+ *		Tests the delivery of messages through the worker pool of the message bus.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	enableWorkerPool				NodeWorkerPool::start
+ *	setNodePriority					NodeWorkerPool::stop
+ *	NodeWorkerPool::deliver
+ *	NodeWorkerPool::droppedMessages
+ *	NodeMailbox::push
+ *	NodeMailbox::pop
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../MessageBus/MessageBus.h"
+#include "../MessageBus/NodeMailbox.h"
+#include "../MessageBusTestHelper.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+// Records the order of the messages it receives and can be made slow
+class RecordingNode : public Node {
+   public:
+    RecordingNode(NodeID id, MessageBus& msgBus, int processTimeMs = 0)
+        : Node(id, msgBus), m_ProcessTimeMs(processTimeMs), m_Received(0), m_InOrder(true) {
+        msgBus.registerNode(*this, MessageType::DataRequest);
+    }
+
+    bool init() { return true; }
+
+    void processMessage(const Message* message) {
+        if (m_ProcessTimeMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_ProcessTimeMs));
+        }
+
+        // The source is used as a sequence number by the tests
+        if (static_cast<int>(message->sourceID()) != m_Received.load() % 30) {
+            m_InOrder = false;
+        }
+        m_Received++;
+    }
+
+    int m_ProcessTimeMs;
+    std::atomic<int> m_Received;
+    std::atomic<bool> m_InOrder;
+};
+
+class MessageBusWorkerPoolSuite : public CxxTest::TestSuite {
+   public:
+
+    void setUp() { Logger::DisableLogging(); }
+
+    void sendSequence(MessageBus& messageBus, int count) {
+        for (int i = 0; i < count; i++) {
+            messageBus.sendMessage(std::make_unique<Message>(MessageType::DataRequest,
+                                                             static_cast<NodeID>(i % 30)));
+        }
+    }
+
+    void test_MailboxKeepsOrderAndCapacity() {
+        NodeMailbox mailbox(3);
+        TS_ASSERT_EQUALS(mailbox.capacity(), 4);
+
+        for (int i = 0; i < 4; i++) {
+            TS_ASSERT(mailbox.push(std::make_shared<Message>(MessageType::DataRequest,
+                                                             static_cast<NodeID>(i))));
+        }
+        TS_ASSERT(not mailbox.push(std::make_shared<Message>(MessageType::DataRequest)));
+
+        SharedMessagePtr msg;
+        for (int i = 0; i < 4; i++) {
+            TS_ASSERT(mailbox.pop(msg));
+            TS_ASSERT_EQUALS(static_cast<int>(msg->sourceID()), i);
+        }
+        TS_ASSERT(not mailbox.pop(msg));
+        TS_ASSERT(mailbox.empty());
+    }
+
+    void test_MessagesDeliveredInOrder() {
+        MessageBus messageBus;
+        RecordingNode nodeA(NodeID::CourseRegulatorNode, messageBus);
+        RecordingNode nodeB(NodeID::DBLoggerNode, messageBus);
+        TS_ASSERT(messageBus.enableWorkerPool(2));
+
+        MessageBusTestHelper messageBusHelper(messageBus);
+        sendSequence(messageBus, 100);
+
+        TS_ASSERT(waitFor(nodeA.m_Received, 100));
+        TS_ASSERT(waitFor(nodeB.m_Received, 100));
+        TS_ASSERT(nodeA.m_InOrder);
+        TS_ASSERT(nodeB.m_InOrder);
+    }
+
+    void test_SlowNodeDoesNotDelayHighPriorityNode() {
+        MessageBus messageBus;
+        RecordingNode controlNode(NodeID::CourseRegulatorNode, messageBus);
+        RecordingNode loggerNode(NodeID::DBLoggerNode, messageBus, 50);
+        TS_ASSERT(messageBus.setNodePriority(controlNode, NodePriority::High));
+        TS_ASSERT(messageBus.setNodePriority(loggerNode, NodePriority::Low));
+        TS_ASSERT(messageBus.enableWorkerPool(2));
+
+        MessageBusTestHelper messageBusHelper(messageBus);
+        auto start = std::chrono::steady_clock::now();
+        sendSequence(messageBus, 10);
+
+        // Serial delivery would take 10 x 50 ms before the last control message arrives
+        TS_ASSERT(waitFor(controlNode.m_Received, 10));
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        TS_ASSERT_LESS_THAN(elapsed.count(), 200);
+        TS_ASSERT(controlNode.m_InOrder);
+
+        TS_ASSERT(waitFor(loggerNode.m_Received, 10));
+    }
+
+    void test_FullMailboxDropsMessages() {
+        MessageBus messageBus;
+        RecordingNode slowNode(NodeID::DBLoggerNode, messageBus, 100);
+        TS_ASSERT(messageBus.enableWorkerPool(1, 4));
+
+        MessageBusTestHelper messageBusHelper(messageBus);
+        sendSequence(messageBus, 20);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        TS_ASSERT_LESS_THAN(slowNode.m_Received.load(), 20);
+        TS_ASSERT(messageBus.droppedMessages(slowNode) > 0);
+    }
+};
@@ -15,12 +15,9 @@
  *
  *	sendMessage						registerNode
  *	run 							getRegisteredNode
+ *	stop
  *									processMessages
- *									startMessageLog
- *									logMessageReceived
- *									logMessage
- *									logMessageConsumer
- *									messageTimeStamp
+ *									buildRoutingTables
  *
  ***************************************************************************************/
 
@@ -36,7 +33,7 @@
 // For std::this_thread
 #include <chrono>
 
-#define MESSAGE_CORE_TESTCOUNT 6
+#define MESSAGE_CORE_TESTCOUNT 7
 
 class MessageCoreSuite : public CxxTest::TestSuite {
    public:
@@ -159,4 +156,34 @@ class MessageCoreSuite : public CxxTest::TestSuite {
         TS_ASSERT_EQUALS(node->m_WindSpeed, 90);
         TS_ASSERT_EQUALS(node->m_WindTemp, 60);
     }
+
+    void test_MessageDeliveredWithoutPollingDelay() {
+        // The bus used to sleep this long between looks at its queue, a message sent just
+        // after one was delivered waited for the whole period
+        const int OLD_POLL_PERIOD_MS = 50;
+        const int ROUNDS = 10;
+
+        // Each message is sent as soon as the previous one arrived, when the bus has just
+        // gone back to waiting. Only waking on send keeps them well under the old period.
+        std::chrono::steady_clock::duration total(0);
+        int delivered = 0;
+        for (int i = 0; i < ROUNDS; i++) {
+            node->m_MessageReceived = false;
+            auto start = std::chrono::steady_clock::now();
+            messageBus.sendMessage(std::make_unique<WindDataMsg>(0, 0, 0));
+
+            while (not node->m_MessageReceived &&
+                   std::chrono::steady_clock::now() - start <
+                       std::chrono::milliseconds(WAIT_FOR_MESSAGE)) {
+                std::this_thread::yield();
+            }
+            total += std::chrono::steady_clock::now() - start;
+            delivered += node->m_MessageReceived;
+        }
+        node->m_MessageReceived = false;
+
+        TS_ASSERT_EQUALS(delivered, ROUNDS);
+        TS_ASSERT_LESS_THAN(std::chrono::duration_cast<std::chrono::milliseconds>(total).count(),
+                            ROUNDS * OLD_POLL_PERIOD_MS / 2);
+    }
 };
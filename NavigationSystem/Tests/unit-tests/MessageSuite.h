@@ -32,6 +32,7 @@
 #include "../Messages/VesselStateMsg.h"
 #include "../Messages/WaypointDataMsg.h"
 #include "../Messages/WindDataMsg.h"
+#include "../MessageBus/MessageBus.h"
 #include "../cxxtest/cxxtest/TestSuite.h"
 
 class MessageSuite : public CxxTest::TestSuite {
@@ -386,4 +387,38 @@ class MessageSuite : public CxxTest::TestSuite {
         TS_ASSERT_EQUALS(msgTwo.COG(2), 80);
         TS_ASSERT_EQUALS(msgTwo.SOG(2), 7);
     }
+
+    void test_PooledMessageReusesMemory() {
+        // Make sure there is at least one block on the free list
+        MessagePtr first = std::make_unique<WindDataMsg>(0, 0, 0);
+        Message* firstAddress = first.get();
+        first.reset();
+
+        MessagePoolStats before = MessagePool<WindDataMsg>::stats();
+        MessagePtr second = std::make_unique<WindDataMsg>(10, 20, 30);
+        MessagePoolStats after = MessagePool<WindDataMsg>::stats();
+
+        TS_ASSERT_EQUALS(second.get(), firstAddress);
+        TS_ASSERT_EQUALS(after.hits, before.hits + 1);
+        TS_ASSERT_EQUALS(after.misses, before.misses);
+        TS_ASSERT_EQUALS(static_cast<WindDataMsg*>(second.get())->windSpeed(), 20);
+    }
+
+    void test_PooledMessageReserve() {
+        MessagePool<CompassDataMsg>::reserve(4);
+        MessagePoolStats before = MessagePool<CompassDataMsg>::stats();
+        TS_ASSERT(before.freeBlocks >= 4);
+
+        std::vector<MessagePtr> msgs;
+        for (int i = 0; i < 4; i++) {
+            msgs.push_back(std::make_unique<CompassDataMsg>(i, 0, 0));
+        }
+        MessagePoolStats after = MessagePool<CompassDataMsg>::stats();
+
+        TS_ASSERT_EQUALS(after.misses, before.misses);
+        TS_ASSERT_EQUALS(after.hits, before.hits + 4);
+
+        msgs.clear();
+        TS_ASSERT_EQUALS(MessagePool<CompassDataMsg>::stats().freeBlocks, before.freeBlocks);
+    }
 };
@@ -0,0 +1,139 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		MessageTracerSuite.h
+ *
+ * Purpose:
+ *		Checks that the message tracer records the messages going through the message
+ *		bus in the binary trace file format.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	MessageBus::startTracing		MessageTracer::droppedRecords
+ *	MessageBus::stopTracing
+ *	MessageTracer::trace
+ *	MessageTracer::start
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../MessageBus/MessageBus.h"
+#include "../MessageBus/MessageTracer.h"
+#include "../MessageBusTestHelper.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "TestMocks/MockNode.h"
+
+#define TRACE_FILE "./MessageTracerSuite.trace"
+
+class MessageTracerSuite : public CxxTest::TestSuite {
+   public:
+    const int WAIT_FOR_MESSAGE = 100;
+
+    void setUp() { Logger::DisableLogging(); }
+
+    void tearDown() { remove(TRACE_FILE); }
+
+    bool readTrace(MessageTraceHeader& header, std::vector<MessageTraceRecord>& records) {
+        FILE* file = fopen(TRACE_FILE, "rb");
+        if (file == NULL) {
+            return false;
+        }
+
+        bool ok = fread(&header, sizeof(header), 1, file) == 1;
+        MessageTraceRecord record;
+        while (ok && fread(&record, sizeof(record), 1, file) == 1) {
+            records.push_back(record);
+        }
+        fclose(file);
+        return ok;
+    }
+
+    void test_TraceRecordsDeliveries() {
+        MessageBus messageBus;
+        bool registered = false;
+        MockNode node(messageBus, registered);
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        TS_ASSERT(messageBus.startTracing(TRACE_FILE));
+
+        // One delivered message and one nobody is interested in
+        messageBus.sendMessage(
+            std::make_unique<WindDataMsg>(NodeID::None, NodeID::WindSensor, 0, 0, 0));
+        messageBus.sendMessage(
+            std::make_unique<Message>(MessageType::DataRequest, NodeID::Compass));
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_FOR_MESSAGE));
+        messageBus.stopTracing();
+
+        MessageTraceHeader header;
+        std::vector<MessageTraceRecord> records;
+        TS_ASSERT(readTrace(header, records));
+        TS_ASSERT_EQUALS(strncmp(header.magic, MESSAGE_TRACE_MAGIC, sizeof(header.magic)), 0);
+        TS_ASSERT_EQUALS(header.recordSize, sizeof(MessageTraceRecord));
+        TS_ASSERT_EQUALS(records.size(), 2);
+
+        if (records.size() == 2) {
+            TS_ASSERT_EQUALS(records[0].messageType, (uint16_t)MessageType::WindData);
+            TS_ASSERT_EQUALS(records[0].sourceID, (uint8_t)NodeID::WindSensor);
+            TS_ASSERT_EQUALS(records[0].consumerID, (uint8_t)NodeID::MessageLogger);
+            TS_ASSERT(records[0].enqueueTime <= records[0].dequeueTime);
+            TS_ASSERT(records[0].dequeueTime <= records[0].deliverTime);
+
+            TS_ASSERT_EQUALS(records[1].messageType, (uint16_t)MessageType::DataRequest);
+            TS_ASSERT_EQUALS(records[1].consumerID, (uint8_t)NodeID::None);
+            TS_ASSERT_EQUALS(records[1].deliverTime, 0);
+        }
+    }
+
+    void test_NothingRecordedWhenDisabled() {
+        MessageBus messageBus;
+        bool registered = false;
+        MockNode node(messageBus, registered);
+        MessageBusTestHelper messageBusHelper(messageBus);
+
+        TS_ASSERT(messageBus.startTracing(TRACE_FILE));
+        messageBus.stopTracing();
+
+        messageBus.sendMessage(
+            std::make_unique<WindDataMsg>(NodeID::None, NodeID::WindSensor, 0, 0, 0));
+        std::this_thread::sleep_for(std::chrono::milliseconds(WAIT_FOR_MESSAGE));
+
+        MessageTraceHeader header;
+        std::vector<MessageTraceRecord> records;
+        TS_ASSERT(readTrace(header, records));
+        TS_ASSERT_EQUALS(records.size(), 0);
+    }
+
+    void test_RecordFromPreviousTraceLeftOut() {
+        MessageTracer tracer;
+        Message msg(MessageType::DataRequest, NodeID::Compass);
+
+        TS_ASSERT(tracer.start(TRACE_FILE));
+        uint64_t beforeStop = MessageTracer::now();
+        tracer.stop();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        TS_ASSERT(tracer.start(TRACE_FILE));
+
+        // The bus thread was still delivering a message of the previous trace
+        tracer.trace(&msg, beforeStop, beforeStop, NodeID::Compass);
+        uint64_t dequeueTime = MessageTracer::now();
+        tracer.trace(&msg, dequeueTime, 0, NodeID::None);
+        tracer.stop();
+
+        MessageTraceHeader header;
+        std::vector<MessageTraceRecord> records;
+        TS_ASSERT(readTrace(header, records));
+        TS_ASSERT_EQUALS(records.size(), 1);
+        if (records.size() == 1) {
+            TS_ASSERT_EQUALS(records[0].dequeueTime, dequeueTime);
+        }
+    }
+};
@@ -0,0 +1,250 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		NMEAParserSuite.h
+ *
+ * Purpose:
+ *		Checks that the NMEA parser picks the sentences with a valid checksum out of the
+ *		serial data, however it is cut, and measures its throughput over CV7 sentences.
+ *
+ * Developer Notes:
+ *		test_Benchmark parses BENCHMARK_SENTENCE_PAIRS recorded CV7 wind and temperature
+ *		sentence pairs in 255 byte reads, then times the regular expressions the CV7 node
+ *		used before over the same reads. It only asserts that every wind reading came
+ *		through, the TS_TRACE line gives both times and the parser's MB/s.
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	NMEAParser::writable
+ *	NMEAParser::commit
+ *	NMEAParser::write
+ *	NMEAParser::next
+ *	NMEASentence::is
+ *	NMEASentence::field
+ *	NMEASentence::toFloat
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <regex>
+#include <string>
+#include "../Hardwares/NMEAParser.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define BENCHMARK_SENTENCE_PAIRS 20000
+
+// What the CV7 sends, see CV7Node
+#define CV7_DATA "$IIMWV,125.8,R,015.8,N,A*3F\r\n$WIXDR,C,036.5,C,,*52\r\n"
+
+class NMEAParserSuite : public CxxTest::TestSuite {
+   public:
+    // Adds the $, the checksum and CR LF to a sentence body
+    static std::string sentence(const char* body) {
+        unsigned char checksum = 0;
+        for (const char* c = body; *c != '\0'; c++) {
+            checksum ^= (unsigned char)*c;
+        }
+        char end[8];
+        snprintf(end, sizeof(end), "*%02X\r\n", checksum);
+        return std::string("$") + body + end;
+    }
+
+    // Sentences like the CV7 records them, the wind and temperature changing a little
+    static std::string recordedSentences(int pairs) {
+        std::string data;
+        char body[64];
+        for (int i = 0; i < pairs; i++) {
+            snprintf(body, sizeof(body), "IIMWV,%05.1f,R,%05.1f,N,A", (i * 7) % 3600 / 10.0,
+                     (i * 3) % 250 / 10.0);
+            data += sentence(body);
+            snprintf(body, sizeof(body), "WIXDR,C,%05.1f,C,,", 10 + (i % 100) / 10.0);
+            data += sentence(body);
+        }
+        return data;
+    }
+
+    void test_CV7Sentences() {
+        NMEAParser parser;
+        NMEASentence sentence;
+        TS_ASSERT_EQUALS(parser.write(CV7_DATA, strlen(CV7_DATA)), strlen(CV7_DATA));
+
+        TS_ASSERT(parser.next(sentence));
+        TS_ASSERT(sentence.is("IIMWV"));
+        TS_ASSERT_EQUALS(sentence.fieldCount(), 5);
+        TS_ASSERT_EQUALS(std::string(sentence.field(2)), "R");
+        TS_ASSERT_EQUALS(std::string(sentence.field(5)), "A");
+        float value = 0;
+        TS_ASSERT(sentence.toFloat(1, value));
+        TS_ASSERT_EQUALS(value, 125.8f);
+        TS_ASSERT(sentence.toFloat(3, value));
+        TS_ASSERT_EQUALS(value, 15.8f);
+
+        TS_ASSERT(parser.next(sentence));
+        TS_ASSERT(sentence.is("WIXDR"));
+        TS_ASSERT_EQUALS(sentence.fieldCount(), 5);
+        TS_ASSERT(sentence.toFloat(2, value));
+        TS_ASSERT_EQUALS(value, 36.5f);
+
+        // The empty fields and the ones past the end aren't numbers
+        TS_ASSERT(not sentence.toFloat(4, value));
+        TS_ASSERT(not sentence.toFloat(1, value));
+        TS_ASSERT_EQUALS(std::string(sentence.field(9)), "");
+
+        TS_ASSERT(not parser.next(sentence));
+        TS_ASSERT_EQUALS(parser.stats().sentences, 2);
+        TS_ASSERT_EQUALS(parser.stats().checksumErrors, 0);
+        TS_ASSERT_EQUALS(parser.stats().dropped, 0);
+    }
+
+    void test_WrongOrMissingChecksum() {
+        NMEAParser parser;
+        NMEASentence sentence;
+        const char* data =
+            "$IIMWV,125.8,R,015.8,N,A*3E\r\n"  // One off
+            "$IIMWV,125.8,R,015.8,N,A\r\n"     // None
+            "$IIMWV,125.8,R,015.8,N,A*G1\r\n"  // Not hex
+            "$WIXDR,C,036.5,C,,*52\r\n";
+        parser.write(data, strlen(data));
+
+        TS_ASSERT(parser.next(sentence));
+        TS_ASSERT(sentence.is("WIXDR"));
+        TS_ASSERT(not parser.next(sentence));
+        TS_ASSERT_EQUALS(parser.stats().sentences, 1);
+        TS_ASSERT_EQUALS(parser.stats().checksumErrors, 3);
+    }
+
+    void test_SentenceAcrossWrites() {
+        NMEAParser parser;
+        NMEASentence sentence;
+        std::string data = CV7_DATA;
+        int sentences = 0;
+
+        // A byte at a time, as a slow serial line may hand them over
+        for (char c : data) {
+            parser.write(&c, 1);
+            while (parser.next(sentence)) {
+                sentences++;
+            }
+        }
+        TS_ASSERT_EQUALS(sentences, 2);
+        TS_ASSERT(sentence.is("WIXDR"));
+    }
+
+    void test_NoiseAndCutSentences() {
+        NMEAParser parser;
+        NMEASentence sentence;
+        std::string data = "\x01\xff garbage ";
+        data += "$IIMWV,125.8,R,01";  // Cut by the next one
+        data += CV7_DATA;
+        data += "$" + std::string(100, 'A') + "*00\r\n";  // Too long
+        data += CV7_DATA;
+        parser.write(data.c_str(), data.size());
+
+        int sentences = 0;
+        while (parser.next(sentence)) {
+            sentences++;
+        }
+        TS_ASSERT_EQUALS(sentences, 4);
+        TS_ASSERT_EQUALS(parser.stats().dropped, 2);
+    }
+
+    void test_RingBufferWraps() {
+        NMEAParser parser;
+        NMEASentence sentence;
+        std::string data = recordedSentences(100);
+        size_t offset = 0;
+        int sentences = 0;
+
+        // Full until it is parsed
+        TS_ASSERT_EQUALS(parser.write(data.c_str(), data.size()), NMEA_BUFFER_SIZE);
+        while (parser.next(sentence)) {
+            sentences++;
+        }
+        offset += NMEA_BUFFER_SIZE;
+
+        // Reads of up to 100 bytes, like the serial ones. Near the end of the ring, writable()
+        // leaves less room and a read is shorter, but the sentence it splits is still found
+        while (offset < data.size()) {
+            char* at;
+            size_t space = parser.writable(at);
+            TS_ASSERT_LESS_THAN(0, space);
+            space = std::min(space, std::min((size_t)100, data.size() - offset));
+            memcpy(at, data.c_str() + offset, space);
+            parser.commit(space);
+            offset += space;
+
+            while (parser.next(sentence)) {
+                sentences++;
+            }
+        }
+        TS_ASSERT_LESS_THAN(NMEA_BUFFER_SIZE * 4, data.size());
+        TS_ASSERT_EQUALS(sentences, 200);
+        TS_ASSERT_EQUALS(parser.stats().checksumErrors, 0);
+    }
+
+    void test_Benchmark() {
+        std::string data = recordedSentences(BENCHMARK_SENTENCE_PAIRS);
+
+        auto start = std::chrono::steady_clock::now();
+        NMEAParser parser;
+        NMEASentence sentence;
+        float windDir = 0, windSpeed = 0, windTemp = 0;
+        int readings = 0;
+        const size_t READ_SIZE = 255;
+        for (size_t offset = 0; offset < data.size(); offset += READ_SIZE) {
+            size_t length = std::min(READ_SIZE, data.size() - offset);
+            parser.write(data.c_str() + offset, length);
+            while (parser.next(sentence)) {
+                if (sentence.is("IIMWV") && sentence.toFloat(1, windDir) &&
+                    sentence.toFloat(3, windSpeed)) {
+                    readings++;
+                } else if (sentence.is("WIXDR")) {
+                    sentence.toFloat(2, windTemp);
+                }
+            }
+        }
+        double parserUs = std::chrono::duration<double, std::micro>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+        TS_ASSERT_EQUALS(readings, BENCHMARK_SENTENCE_PAIRS);
+        TS_ASSERT_EQUALS(parser.stats().sentences, 2 * BENCHMARK_SENTENCE_PAIRS);
+
+        // The regular expressions over a growing string, as the CV7 node parsed them
+        start = std::chrono::steady_clock::now();
+        std::regex iimwv("\\$IIMWV,([^,]{0,6}),.,([^,]{0,6}),.,[^\\$]{0,4}\\n?");
+        std::regex wixdr("\\$WIXDR,.,([^,]{0,6}),.,.?,[^\\$]{0,4}");
+        std::string buffer;
+        int regexReadings = 0;
+        for (size_t offset = 0; offset < data.size(); offset += READ_SIZE) {
+            buffer.append(data, offset, READ_SIZE);
+            buffer.erase(0, buffer.find_first_of("$"));
+            std::smatch sm;
+            while (std::regex_search(buffer, sm, iimwv) || std::regex_search(buffer, sm, wixdr)) {
+                if (sm.size() == 3) {
+                    windDir = std::stof(sm[1].str());
+                    windSpeed = std::stof(sm[2].str());
+                    regexReadings++;
+                } else {
+                    windTemp = std::stof(sm[1].str());
+                }
+                buffer.erase(0, sm.position(0) + sm.length(0));
+            }
+        }
+        double regexUs = std::chrono::duration<double, std::micro>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+        TS_ASSERT_LESS_THAN(0, regexReadings);
+
+        char trace[160];
+        snprintf(trace, sizeof(trace),
+                 "%d sentences: parser %.0f us (%.2f MB/s), regex %.0f us (%.1fx slower)",
+                 2 * BENCHMARK_SENTENCE_PAIRS, parserUs, data.size() / parserUs, regexUs,
+                 regexUs / parserUs);
+        TS_TRACE(trace);
+    }
+};
@@ -0,0 +1,200 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		SimulatedClockSuite.h
+ *
+ * Purpose:
+ *		Checks that the timers and the system clock follow the simulated clock, that a
+ *		node loop runs once per tick when stepped in lockstep, and that the threads due
+ *		in the same tick run one after the other in the order they took part in.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	SimulatedClock::enable
+ *	SimulatedClock::disable
+ *	SimulatedClock::now
+ *	SimulatedClock::sleepFor
+ *	SimulatedClock::advance
+ *	SimulatedClock::waitUntilIdle
+ *	SimulatedClock::participants
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "../SystemServices/SimulatedClock.h"
+#include "../SystemServices/SysClock.h"
+#include "../SystemServices/Timer.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define SIM_START_TIME 1500000000
+#define SIM_LOOP_TIME 0.1
+
+class SimulatedClockSuite : public CxxTest::TestSuite {
+   public:
+    std::atomic<bool> m_Running;
+    std::atomic<int> m_Loops;
+
+    void setUp() {
+        m_Running = true;
+        m_Loops = 0;
+    }
+
+    void tearDown() { SimulatedClock::disable(); }
+
+    // Like a node thread, runs once per loop time
+    void nodeLoop() {
+        Timer timer;
+        timer.start();
+        while (m_Running) {
+            m_Loops++;
+            timer.sleepUntil(SIM_LOOP_TIME);
+            timer.reset();
+        }
+    }
+
+    void test_DisabledIsTheSteadyClock() {
+        auto before = std::chrono::steady_clock::now();
+        auto now = SimulatedClock::now();
+        TS_ASSERT(before <= now);
+        TS_ASSERT(now <= std::chrono::steady_clock::now());
+
+        Timer timer;
+        timer.start();
+        timer.sleepUntil(0.02);
+        TS_ASSERT_LESS_THAN_EQUALS(0.02, timer.timePassed());
+    }
+
+    void test_TimeOnlyMovesWithTheSimulation() {
+        SimulatedClock::enable(SIM_START_TIME);
+        Timer timer;
+        timer.start();
+        TS_ASSERT_EQUALS(SysClock::unixTime(), SIM_START_TIME);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        TS_ASSERT_EQUALS(timer.timePassed(), 0);
+
+        SimulatedClock::advance(std::chrono::milliseconds(2500));
+        TS_ASSERT_DELTA(timer.timePassed(), 2.5, 1e-9);
+        TS_ASSERT_EQUALS(SysClock::unixTime(), SIM_START_TIME + 2);
+        TS_ASSERT_EQUALS(SysClock::millis(), 500);
+        TS_ASSERT(timer.timeReached(2.4));
+    }
+
+    void test_LockstepRunsALoopPerTick() {
+        SimulatedClock::enable(SIM_START_TIME);
+        std::thread first(&SimulatedClockSuite::nodeLoop, this);
+        std::thread second(&SimulatedClockSuite::nodeLoop, this);
+
+        auto idle = []() { return true; };
+        auto timeout = std::chrono::milliseconds(1000);
+        while (SimulatedClock::participants() < 2) {
+            std::this_thread::yield();
+        }
+        TS_ASSERT(SimulatedClock::waitUntilIdle(idle, timeout));
+        TS_ASSERT_EQUALS(m_Loops.load(), 2);
+
+        // A simulated minute in much less than a real one
+        auto start = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < 600; tick++) {
+            SimulatedClock::advance(std::chrono::milliseconds(100));
+            TS_ASSERT(SimulatedClock::waitUntilIdle(idle, timeout));
+            TS_ASSERT_EQUALS(m_Loops.load(), 2 * (tick + 2));
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        TS_ASSERT_LESS_THAN(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+                            6000);
+
+        m_Running = false;
+        SimulatedClock::disable();
+        first.join();
+        second.join();
+    }
+
+    // Records when every loop starts and ends
+    void orderedLoop(int id, std::vector<int>* order, std::mutex* orderMutex) {
+        Timer timer;
+        timer.start();
+        while (m_Running) {
+            orderMutex->lock();
+            order->push_back(id);
+            orderMutex->unlock();
+
+            // The others would run meanwhile if they were woken together
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+            orderMutex->lock();
+            order->push_back(id);
+            orderMutex->unlock();
+            timer.sleepUntil(SIM_LOOP_TIME);
+            timer.reset();
+        }
+    }
+
+    void test_ThreadsDueRunOneAtATime() {
+        SimulatedClock::enable(SIM_START_TIME);
+        std::vector<int> order;
+        std::mutex orderMutex;
+        std::vector<std::thread> threads;
+        for (int id = 0; id < 3; id++) {
+            threads.push_back(
+                std::thread(&SimulatedClockSuite::orderedLoop, this, id, &order, &orderMutex));
+            while (SimulatedClock::participants() < (unsigned int)id + 1) {
+                std::this_thread::yield();
+            }
+        }
+
+        auto idle = []() { return true; };
+        auto timeout = std::chrono::milliseconds(1000);
+        TS_ASSERT(SimulatedClock::waitUntilIdle(idle, timeout));
+        for (int tick = 0; tick < 5; tick++) {
+            SimulatedClock::advance(std::chrono::milliseconds(100));
+            TS_ASSERT(SimulatedClock::waitUntilIdle(idle, timeout));
+        }
+
+        // Every loop ends before the next starts, in the order they took part in
+        TS_ASSERT_EQUALS(order.size(), 2 * 3 * 6);
+        for (size_t i = 0; i < order.size(); i++) {
+            TS_ASSERT_EQUALS(order[i], (int)(i / 2 % 3));
+        }
+
+        m_Running = false;
+        SimulatedClock::disable();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void test_WaitsForTheOthers() {
+        SimulatedClock::enable(SIM_START_TIME);
+        std::thread node(&SimulatedClockSuite::nodeLoop, this);
+        while (SimulatedClock::participants() < 1) {
+            std::this_thread::yield();
+        }
+
+        auto timeout = std::chrono::milliseconds(20);
+        TS_ASSERT(not SimulatedClock::waitUntilIdle([]() { return false; }, timeout));
+
+        // Woken up but didn't go back to sleep yet counts as busy
+        std::atomic<int> calls(0);
+        auto countCalls = [&]() {
+            calls++;
+            return true;
+        };
+        SimulatedClock::advance(std::chrono::milliseconds(100));
+        TS_ASSERT(SimulatedClock::waitUntilIdle(countCalls, std::chrono::milliseconds(1000)));
+        TS_ASSERT_EQUALS(m_Loops.load(), 2);
+        TS_ASSERT_LESS_THAN_EQUALS(1, calls.load());
+
+        m_Running = false;
+        SimulatedClock::disable();
+        node.join();
+    }
+};
@@ -0,0 +1,156 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		TCPServerSuite.h
+ *
+ * Purpose:
+ *		Checks that the TCP server puts packets back together however their bytes
+ *		arrive, times out when nothing does, and drops clients sending invalid packets.
+ *
+ * Developer Notes:
+ *		The server listens on TCP_TEST_PORT of the loopback interface.
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	TCPServer::start				TCPServer::broadcast
+ *	TCPServer::acceptConnection		TCPServer::sendData
+ *	TCPServer::readPacket			TCPServer::clearSocketBuffer
+ *	TCPServer::shutdown				TCPServer::acceptConnections
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../Network/TCPServer.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define TCP_TEST_PORT 19321
+
+class TCPServerSuite : public CxxTest::TestSuite {
+   public:
+    TCPServer* server;
+
+    void setUp() {
+        Logger::DisableLogging();
+        server = new TCPServer();
+        TS_ASSERT_EQUALS(server->start(TCP_TEST_PORT), 1);
+    }
+
+    void tearDown() {
+        server->shutdown();
+        delete server;
+    }
+
+    int connectClient() {
+        int clientFD = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in serverAddr;
+        memset(&serverAddr, 0, sizeof(serverAddr));
+        serverAddr.sin_family = AF_INET;
+        serverAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        serverAddr.sin_port = htons(TCP_TEST_PORT);
+        TS_ASSERT_EQUALS(connect(clientFD, (sockaddr*)&serverAddr, sizeof(serverAddr)), 0);
+        return clientFD;
+    }
+
+    // Packets of length i, filled with i
+    std::vector<uint8_t> makePackets(int first, int count) {
+        std::vector<uint8_t> bytes;
+        for (uint16_t length = first; length < first + count; length++) {
+            uint8_t prefix[2];
+            memcpy(prefix, &length, 2);
+            bytes.insert(bytes.end(), prefix, prefix + 2);
+            bytes.insert(bytes.end(), length, (uint8_t)length);
+        }
+        return bytes;
+    }
+
+    void checkPackets(int first, int count) {
+        TCPPacket_t packet;
+        for (int length = first; length < first + count; length++) {
+            TS_ASSERT_EQUALS(server->readPacket(packet, 2), 1);
+            TS_ASSERT_EQUALS(packet.length, length);
+            bool filled = true;
+            for (int i = 0; i < packet.length; i++) {
+                filled = filled && packet.data[i] == (uint8_t)length;
+            }
+            TS_ASSERT(filled);
+        }
+    }
+
+    void test_PacketsSplitAcrossReads() {
+        int clientFD = connectClient();
+        TS_ASSERT_EQUALS(server->acceptConnection(2), 1);
+
+        // A byte at a time, on another thread so the server waits for each one
+        std::vector<uint8_t> bytes = makePackets(1, 20);
+        std::thread sender([&] {
+            for (uint8_t byte : bytes) {
+                TS_ASSERT_EQUALS(write(clientFD, &byte, 1), 1);
+                if (byte % 7 == 0) {
+                    std::this_thread::sleep_for(std::chrono::microseconds(200));
+                }
+            }
+        });
+        checkPackets(1, 20);
+        sender.join();
+        close(clientFD);
+    }
+
+    void test_ManyPacketsInOneRead() {
+        int clientFD = connectClient();
+        TS_ASSERT_EQUALS(server->acceptConnection(2), 1);
+
+        // More than the receive buffer holds, with packets up to the largest
+        std::vector<uint8_t> bytes = makePackets(400, 113);
+        TS_ASSERT_EQUALS(write(clientFD, bytes.data(), bytes.size()), (ssize_t)bytes.size());
+        checkPackets(400, 113);
+        close(clientFD);
+    }
+
+    void test_TimesOut() {
+        int clientFD = connectClient();
+        TCPPacket_t packet;
+
+        auto start = std::chrono::steady_clock::now();
+        TS_ASSERT_EQUALS(server->readPacket(packet, 1), 0);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        TS_ASSERT_LESS_THAN_EQUALS(std::chrono::milliseconds(900).count(),
+                                   std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count());
+        TS_ASSERT_LESS_THAN(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(), 2000);
+
+        // The client was accepted while waiting
+        std::vector<uint8_t> bytes = makePackets(3, 1);
+        TS_ASSERT_EQUALS(write(clientFD, bytes.data(), bytes.size()), (ssize_t)bytes.size());
+        checkPackets(3, 1);
+        close(clientFD);
+    }
+
+    void test_InvalidPacketDisconnects() {
+        int badFD = connectClient();
+        int goodFD = connectClient();
+
+        uint16_t tooLong = TCP_MAX_PACKET_LENGTH + 1;
+        TS_ASSERT_EQUALS(write(badFD, &tooLong, 2), 2);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::vector<uint8_t> bytes = makePackets(5, 2);
+        TS_ASSERT_EQUALS(write(goodFD, bytes.data(), bytes.size()), (ssize_t)bytes.size());
+
+        checkPackets(5, 2);
+
+        // The server closed the connection
+        TCPPacket_t packet;
+        server->readPacket(packet, 1);
+        uint8_t byte;
+        TS_ASSERT_EQUALS(read(badFD, &byte, 1), 0);
+        close(badFD);
+        close(goodFD);
+    }
+};
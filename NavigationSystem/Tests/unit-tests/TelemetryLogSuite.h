@@ -0,0 +1,183 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		TelemetryLogSuite.h
+ *
+ * Purpose:
+ *		Checks that the rows written to a binary telemetry log are read back unchanged.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	TelemetryLog::open				TelemetryLog::flush
+ *	TelemetryLog::writeLogs
+ *	TelemetryLog::close
+ *	TelemetryLog::reserve
+ *	TelemetryLogReader::next
+ *	TelemetryLogReader::seek
+ *	parseLogTimestamp
+ *	formatLogTimestamp
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <signal.h>
+#include <stdio.h>
+#include <sys/resource.h>
+#include <string>
+#include <vector>
+#include "../Database/TelemetryLog.h"
+#include "../SystemServices/Logger.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+#include "LogItemTestHelper.h"
+
+#define TELEMETRY_TEST_LOG "./TelemetryLogSuite.log"
+
+class TelemetryLogSuite : public CxxTest::TestSuite {
+   public:
+    void setUp() {
+        Logger::DisableLogging();
+        remove(TELEMETRY_TEST_LOG);
+    }
+
+    void tearDown() { remove(TELEMETRY_TEST_LOG); }
+
+    void writeRows(TelemetryLog& log, int from, int to) {
+        std::vector<LogItem> logs;
+        for (int i = from; i < to; i++) {
+            logs.push_back(makeLogItem(i));
+        }
+        log.writeLogs(logs);
+    }
+
+    void test_Timestamps() {
+        TS_ASSERT_EQUALS(parseLogTimestamp("2018-05-04 12:00:00.5"), LOG_ITEM_TEST_START_MS + 5);
+        TS_ASSERT_EQUALS(parseLogTimestamp("2018-05-04 12:00:01"), LOG_ITEM_TEST_START_MS + 1000);
+        TS_ASSERT_EQUALS(parseLogTimestamp("initialized"), 0);
+        TS_ASSERT_EQUALS(formatLogTimestamp(LOG_ITEM_TEST_START_MS + 250), "2018-05-04 12:00:00.250");
+    }
+
+    void test_RowsReadBack() {
+        TelemetryLog log;
+        TS_ASSERT(log.open(TELEMETRY_TEST_LOG));
+        // Spans several blocks
+        writeRows(log, 0, TELEMETRY_BLOCK_ROWS * 2 + 10);
+        log.close();
+
+        TelemetryLogReader reader;
+        TS_ASSERT(reader.open(TELEMETRY_TEST_LOG));
+
+        LogItem item;
+        int count = 0;
+        while (reader.next(item)) {
+            LogItem expected = makeLogItem(count);
+            TS_ASSERT_EQUALS(item.m_compassHeading, expected.m_compassHeading);
+            TS_ASSERT_EQUALS(item.m_gpsLat, expected.m_gpsLat);
+            TS_ASSERT_EQUALS(item.m_gpsSatellite, expected.m_gpsSatellite);
+            TS_ASSERT_EQUALS(item.m_tack, expected.m_tack);
+            TS_ASSERT_EQUALS(item.m_windSpeed, expected.m_windSpeed);
+            TS_ASSERT_EQUALS(item.m_element, SAILDRIVE);
+            TS_ASSERT_EQUALS(item.m_element_str, expected.m_element_str);
+            TS_ASSERT_EQUALS(item.m_timestamp_str, expected.m_timestamp_str);
+            count++;
+        }
+        TS_ASSERT_EQUALS(count, TELEMETRY_BLOCK_ROWS * 2 + 10);
+    }
+
+    void test_ReopenAppends() {
+        TelemetryLog log;
+        TS_ASSERT(log.open(TELEMETRY_TEST_LOG));
+        writeRows(log, 0, 10);
+        log.close();
+
+        TS_ASSERT(log.open(TELEMETRY_TEST_LOG));
+        writeRows(log, 10, 20);
+        log.close();
+
+        TelemetryLogReader reader;
+        TS_ASSERT(reader.open(TELEMETRY_TEST_LOG));
+        LogItem item;
+        int count = 0;
+        while (reader.next(item)) {
+            TS_ASSERT_EQUALS(item.m_compassHeading, count);
+            count++;
+        }
+        TS_ASSERT_EQUALS(count, 20);
+    }
+
+    void test_FailedGrowKeepsLoggedRows() {
+        TelemetryLog log;
+        TS_ASSERT(log.open(TELEMETRY_TEST_LOG));
+        writeRows(log, 0, 10);
+
+        // The file can't grow past its first size, which fails ftruncate rather than
+        // killing the process with SIGXFSZ
+        struct rlimit limit, capped;
+        getrlimit(RLIMIT_FSIZE, &limit);
+        capped = limit;
+        capped.rlim_cur = TELEMETRY_GROW_SIZE;
+        void (*previousHandler)(int) = signal(SIGXFSZ, SIG_IGN);
+        TS_ASSERT_EQUALS(setrlimit(RLIMIT_FSIZE, &capped), 0);
+
+        // More rows than fit, then some more once the log couldn't grow
+        const int rows = TELEMETRY_GROW_SIZE / 64;
+        writeRows(log, 10, rows);
+        writeRows(log, rows, rows + 10);
+
+        setrlimit(RLIMIT_FSIZE, &limit);
+        signal(SIGXFSZ, previousHandler);
+        log.close();
+
+        TelemetryLogReader reader;
+        TS_ASSERT(reader.open(TELEMETRY_TEST_LOG));
+        LogItem item;
+        int count = 0;
+        while (reader.next(item)) {
+            TS_ASSERT_EQUALS(item.m_compassHeading, count);
+            count++;
+        }
+        TS_ASSERT_LESS_THAN(TELEMETRY_BLOCK_ROWS, count);
+        TS_ASSERT_LESS_THAN(count, rows);
+    }
+
+    void test_SeekUsesIndex() {
+        const int rows = TELEMETRY_BLOCK_ROWS * (TELEMETRY_INDEX_INTERVAL * 2 + 3);
+        TelemetryLog log;
+        TS_ASSERT(log.open(TELEMETRY_TEST_LOG));
+        writeRows(log, 0, rows);
+        log.close();
+
+        TelemetryLogReader reader;
+        TS_ASSERT(reader.open(TELEMETRY_TEST_LOG));
+        LogItem item;
+
+        // Lands on the block holding the row, in the second indexed range
+        int target = TELEMETRY_BLOCK_ROWS * (TELEMETRY_INDEX_INTERVAL + 5) + 17;
+        reader.seek(LOG_ITEM_TEST_START_MS + target * 500);
+        TS_ASSERT(reader.next(item));
+        TS_ASSERT_EQUALS(item.m_compassHeading, target - 17);
+
+        // Past the indexed blocks
+        target = rows - 5;
+        reader.seek(LOG_ITEM_TEST_START_MS + target * 500);
+        TS_ASSERT(reader.next(item));
+        TS_ASSERT_EQUALS(item.m_compassHeading, TELEMETRY_BLOCK_ROWS * (TELEMETRY_INDEX_INTERVAL * 2));
+
+        reader.seek(0);
+        TS_ASSERT(reader.next(item));
+        TS_ASSERT_EQUALS(item.m_compassHeading, 0);
+    }
+
+    void test_RejectsOtherFiles() {
+        FILE* file = fopen(TELEMETRY_TEST_LOG, "w");
+        fprintf(file, "this is not a telemetry log, nor anything else useful at all");
+        fclose(file);
+
+        TelemetryLog log;
+        TS_ASSERT(not log.open(TELEMETRY_TEST_LOG));
+        TelemetryLogReader reader;
+        TS_ASSERT(not reader.open(TELEMETRY_TEST_LOG));
+    }
+};
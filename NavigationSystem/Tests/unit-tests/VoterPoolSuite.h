@@ -0,0 +1,196 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		VoterPoolSuite.h
+ *
+ * Purpose:
+ *		Checks that the voter pool asks every voter to vote once per ballot, keeps the
+ *		ballots in the voters' order, votes concurrently and times the voters.
+ *
+ * Developer Notes:
+ *
+ *	Functions that have tests:		Functions that does not have tests:
+ *
+ *	VoterPool::vote					VoterPool::workerCount
+ *	VoterPool::ballot
+ *	VoterPool::lastDurationUs
+ *	VoterPool::durations
+ *	VoterPool::start
+ *	VoterPool::stop
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../Navigation/LocalNavigationModule/ASRArbiter.h"
+#include "../Navigation/LocalNavigationModule/VoterPool.h"
+#include "../Tests/cxxtest/cxxtest/TestSuite.h"
+
+#define VOTER_SLEEP_MS 40
+
+// How long a voter waits for the others to vote at the same time
+#define VOTER_OVERLAP_TIMEOUT_MS 2000
+
+// Votes for a single course after a while
+class SleepyVoter final : public ASRVoter {
+   public:
+    SleepyVoter(uint16_t course, int16_t weight, int sleepMs)
+        : ASRVoter(100, weight, "Sleepy"),
+          m_Course(course),
+          m_SleepMs(sleepMs),
+          m_Votes(0),
+          m_Finished(NULL),
+          m_FinishedAs(-1),
+          m_Running(NULL),
+          m_MostRunning(NULL),
+          m_WaitForRunning(0) {}
+
+    const ASRCourseBallot& vote(const BoatState_t& boatState) {
+        m_Votes++;
+        courseBallot.clear();
+        if (m_Running != NULL) {
+            waitForOthers();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(m_SleepMs));
+        courseBallot.set(m_Course, 10 + (int)boatState.heading);
+        if (m_Finished != NULL) {
+            m_FinishedAs = (*m_Finished)++;
+        }
+        if (m_Running != NULL) {
+            (*m_Running)--;
+        }
+        return courseBallot;
+    }
+
+    // Records how many voters vote at once, and waits until m_WaitForRunning of them
+    // did or the timeout expired
+    void waitForOthers() {
+        int running = ++(*m_Running);
+        int most = m_MostRunning->load();
+        while (running > most && not m_MostRunning->compare_exchange_weak(most, running)) {
+        }
+
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(VOTER_OVERLAP_TIMEOUT_MS);
+        while (m_MostRunning->load() < m_WaitForRunning &&
+               std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    uint16_t m_Course;
+    int m_SleepMs;
+    std::atomic<int> m_Votes;
+    std::atomic<int>* m_Finished;  // Counts the voters done, to know who finished when
+    int m_FinishedAs;
+    std::atomic<int>* m_Running;      // Counts the voters voting at the moment
+    std::atomic<int>* m_MostRunning;  // The most voters that were voting at once
+    int m_WaitForRunning;
+};
+
+class VoterPoolSuite : public CxxTest::TestSuite {
+   public:
+    BoatState_t m_BoatState;
+
+    void setUp() { m_BoatState.heading = 5; }
+
+    void test_VotersVoteConcurrently() {
+        // Every voter waits until the three of them vote at once, which never happens
+        // if they vote one after the other
+        std::atomic<int> running(0);
+        std::atomic<int> mostRunning(0);
+        std::vector<SleepyVoter*> sleepy;
+        std::vector<ASRVoter*> voters;
+        for (int i = 0; i < 3; i++) {
+            sleepy.push_back(new SleepyVoter(100 + i, 1, VOTER_SLEEP_MS));
+            sleepy.back()->m_Running = &running;
+            sleepy.back()->m_MostRunning = &mostRunning;
+            sleepy.back()->m_WaitForRunning = 3;
+            voters.push_back(sleepy.back());
+        }
+
+        // Two workers and the calling thread
+        VoterPool pool(2);
+        pool.start();
+        pool.vote(voters, m_BoatState);
+
+        TS_ASSERT_EQUALS(mostRunning.load(), 3);
+        TS_ASSERT_EQUALS(running.load(), 0);
+        for (int i = 0; i < 3; i++) {
+            TS_ASSERT_EQUALS(sleepy[i]->m_Votes.load(), 1);
+            TS_ASSERT_EQUALS(pool.ballot(i).get(100 + i), 15);
+            TS_ASSERT_LESS_THAN_EQUALS(VOTER_SLEEP_MS * 1000, pool.lastDurationUs(i));
+            TS_ASSERT_EQUALS(pool.durations(i).count(), 1);
+        }
+
+        pool.stop();
+        for (SleepyVoter* voter : sleepy) {
+            delete voter;
+        }
+    }
+
+    void test_WithoutWorkers() {
+        SleepyVoter first(10, 1, 0);
+        SleepyVoter second(20, 1, 0);
+        std::vector<ASRVoter*> voters = {&first, &second};
+
+        // Never started, the calling thread votes alone
+        VoterPool pool(2);
+        pool.vote(voters, m_BoatState);
+        TS_ASSERT_EQUALS(pool.ballot(0).get(10), 15);
+        TS_ASSERT_EQUALS(pool.ballot(1).get(20), 15);
+
+        std::vector<ASRVoter*> none;
+        pool.vote(none, m_BoatState);
+    }
+
+    void test_MergeDoesntDependOnWhoFinishesFirst() {
+        // Every voter votes for a course of its own with a weight of its own, so a ballot
+        // merged with the wrong weight shows in the result
+        std::vector<SleepyVoter*> sleepy;
+        std::vector<ASRVoter*> voters;
+        for (int i = 0; i < 4; i++) {
+            sleepy.push_back(new SleepyVoter(90 + i, 1 + i, 0));
+            voters.push_back(sleepy.back());
+        }
+
+        ASRArbiter expected;
+        for (size_t i = 0; i < voters.size(); i++) {
+            expected.castVote(voters[i]->weight(), voters[i]->vote(m_BoatState));
+        }
+
+        // The first voter is slow on purpose, it finishes last
+        std::atomic<int> finished(0);
+        for (SleepyVoter* voter : sleepy) {
+            voter->m_Finished = &finished;
+        }
+        sleepy[0]->m_SleepMs = VOTER_SLEEP_MS;
+
+        VoterPool pool(3);
+        pool.start();
+        for (int ballot = 0; ballot < 5; ballot++) {
+            finished = 0;
+            pool.vote(voters, m_BoatState);
+            TS_ASSERT_EQUALS(sleepy[0]->m_FinishedAs, 3);
+
+            ASRArbiter arbiter;
+            for (size_t i = 0; i < voters.size(); i++) {
+                arbiter.castVote(voters[i]->weight(), pool.ballot(i));
+            }
+            for (uint16_t course = 90; course < 94; course++) {
+                TS_ASSERT_EQUALS(arbiter.getResult().get(course), expected.getResult().get(course));
+            }
+        }
+        pool.stop();
+
+        for (SleepyVoter* voter : sleepy) {
+            // Once per ballot, plus once for the expected result
+            TS_ASSERT_EQUALS(voter->m_Votes.load(), 5 + 1);
+            delete voter;
+        }
+    }
+};
@@ -54,12 +54,14 @@ AISProcessing::AISProcessing(MessageBus& msgBus, DBHandler& dbhandler, Collidabl
   void AISProcessing::processAISMessage(AISDataMsg* msg) {
     std::vector<AISVessel> list = msg->vesselList();
     std::vector<AISVesselInfo> tmp_info = msg->vesselInfoList();
-    double dist;
+    double east, north;
     m_latitude = msg->posLat();
     m_longitude = msg->posLon();
+    // Flat around the boat, cheaper than the great circle distance to every vessel
+    LocalTangentPlane plane(m_latitude, m_longitude);
     for (auto vessel: list) {
-      dist = CourseMath::calculateDTW(m_latitude, m_longitude, vessel.latitude, vessel.longitude);
-      if (dist < m_Radius && vessel.MMSI != m_MMSI) {
+      plane.project(vessel.latitude, vessel.longitude, east, north);
+      if (hypot(east, north) < m_Radius && vessel.MMSI != m_MMSI) {
         m_Vessels.push_back(vessel);
       }
     }
@@ -79,6 +81,7 @@ AISProcessing::AISProcessing(MessageBus& msgBus, DBHandler& dbhandler, Collidabl
     * And the second sends the static report
     */
     std::vector<int> indexToRemove;
+    this->collidableMgr->beginAISUpdate();
     for (auto vessel: m_Vessels) {
       this->collidableMgr->addAISContact(vessel.MMSI, vessel.latitude, vessel.longitude, vessel.SOG, vessel.COG);
       for (uint32_t i = 0; i<m_InfoList.size();i++) {
@@ -88,6 +91,7 @@ AISProcessing::AISProcessing(MessageBus& msgBus, DBHandler& dbhandler, Collidabl
         }
       }
     }
+    this->collidableMgr->endAISUpdate();
     for (auto i: indexToRemove) {
       m_InfoList.erase(m_InfoList.begin() + i);
     }
@@ -15,6 +15,7 @@
 #pragma once
 
 #include "../Database/DBHandler.h"
+#include "../Math/CollisionMath.h"
 #include "../Math/CourseMath.h"
 #include "../MessageBus/ActiveNode.h"
 #include "../MessageBus/Message.h"
@@ -24,6 +25,7 @@
 #include "../SystemServices/Timer.h"
 #include "../WorldState/CollidableMgr/CollidableMgr.h"
 
+#include <math.h>
 #include <chrono>
 #include <mutex>
 #include <thread>
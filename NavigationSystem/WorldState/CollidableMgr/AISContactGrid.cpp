@@ -0,0 +1,160 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISContactGrid.cpp
+ *
+ * Purpose:
+ *		The AIS contacts of a snapshot placed on a local tangent plane and sorted into a
+ *		grid of square cells, to find the contacts around the boat without going through
+ *		all of them.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+#include "AISContactGrid.h"
+
+#include <math.h>
+#include <algorithm>
+
+#define MIN_BUCKETS                 16
+
+// A latitude below this means the position of the contact isn't known
+#define LOWEST_LATITUDE             -90
+
+///----------------------------------------------------------------------------------
+AISContactGrid::AISContactGrid()
+    :m_bucketStart(MIN_BUCKETS + 1, 0), m_bucketMask(MIN_BUCKETS - 1)
+{
+}
+
+///----------------------------------------------------------------------------------
+void AISContactGrid::build( const std::vector<AISCollidable_t>& contacts )
+{
+    m_east.clear();
+    m_north.clear();
+    m_velocityEast.clear();
+    m_velocityNorth.clear();
+    m_item.clear();
+
+    std::vector<uint32_t> positioned;
+    for( uint32_t i = 0; i < contacts.size(); i++ )
+    {
+        if( contacts[i].latitude >= LOWEST_LATITUDE )
+        {
+            positioned.push_back(i);
+        }
+    }
+
+    uint32_t buckets = MIN_BUCKETS;
+    while( buckets < positioned.size() )
+    {
+        buckets <<= 1;
+    }
+    m_bucketMask = buckets - 1;
+    m_bucketStart.assign(buckets + 1, 0);
+
+    if( positioned.empty() )
+    {
+        return;
+    }
+
+    const AISCollidable_t& first = contacts[positioned.front()];
+    m_plane = LocalTangentPlane(first.latitude, first.longitude);
+
+    // Counting sort of the contacts by bucket
+    std::vector<uint32_t> bucketOfContact(positioned.size());
+    std::vector<double> east(positioned.size());
+    std::vector<double> north(positioned.size());
+    for( uint32_t i = 0; i < positioned.size(); i++ )
+    {
+        const AISCollidable_t& contact = contacts[positioned[i]];
+        m_plane.project(contact.latitude, contact.longitude, east[i], north[i]);
+
+        bucketOfContact[i] = bucketOf(floor(east[i] / AIS_GRID_CELL_METRES), floor(north[i] / AIS_GRID_CELL_METRES));
+        m_bucketStart[bucketOfContact[i] + 1]++;
+    }
+    for( uint32_t b = 0; b < buckets; b++ )
+    {
+        m_bucketStart[b + 1] += m_bucketStart[b];
+    }
+
+    m_east.resize(positioned.size());
+    m_north.resize(positioned.size());
+    m_velocityEast.resize(positioned.size());
+    m_velocityNorth.resize(positioned.size());
+    m_item.resize(positioned.size());
+
+    std::vector<uint32_t> next(m_bucketStart.begin(), m_bucketStart.end() - 1);
+    for( uint32_t i = 0; i < positioned.size(); i++ )
+    {
+        const AISCollidable_t& contact = contacts[positioned[i]];
+        uint32_t row = next[bucketOfContact[i]]++;
+
+        m_east[row] = east[i];
+        m_north[row] = north[i];
+        CollisionMath::courseToVelocity(contact.course, contact.speed, m_velocityEast[row], m_velocityNorth[row]);
+        m_item[row] = positioned[i];
+    }
+}
+
+///----------------------------------------------------------------------------------
+void AISContactGrid::query( double east, double north, double radius, std::vector<uint32_t>& rows ) const
+{
+    rows.clear();
+    if( m_item.empty() )
+    {
+        return;
+    }
+
+    double squaredRadius = radius * radius;
+    int32_t lowEast = floor((east - radius) / AIS_GRID_CELL_METRES);
+    int32_t highEast = floor((east + radius) / AIS_GRID_CELL_METRES);
+    int32_t lowNorth = floor((north - radius) / AIS_GRID_CELL_METRES);
+    int32_t highNorth = floor((north + radius) / AIS_GRID_CELL_METRES);
+
+    auto addIfInside = [&]( uint32_t row ) {
+        double deltaEast = m_east[row] - east;
+        double deltaNorth = m_north[row] - north;
+        if( deltaEast * deltaEast + deltaNorth * deltaNorth <= squaredRadius )
+        {
+            rows.push_back(row);
+        }
+    };
+
+    // Around more cells than there are buckets every bucket would be looked at anyway
+    if( (double)(highEast - lowEast + 1) * (highNorth - lowNorth + 1) > m_bucketMask + 1 )
+    {
+        for( uint32_t row = 0; row < m_item.size(); row++ )
+        {
+            addIfInside(row);
+        }
+    }
+    else
+    {
+        for( int32_t cellEast = lowEast; cellEast <= highEast; cellEast++ )
+        {
+            for( int32_t cellNorth = lowNorth; cellNorth <= highNorth; cellNorth++ )
+            {
+                uint32_t bucket = bucketOf(cellEast, cellNorth);
+                for( uint32_t row = m_bucketStart[bucket]; row < m_bucketStart[bucket + 1]; row++ )
+                {
+                    addIfInside(row);
+                }
+            }
+        }
+    }
+
+    // Several cells may share a bucket
+    std::sort(rows.begin(), rows.end(), [this]( uint32_t a, uint32_t b ) { return m_item[a] < m_item[b]; });
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+}
+
+///----------------------------------------------------------------------------------
+uint32_t AISContactGrid::bucketOf( int32_t cellEast, int32_t cellNorth ) const
+{
+    uint32_t h = (uint32_t)cellEast * 73856093u ^ (uint32_t)cellNorth * 19349663u;
+    return (h ^ (h >> 16)) & m_bucketMask;
+}
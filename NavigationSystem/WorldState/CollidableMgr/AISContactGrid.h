@@ -0,0 +1,67 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISContactGrid.h
+ *
+ * Purpose:
+ *		The AIS contacts of a snapshot placed on a local tangent plane and sorted into a
+ *		grid of square cells, to find the contacts around the boat without going through
+ *		all of them.
+ *
+ * Developer Notes:
+ *		The plane's origin is the first contact with a position. The cells are
+ *		AIS_GRID_CELL_METRES wide and hashed into a power of two number of buckets; the
+ *		contacts are stored bucket by bucket, column by column (east, north and the
+ *		velocity), so the contacts of a bucket are next to each other and can be handed
+ *		to the CollisionMath functions as they are.
+ *
+ *		Contacts without a position (only their static data was received) are left out.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include "../Math/CollisionMath.h"
+#include "Collidable.h"
+
+#define AIS_GRID_CELL_METRES 500
+
+class AISContactGrid {
+   public:
+    AISContactGrid();
+
+    ///----------------------------------------------------------------------------------
+    /// Places the contacts in the grid, replacing those there before.
+    ///----------------------------------------------------------------------------------
+    void build(const std::vector<AISCollidable_t>& contacts);
+
+    const LocalTangentPlane& plane() const { return m_plane; }
+
+    ///----------------------------------------------------------------------------------
+    /// Finds the rows of the contacts within radius metres of a point of the plane. The
+    /// rows are sorted in the order of the contacts the grid was built from.
+    ///----------------------------------------------------------------------------------
+    void query(double east, double north, double radius, std::vector<uint32_t>& rows) const;
+
+    uint32_t size() const { return m_item.size(); }
+
+    // The columns, one entry per row
+    std::vector<float> m_east;   // Metres from the origin of the plane
+    std::vector<float> m_north;  // Metres from the origin of the plane
+    std::vector<float> m_velocityEast;
+    std::vector<float> m_velocityNorth;
+    std::vector<uint32_t> m_item;  // Index of the contact in the vector the grid was built from
+
+   private:
+    uint32_t bucketOf(int32_t cellEast, int32_t cellNorth) const;
+
+    LocalTangentPlane m_plane;
+    std::vector<uint32_t> m_bucketStart;  // The rows of bucket b are [m_bucketStart[b], m_bucketStart[b+1])
+    uint32_t m_bucketMask;
+};
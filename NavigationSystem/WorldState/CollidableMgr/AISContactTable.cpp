@@ -0,0 +1,258 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISContactTable.cpp
+ *
+ * Purpose:
+ *		Stores the AIS contacts of the CollidableMgr, found by MMSI in constant time and
+ *		expired without going through every contact.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+#include "AISContactTable.h"
+
+#include <stddef.h>
+#include <limits>
+
+#define INITIAL_INDEX_SIZE          64
+#define FREE_SLOT                   -1
+#define REMOVED_SLOT                -2
+
+// The contact isn't listed in any bucket yet
+#define NO_BUCKET                   std::numeric_limits<unsigned long>::max()
+
+///----------------------------------------------------------------------------------
+AISContactTable::AISContactTable()
+    :m_index(INITIAL_INDEX_SIZE, FREE_SLOT), m_removedSlots(0)
+{
+}
+
+///----------------------------------------------------------------------------------
+int AISContactTable::find( uint32_t mmsi ) const
+{
+    int slot = slotOf(mmsi);
+    return slot < 0 ? -1 : m_index[slot];
+}
+
+///----------------------------------------------------------------------------------
+int AISContactTable::insert( uint32_t mmsi, unsigned long now )
+{
+    // Keep at least half of the slots free so the probes stay short
+    if( (m_mmsi.size() + m_removedSlots + 1) * 2 > m_index.size() )
+    {
+        bool full = (m_mmsi.size() + 1) * 2 > m_index.size();
+        rebuildIndex(full ? m_index.size() * 2 : m_index.size());
+    }
+
+    int row = m_mmsi.size();
+    uint32_t slot = newSlotOf(mmsi);
+    if( m_index[slot] == REMOVED_SLOT )
+    {
+        m_removedSlots--;
+    }
+    m_index[slot] = row;
+
+    m_mmsi.push_back(mmsi);
+    m_latitude.push_back(0);
+    m_longitude.push_back(0);
+    m_course.push_back(0);
+    m_speed.push_back(0);
+    m_length.push_back(0);
+    m_beam.push_back(0);
+    m_lastUpdated.push_back(now);
+    m_bucket.push_back(NO_BUCKET);
+
+    touch(row, now);
+    return row;
+}
+
+///----------------------------------------------------------------------------------
+void AISContactTable::touch( int row, unsigned long now )
+{
+    m_lastUpdated[row] = now;
+
+    // The clock went back, the contact may be expired a bit late
+    unsigned long bucket = now / AIS_CONTACT_BUCKET_SECONDS;
+    if( !m_buckets.empty() && bucket < m_buckets.back().start )
+    {
+        bucket = m_buckets.back().start;
+    }
+
+    if( m_bucket[row] == bucket )
+    {
+        return;
+    }
+
+    if( m_buckets.empty() || m_buckets.back().start < bucket )
+    {
+        m_buckets.push_back(Bucket());
+        m_buckets.back().start = bucket;
+    }
+
+    m_buckets.back().mmsi.push_back(m_mmsi[row]);
+    m_bucket[row] = bucket;
+}
+
+///----------------------------------------------------------------------------------
+uint32_t AISContactTable::bucketEntries() const
+{
+    uint32_t entries = 0;
+    for( const Bucket& bucket : m_buckets )
+    {
+        entries += bucket.mmsi.size();
+    }
+    return entries;
+}
+
+///----------------------------------------------------------------------------------
+unsigned int AISContactTable::removeExpired( unsigned long timeout, unsigned long now )
+{
+    unsigned int removed = 0;
+
+    while( !m_buckets.empty() )
+    {
+        Bucket& oldest = m_buckets.front();
+
+        // Every contact in the bucket was updated after it started
+        if( oldest.start * AIS_CONTACT_BUCKET_SECONDS + timeout >= now )
+        {
+            break;
+        }
+
+        size_t kept = 0;
+        for( uint32_t mmsi : oldest.mmsi )
+        {
+            int row = find(mmsi);
+
+            // Removed already, or listed in a newer bucket
+            if( row < 0 || m_bucket[row] != oldest.start )
+            {
+                continue;
+            }
+
+            if( m_lastUpdated[row] + timeout < now )
+            {
+                remove(row);
+                removed++;
+            }
+            else
+            {
+                oldest.mmsi[kept++] = mmsi;
+            }
+        }
+
+        // The contacts of the newer buckets are more recent than those still here
+        if( kept > 0 )
+        {
+            oldest.mmsi.resize(kept);
+            break;
+        }
+        m_buckets.pop_front();
+    }
+
+    return removed;
+}
+
+///----------------------------------------------------------------------------------
+void AISContactTable::remove( int row )
+{
+    m_index[slotOf(m_mmsi[row])] = REMOVED_SLOT;
+    m_removedSlots++;
+
+    // The last contact takes the row
+    int last = m_mmsi.size() - 1;
+    if( row != last )
+    {
+        m_mmsi[row] = m_mmsi[last];
+        m_latitude[row] = m_latitude[last];
+        m_longitude[row] = m_longitude[last];
+        m_course[row] = m_course[last];
+        m_speed[row] = m_speed[last];
+        m_length[row] = m_length[last];
+        m_beam[row] = m_beam[last];
+        m_lastUpdated[row] = m_lastUpdated[last];
+        m_bucket[row] = m_bucket[last];
+
+        m_index[slotOf(m_mmsi[row])] = row;
+    }
+
+    m_mmsi.pop_back();
+    m_latitude.pop_back();
+    m_longitude.pop_back();
+    m_course.pop_back();
+    m_speed.pop_back();
+    m_length.pop_back();
+    m_beam.pop_back();
+    m_lastUpdated.pop_back();
+    m_bucket.pop_back();
+}
+
+///----------------------------------------------------------------------------------
+AISCollidable_t AISContactTable::contact( int row ) const
+{
+    AISCollidable_t contact;
+    contact.mmsi = m_mmsi[row];
+    contact.course = m_course[row];
+    contact.latitude = m_latitude[row];
+    contact.longitude = m_longitude[row];
+    contact.speed = m_speed[row];
+    contact.lastUpdated = m_lastUpdated[row];
+    contact.length = m_length[row];
+    contact.beam = m_beam[row];
+    return contact;
+}
+
+///----------------------------------------------------------------------------------
+uint32_t AISContactTable::hash( uint32_t mmsi )
+{
+    // The vessels around mostly share the country digits at the front of their MMSIs
+    // and differ in the last ones, which spread over the low bits well enough. Some
+    // MMSIs end in zeros though (e.g. Inmarsat equipped ships), folding the upper bits
+    // in keeps them apart.
+    return mmsi ^ (mmsi >> 11) ^ (mmsi >> 22);
+}
+
+///----------------------------------------------------------------------------------
+int AISContactTable::slotOf( uint32_t mmsi ) const
+{
+    uint32_t mask = m_index.size() - 1;
+    uint32_t slot = hash(mmsi) & mask;
+
+    while( m_index[slot] != FREE_SLOT )
+    {
+        if( m_index[slot] != REMOVED_SLOT && m_mmsi[m_index[slot]] == mmsi )
+        {
+            return slot;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+///----------------------------------------------------------------------------------
+uint32_t AISContactTable::newSlotOf( uint32_t mmsi ) const
+{
+    uint32_t mask = m_index.size() - 1;
+    uint32_t slot = hash(mmsi) & mask;
+
+    while( m_index[slot] >= 0 )
+    {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+///----------------------------------------------------------------------------------
+void AISContactTable::rebuildIndex( uint32_t size )
+{
+    m_index.assign(size, FREE_SLOT);
+    m_removedSlots = 0;
+    for( uint32_t row = 0; row < m_mmsi.size(); row++ )
+    {
+        m_index[newSlotOf(m_mmsi[row])] = row;
+    }
+}
@@ -0,0 +1,105 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		AISContactTable.h
+ *
+ * Purpose:
+ *		Stores the AIS contacts of the CollidableMgr, found by MMSI in constant time and
+ *		expired without going through every contact.
+ *
+ * Developer Notes:
+ *		The contacts are kept column by column (one vector per field) in a dense table,
+ *		a contact removed being replaced by the last one. An open addressing index
+ *		(linear probing) maps each MMSI to its row. A removed contact leaves a marker in
+ *		its slot, so the probes for the other MMSIs go on past it, and a new contact can
+ *		take the slot. The index is rebuilt without the markers once they and the
+ *		contacts fill half of it, and twice as large if the contacts alone do.
+ *
+ *		Each contact is also listed in the time bucket of its last update, buckets being
+ *		AIS_CONTACT_BUCKET_SECONDS wide. Expiring contacts only looks at the oldest
+ *		buckets; a contact updated since it was listed in a bucket is skipped there as it
+ *		is listed again in a newer one.
+ *
+ * License:
+ *      This file is subject to the terms and conditions defined in the file
+ *      'LICENSE.txt', which is part of this source code package.
+ *
+ ***************************************************************************************/
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include "Collidable.h"
+
+#define AIS_CONTACT_BUCKET_SECONDS 10
+
+class AISContactTable {
+   public:
+    AISContactTable();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the row of the contact, -1 if there is none.
+    ///----------------------------------------------------------------------------------
+    int find(uint32_t mmsi) const;
+
+    ///----------------------------------------------------------------------------------
+    /// Adds a contact with every field zeroed and returns its row. The MMSI must not be
+    /// in the table already.
+    ///----------------------------------------------------------------------------------
+    int insert(uint32_t mmsi, unsigned long now);
+
+    ///----------------------------------------------------------------------------------
+    /// Sets the time the contact was last updated.
+    ///----------------------------------------------------------------------------------
+    void touch(int row, unsigned long now);
+
+    ///----------------------------------------------------------------------------------
+    /// Removes the contacts not updated for more than timeout seconds, returns how many
+    /// were removed.
+    ///----------------------------------------------------------------------------------
+    unsigned int removeExpired(unsigned long timeout, unsigned long now);
+
+    void remove(int row);
+
+    uint32_t size() const { return m_mmsi.size(); }
+
+    /* How many entries the buckets hold, a contact updated since it was listed has more
+       than one until the older bucket expires */
+    uint32_t bucketEntries() const;
+
+    AISCollidable_t contact(int row) const;
+
+    // The columns, one entry per contact
+    std::vector<uint32_t> m_mmsi;
+    std::vector<double> m_latitude;
+    std::vector<double> m_longitude;
+    std::vector<float> m_course;
+    std::vector<float> m_speed;
+    std::vector<float> m_length;
+    std::vector<float> m_beam;
+    std::vector<unsigned long> m_lastUpdated;
+
+   private:
+    struct Bucket {
+        unsigned long start;  // In AIS_CONTACT_BUCKET_SECONDS
+        std::vector<uint32_t> mmsi;
+    };
+
+    static uint32_t hash(uint32_t mmsi);
+
+    /* Index slot of the MMSI, -1 if it isn't in the table */
+    int slotOf(uint32_t mmsi) const;
+
+    /* The first slot a new MMSI can take, free or left by a removed contact */
+    uint32_t newSlotOf(uint32_t mmsi) const;
+
+    void rebuildIndex(uint32_t size);
+
+    std::vector<int32_t> m_index;  // Rows, or FREE_SLOT or REMOVED_SLOT; the size is a
+                                   // power of two
+    uint32_t m_removedSlots;       // Slots marked REMOVED_SLOT
+    std::vector<unsigned long> m_bucket;  // Column: the bucket the contact is listed in last
+    std::deque<Bucket> m_buckets;         // Oldest first
+};
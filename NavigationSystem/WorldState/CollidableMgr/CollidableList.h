@@ -4,8 +4,8 @@
  * 		CollidableList.h
  *
  * Purpose:
- *		A list which a mutex associated with it. Prevents multiple sources from accessing
- *      the underlying vector unless it has locked the mutex.
+ *		A read only snapshot of the collidables. The list keeps the snapshot alive, so it
+ *      stays the same however long it is used, while newer snapshots get published.
  *
  * License:
  *      This file is subject to the terms and conditions defined in the file
@@ -16,52 +16,39 @@
 #pragma once
 
 #include <stdint.h>
-#include <mutex>
+#include <memory>
 #include <vector>
 
+template <typename T>
+struct CollidableSnapshot {
+    uint64_t version;  // Increases with every snapshot published
+    std::vector<T> items;
+};
+
 template <typename T>
 class CollidableList {
    public:
-    ///----------------------------------------------------------------------------------
-    /// Constructs the collidable list, the data and the mutex to the data are passed in
-    /// as arguments.
-    ///----------------------------------------------------------------------------------
-    CollidableList<T>(std::mutex* mutex, std::vector<T>* data)
-        : ownsLock(false), index(0), listMutex(mutex), dataPtr(data) {}
+    typedef typename std::vector<T>::const_iterator const_iterator;
 
     ///----------------------------------------------------------------------------------
-    /// Frees the mutex if this list has locked it.
+    /// Constructs the collidable list over a published snapshot.
     ///----------------------------------------------------------------------------------
-    ~CollidableList() { this->release(); }
+    CollidableList<T>(std::shared_ptr<const CollidableSnapshot<T>> snapshot)
+        : index(0), snapshot(snapshot) {}
 
     ///----------------------------------------------------------------------------------
-    /// Frees the mutex over the list if this list has locked it.
+    /// Kept for the callers written when the list held a lock, there is nothing to free.
     ///----------------------------------------------------------------------------------
-    void release() {
-        if (this->ownsLock) {
-            this->listMutex->unlock();
-            this->ownsLock = false;
-        }
-    }
+    void release() {}
 
     ///----------------------------------------------------------------------------------
-    /// Returns the next data item in the underlying vector. If the end of the vector has
-    /// been reached, the last item is returned. This function ensures it has locked the
-    /// mutex associated with the underlying vector before attempting to access it.
-    ///
-    /// NOTE:
-    ///     It does not release the lock, use either release() or destroy the object to
-    ///     do this.
+    /// Returns the next item of the snapshot. If the end of the snapshot has been
+    /// reached, the last item is returned.
     ///----------------------------------------------------------------------------------
-    T next() {
-        if (!this->ownsLock) {
-            this->listMutex->lock();
-            this->ownsLock = true;
-        }
-
+    const T& next() {
         uint16_t length = this->length();
 
-        T nextItem = dataPtr->at(index);
+        const T& nextItem = snapshot->items.at(index);
 
         if (this->index < length - 1) {
             this->index++;
@@ -72,14 +59,17 @@ class CollidableList {
 
     void reset() { this->index = 0; }
 
+    const_iterator begin() const { return snapshot->items.begin(); }
+    const_iterator end() const { return snapshot->items.end(); }
+
     ///----------------------------------------------------------------------------------
     /// Returns the number of items in the list.
     ///----------------------------------------------------------------------------------
-    uint16_t length() { return dataPtr->size(); }
+    uint16_t length() const { return snapshot->items.size(); }
+
+    uint64_t version() const { return snapshot->version; }
 
    private:
-    bool ownsLock;
     uint16_t index;
-    std::mutex* listMutex;
-    std::vector<T>* dataPtr;
-};
\ No newline at end of file
+    std::shared_ptr<const CollidableSnapshot<T>> snapshot;
+};
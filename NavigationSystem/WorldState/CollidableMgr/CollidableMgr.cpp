@@ -36,8 +36,12 @@ const unsigned int visualFieldTimeOut = 30;
 const int fadeOut = 2;  
 ///----------------------------------------------------------------------------------
 CollidableMgr::CollidableMgr()
-    :ownAISLock(false)
+    :m_aisUpdateDepth(0), m_aisContactsChanged(false)
 {
+    std::shared_ptr<AISContactSnapshot_t> aisSnapshot = std::make_shared<AISContactSnapshot_t>();
+    aisSnapshot->version = 0;
+    m_aisSnapshot = aisSnapshot;
+    m_visualSnapshot = std::make_shared<VisualField_t>(m_visualField);
 }
 
 ///----------------------------------------------------------------------------------
@@ -49,82 +53,96 @@ void CollidableMgr::startGC()
 ///----------------------------------------------------------------------------------
 void CollidableMgr::addAISContact( uint32_t mmsi, double lat, double lon, float speed, float course )
 {
-    if( !this->ownAISLock )
+    std::lock_guard<std::mutex> guard(aisListMutex);
+    auto timeNow = SysClock::unixTime();
+
+    // Check if the contact already exists, and if so update it
+    int row = m_aisTable.find(mmsi);
+    if( row < 0 )
     {
-        this->aisListMutex.lock();
-        this->ownAISLock = true;
+        row = m_aisTable.insert(mmsi, timeNow);
+        m_aisTable.m_length[row] = NOT_AVAILABLE;
+        m_aisTable.m_beam[row] = NOT_AVAILABLE;
     }
+    else
+    {
+        m_aisTable.touch(row, timeNow);
+    }
+
+    m_aisTable.m_latitude[row] = lat;
+    m_aisTable.m_longitude[row] = lon;
+    m_aisTable.m_speed[row] = speed;
+    m_aisTable.m_course[row] = course;
+    m_aisContactsChanged = true;
+    publishAISContacts();
+}
+
+///----------------------------------------------------------------------------------
+void CollidableMgr::addAISContact( uint32_t mmsi, float length, float beam )
+{
+    std::lock_guard<std::mutex> guard(aisListMutex);
 
     // Check if the contact already exists, and if so update it
-    bool contactExists = false;
-    for( uint16_t i = 0; i < this->aisContacts.size() && !contactExists; i++ )
+    int row = m_aisTable.find(mmsi);
+    if( row < 0 )
     {
-        if( this->aisContacts[i].mmsi == mmsi)
-        {
-            this->aisContacts[i].latitude = lat;
-            this->aisContacts[i].longitude = lon;
-            this->aisContacts[i].speed = speed;
-            this->aisContacts[i].course = course;
-            this->aisContacts[i].lastUpdated = SysClock::unixTime();
-            contactExists = true;
-        }
+        row = m_aisTable.insert(mmsi, SysClock::unixTime());
+        m_aisTable.m_latitude[row] = NOT_AVAILABLE;
+        m_aisTable.m_longitude[row] = NOT_AVAILABLE;
+        m_aisTable.m_speed[row] = NOT_AVAILABLE;
+        m_aisTable.m_course[row] = NOT_AVAILABLE;
     }
 
-    if(!contactExists)
-    {
-        AISCollidable_t aisContact;
-        aisContact.mmsi = mmsi;
-        aisContact.latitude = lat;
-        aisContact.longitude = lon;
-        aisContact.speed = speed;
-        aisContact.course = course;
-        aisContact.length = NOT_AVAILABLE;
-        aisContact.beam = NOT_AVAILABLE;
-        aisContact.lastUpdated = SysClock::unixTime();
-
-        this->aisContacts.push_back(aisContact);
-      }
-    this->aisListMutex.unlock();
-    this->ownAISLock = false;
+    m_aisTable.m_length[row] = length;
+    m_aisTable.m_beam[row] = beam;
+    m_aisContactsChanged = true;
+    publishAISContacts();
 }
 
 ///----------------------------------------------------------------------------------
-void CollidableMgr::addAISContact( uint32_t mmsi, float length, float beam )
+void CollidableMgr::beginAISUpdate()
+{
+    std::lock_guard<std::mutex> guard(aisListMutex);
+    m_aisUpdateDepth++;
+}
+
+///----------------------------------------------------------------------------------
+void CollidableMgr::endAISUpdate()
 {
-    if( !this->ownAISLock )
+    std::lock_guard<std::mutex> guard(aisListMutex);
+    if( m_aisUpdateDepth > 0 )
     {
-        this->aisListMutex.lock();
-        this->ownAISLock = true;
+        m_aisUpdateDepth--;
     }
+    publishAISContacts();
+}
 
-    // Check if the contact already exists, and if so update it
-    bool contactExists = false;
-    for( uint16_t i = 0; i < this->aisContacts.size() && !contactExists; i++ )
+///----------------------------------------------------------------------------------
+void CollidableMgr::publishAISContacts()
+{
+    if( m_aisUpdateDepth > 0 || !m_aisContactsChanged )
     {
-        if( this->aisContacts[i].mmsi == mmsi)
-        {
-            this->aisContacts[i].length = length;
-            this->aisContacts[i].beam = beam;
-            contactExists = true;
-        }
+        return;
     }
 
-    if(!contactExists)
+    // Built aside, the readers keep using the previous snapshot meanwhile
+    std::shared_ptr<AISContactSnapshot_t> snapshot = std::make_shared<AISContactSnapshot_t>();
+    snapshot->version = m_aisSnapshot->version + 1;
+    snapshot->items.reserve(m_aisTable.size());
+    for( uint32_t row = 0; row < m_aisTable.size(); row++ )
     {
-        AISCollidable_t aisContact;
-        aisContact.mmsi = mmsi;
-        aisContact.length = length;
-        aisContact.beam = beam;
-        aisContact.latitude = NOT_AVAILABLE;
-        aisContact.longitude = NOT_AVAILABLE;
-        aisContact.speed = NOT_AVAILABLE;
-        aisContact.course = NOT_AVAILABLE;
-        aisContact.lastUpdated = SysClock::unixTime();
-
-        this->aisContacts.push_back(aisContact);
-      }
-    this->aisListMutex.unlock();
-    this->ownAISLock = false;
+        snapshot->items.push_back(m_aisTable.contact(row));
+    }
+    snapshot->grid.build(snapshot->items);
+
+    std::atomic_store(&m_aisSnapshot, std::shared_ptr<const AISContactSnapshot_t>(snapshot));
+    m_aisContactsChanged = false;
+}
+
+///----------------------------------------------------------------------------------
+void CollidableMgr::publishVisualField()
+{
+    std::atomic_store(&m_visualSnapshot, std::shared_ptr<const VisualField_t>(std::make_shared<VisualField_t>(m_visualField)));
 }
 
 ///----------------------------------------------------------------------------------
@@ -148,19 +166,25 @@ void CollidableMgr::addVisualField( std::map<int16_t, uint16_t> relBearingToRelO
     }
     m_visualField.visualFieldLowBearing = lowBearing + heading;
     m_visualField.visualFieldHighBearing = highBearing + heading;
+    publishVisualField();
 }
 
 ///----------------------------------------------------------------------------------
 CollidableList<AISCollidable_t> CollidableMgr::getAISContacts()
 {
-    return CollidableList<AISCollidable_t>(&this->aisListMutex, &aisContacts);
+    return CollidableList<AISCollidable_t>(std::atomic_load(&m_aisSnapshot));
 }
 
 ///----------------------------------------------------------------------------------
-VisualField_t CollidableMgr::getVisualField()
+std::shared_ptr<const AISContactSnapshot_t> CollidableMgr::getAISSnapshot()
 {
-    std::lock_guard<std::mutex> guard(m_visualMutex);
-    return m_visualField;
+    return std::atomic_load(&m_aisSnapshot);
+}
+
+///----------------------------------------------------------------------------------
+std::shared_ptr<const VisualField_t> CollidableMgr::getVisualField()
+{
+    return std::atomic_load(&m_visualSnapshot);
 }
 
 void CollidableMgr::removeOldVisualField(){
@@ -169,6 +193,7 @@ void CollidableMgr::removeOldVisualField(){
         return;
     }
     std::vector<int16_t> eraseBearings;
+    bool changed = false;
     for (auto it : m_visualField.bearingToLastUpdated){
         if (it.second + visualFieldTimeOut < SysClock::unixTime()){
             eraseBearings.push_back(it.first);
@@ -177,6 +202,7 @@ void CollidableMgr::removeOldVisualField(){
             if (m_visualField.bearingToRelativeObstacleDistance[it.first] < 100){
                 m_visualField.bearingToRelativeObstacleDistance[it.first] = 
                     std::min(m_visualField.bearingToRelativeObstacleDistance[it.first] + fadeOut, 100);
+                changed = true;
             }
         }
     }
@@ -185,36 +211,21 @@ void CollidableMgr::removeOldVisualField(){
         m_visualField.bearingToRelativeObstacleDistance.erase(it);
         m_visualField.bearingToLastUpdated.erase(it);
     } 
+    if (changed || !eraseBearings.empty()){
+        publishVisualField();
+    }
    
 }
 
 ///----------------------------------------------------------------------------------
 void CollidableMgr::removeOldAISContacts()
 {
- 
-    if( !this->ownAISLock )
+    std::lock_guard<std::mutex> guard(aisListMutex);
+    if( m_aisTable.removeExpired(AIS_CONTACT_TIME_OUT, SysClock::unixTime()) > 0 )
     {
-        this->aisListMutex.lock();
-        this->ownAISLock = true;
+        m_aisContactsChanged = true;
+        publishAISContacts();
     }
-
-    auto timeNow = SysClock::unixTime();
-
-
-    for (auto it = this->aisContacts.cbegin(); it != this->aisContacts.cend();)
-    {
-        if ( (*it).lastUpdated + AIS_CONTACT_TIME_OUT < timeNow )
-        {
-            it = aisContacts.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
-
-    this->aisListMutex.unlock();
-    this->ownAISLock = false;
 }
 
 ///----------------------------------------------------------------------------------
@@ -8,6 +8,17 @@
  *    or smaller boats/obstacles found by the thermal imager
  *    The AISProcessing adds/updates the data to the collidableMgr
  *    Removes the data when enough time has gone without the contact being updated
+ *
+ * Developer notes:
+ *    The AIS contacts are stored in an AISContactTable. Whoever changes the contacts
+ *    or the visual field publishes an immutable snapshot of them, which the readers
+ *    (the voters) pick up with an atomic load of a shared pointer. The readers never
+ *    wait for the writers, nor the writers for the readers; a snapshot is freed once
+ *    the last reader lets go of it.
+ *
+ *    The AIS snapshot comes with a spatial grid of its contacts, built when it is
+ *    published.
+ *
  * License:
  *      This file is subject to the terms and conditions defined in the file
  *      'LICENSE.txt', which is part of this source code package.
@@ -17,11 +28,18 @@
 #pragma once
 
 #include <stdint.h>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include "AISContactGrid.h"
+#include "AISContactTable.h"
 #include "Collidable.h"
 #include "CollidableList.h"
 
+struct AISContactSnapshot_t : public CollidableSnapshot<AISCollidable_t> {
+    AISContactGrid grid;  // Of the items
+};
+
 class CollidableMgr {
    public:
     CollidableMgr();
@@ -33,12 +51,32 @@ class CollidableMgr {
 
     void addAISContact(uint32_t mmsi, double lat, double lon, float speed, float course);
     void addAISContact(uint32_t mmsi, float length, float beam);
+
+    ///----------------------------------------------------------------------------------
+    /// The contacts added until endAISUpdate() is called are published together, in a
+    /// single snapshot.
+    ///----------------------------------------------------------------------------------
+    void beginAISUpdate();
+    void endAISUpdate();
+
     // replaces the visual field
     void addVisualField(std::map<int16_t, uint16_t> relBearingToRelObstacleDistance,
                         int16_t heading);
 
+    ///----------------------------------------------------------------------------------
+    /// Returns the latest snapshot of the AIS contacts, never blocks.
+    ///----------------------------------------------------------------------------------
     CollidableList<AISCollidable_t> getAISContacts();
-    VisualField_t getVisualField();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the latest snapshot of the AIS contacts with their grid, never blocks.
+    ///----------------------------------------------------------------------------------
+    std::shared_ptr<const AISContactSnapshot_t> getAISSnapshot();
+
+    ///----------------------------------------------------------------------------------
+    /// Returns the latest snapshot of the visual field, never blocks.
+    ///----------------------------------------------------------------------------------
+    std::shared_ptr<const VisualField_t> getVisualField();
 
     void removeOldVisualField();
 
@@ -47,10 +85,19 @@ class CollidableMgr {
    private:
     static void ContactGC(CollidableMgr* ptr);
 
-    std::vector<AISCollidable_t> aisContacts;
+    // Called with aisListMutex locked
+    void publishAISContacts();
+
+    // Called with m_visualMutex locked
+    void publishVisualField();
+
+    AISContactTable m_aisTable;
+    int m_aisUpdateDepth;  // How many beginAISUpdate() are waiting for their endAISUpdate()
+    bool m_aisContactsChanged;
+    std::shared_ptr<const AISContactSnapshot_t> m_aisSnapshot;
     VisualField_t m_visualField;
+    std::shared_ptr<const VisualField_t> m_visualSnapshot;
     std::mutex aisListMutex;
     std::mutex m_visualMutex;
-    bool ownAISLock;
     std::thread* m_Thread;
 };
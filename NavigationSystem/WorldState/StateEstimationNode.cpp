@@ -163,7 +163,7 @@ void StateEstimationNode::StateEstimationNodeThreadFunc(ActiveNode* nodePtr)
 
     // An initial sleep, its purpose is to ensure that most if not all the sensor data arrives
     // at the start before we send out the vessel state message.
-    std::this_thread::sleep_for(std::chrono::milliseconds(INITIAL_SLEEP));
+    SimulatedClock::sleepFor(std::chrono::milliseconds(INITIAL_SLEEP));
 
     Timer timer;
     timer.start();
@@ -1,6 +1,12 @@
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <memory>
 #include <string>
 #include "../Database/DBHandler.h"
 #include "../Database/DBLoggerNode.h"
+#include "../Database/TelemetryLog.h"
 #include "../HTTPSync/HTTPSyncNode.h"
 #include "../MessageBus/MessageBus.h"
 #include "../Messages/DataRequestMsg.h"
@@ -31,6 +37,9 @@
   #include "../Hardwares/HMC6343Node.h"
   #include "../Hardwares/GPSDNode.h"
   #include "../Hardwares/CAN_Services/CANService.h"
+  #include "../Hardwares/CAN_Services/CANTrace.h"
+  #include "../Hardwares/CAN_Services/MCP2515Transport.h"
+  #include "../Hardwares/CAN_Services/SocketCANTransport.h"
   #include "../Hardwares/CANWindsensorNode.h"
   #include "../Hardwares/ActuatorNodeASPire.h"
   #include "../Hardwares/CANArduinoNode.h"
@@ -136,8 +145,18 @@ int main(int argc, char *argv[])
 	// Declare nodes
 	//-------------------------------------------------------------------------------
 
+	// Set SR_TELEMETRY_LOG to a file path to log to a binary telemetry log instead of the
+	// database, see telemetry_log_converter.cpp to import it afterwards
+	TelemetryLog telemetryLog;
+	const char* telemetryLogPath = getenv("SR_TELEMETRY_LOG");
+	if(telemetryLogPath != NULL && not telemetryLog.open(telemetryLogPath))
+	{
+		Logger::warning("Could not open the telemetry log, logging to the database");
+	}
+
 	int dbLoggerQueueSize = 5; 			// how many messages to log to the databse at a time
-	DBLoggerNode dbLoggerNode(messageBus, dbHandler, dbLoggerQueueSize);
+	DBLoggerNode dbLoggerNode(messageBus, dbHandler, dbLoggerQueueSize,
+		telemetryLog.isOpen() ? &telemetryLog : NULL);
 	HTTPSyncNode httpsync(messageBus, &dbHandler);
 
 	StateEstimationNode stateEstimationNode(messageBus, dbHandler);
@@ -169,8 +188,85 @@ int main(int argc, char *argv[])
 
 	#if SIMULATION == 1
   		SimulationNode simulation(messageBus, 1, &collidableMgr);
+
+		// Set SR_SIM_LOCKSTEP_MS to step the simulator in lockstep with the nodes, that
+		// many simulated milliseconds per simulator tick, as fast as the nodes allow
+		const char* lockstepTick = getenv("SR_SIM_LOCKSTEP_MS");
+		if(lockstepTick != NULL)
+		{
+			char* end;
+			errno = 0;
+			long tickMs = strtol(lockstepTick, &end, 10);
+			if(errno == 0 && end != lockstepTick && *end == '\0' && tickMs > 0 && tickMs <= UINT_MAX)
+			{
+				simulation.enableLockstep((unsigned int)tickMs);
+			}
+			else
+			{
+				Logger::warning("SR_SIM_LOCKSTEP_MS=\"%s\" isn't a number of milliseconds above 0, simulating in real time", lockstepTick);
+			}
+		}
+
+		// Set SR_SIM_DYNAMICS to simulate the boat in process rather than to wait for the
+		// simulator to connect, it can name a json file configuring the boat and the wind
+		// (see Simulation/BoatDynamics.h) or be empty for the defaults
+		BoatDynamics boatDynamics(true);
+		const char* dynamicsPath = getenv("SR_SIM_DYNAMICS");
+		if(dynamicsPath != NULL)
+		{
+			if(dynamicsPath[0] != '\0' && not boatDynamics.loadConfig(dynamicsPath))
+			{
+				Logger::warning("Could not read %s, simulating the default boat", dynamicsPath);
+			}
+			simulation.simulateInProcess(boatDynamics);
+		}
   	#else
-		CANService canService;
+		// The CAN frames come from the MCP2515 unless SR_CAN_INTERFACE names a SocketCAN
+		// interface (e.g. can0 or vcan0), or SR_CAN_REPLAY a candump log to replay at
+		// SR_CAN_REPLAY_SPEED times real time (1 to 100, 0 for as fast as possible). Set
+		// SR_CAN_RECORD to a file path to record the frames to a candump log.
+		std::unique_ptr<CANTransport> canTransport;
+		const char* canReplayPath = getenv("SR_CAN_REPLAY");
+		const char* canInterface = getenv("SR_CAN_INTERFACE");
+		const char* canRecordPath = getenv("SR_CAN_RECORD");
+		if(canReplayPath != NULL)
+		{
+			double speed = 1;
+			const char* replaySpeed = getenv("SR_CAN_REPLAY_SPEED");
+			if(replaySpeed != NULL)
+			{
+				char* end;
+				errno = 0;
+				speed = strtod(replaySpeed, &end);
+				if(errno != 0 || end == replaySpeed || *end != '\0' ||
+					not (speed == 0 || (speed >= 1 && speed <= 100)))
+				{
+					Logger::warning("SR_CAN_REPLAY_SPEED=\"%s\" isn't 0 or a speed from 1 to 100, replaying in real time", replaySpeed);
+					speed = 1;
+				}
+			}
+			canTransport.reset(new CANTraceReplayer(canReplayPath, speed));
+		}
+		else if(canInterface != NULL)
+		{
+			canTransport.reset(new SocketCANTransport(canInterface));
+		}
+		else
+		{
+			canTransport.reset(new MCP2515Transport());
+		}
+		if(canRecordPath != NULL)
+		{
+			canTransport.reset(new CANTraceRecorder(std::move(canTransport), canRecordPath,
+				canInterface != NULL ? canInterface : "can0"));
+		}
+
+		CANService canService(*canTransport);
+		if(canReplayPath != NULL)
+		{
+			// The time spent per PGN is logged once the whole log is replayed
+			canService.enableStatistics();
+		}
 
 		HMC6343Node compass(messageBus, dbHandler);
 	  	GPSDNode gpsd(messageBus, dbHandler);
@@ -248,6 +344,18 @@ int main(int argc, char *argv[])
 
 	// Begins running the message bus
 	//-------------------------------------------------------------------------------
+
+	// Set SR_MESSAGE_TRACE to a file path to record the messages going through the bus
+	const char* messageTracePath = getenv("SR_MESSAGE_TRACE");
+	if(messageTracePath != NULL)
+	{
+		messageBus.startTracing(messageTracePath);
+	}
+
+	// Node timings are logged every 5 minutes, or on demand with 'kill -USR1 <pid>'
+	messageBus.enableStatistics(300);
+	MessageBusStats::dumpOnSignal(SIGUSR1);
+
 	Logger::info("Message bus started!");
 	messageBus.run();
 
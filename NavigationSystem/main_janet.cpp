@@ -1,6 +1,11 @@
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdlib.h>
 #include <string>
 #include "../Database/DBHandler.h"
 #include "../Database/DBLoggerNode.h"
+#include "../Database/TelemetryLog.h"
 #include "../HTTPSync/HTTPSyncNode.h"
 #include "../MessageBus/MessageBus.h"
 #include "../Messages/DataRequestMsg.h"
@@ -138,8 +143,18 @@ int main(int argc, char *argv[])
 	// Declare nodes
 	//-------------------------------------------------------------------------------
 
+	// Set SR_TELEMETRY_LOG to a file path to log to a binary telemetry log instead of the
+	// database, see telemetry_log_converter.cpp to import it afterwards
+	TelemetryLog telemetryLog;
+	const char* telemetryLogPath = getenv("SR_TELEMETRY_LOG");
+	if(telemetryLogPath != NULL && not telemetryLog.open(telemetryLogPath))
+	{
+		Logger::warning("Could not open the telemetry log, logging to the database");
+	}
+
 	int dbLoggerQueueSize = 5; 			// how many messages to log to the databse at a time
-	DBLoggerNode dbLoggerNode(messageBus, dbHandler, dbLoggerQueueSize);
+	DBLoggerNode dbLoggerNode(messageBus, dbHandler, dbLoggerQueueSize,
+		telemetryLog.isOpen() ? &telemetryLog : NULL);
 
 	//HTTPSyncNode httpsync(messageBus, &dbHandler);
 
@@ -173,6 +188,38 @@ int main(int argc, char *argv[])
 
 	#if SIMULATION == 1
 	  	SimulationNode simulation(messageBus, 0, &collidableMgr);
+
+		// Set SR_SIM_LOCKSTEP_MS to step the simulator in lockstep with the nodes, that
+		// many simulated milliseconds per simulator tick, as fast as the nodes allow
+		const char* lockstepTick = getenv("SR_SIM_LOCKSTEP_MS");
+		if(lockstepTick != NULL)
+		{
+			char* end;
+			errno = 0;
+			long tickMs = strtol(lockstepTick, &end, 10);
+			if(errno == 0 && end != lockstepTick && *end == '\0' && tickMs > 0 && tickMs <= UINT_MAX)
+			{
+				simulation.enableLockstep((unsigned int)tickMs);
+			}
+			else
+			{
+				Logger::warning("SR_SIM_LOCKSTEP_MS=\"%s\" isn't a number of milliseconds above 0, simulating in real time", lockstepTick);
+			}
+		}
+
+		// Set SR_SIM_DYNAMICS to simulate the boat in process rather than to wait for the
+		// simulator to connect, it can name a json file configuring the boat and the wind
+		// (see Simulation/BoatDynamics.h) or be empty for the defaults
+		BoatDynamics boatDynamics(false);
+		const char* dynamicsPath = getenv("SR_SIM_DYNAMICS");
+		if(dynamicsPath != NULL)
+		{
+			if(dynamicsPath[0] != '\0' && not boatDynamics.loadConfig(dynamicsPath))
+			{
+				Logger::warning("Could not read %s, simulating the default boat", dynamicsPath);
+			}
+			simulation.simulateInProcess(boatDynamics);
+		}
   	#else
 		CV7Node windSensor(messageBus, dbHandler);
 		HMC6343Node compass(messageBus, dbHandler);
@@ -255,6 +302,18 @@ int main(int argc, char *argv[])
 
 	// Begins running the message bus
 	//-------------------------------------------------------------------------------
+
+	// Set SR_MESSAGE_TRACE to a file path to record the messages going through the bus
+	const char* messageTracePath = getenv("SR_MESSAGE_TRACE");
+	if(messageTracePath != NULL)
+	{
+		messageBus.startTracing(messageTracePath);
+	}
+
+	// Node timings are logged every 5 minutes, or on demand with 'kill -USR1 <pid>'
+	messageBus.enableStatistics(300);
+	MessageBusStats::dumpOnSignal(SIGUSR1);
+
 	Logger::info("Message bus started!");
 	messageBus.run();
 
@@ -0,0 +1,94 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		message_trace_decoder.cpp
+ *
+ * Purpose:
+ *		Turns a binary message trace recorded by MessageBus::startTracing into CSV, one
+ *		line per delivery, with the message and node names and the queueing latency.
+ *		The latency is left empty for the messages sent before tracing was enabled.
+ *
+ * Usage:
+ *		./message-trace-decoder.run Messages.trace > Messages.csv
+ *
+ ***************************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "MessageBus/MessageTracer.h"
+
+
+///----------------------------------------------------------------------------------
+/// Prints a unix time in microseconds as hh:mm:ss.uuuuuu (UTC)
+///----------------------------------------------------------------------------------
+void printTime(int64_t unixTimeUs)
+{
+	time_t seconds = (time_t)(unixTimeUs / 1000000);
+	char buff[16];
+	strftime(buff, sizeof(buff), "%H:%M:%S", gmtime(&seconds));
+	printf("%s.%06d", buff, (int)(unixTimeUs % 1000000));
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		fprintf(stderr, "Usage: %s <trace file>\n", argv[0]);
+		return 1;
+	}
+
+	FILE* file = fopen(argv[1], "rb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Could not open %s\n", argv[1]);
+		return 1;
+	}
+
+	MessageTraceHeader header;
+	if(fread(&header, sizeof(header), 1, file) != 1 ||
+		strncmp(header.magic, MESSAGE_TRACE_MAGIC, sizeof(header.magic)) != 0)
+	{
+		fprintf(stderr, "%s is not a message trace\n", argv[1]);
+		fclose(file);
+		return 1;
+	}
+
+	if(header.version != MESSAGE_TRACE_VERSION || header.recordSize != sizeof(MessageTraceRecord))
+	{
+		fprintf(stderr, "Unsupported trace version %u\n", header.version);
+		fclose(file);
+		return 1;
+	}
+
+	printf("time,message_type,source,destination,consumer,queue_us,dispatch_us\n");
+
+	MessageTraceRecord record;
+	unsigned long count = 0;
+	while(fread(&record, sizeof(record), 1, file) == 1)
+	{
+		// Messages sent before tracing was enabled weren't timestamped, there is no
+		// queueing latency to tell
+		bool enqueued = record.enqueueTime != 0;
+		printTime(header.unixTimeOffset + (int64_t)(enqueued ? record.enqueueTime : record.dequeueTime));
+
+		printf(",%s,%s,%s,%s,",
+			msgToString((MessageType)record.messageType).c_str(),
+			nodeToString((NodeID)record.sourceID).c_str(),
+			nodeToString((NodeID)record.destinationID).c_str(),
+			nodeToString((NodeID)record.consumerID).c_str());
+		if(enqueued)
+		{
+			printf("%" PRIu64, record.dequeueTime - record.enqueueTime);
+		}
+		printf(",%" PRId64 "\n",
+			record.deliverTime == 0 ? -1 : (int64_t)(record.deliverTime - record.dequeueTime));
+		count++;
+	}
+
+	fclose(file);
+	fprintf(stderr, "%lu records\n", count);
+	return 0;
+}
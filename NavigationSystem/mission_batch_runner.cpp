@@ -0,0 +1,823 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		mission_batch_runner.cpp
+ *
+ * Purpose:
+ *		Sails missions many times over in the in process simulation, each time with a
+ *		random wind, current and AIS traffic, and prints a CSV line of metrics per run:
+ *		whether and how fast the mission was completed, the distance sailed, the number
+ *		of tacks, the closest approach to the traffic and the CPU time spent per control
+ *		cycle (course regulator command).
+ *
+ * Usage:
+ *		./mission-batch-runner.run [options] <database> <mission.json>... > runs.csv
+ *
+ *		-n runs 		Runs per mission (10)
+ *		-j jobs 		Runs at the same time (the number of CPUs)
+ *		-s seed 		Seed of the first run (1), every run has its own seed
+ *		-t hours 		Simulated time after which a run is given up (4)
+ *		-a vessels 		Most AIS vessels per run (3)
+ *		-k ms 			Lockstep tick (100)
+ *		-b boat 		ASPire (wing sail, default) or Janet (sail), with a config_sail_control
+ *
+ *		The database is copied for every run and its currentMission replaced by the
+ *		mission, it must have the boat's config (see createtables*.sql and
+ *		update_config.py). A run is reproduced with its seed, -n 1 and the one mission.
+ *		Build with USE_LNM=1 to run the missions with the Local Navigation Module.
+ *
+ *		time_s is the simulated time until the last waypoint was harvested, tacks the
+ *		times the bow went through the true wind. cpu_us_per_cycle is the CPU time of
+ *		the control system per course regulator command: the nodes' threads, the voter
+ *		pool's and the message bus thread's, without the simulation thread (the boat,
+ *		the traffic and the lockstep), the runner's main thread and the metrics.
+ *
+ * Developer Notes:
+ *		Every run is a process of its own, the nodes run on the SimulatedClock which
+ *		there is one of per process. The results come back through shared memory.
+ *
+ *		The nodes are started one at a time, so they take part in the lockstep in the
+ *		same order and the clock wakes them in that order every tick. Together with the
+ *		seeded conditions this makes a run repeat exactly.
+ *
+ ***************************************************************************************/
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Database/DBHandler.h"
+#include "Libs/json/include/nlohmann/json.hpp"
+#include "LowLevelControllers/CourseRegulatorNode.h"
+#include "LowLevelControllers/SailControlNode.h"
+#include "LowLevelControllers/WingsailControlNode.h"
+#include "Math/CourseMath.h"
+#include "MessageBus/MessageBus.h"
+#include "Messages/LocalNavigationMsg.h"
+#include "Messages/StateMessage.h"
+#include "Messages/WaypointDataMsg.h"
+#include "Messages/WindStateMsg.h"
+#include "Navigation/WaypointMgrNode.h"
+#include "Simulation/SimulationNode.h"
+#include "SystemServices/Logger.h"
+#include "WorldState/CollidableMgr/CollidableMgr.h"
+#include "WorldState/StateEstimationNode.h"
+#include "WorldState/WindStateNode.h"
+#if LOCAL_NAVIGATION_MODULE == 1
+	#include "Navigation/LocalNavigationModule/LocalNavigationModule.h"
+	#include "Navigation/LocalNavigationModule/Voters/ChannelVoter.h"
+	#include "Navigation/LocalNavigationModule/Voters/MidRangeVoter.h"
+	#include "Navigation/LocalNavigationModule/Voters/ProximityVoter.h"
+	#include "Navigation/LocalNavigationModule/Voters/WaypointVoter.h"
+	#include "Navigation/LocalNavigationModule/Voters/WindVoter.h"
+#else
+	#include "Navigation/LineFollowNode.h"
+#endif
+
+using Json = nlohmann::json;
+
+// Speed the boat is expected to make good, to spread the traffic over the mission
+#define EXPECTED_SPEED 1.0
+
+// How far off the bow or the stern the wind has to be for the side it blows on to
+// change, so luffing head to wind for a moment isn't counted as tacks
+#define WIND_SIDE_MARGIN 10
+
+// The most the options can ask for
+#define MAX_RUNS 100000
+#define MAX_JOBS 256
+#define MAX_VESSELS 100
+#define MAX_TICK_MS 60000
+
+
+enum class RunStatus : int {
+	NotRun = 0,
+	Completed,
+	Timeout,
+	Failed
+};
+
+struct BatchConfig_t {
+	unsigned int runs;
+	unsigned int jobs;
+	unsigned long seed;
+	double maxHours;
+	unsigned int maxVessels;
+	unsigned int tickMs;
+	bool wingSail;
+	std::string database;
+};
+
+struct Waypoint_t {
+	int id;
+	double latitude;
+	double longitude;
+	Json values;
+};
+
+struct Mission_t {
+	std::string name;
+	std::vector<Waypoint_t> waypoints;
+};
+
+// Written by the run's process into memory shared with the batch
+struct RunResult_t {
+	RunStatus status;
+	unsigned long seed;
+	double windSpeed;
+	double windDirection;
+	double currentSpeed;
+	double currentDirection;
+	unsigned int vessels;
+	double time;
+	double distance;
+	unsigned int tacks;
+	double closestApproach;
+	unsigned long controlCycles;
+	double cpuPerCycleUs;
+	double wallTime;
+};
+
+
+///----------------------------------------------------------------------------------
+/// Returns the CPU time of a clock, e.g. the process's or the calling thread's, in
+/// seconds.
+///----------------------------------------------------------------------------------
+double cpuTime(clockid_t clock)
+{
+	timespec time;
+	clock_gettime(clock, &time);
+	return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+///----------------------------------------------------------------------------------
+/// Follows the mission from the messages the nodes send each other, and tells when it
+/// is over. Registered after the WaypointMgrNode, it gets a vessel state once the
+/// waypoint manager has harvested with it.
+///----------------------------------------------------------------------------------
+class MissionMetricsNode : public Node {
+public:
+	MissionMetricsNode(MessageBus& msgBus, DBHandler& dbHandler, CollidableMgr& collidableMgr,
+		int lastWaypointId, double maxSeconds)
+		:Node(NodeID::None, msgBus), m_DBHandler(dbHandler), m_CollidableMgr(collidableMgr),
+		m_LastWaypointId(lastWaypointId), m_MaxSeconds(maxSeconds), m_NextWaypointId(0),
+		m_Done(false), m_Status(RunStatus::NotRun), m_Time(0), m_HasWind(false),
+		m_TrueWindDirection(0), m_WindSide(0), m_Tacks(0), m_ClosestApproach(-1),
+		m_ControlCycles(0), m_CpuTime(0)
+	{
+		msgBus.registerNode(*this, MessageType::StateMessage);
+		msgBus.registerNode(*this, MessageType::WindState);
+		msgBus.registerNode(*this, MessageType::WaypointData);
+		msgBus.registerNode(*this, MessageType::RudderCommand);
+	}
+
+	///----------------------------------------------------------------------------------
+	/// The mission starts now, on the simulated clock.
+	///----------------------------------------------------------------------------------
+	bool init()
+	{
+		m_Start = SimulatedClock::now();
+		return true;
+	}
+
+	void processMessage(const Message* msg)
+	{
+		std::lock_guard<std::mutex> lock(m_Lock);
+		if(m_Done)
+		{
+			return;
+		}
+		double cpuStart = ::cpuTime(CLOCK_THREAD_CPUTIME_ID);
+
+		switch(msg->messageType())
+		{
+			case MessageType::StateMessage:
+				processStateMessage((const StateMessage*)msg);
+				checkMission();
+				break;
+			case MessageType::WindState:
+				m_TrueWindDirection = ((const WindStateMsg*)msg)->trueWindDirection();
+				m_HasWind = true;
+				break;
+			case MessageType::WaypointData:
+				m_NextWaypointId = ((const WaypointDataMsg*)msg)->nextId();
+				break;
+			case MessageType::RudderCommand:
+				m_ControlCycles++;
+				break;
+			default:
+				break;
+		}
+
+		m_CpuTime += ::cpuTime(CLOCK_THREAD_CPUTIME_ID) - cpuStart;
+	}
+
+	///----------------------------------------------------------------------------------
+	/// Waits until the mission is completed, timed out or failed.
+	///----------------------------------------------------------------------------------
+	RunStatus waitUntilDone()
+	{
+		std::unique_lock<std::mutex> lock(m_Lock);
+		m_DoneCondition.wait(lock, [this]() { return m_Done; });
+		return m_Status;
+	}
+
+	// The figures stop changing once the mission is over
+	double time() { std::lock_guard<std::mutex> lock(m_Lock); return m_Time; }
+	unsigned int tacks() { std::lock_guard<std::mutex> lock(m_Lock); return m_Tacks; }
+	double closestApproach() { std::lock_guard<std::mutex> lock(m_Lock); return m_ClosestApproach; }
+	unsigned long controlCycles() { std::lock_guard<std::mutex> lock(m_Lock); return m_ControlCycles; }
+
+	///----------------------------------------------------------------------------------
+	/// Returns the CPU time the metrics took on the message bus thread, in seconds.
+	///----------------------------------------------------------------------------------
+	double cpuTime() { std::lock_guard<std::mutex> lock(m_Lock); return m_CpuTime; }
+
+private:
+	void processStateMessage(const StateMessage* msg)
+	{
+		CollidableList<AISCollidable_t> contacts = m_CollidableMgr.getAISContacts();
+		for(const AISCollidable_t& contact : contacts)
+		{
+			double distance = CourseMath::calculateDTW(msg->longitude(), msg->latitude(),
+				contact.longitude, contact.latitude);
+			if(m_ClosestApproach < 0 || distance < m_ClosestApproach)
+			{
+				m_ClosestApproach = distance;
+			}
+		}
+
+		if(not m_HasWind)
+		{
+			return;
+		}
+
+		// Positive when the wind blows on the starboard side
+		double windAngle = Utility::limitAngleRange180(m_TrueWindDirection - msg->heading());
+		if(std::fabs(windAngle) < WIND_SIDE_MARGIN || std::fabs(windAngle) > 180 - WIND_SIDE_MARGIN)
+		{
+			return;
+		}
+
+		// The wind changed side through the bow rather than the stern (a gybe) if that is
+		// the shorter way round
+		if(m_WindSide != 0 && (windAngle > 0) != (m_WindSide > 0) &&
+			std::fabs(windAngle) + std::fabs(m_WindSide) < 180)
+		{
+			m_Tacks++;
+		}
+		m_WindSide = windAngle;
+	}
+
+	///----------------------------------------------------------------------------------
+	/// The mission is completed once every waypoint is harvested, which can only have
+	/// happened once the last one is the next.
+	///----------------------------------------------------------------------------------
+	void checkMission()
+	{
+		double elapsed = std::chrono::duration<double>(SimulatedClock::now() - m_Start).count();
+
+		if(m_NextWaypointId == m_LastWaypointId)
+		{
+			int unharvested;
+			if(not m_DBHandler.countUnharvestedWaypoints(unharvested))
+			{
+				finish(RunStatus::Failed, elapsed);
+				return;
+			}
+			if(unharvested == 0)
+			{
+				finish(RunStatus::Completed, elapsed);
+				return;
+			}
+		}
+
+		if(elapsed >= m_MaxSeconds)
+		{
+			finish(RunStatus::Timeout, elapsed);
+		}
+	}
+
+	void finish(RunStatus status, double elapsed)
+	{
+		m_Status = status;
+		m_Time = elapsed;
+		m_Done = true;
+		m_DoneCondition.notify_all();
+	}
+
+	DBHandler& m_DBHandler;
+	CollidableMgr& m_CollidableMgr;
+	const int m_LastWaypointId;
+	const double m_MaxSeconds;
+	std::chrono::steady_clock::time_point m_Start;
+
+	std::mutex m_Lock;
+	std::condition_variable m_DoneCondition;
+	int m_NextWaypointId;
+	bool m_Done;
+	RunStatus m_Status;
+	double m_Time;				// s of simulated time until the mission was over
+	bool m_HasWind;
+	double m_TrueWindDirection;
+	double m_WindSide;			// The last wind angle clearly on a side, 0 until there is one
+	unsigned int m_Tacks;
+	double m_ClosestApproach;	// m, -1 until a contact is seen
+	unsigned long m_ControlCycles;
+	double m_CpuTime;			// s
+};
+
+
+///----------------------------------------------------------------------------------
+/// Reads a mission json like update_waypoints.py does, waypoints keyed by their id.
+///----------------------------------------------------------------------------------
+bool loadMission(const std::string& path, Mission_t& mission)
+{
+	std::ifstream file(path);
+	if(not file.is_open())
+	{
+		return false;
+	}
+
+	Json json;
+	try
+	{
+		file >> json;
+		for(auto& item : json.items())
+		{
+			Waypoint_t waypoint;
+			waypoint.id = std::stoi(item.key());
+			waypoint.latitude = item.value().at("latitude").get<double>();
+			waypoint.longitude = item.value().at("longitude").get<double>();
+			waypoint.values = item.value();
+			mission.waypoints.push_back(waypoint);
+		}
+	}
+	catch(std::exception&)
+	{
+		return false;
+	}
+
+	std::sort(mission.waypoints.begin(), mission.waypoints.end(),
+		[](const Waypoint_t& a, const Waypoint_t& b) { return a.id < b.id; });
+	size_t slash = path.find_last_of('/');
+	mission.name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+	return not mission.waypoints.empty();
+}
+
+///----------------------------------------------------------------------------------
+/// Copies the database and puts the mission in its currentMission.
+///----------------------------------------------------------------------------------
+bool prepareDatabase(const std::string& from, const std::string& to, const Mission_t& mission)
+{
+	{
+		std::ifstream source(from, std::ios::binary);
+		std::ofstream destination(to, std::ios::binary | std::ios::trunc);
+		if(not source.is_open() || not destination.is_open())
+		{
+			return false;
+		}
+		destination << source.rdbuf();
+	}
+
+	DBHandler dbHandler(to);
+	if(not dbHandler.initialise())
+	{
+		return false;
+	}
+
+	dbHandler.clearTable("currentMission");
+	for(const Waypoint_t& waypoint : mission.waypoints)
+	{
+		std::string fields = "id";
+		std::string values = std::to_string(waypoint.id);
+		for(auto& value : waypoint.values.items())
+		{
+			fields += "," + value.key();
+			values += "," + value.value().dump();
+		}
+		if(not dbHandler.insert("currentMission", fields, values))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+///----------------------------------------------------------------------------------
+/// Draws the wind, the current and the traffic of a run. The vessels go through
+/// random points of the mission at random times, straight from anywhere.
+///----------------------------------------------------------------------------------
+void randomiseRun(const BatchConfig_t& config, const Mission_t& mission, unsigned long seed,
+	BoatDynamics& dynamics, AISTraffic& traffic, RunResult_t& result)
+{
+	std::mt19937 random(seed);
+	auto uniform = [&](double low, double high) {
+		return std::uniform_real_distribution<double>(low, high)(random);
+	};
+
+	WindField_t& wind = dynamics.wind();
+	wind.speed = uniform(3, 9);
+	wind.direction = uniform(0, 360);
+	wind.gustAmplitude = uniform(0, 2);
+	wind.gustPeriod = uniform(30, 120);
+	wind.shiftAmplitude = uniform(0, 15);
+	wind.shiftPeriod = uniform(120, 600);
+	dynamics.current().speed = uniform(0, 0.4);
+	dynamics.current().direction = uniform(0, 360);
+
+	// Starts on the first waypoint on a beam reach, the side closest to the next one
+	const Waypoint_t& first = mission.waypoints.front();
+	double heading = Utility::limitAngleRange(wind.direction + 90);
+	if(mission.waypoints.size() > 1)
+	{
+		const Waypoint_t& second = mission.waypoints[1];
+		double bearing = CourseMath::calculateBTW(first.longitude, first.latitude,
+			second.longitude, second.latitude);
+		if(std::fabs(Utility::limitAngleRange180(bearing - heading)) > 90)
+		{
+			heading = Utility::limitAngleRange(wind.direction - 90);
+		}
+	}
+	dynamics.reset(first.latitude, first.longitude, heading);
+
+	LocalTangentPlane plane(first.latitude, first.longitude);
+	std::vector<double> east, north;
+	double length = 0;
+	for(const Waypoint_t& waypoint : mission.waypoints)
+	{
+		double x, y;
+		plane.project(waypoint.latitude, waypoint.longitude, x, y);
+		if(not east.empty())
+		{
+			length += std::hypot(x - east.back(), y - north.back());
+		}
+		east.push_back(x);
+		north.push_back(y);
+	}
+
+	unsigned int vessels = std::uniform_int_distribution<unsigned int>(0, config.maxVessels)(random);
+	for(unsigned int i = 0; i < vessels; i++)
+	{
+		size_t leg = std::uniform_int_distribution<size_t>(0, east.size() - 1)(random);
+		size_t next = std::min(leg + 1, east.size() - 1);
+		double fraction = uniform(0, 1);
+		double x = east[leg] + (east[next] - east[leg]) * fraction;
+		double y = north[leg] + (north[next] - north[leg]) * fraction;
+
+		double speed = uniform(2, 8);
+		double course = uniform(0, 360);
+		double time = uniform(0, std::max(length / EXPECTED_SPEED, 600.0));
+		x -= speed * time * std::sin(Utility::degreeToRadian(course));
+		y -= speed * time * std::cos(Utility::degreeToRadian(course));
+
+		double latitude, longitude;
+		plane.unproject(x, y, latitude, longitude);
+		float vesselLength = uniform(10, 60);
+		traffic.addVessel(1000 + i, latitude, longitude, speed, course, vesselLength, vesselLength / 4);
+	}
+
+	result.windSpeed = wind.speed;
+	result.windDirection = wind.direction;
+	result.currentSpeed = dynamics.current().speed;
+	result.currentDirection = dynamics.current().direction;
+	result.vessels = vessels;
+}
+
+///----------------------------------------------------------------------------------
+/// Sails a mission once, in the process of the run, and exits it. Only returns if the
+/// run couldn't start.
+///----------------------------------------------------------------------------------
+void runMission(const BatchConfig_t& config, const Mission_t& mission, unsigned long seed,
+	RunResult_t& result)
+{
+	result.status = RunStatus::Failed;
+	result.seed = seed;
+
+	std::string dbPath = "/tmp/sr-batch-" + std::to_string(getpid()) + ".db";
+	if(not prepareDatabase(config.database, dbPath, mission))
+	{
+		fprintf(stderr, "Could not prepare the database for %s\n", mission.name.c_str());
+		return;
+	}
+
+	DBHandler dbHandler(dbPath);
+	if(not dbHandler.initialise())
+	{
+		return;
+	}
+	MessageBus messageBus;
+
+	BoatDynamics dynamics(config.wingSail);
+	AISTraffic traffic(mission.waypoints.front().latitude, mission.waypoints.front().longitude);
+	randomiseRun(config, mission, seed, dynamics, traffic, result);
+
+	StateEstimationNode stateEstimationNode(messageBus, dbHandler);
+	WindStateNode windStateNode(messageBus);
+	WaypointMgrNode waypoint(messageBus, dbHandler);
+	CollidableMgr collidableMgr;
+	CourseRegulatorNode courseRegulatorNode(messageBus, dbHandler);
+	std::unique_ptr<ActiveNode> sailControl;
+	if(config.wingSail)
+	{
+		sailControl.reset(new WingsailControlNode(messageBus, dbHandler));
+	}
+	else
+	{
+		sailControl.reset(new SailControlNode(messageBus, dbHandler));
+	}
+	#if LOCAL_NAVIGATION_MODULE == 1
+		LocalNavigationModule lnm(messageBus, dbHandler);
+		const int16_t MAX_VOTES = dbHandler.retrieveCellAsInt("config_voter_system","1","max_vote");
+		WaypointVoter waypointVoter(MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","waypoint_voter_weight"));
+		WindVoter windVoter(MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","wind_voter_weight"));
+		ChannelVoter channelVoter(MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","channel_voter_weight"));
+		MidRangeVoter midRangeVoter(MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","midrange_voter_weight"), collidableMgr);
+		ProximityVoter proximityVoter(MAX_VOTES, dbHandler.retrieveCellAsDouble("config_voter_system","1","proximity_voter_weight"), collidableMgr);
+		lnm.registerVoter(&waypointVoter);
+		lnm.registerVoter(&windVoter);
+		lnm.registerVoter(&channelVoter);
+		lnm.registerVoter(&proximityVoter);
+		lnm.registerVoter(&midRangeVoter);
+		ActiveNode& navigation = lnm;
+	#else
+		LineFollowNode sailingLogic(messageBus, dbHandler);
+		ActiveNode& navigation = sailingLogic;
+	#endif
+	SimulationNode simulation(messageBus, config.wingSail, &collidableMgr);
+	MissionMetricsNode metrics(messageBus, dbHandler, collidableMgr, mission.waypoints.back().id,
+		config.maxHours * 3600);
+
+	simulation.enableLockstep(config.tickMs);
+	simulation.simulateInProcess(dynamics);
+	simulation.simulateTraffic(traffic);
+
+	Node* nodes[] = { &stateEstimationNode, &windStateNode, &waypoint, &courseRegulatorNode,
+		sailControl.get(), &navigation, &simulation, &metrics };
+	for(Node* node : nodes)
+	{
+		if(not node->init())
+		{
+			fprintf(stderr, "A node failed to initialise for %s\n", mission.name.c_str());
+			return;
+		}
+	}
+
+	auto wallStart = std::chrono::steady_clock::now();
+	double processCpuStart = cpuTime(CLOCK_PROCESS_CPUTIME_ID);
+	double mainCpuStart = cpuTime(CLOCK_THREAD_CPUTIME_ID);
+
+	std::thread busThread([&messageBus]() { messageBus.run(); });
+	busThread.detach();
+
+	// Each node takes part in the lockstep before the next starts, and the simulation
+	// only steps once they all do
+	ActiveNode* controlNodes[] = { &stateEstimationNode, &courseRegulatorNode, sailControl.get(),
+		&navigation };
+	for(ActiveNode* node : controlNodes)
+	{
+		unsigned int participants = SimulatedClock::participants();
+		node->start();
+		while(SimulatedClock::participants() == participants)
+		{
+			std::this_thread::yield();
+		}
+	}
+	simulation.start();
+
+	result.status = metrics.waitUntilDone();
+
+	// What is left once the harness is taken out, see the Usage
+	double cpu = (cpuTime(CLOCK_PROCESS_CPUTIME_ID) - processCpuStart) -
+		(cpuTime(CLOCK_THREAD_CPUTIME_ID) - mainCpuStart) - simulation.threadCpuTime() -
+		metrics.cpuTime();
+
+	result.time = metrics.time();
+	result.distance = dynamics.distance();
+	result.tacks = metrics.tacks();
+	result.closestApproach = metrics.closestApproach();
+	result.controlCycles = metrics.controlCycles();
+	result.cpuPerCycleUs = result.controlCycles > 0 ? cpu * 1e6 / result.controlCycles : 0;
+	result.wallTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+	remove(dbPath.c_str());
+	remove((dbPath + "-wal").c_str());
+	remove((dbPath + "-shm").c_str());
+
+	// The nodes never stop, leave without destroying them under their threads
+	_exit(0);
+}
+
+void printResult(const Mission_t& mission, unsigned int run, const RunResult_t& result)
+{
+	static const char* STATUS[] = { "not_run", "completed", "timeout", "failed" };
+
+	printf("%s,%u,%lu,%s,%.2f,%.1f,%.2f,%.1f,%u,", mission.name.c_str(), run, result.seed,
+		STATUS[(int)result.status], result.windSpeed, result.windDirection, result.currentSpeed,
+		result.currentDirection, result.vessels);
+
+	if(result.status != RunStatus::Completed && result.status != RunStatus::Timeout)
+	{
+		printf(",,,,,,\n");
+		return;
+	}
+
+	printf("%.1f,%.1f,%u,", result.time, result.distance, result.tacks);
+	if(result.closestApproach >= 0)
+	{
+		printf("%.1f", result.closestApproach);
+	}
+	printf(",%lu,%.1f,%.2f\n", result.controlCycles, result.cpuPerCycleUs, result.wallTime);
+}
+
+///----------------------------------------------------------------------------------
+/// Reads a whole number option, false if it isn't one between min and max.
+///----------------------------------------------------------------------------------
+bool parseOption(const char* text, long min, long max, long& value)
+{
+	char* end;
+	errno = 0;
+	value = strtol(text, &end, 10);
+	return errno == 0 && end != text && *end == '\0' && value >= min && value <= max;
+}
+
+void printUsage(const char* name)
+{
+	fprintf(stderr, "Usage: %s [-n runs] [-j jobs] [-s seed] [-t hours] [-a vessels] [-k tick ms]"
+		" [-b ASPire|Janet] <database> <mission.json>...\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	BatchConfig_t config;
+	config.runs = 10;
+	config.jobs = std::max(1u, std::thread::hardware_concurrency());
+	config.seed = 1;
+	config.maxHours = 4;
+	config.maxVessels = 3;
+	config.tickMs = 100;
+	config.wingSail = true;
+
+	int option;
+	while((option = getopt(argc, argv, "n:j:s:t:a:k:b:")) != -1)
+	{
+		long value = 0;
+		bool valid = true;
+		switch(option)
+		{
+			case 'n':
+				valid = parseOption(optarg, 1, MAX_RUNS, value);
+				config.runs = value;
+				break;
+			case 'j':
+				valid = parseOption(optarg, 1, MAX_JOBS, value);
+				config.jobs = value;
+				break;
+			case 's':
+				valid = parseOption(optarg, 0, LONG_MAX, value);
+				config.seed = value;
+				break;
+			case 't':
+			{
+				char* end;
+				errno = 0;
+				config.maxHours = strtod(optarg, &end);
+				valid = errno == 0 && end != optarg && *end == '\0' && config.maxHours > 0 &&
+					std::isfinite(config.maxHours);
+				break;
+			}
+			case 'a':
+				valid = parseOption(optarg, 0, MAX_VESSELS, value);
+				config.maxVessels = value;
+				break;
+			case 'k':
+				valid = parseOption(optarg, 1, MAX_TICK_MS, value);
+				config.tickMs = value;
+				break;
+			case 'b':
+				valid = strcmp(optarg, "ASPire") == 0 || strcmp(optarg, "Janet") == 0;
+				config.wingSail = strcmp(optarg, "ASPire") == 0;
+				break;
+			default:
+				printUsage(argv[0]);
+				return 1;
+		}
+
+		if(not valid)
+		{
+			fprintf(stderr, "Invalid -%c %s\n", option, optarg);
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if(argc - optind < 2)
+	{
+		printUsage(argv[0]);
+		return 1;
+	}
+	config.database = argv[optind];
+
+	std::vector<Mission_t> missions;
+	for(int i = optind + 1; i < argc; i++)
+	{
+		Mission_t mission;
+		if(not loadMission(argv[i], mission))
+		{
+			fprintf(stderr, "Could not read the mission %s\n", argv[i]);
+			return 1;
+		}
+		missions.push_back(mission);
+	}
+
+	Logger::DisableLogging();
+
+	// Without the controller's config its loop would never sleep, and never let the
+	// lockstep go on
+	{
+		DBHandler dbHandler(config.database);
+		const char* sailConfig = config.wingSail ? "config_wingsail_control" : "config_sail_control";
+		if(not dbHandler.initialise() || dbHandler.getRows(sailConfig) < 1)
+		{
+			fprintf(stderr, "%s has no %s, is it the database of the boat?\n",
+				config.database.c_str(), sailConfig);
+			return 1;
+		}
+	}
+
+	size_t runCount = missions.size() * config.runs;
+	RunResult_t* results = (RunResult_t*)mmap(NULL, runCount * sizeof(RunResult_t),
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(results == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map the results\n");
+		return 1;
+	}
+	memset((void*)results, 0, runCount * sizeof(RunResult_t));
+
+	// One process per run, at most jobs of them at a time
+	unsigned int running = 0;
+	for(size_t i = 0; i < runCount; i++)
+	{
+		if(running == config.jobs)
+		{
+			wait(NULL);
+			running--;
+		}
+
+		pid_t pid = fork();
+		if(pid == 0)
+		{
+			runMission(config, missions[i / config.runs], config.seed + i, results[i]);
+			_exit(1);
+		}
+		else if(pid < 0)
+		{
+			fprintf(stderr, "Could not start run %zu\n", i);
+			results[i].status = RunStatus::Failed;
+			results[i].seed = config.seed + i;
+			continue;
+		}
+		running++;
+	}
+	while(running > 0)
+	{
+		wait(NULL);
+		running--;
+	}
+
+	printf("mission,run,seed,status,wind_speed,wind_direction,current_speed,current_direction,"
+		"ais_vessels,time_s,distance_m,tacks,closest_approach_m,control_cycles,cpu_us_per_cycle,"
+		"wall_s\n");
+	unsigned int completed = 0;
+	for(size_t i = 0; i < runCount; i++)
+	{
+		// A run that crashed never wrote its status
+		if(results[i].status == RunStatus::NotRun)
+		{
+			results[i].status = RunStatus::Failed;
+			results[i].seed = config.seed + i;
+		}
+		printResult(missions[i / config.runs], i % config.runs, results[i]);
+		completed += results[i].status == RunStatus::Completed;
+	}
+	fprintf(stderr, "%u of %zu runs completed their mission\n", completed, runCount);
+
+	munmap(results, runCount * sizeof(RunResult_t));
+	return 0;
+}
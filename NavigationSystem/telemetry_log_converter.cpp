@@ -0,0 +1,108 @@
+/****************************************************************************************
+ *
+ * File:
+ * 		telemetry_log_converter.cpp
+ *
+ * Purpose:
+ *		Imports a binary telemetry log written by TelemetryLog into the dataLogs_*
+ *		tables of a database, the same way DBLogger would have logged them.
+ *
+ * Usage:
+ *		./telemetry-log-converter.run telemetry.log asr.db [from unix time]
+ *
+ *		The database must already exist (see createtables*.sql). With a start time only
+ *		the rows logged from then on are imported.
+ *
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "Database/DBHandler.h"
+#include "Database/TelemetryLog.h"
+#include "SystemServices/Logger.h"
+
+// How many rows are inserted per transaction
+#define IMPORT_BATCH_SIZE 500
+
+
+int main(int argc, char *argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "Usage: %s <telemetry log> <database> [from unix time]\n", argv[0]);
+		return 1;
+	}
+
+	Logger::init("TelemetryConverter.log");
+
+	TelemetryLogReader reader;
+	if(not reader.open(argv[1]))
+	{
+		fprintf(stderr, "Could not read %s\n", argv[1]);
+		return 1;
+	}
+
+	DBHandler dbHandler(argv[2]);
+	if(not dbHandler.initialise())
+	{
+		fprintf(stderr, "Could not open the database %s\n", argv[2]);
+		return 1;
+	}
+
+	int64_t from = 0;
+	if(argc > 3)
+	{
+		from = atoll(argv[3]) * 1000;
+		reader.seek(from);
+	}
+
+	std::vector<LogItem> logs;
+	logs.reserve(IMPORT_BATCH_SIZE);
+	unsigned long count = 0;
+	unsigned long failed = 0;
+
+	LogItem item;
+	while(reader.next(item))
+	{
+		if(reader.timestamp() < from)
+		{
+			continue;
+		}
+
+		logs.push_back(item);
+		if(logs.size() == IMPORT_BATCH_SIZE)
+		{
+			if(dbHandler.insertDataLogs(logs))
+			{
+				count += logs.size();
+			}
+			else
+			{
+				failed += logs.size();
+			}
+			logs.clear();
+		}
+	}
+
+	if(not logs.empty())
+	{
+		if(dbHandler.insertDataLogs(logs))
+		{
+			count += logs.size();
+		}
+		else
+		{
+			failed += logs.size();
+		}
+	}
+
+	fprintf(stderr, "%lu rows imported\n", count);
+	if(failed > 0)
+	{
+		fprintf(stderr, "%lu rows could not be written to the database\n", failed);
+		return 1;
+	}
+	return 0;
+}
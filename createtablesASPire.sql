@@ -374,6 +374,16 @@ CREATE TABLE config_xbee (
   push_only_latest_logs BOOLEAN
 );
 
+-- -----------------------------------------------------
+-- Table sync_cursors
+-- Id of the last row of each dataLogs table acknowledged by the server
+-- -----------------------------------------------------
+DROP TABLE IF EXISTS "sync_cursors";
+CREATE TABLE sync_cursors (
+  table_name	VARCHAR PRIMARY KEY,
+  last_id		INTEGER
+);
+
 -- -----------------------------------------------------
 -- Table sailing zone
 -- -----------------------------------------------------